@@ -0,0 +1,135 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include "advancedthreadpool.hpp"
+#include "dbconnectionpool.hpp"
+#include "terrainStorageEngine.hpp"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace bench {
+
+// 测试区域（北京地区，0.01° 网格，与地形引擎测试一致）
+inline constexpr double kMinLon = 116.0;
+inline constexpr double kMinLat = 39.0;
+inline constexpr double kMaxLon = 117.5;
+inline constexpr double kMaxLat = 41.0;
+inline constexpr double kGridSize = 0.01;
+inline constexpr double kDegreesPerKm = 0.009;  // 约 1km 对应的纬度跨度
+inline constexpr size_t kDatasetPoints = 200000; // 共享数据集点数
+
+using PointData = std::vector<std::tuple<double, double, std::string>>;
+
+// 固定种子生成地形点：同一 seed 每次运行得到相同的数据，基线之间可比
+inline PointData generatePoints(size_t count, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> lon_dist(kMinLon, kMaxLon);
+    std::uniform_real_distribution<double> lat_dist(kMinLat, kMaxLat);
+    std::uniform_real_distribution<double> elevation_dist(0.0, 2000.0);
+    PointData data;
+    data.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const double lon = lon_dist(gen);
+        const double lat = lat_dist(gen);
+        data.emplace_back(lon, lat, std::to_string(elevation_dist(gen)));
+    }
+    return data;
+}
+
+// 忙等模拟一次查询的耗时：sleep_for 的精度受调度器影响，短时延下不可比
+inline void spinFor(std::chrono::nanoseconds duration) {
+    const auto deadline = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
+
+// 模拟连接：不访问数据库，只测量连接池本身的开销
+class MockConnection : public DBConn {
+public:
+    bool connect() override { return true; }
+    bool ping() override { return true; }
+    void reset() override {}
+    bool needsReset() const override { return false; }
+    void close() override {}
+};
+
+inline DBConnectionPool::Factory mockFactory() {
+    return [] { return std::make_shared<MockConnection>(); };
+}
+
+/**
+ * 基准测试用的临时 LevelDB 实例：构造时创建目录，析构时关闭并删除
+ */
+class TempDatabase {
+public:
+    explicit TempDatabase(const std::string& name)
+        : path_(std::filesystem::temp_directory_path() / ("sim_bench_" + name)) {
+        std::filesystem::remove_all(path_);
+        std::filesystem::create_directories(path_);
+        db_.initialize(path_.string());
+    }
+
+    ~TempDatabase() {
+        db_.shutdown();
+        std::filesystem::remove_all(path_);
+    }
+
+    TempDatabase(const TempDatabase&) = delete;
+    TempDatabase& operator=(const TempDatabase&) = delete;
+
+    LevelDBManager& db() { return db_; }
+
+private:
+    std::filesystem::path path_;
+    LevelDBManager db_;
+};
+
+/**
+ * 预先导入 kDatasetPoints 个点的共享地形库，首次使用时构建，进程退出前一直有效。
+ * 读取类基准共用它，避免每个基准重复导入
+ */
+struct TerrainDataset {
+    TempDatabase database{ "dataset" };
+    PointData points = generatePoints(kDatasetPoints, 42);
+
+    static TerrainDataset& instance() {
+        static TerrainDataset dataset;
+        return dataset;
+    }
+
+    std::unique_ptr<TerrainStorageEngine> openEngine(size_t cache_capacity,
+                                                     TerrainStorageConfig config = TerrainStorageConfig()) {
+        return std::make_unique<TerrainStorageEngine>(database.db(), kMinLon, kMinLat, kMaxLon, kMaxLat,
+                                                      kGridSize, cache_capacity, config);
+    }
+
+private:
+    TerrainDataset() {
+        openEngine(1)->bulkLoad(points);
+    }
+};
+
+inline ThreadPoolConfig poolConfig(PoolMode mode, size_t threads) {
+    ThreadPoolConfig config;
+    config.mode = mode;
+    config.min_threads = threads;
+    config.max_threads = threads;
+    config.max_tasks = 65536;
+    return config;
+}
+
+// 把直方图的百分位写入计数器（单位微秒）
+template <typename Histogram>
+void reportPercentiles(benchmark::State& state, const std::string& prefix, const Histogram& histogram) {
+    state.counters[prefix + "_p50_us"] = static_cast<double>(histogram.percentile(0.50)) / 1000.0;
+    state.counters[prefix + "_p99_us"] = static_cast<double>(histogram.percentile(0.99)) / 1000.0;
+    state.counters[prefix + "_max_us"] = static_cast<double>(histogram.max) / 1000.0;
+}
+
+} // namespace bench
+
+#endif
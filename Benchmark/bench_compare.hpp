@@ -0,0 +1,240 @@
+#ifndef BENCH_COMPARE_H
+#define BENCH_COMPARE_H
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace bench {
+
+// 一条基准结果：统一换算为纳秒
+struct BenchmarkResult {
+    double real_ns = 0.0;
+    double cpu_ns = 0.0;
+};
+
+using BenchmarkResults = std::map<std::string, BenchmarkResult>;
+
+/**
+ * Google Benchmark JSON 输出（--benchmark_out_format=json）的读取器
+ *
+ * 只解析比较需要的字段：benchmarks 数组中每项的 name/run_name、run_type、aggregate_name、
+ * real_time、cpu_time 与 time_unit。带重复次数运行时取 median 聚合结果，否则取单次结果
+ */
+class BenchmarkJsonReader {
+public:
+    static BenchmarkResults load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            throw std::runtime_error("无法打开基准结果文件: " + path);
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        BenchmarkJsonReader reader(buffer.str());
+        reader.parseRoot();
+        return reader.results_;
+    }
+
+private:
+    explicit BenchmarkJsonReader(std::string text) : text_(std::move(text)) {}
+
+    struct Entry {
+        std::string name;
+        std::string run_name;
+        std::string run_type;
+        std::string aggregate_name;
+        std::string time_unit = "ns";
+        double real_time = NAN;
+        double cpu_time = NAN;
+    };
+
+    void parseRoot() {
+        expect('{');
+        if (consume('}')) return;
+        do {
+            const std::string key = parseString();
+            expect(':');
+            if (key == "benchmarks") {
+                parseBenchmarks();
+            } else {
+                skipValue();
+            }
+        } while (consume(','));
+        expect('}');
+    }
+
+    void parseBenchmarks() {
+        std::map<std::string, bool> has_median;
+        expect('[');
+        if (consume(']')) return;
+        do {
+            const Entry entry = parseEntry();
+            const std::string& key = entry.run_name.empty() ? entry.name : entry.run_name;
+            if (std::isnan(entry.real_time) || key.empty()) continue;
+
+            const bool median = entry.run_type == "aggregate" && entry.aggregate_name == "median";
+            if (entry.run_type == "aggregate" && !median) continue;
+            if (!median && has_median[key]) continue;
+            if (median) has_median[key] = true;
+
+            const double scale = unitScale(entry.time_unit);
+            results_[key] = BenchmarkResult{ entry.real_time * scale, entry.cpu_time * scale };
+        } while (consume(','));
+        expect(']');
+    }
+
+    Entry parseEntry() {
+        Entry entry;
+        expect('{');
+        if (consume('}')) return entry;
+        do {
+            const std::string key = parseString();
+            expect(':');
+            if (key == "name") entry.name = parseString();
+            else if (key == "run_name") entry.run_name = parseString();
+            else if (key == "run_type") entry.run_type = parseString();
+            else if (key == "aggregate_name") entry.aggregate_name = parseString();
+            else if (key == "time_unit") entry.time_unit = parseString();
+            else if (key == "real_time") entry.real_time = parseNumber();
+            else if (key == "cpu_time") entry.cpu_time = parseNumber();
+            else skipValue();
+        } while (consume(','));
+        expect('}');
+        return entry;
+    }
+
+    static double unitScale(const std::string& unit) {
+        if (unit == "us") return 1e3;
+        if (unit == "ms") return 1e6;
+        if (unit == "s") return 1e9;
+        return 1.0;
+    }
+
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            throw std::runtime_error(std::string("基准结果 JSON 格式错误：位置 ") + std::to_string(pos_) + " 处应为 '" + c + "'");
+        }
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c == '\\' && pos_ < text_.size()) {
+                c = text_[pos_++];
+                if (c == 'n') c = '\n';
+                else if (c == 't') c = '\t';
+                else if (c == 'u') {  // 基准名称只含 ASCII，\uXXXX 原样跳过
+                    pos_ = std::min(pos_ + 4, text_.size());
+                    continue;
+                }
+            }
+            out.push_back(c);
+        }
+        expect('"');
+        return out;
+    }
+
+    double parseNumber() {
+        skipSpace();
+        const char* begin = text_.c_str() + pos_;
+        char* end = nullptr;
+        const double value = std::strtod(begin, &end);
+        if (end == begin) {
+            skipValue();  // 如 "NaN" 之类的非数值
+            return NAN;
+        }
+        pos_ += static_cast<size_t>(end - begin);
+        return value;
+    }
+
+    void skipValue() {
+        skipSpace();
+        if (pos_ >= text_.size()) {
+            throw std::runtime_error("基准结果 JSON 意外结束");
+        }
+        const char c = text_[pos_];
+        if (c == '"') {
+            parseString();
+        } else if (c == '{' || c == '[') {
+            const char close = c == '{' ? '}' : ']';
+            ++pos_;
+            if (consume(close)) return;
+            do {
+                if (c == '{') {
+                    parseString();
+                    expect(':');
+                }
+                skipValue();
+            } while (consume(','));
+            expect(close);
+        } else {
+            while (pos_ < text_.size() && text_[pos_] != ',' && text_[pos_] != '}' && text_[pos_] != ']') ++pos_;
+        }
+    }
+
+    std::string text_;
+    size_t pos_ = 0;
+    BenchmarkResults results_;
+};
+
+/**
+ * 按名称比较两组结果，打印每项的变化
+ * @param threshold 实测时间比基线慢超过该比例（如 0.1 即 10%）判为回归
+ * @return 回归的项数；只出现在一侧的基准只提示，不计入回归
+ */
+inline size_t compareResults(const BenchmarkResults& baseline, const BenchmarkResults& current,
+                             double threshold, std::ostream& out = std::cout) {
+    size_t regressions = 0;
+    out << std::left << std::setw(72) << "基准" << std::right << std::setw(14) << "基线(ns)"
+        << std::setw(14) << "当前(ns)" << std::setw(10) << "变化" << '\n';
+    for (const auto& [name, now] : current) {
+        auto it = baseline.find(name);
+        if (it == baseline.end()) {
+            out << std::left << std::setw(72) << name << std::right << std::setw(14) << "-"
+                << std::setw(14) << std::fixed << std::setprecision(1) << now.real_ns << "    新增\n";
+            continue;
+        }
+        const double before = it->second.real_ns;
+        const double change = before > 0.0 ? now.real_ns / before - 1.0 : 0.0;
+        const bool regressed = change > threshold;
+        regressions += regressed;
+        out << std::left << std::setw(72) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(14) << before << std::setw(14) << now.real_ns
+            << std::setw(9) << std::showpos << change * 100.0 << std::noshowpos << '%'
+            << (regressed ? "  回归" : "") << '\n';
+    }
+    for (const auto& [name, before] : baseline) {
+        if (!current.count(name)) {
+            out << std::left << std::setw(72) << name << std::right << "    本次未运行\n";
+        }
+    }
+    out << (regressions ? "发现 " + std::to_string(regressions) + " 项回归" : std::string("无回归"))
+        << "（阈值 " << threshold * 100.0 << "%）" << std::endl;
+    return regressions;
+}
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,51 @@
+// bench_connectionpool.cpp
+#include "bench_common.hpp"
+
+namespace {
+
+// 各线程共享的连接池：Setup 中创建，Teardown 中销毁
+std::unique_ptr<DBConnectionPool> g_pool;
+
+void createPool(const benchmark::State& state) {
+    DBPoolConfig config;
+    config.max_connections = static_cast<size_t>(state.range(0));
+    config.initial_size = config.max_connections;
+    config.connection_timeout = std::chrono::seconds(30);
+    g_pool = std::make_unique<DBConnectionPool>(config, bench::mockFactory());
+}
+
+void destroyPool(const benchmark::State&) {
+    g_pool.reset();
+}
+
+// 竞争下取出、归还连接：参数 { 最大连接数, 每次持有连接的时长（微秒） }，线程数多于连接数时出现等待
+void BM_ConnectionCheckout(benchmark::State& state) {
+    const std::chrono::microseconds hold(state.range(1));
+    for (auto _ : state) {
+        auto conn = g_pool->getConnection();
+        if (!conn) {
+            state.SkipWithError("获取连接超时");
+            break;
+        }
+        if (hold.count() > 0) {
+            bench::spinFor(hold);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        // 所有线程结束计时循环后才会到达这里，统计已完整
+        const DBPoolStats stats = g_pool->stats();
+        bench::reportPercentiles(state, "wait", stats.wait);
+        state.counters["timeouts"] = static_cast<double>(stats.timeouts);
+        state.counters["steals"] = static_cast<double>(stats.steals);
+    }
+}
+BENCHMARK(BM_ConnectionCheckout)
+    ->Setup(createPool)
+    ->Teardown(destroyPool)
+    ->ArgsProduct({ { 4, 16 }, { 0, 20 } })
+    ->ArgNames({ "connections", "hold_us" })
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+} // namespace
@@ -0,0 +1,97 @@
+// bench_simulation_tick.cpp
+#include "bench_common.hpp"
+#include <latch>
+
+namespace {
+
+// 仿真节点：在测试区域内随机游走，每步读取所在位置的地形
+struct Agent {
+    double lon = 0.0;
+    double lat = 0.0;
+    MovementCursor cursor;
+    std::mt19937 gen;
+    double elevation = 0.0;
+    size_t sensed = 0;
+};
+
+constexpr double kStep = 0.002;              // 每步最大位移（度）
+constexpr double kSenseSide = 0.01;          // 感知范围边长（度，约 1km）
+constexpr size_t kSenseEvery = 16;           // 每 16 个节点中有一个执行范围感知
+constexpr size_t kAgentsPerWrite = 64;       // 每次写库的节点数
+constexpr auto kWriteLatency = std::chrono::microseconds(20);  // 模拟一次批量写库的耗时
+
+/**
+ * 一个仿真周期串联三个子系统：
+ * 1. 线程池 parallel_for 推进全部节点：移动、读取地形点（带 MovementCursor 预取），部分节点做范围感知
+ * 2. 按 kAgentsPerWrite 分批投递写库任务，每个任务从连接池取连接并模拟一次批量写入
+ * 参数：{ 节点数, 线程池线程数 }
+ */
+void BM_SimulationTick(benchmark::State& state) {
+    bench::TerrainDataset& dataset = bench::TerrainDataset::instance();
+    const size_t agent_count = static_cast<size_t>(state.range(0));
+    const size_t threads = static_cast<size_t>(state.range(1));
+
+    ThreadPoolConfig pool_config = bench::poolConfig(PoolMode::FIXED, threads);
+    pool_config.latency_histograms = true;
+    AdvancedThreadPool pool(pool_config);
+
+    DBPoolConfig db_config;
+    db_config.max_connections = std::max<size_t>(threads / 2, 1);
+    db_config.initial_size = db_config.max_connections;
+    DBConnectionPool connections(db_config, bench::mockFactory());
+
+    TerrainStorageConfig terrain_config;
+    terrain_config.loader_pool = &pool;
+    auto engine = dataset.openEngine(4096, terrain_config);
+
+    std::vector<Agent> agents(agent_count);
+    for (size_t i = 0; i < agent_count; ++i) {
+        agents[i].gen.seed(static_cast<uint32_t>(i));
+        agents[i].lon = std::get<0>(dataset.points[i]);
+        agents[i].lat = std::get<1>(dataset.points[i]);
+    }
+
+    auto step = [&](size_t i) {
+        Agent& agent = agents[i];
+        std::uniform_real_distribution<double> move(-kStep, kStep);
+        agent.lon = std::clamp(agent.lon + move(agent.gen), bench::kMinLon, bench::kMaxLon - kSenseSide);
+        agent.lat = std::clamp(agent.lat + move(agent.gen), bench::kMinLat, bench::kMaxLat - kSenseSide);
+
+        std::string value;
+        if (engine->get(agent.lon, agent.lat, value, agent.cursor)) {
+            agent.elevation = std::stod(value);
+        }
+        if (i % kSenseEvery == 0) {
+            agent.sensed = 0;
+            engine->rangeQuery(agent.lon, agent.lat, agent.lon + kSenseSide, agent.lat + kSenseSide,
+                               [&](double, double, const std::string&) { ++agent.sensed; });
+        }
+    };
+
+    const size_t writes = (agent_count + kAgentsPerWrite - 1) / kAgentsPerWrite;
+    for (auto _ : state) {
+        pool.parallel_for(size_t(0), agent_count, 32, step).get();
+
+        std::latch persisted(static_cast<std::ptrdiff_t>(writes));
+        for (size_t w = 0; w < writes; ++w) {
+            pool.post(TaskPriority::LOW, [&connections, &persisted] {
+                if (auto conn = connections.getConnection()) {
+                    bench::spinFor(kWriteLatency);
+                }
+                persisted.count_down();
+            });
+        }
+        persisted.wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(agent_count));
+    bench::reportPercentiles(state, "conn_wait", connections.stats().wait);
+    bench::reportPercentiles(state, "queue_wait", pool.stats()[TaskPriority::NORMAL].queue_wait);
+}
+BENCHMARK(BM_SimulationTick)
+    ->ArgsProduct({ { 256, 2048 }, { 4, 8 } })
+    ->ArgNames({ "agents", "threads" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
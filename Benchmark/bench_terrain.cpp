@@ -0,0 +1,140 @@
+// bench_terrain.cpp
+#include "bench_common.hpp"
+
+namespace {
+
+using bench::TerrainDataset;
+
+// 缓存命中：在前 N 个点上循环读取，计时前已预热并确认全部命中
+void BM_TerrainGetHit(benchmark::State& state) {
+    TerrainDataset& dataset = TerrainDataset::instance();
+    const size_t working_set = static_cast<size_t>(state.range(0));
+    // 缓存容量在分片间均分：留出两倍余量与每个分片一个网格，哈希不均时工作集也不会被淘汰
+    auto engine = dataset.openEngine(2 * working_set + TerrainStorageConfig().cache_shards);
+    std::string value;
+    auto warm = [&] {
+        for (size_t i = 0; i < working_set; ++i) {
+            engine->get(std::get<0>(dataset.points[i]), std::get<1>(dataset.points[i]), value);
+        }
+        return engine->getLoadStats().loads;
+    };
+    const size_t loads = warm();
+    if (warm() != loads) {
+        state.SkipWithError("预热后仍有网格未命中缓存");
+        return;
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& point = dataset.points[i];
+        benchmark::DoNotOptimize(engine->get(std::get<0>(point), std::get<1>(point), value));
+        i = i + 1 == working_set ? 0 : i + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["misses"] = static_cast<double>(engine->getLoadStats().loads - loads);
+}
+BENCHMARK(BM_TerrainGetHit)->Arg(64)->Arg(1024)->ArgName("points");
+
+// 缓存未命中：缓存只容纳一个网格，随机点几乎每次都要从 LevelDB 读取整个网格
+void BM_TerrainGetMiss(benchmark::State& state) {
+    TerrainDataset& dataset = TerrainDataset::instance();
+    auto engine = dataset.openEngine(1);
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> pick(0, dataset.points.size() - 1);
+
+    std::string value;
+    for (auto _ : state) {
+        const auto& point = dataset.points[pick(gen)];
+        benchmark::DoNotOptimize(engine->get(std::get<0>(point), std::get<1>(point), value));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TerrainGetMiss);
+
+// 范围查询：参数为查询框边长（km），查询框在测试区域内随机平移，不使用网格缓存
+void BM_TerrainRangeQuery(benchmark::State& state) {
+    TerrainDataset& dataset = TerrainDataset::instance();
+    auto engine = dataset.openEngine(1);
+    const double side = static_cast<double>(state.range(0)) * bench::kDegreesPerKm;
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> lon_dist(bench::kMinLon, bench::kMaxLon - side);
+    std::uniform_real_distribution<double> lat_dist(bench::kMinLat, bench::kMaxLat - side);
+
+    size_t points = 0;
+    for (auto _ : state) {
+        const double lon = lon_dist(gen);
+        const double lat = lat_dist(gen);
+        engine->rangeQuery(lon, lat, lon + side, lat + side, [&](double, double, const std::string&) { ++points; });
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(points));
+    state.counters["points_per_query"] = static_cast<double>(points) / static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_TerrainRangeQuery)->Arg(1)->Arg(10)->Arg(50)->Arg(100)->ArgName("box_km")->Unit(benchmark::kMicrosecond);
+
+// 并行范围查询：参数 { 查询框边长（km）, 线程池线程数 }
+void BM_TerrainParallelRangeQuery(benchmark::State& state) {
+    TerrainDataset& dataset = TerrainDataset::instance();
+    AdvancedThreadPool pool(bench::poolConfig(PoolMode::FIXED, static_cast<size_t>(state.range(1))));
+    auto engine = dataset.openEngine(1);
+    const double side = static_cast<double>(state.range(0)) * bench::kDegreesPerKm;
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> lon_dist(bench::kMinLon, bench::kMaxLon - side);
+    std::uniform_real_distribution<double> lat_dist(bench::kMinLat, bench::kMaxLat - side);
+
+    ParallelQueryOptions options;
+    options.pool = &pool;
+    options.max_in_flight = static_cast<size_t>(state.range(1)) * 2;
+    size_t points = 0;
+    for (auto _ : state) {
+        const double lon = lon_dist(gen);
+        const double lat = lat_dist(gen);
+        engine->parallelRangeQuery(lon, lat, lon + side, lat + side, [&](const TerrainPointChunk& chunk) {
+            points += chunk.size();
+            return true;
+        }, options);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(points));
+}
+BENCHMARK(BM_TerrainParallelRangeQuery)
+    ->ArgsProduct({ { 10, 100 }, { 1, 4, 8 } })
+    ->ArgNames({ "box_km", "threads" })
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// 批量导入：参数 { 点数, 存放方式（0 逐点, 1 网格块）, 是否用 bulkLoad }，每轮导入到新建的空库
+void BM_TerrainIngest(benchmark::State& state) {
+    const bench::PointData data = bench::generatePoints(static_cast<size_t>(state.range(0)), 3);
+    AdvancedThreadPool pool(bench::poolConfig(PoolMode::FIXED, 4));
+    TerrainStorageConfig config;
+    config.storage_layout = state.range(1) ? StorageLayout::GRID_TILES : StorageLayout::POINT_KEYS;
+    config.background_merge = false;
+    config.worker_pool = &pool;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto database = std::make_unique<bench::TempDatabase>("ingest");
+        auto engine = std::make_unique<TerrainStorageEngine>(database->db(), bench::kMinLon, bench::kMinLat,
+                                                             bench::kMaxLon, bench::kMaxLat, bench::kGridSize,
+                                                             100, config);
+        state.ResumeTiming();
+
+        if (state.range(2)) {
+            engine->bulkLoad(data, false);
+        } else {
+            engine->batchPut(data);
+        }
+
+        state.PauseTiming();
+        engine.reset();
+        database.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TerrainIngest)
+    ->ArgsProduct({ { 10000, 100000 }, { 0, 1 }, { 0, 1 } })
+    ->ArgNames({ "points", "tiles", "bulk" })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
@@ -0,0 +1,70 @@
+// bench_threadpool.cpp
+#include "bench_common.hpp"
+#include <latch>
+
+namespace {
+
+constexpr int64_t kTasksPerIteration = 1024;
+
+const PoolMode kModes[] = { PoolMode::FIXED, PoolMode::CACHED, PoolMode::WORK_STEALING };
+const char* const kModeNames[] = { "FIXED", "CACHED", "WORK_STEALING" };
+
+// 参数：{ 模式下标, 线程数 }
+void poolArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t mode = 0; mode < 3; ++mode) {
+        for (int64_t threads : { 1, 2, 4, 8, 16 }) {
+            b->Args({ mode, threads });
+        }
+    }
+    b->ArgNames({ "mode", "threads" })->UseRealTime();
+}
+
+// submit() 吞吐：每轮提交一批小任务并等待全部 future
+void BM_PoolSubmit(benchmark::State& state) {
+    AdvancedThreadPool pool(bench::poolConfig(kModes[state.range(0)], static_cast<size_t>(state.range(1))));
+    std::vector<std::future<int64_t>> futures;
+    futures.reserve(kTasksPerIteration);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < kTasksPerIteration; ++i) {
+            futures.push_back(pool.submit([i] { return i * i; }));
+        }
+        for (auto& future : futures) {
+            benchmark::DoNotOptimize(future.get());
+        }
+        futures.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * kTasksPerIteration);
+    state.SetLabel(kModeNames[state.range(0)]);
+}
+BENCHMARK(BM_PoolSubmit)->Apply(poolArgs);
+
+// post() 吞吐：无 future，用 latch 等待一批任务完成
+void BM_PoolPost(benchmark::State& state) {
+    AdvancedThreadPool pool(bench::poolConfig(kModes[state.range(0)], static_cast<size_t>(state.range(1))));
+    for (auto _ : state) {
+        std::latch done(kTasksPerIteration);
+        for (int64_t i = 0; i < kTasksPerIteration; ++i) {
+            pool.post([&done] { done.count_down(); });
+        }
+        done.wait();
+    }
+    state.SetItemsProcessed(state.iterations() * kTasksPerIteration);
+    state.SetLabel(kModeNames[state.range(0)]);
+}
+BENCHMARK(BM_PoolPost)->Apply(poolArgs);
+
+// 单任务往返时延：每轮提交一个任务并等待结果，同时报告线程池统计的排队时延分布
+void BM_PoolRoundTrip(benchmark::State& state) {
+    ThreadPoolConfig config = bench::poolConfig(kModes[state.range(0)], static_cast<size_t>(state.range(1)));
+    config.latency_histograms = true;
+    AdvancedThreadPool pool(config);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pool.submit([] { return 1; }).get());
+    }
+    const ThreadPoolStats stats = pool.stats();
+    bench::reportPercentiles(state, "queue_wait", stats[TaskPriority::NORMAL].queue_wait);
+    state.SetLabel(kModeNames[state.range(0)]);
+}
+BENCHMARK(BM_PoolRoundTrip)->Apply(poolArgs);
+
+} // namespace
@@ -0,0 +1,91 @@
+/*--------仿真平台端到端基准：线程池、连接池、地形存储引擎及三者组合的仿真周期--------*/
+
+// 运行：./SimulationBenchmark --benchmark_out=result.json --benchmark_out_format=json
+// 回归比较：./SimulationBenchmark --baseline=baseline.json [--regression_threshold=0.1] [Google Benchmark 参数]
+// 只比较已有结果：./SimulationBenchmark --compare=baseline.json,result.json
+
+#include "bench_compare.hpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+// 本程序自己的参数，其余参数原样交给 Google Benchmark
+struct CompareOptions {
+    std::string baseline;            // 运行后与该基线比较
+    std::string compare_current;     // 不运行，直接比较 baseline 与该文件
+    double threshold = 0.10;         // 回归阈值（比例）
+    std::string output;              // --benchmark_out 指定的结果文件
+};
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::vector<char*> parseArgs(int argc, char** argv, CompareOptions& options) {
+    std::vector<char*> rest{ argv[0] };
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (startsWith(arg, "--baseline=")) {
+            options.baseline = arg.substr(11);
+        } else if (startsWith(arg, "--regression_threshold=")) {
+            options.threshold = std::atof(arg.c_str() + 23);
+        } else if (startsWith(arg, "--compare=")) {
+            const std::string files = arg.substr(10);
+            const size_t comma = files.find(',');
+            options.baseline = files.substr(0, comma);
+            options.compare_current = comma == std::string::npos ? "" : files.substr(comma + 1);
+        } else {
+            if (startsWith(arg, "--benchmark_out=")) {
+                options.output = arg.substr(16);
+            }
+            rest.push_back(argv[i]);
+        }
+    }
+    return rest;
+}
+
+// 读取并比较两个结果文件；返回进程退出码：0 无回归，1 有回归，2 读取失败
+int compareFiles(const std::string& baseline, const std::string& current, double threshold) {
+    try {
+        const size_t regressions = bench::compareResults(bench::BenchmarkJsonReader::load(baseline),
+                                                         bench::BenchmarkJsonReader::load(current), threshold);
+        return regressions ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    CompareOptions options;
+    std::vector<char*> args = parseArgs(argc, argv, options);
+
+    if (!options.compare_current.empty()) {
+        return compareFiles(options.baseline, options.compare_current, options.threshold);
+    }
+
+    // 回归比较需要本次结果的 JSON 文件，未指定时写入默认文件
+    std::string default_out = "--benchmark_out=sim_benchmark.json";
+    std::string default_format = "--benchmark_out_format=json";
+    if (!options.baseline.empty() && options.output.empty()) {
+        options.output = "sim_benchmark.json";
+        args.push_back(default_out.data());
+        args.push_back(default_format.data());
+    }
+
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 2;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    if (!options.baseline.empty()) {
+        return compareFiles(options.baseline, options.output, options.threshold);
+    }
+    return 0;
+}
@@ -0,0 +1,359 @@
+
+/*--------此为基于连接池与线程池的异步查询引擎，使用时包含该头文件即可，切记需要使用支持C++20及以上的编译器--------*/
+
+#ifndef ASYNCQUERYENGINE_H
+#define ASYNCQUERYENGINE_H
+
+#include "dbconnectionpool.hpp"
+#include "../ThreadPool/advancedthreadpool.hpp"
+
+#include <future>
+#include <deque>
+
+#ifdef MYSQL_WAIT_READ
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+/**
+ * 异步查询引擎：调用线程（通常是线程池工作线程）提交 SQL 后立即返回，
+ * 查询由引擎自己的 I/O 线程执行，完成后把回调投递回 AdvancedThreadPool
+ *
+ * - 客户端库提供 MariaDB 非阻塞接口（MYSQL_WAIT_READ 已定义）时，单个 I/O 线程用 poll() 同时驱动所有进行中的查询
+ * - 否则退化为 io_threads 个 I/O 线程执行阻塞查询，线程池工作线程仍不会被数据库往返占用；
+ *   同时执行的查询数不超过 min(io_threads, 连接池最大连接数)，请求先排队，I/O 线程空闲时才取连接，
+ *   排队的请求不占用连接，其他 getConnection() 调用方不会被饿死
+ *
+ * 连接通过 DBConnectionPool::asyncGetConnection() 获取（非阻塞模式下等待连接期间不占用任何线程）；
+ * 引擎须先于连接池和线程池销毁，析构时等待所有已提交的查询完成
+ *
+ *   AsyncQueryEngine engine(db, pool);
+ *   engine.query("SELECT ...", [](QueryResult r) { ... });   // 回调在线程池上执行
+ *   auto future = engine.query("UPDATE ...");
+ */
+
+// 异步查询引擎配置参数
+struct AsyncQueryEngineConfig {
+    std::chrono::milliseconds acquire_timeout = std::chrono::seconds(5); // 获取连接超时时间
+    size_t io_threads = 0;                                               // 阻塞模式下的I/O线程数，0 表示等于连接池最大连接数（非阻塞模式固定为1）
+};
+
+class AsyncQueryEngine {
+public:
+    // 完成回调：在线程池上执行，线程池拒绝时在I/O线程上执行
+    using Callback = std::function<void(QueryResult)>;
+
+    AsyncQueryEngine(const AsyncQueryEngine&) = delete;
+    AsyncQueryEngine& operator=(const AsyncQueryEngine&) = delete;
+
+    /**
+     * @brief 构造函数
+     * @param db 连接池（连接须为 MySQLConnection）
+     * @param executor 执行完成回调的线程池
+     * @param config 引擎配置
+     */
+    AsyncQueryEngine(DBConnectionPool& db, AdvancedThreadPool& executor,
+                     AsyncQueryEngineConfig config = AsyncQueryEngineConfig())
+        : db_(db), executor_(executor), config_(config) {
+#ifdef MYSQL_WAIT_READ
+        if (pipe(wake_pipe_) != 0) {
+            throw std::runtime_error("AsyncQueryEngine: pipe failed");
+        }
+        fcntl(wake_pipe_[0], F_SETFL, O_NONBLOCK);
+        fcntl(wake_pipe_[1], F_SETFL, O_NONBLOCK);
+        io_threads_.emplace_back([this] { eventLoop(); });
+#else
+        const size_t n = std::max<size_t>(config_.io_threads ? config_.io_threads : db_.maxConnections(), 1);
+        for (size_t i = 0; i < n; ++i) {
+            io_threads_.emplace_back([this] { blockingLoop(); });
+        }
+#endif
+    }
+
+    /**
+     * @brief 析构函数：等待所有已提交的查询完成后停止I/O线程
+     */
+    ~AsyncQueryEngine() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            drained_cv_.wait(lock, [this] { return outstanding_ == 0; });
+            running_ = false;
+        }
+        wake();
+        for (auto& t : io_threads_) {
+            t.join();
+        }
+#ifdef MYSQL_WAIT_READ
+        ::close(wake_pipe_[0]);
+        ::close(wake_pipe_[1]);
+#endif
+    }
+
+    /**
+     * @brief 异步执行查询
+     * @param sql SQL语句
+     * @param callback 完成回调（恰好调用一次）；获取连接超时时 result.ok 为 false
+     * @param priority 投递回调时使用的任务优先级
+     */
+    void query(std::string sql, Callback callback, TaskPriority priority = TaskPriority::NORMAL) {
+        auto request = std::make_shared<Request>();
+        request->sql = std::move(sql);
+        request->callback = std::move(callback);
+        request->priority = priority;
+#ifndef MYSQL_WAIT_READ
+        // 阻塞模式：先排队，由空闲的I/O线程获取连接后执行
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++outstanding_;
+            ready_.push_back(std::move(request));
+        }
+        wake();
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++outstanding_;
+        }
+
+        // 连接可能立即获得（当前线程回调），也可能在其他线程归还连接时移交
+        db_.asyncGetConnection([this, request](DBConnectionPool::ConnectionPtr conn) {
+            if (!conn) {
+                request->result.error = CR_CONNECTION_ERROR;
+                request->result.message = "acquire connection timeout";
+                complete(request);
+                return;
+            }
+            request->conn = std::move(conn);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_.push_back(request);
+            }
+            wake();
+        }, config_.acquire_timeout);
+#endif
+    }
+
+    /**
+     * @brief 异步执行查询，返回 future
+     */
+    std::future<QueryResult> query(std::string sql, TaskPriority priority = TaskPriority::NORMAL) {
+        auto promise = std::make_shared<std::promise<QueryResult>>();
+        auto future = promise->get_future();
+        query(std::move(sql), [promise](QueryResult result) {
+            promise->set_value(std::move(result));
+        }, priority);
+        return future;
+    }
+
+    /**
+     * @brief 已提交但尚未完成的查询数（含等待连接的）
+     */
+    size_t outstanding() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return outstanding_;
+    }
+
+private:
+    // 一次查询请求
+    struct Request {
+        std::string sql;
+        Callback callback;
+        TaskPriority priority = TaskPriority::NORMAL;
+        DBConnectionPool::ConnectionPtr conn;
+        QueryResult result;
+    };
+    using RequestPtr = std::shared_ptr<Request>;
+
+    // 连接须为 MySQLConnection
+    static MySQLConnection* mysqlOf(const Request& request) {
+        return dynamic_cast<MySQLConnection*>(request.conn.get());
+    }
+
+    static void rejectNonMySQL(Request& request) {
+        request.result.error = CR_CONNECTION_ERROR;
+        request.result.message = "connection is not a MySQLConnection";
+    }
+
+    /**
+     * @brief 归还连接并把回调投递到线程池
+     *        先归还再投递：归还可能直接把连接移交给下一个等待中的请求
+     */
+    void complete(const RequestPtr& request) {
+        request->conn.reset();
+
+        // 队列满或线程池已关闭时在当前线程执行，I/O线程不阻塞在投递上
+        const SubmitStatus status = executor_.try_post(request->priority, [request] {
+            request->callback(std::move(request->result));
+        });
+        if (status != SubmitStatus::ACCEPTED && status != SubmitStatus::RAN_IN_CALLER) {
+            request->callback(std::move(request->result));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--outstanding_ == 0) {
+            drained_cv_.notify_all();
+        }
+    }
+
+#ifdef MYSQL_WAIT_READ
+    // 唤醒阻塞在 poll() 上的事件循环
+    void wake() {
+        const char byte = 1;
+        [[maybe_unused]] auto n = ::write(wake_pipe_[1], &byte, 1);
+    }
+
+    // MariaDB 等待事件与 poll 事件互相转换
+    static short toPollEvents(int status) {
+        short events = 0;
+        if (status & MYSQL_WAIT_READ) events |= POLLIN;
+        if (status & MYSQL_WAIT_WRITE) events |= POLLOUT;
+        if (status & MYSQL_WAIT_EXCEPT) events |= POLLPRI;
+        return events;
+    }
+
+    static int fromPollEvents(short revents) {
+        int status = 0;
+        if (revents & (POLLIN | POLLERR | POLLHUP)) status |= MYSQL_WAIT_READ;
+        if (revents & POLLOUT) status |= MYSQL_WAIT_WRITE;
+        if (revents & POLLPRI) status |= MYSQL_WAIT_EXCEPT;
+        return status;
+    }
+
+    /**
+     * @brief 事件循环：启动新就绪的查询，poll 所有进行中查询的套接字，按事件推进状态机
+     */
+    void eventLoop() {
+        struct Active {
+            RequestPtr request;
+            MySQLConnection* mysql;                          // request->conn 对应的 MySQL 连接（非空）
+            int status;                                      // 正在等待的事件
+            std::chrono::steady_clock::time_point deadline;  // status 含 MYSQL_WAIT_TIMEOUT 时有效
+        };
+        std::vector<Active> active;
+        std::vector<pollfd> fds;
+
+        // 推进一次状态机：完成的查询归还连接并投递回调
+        auto advance = [this, &active](RequestPtr request, MySQLConnection* mysql, int status) {
+            if (status == 0) {
+                complete(request);
+                return;
+            }
+            auto deadline = std::chrono::steady_clock::time_point::max();
+            if (status & MYSQL_WAIT_TIMEOUT) {
+                deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(mysql->waitTimeoutMs());
+            }
+            active.push_back({ std::move(request), mysql, status, deadline });
+        };
+
+        while (true) {
+            std::deque<RequestPtr> started;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!running_ && ready_.empty() && active.empty()) break;
+                started.swap(ready_);
+            }
+            for (auto& request : started) {
+                MySQLConnection* mysql = mysqlOf(*request);
+                if (!mysql) {
+                    rejectNonMySQL(*request);
+                    complete(request);
+                    continue;
+                }
+                advance(request, mysql, mysql->queryStart(std::move(request->sql), request->result));
+            }
+
+            // fds[0] 为唤醒管道，fds[i + 1] 对应 active[i]
+            const auto now = std::chrono::steady_clock::now();
+            auto earliest = std::chrono::steady_clock::time_point::max();
+            fds.assign(1, pollfd{ wake_pipe_[0], POLLIN, 0 });
+            for (const auto& a : active) {
+                fds.push_back(pollfd{ a.mysql->socket(), toPollEvents(a.status), 0 });
+                earliest = std::min(earliest, a.deadline);
+            }
+            int timeout_ms = -1;
+            if (earliest != std::chrono::steady_clock::time_point::max()) {
+                timeout_ms = static_cast<int>(std::max<long long>(0,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(earliest - now).count()));
+            }
+            ::poll(fds.data(), fds.size(), timeout_ms);
+
+            if (fds[0].revents & POLLIN) {
+                char buf[64];
+                while (::read(wake_pipe_[0], buf, sizeof(buf)) > 0) {}
+            }
+
+            std::vector<Active> waiting;
+            waiting.swap(active);
+            const auto after = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < waiting.size(); ++i) {
+                int ready = fromPollEvents(fds[i + 1].revents);
+                if (!ready && after >= waiting[i].deadline) {
+                    ready = MYSQL_WAIT_TIMEOUT;
+                }
+                if (!ready) {
+                    active.push_back(std::move(waiting[i]));
+                    continue;
+                }
+                auto& request = waiting[i].request;
+                MySQLConnection* mysql = waiting[i].mysql;
+                advance(request, mysql, mysql->queryContinue(ready, request->result));
+            }
+        }
+    }
+
+    int wake_pipe_[2] = { -1, -1 };  // 唤醒事件循环的管道
+#else
+    void wake() { ready_cv_.notify_all(); }
+
+    /**
+     * @brief 阻塞模式的I/O线程：依次取出排队的请求，获取连接后执行
+     *        连接只在I/O线程空闲时获取，执行完立即归还，不会被排队的请求占住
+     */
+    void blockingLoop() {
+        while (true) {
+            RequestPtr request;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_cv_.wait(lock, [this] { return !running_ || !ready_.empty(); });
+                if (ready_.empty()) return;  // 已停止且没有待执行的请求
+                request = std::move(ready_.front());
+                ready_.pop_front();
+            }
+
+            // 经 asyncGetConnection 获取以使用 acquire_timeout；回调可能在归还连接的线程上执行
+            auto acquired = std::make_shared<std::promise<DBConnectionPool::ConnectionPtr>>();
+            auto future = acquired->get_future();
+            db_.asyncGetConnection([acquired](DBConnectionPool::ConnectionPtr conn) {
+                acquired->set_value(std::move(conn));
+            }, config_.acquire_timeout);
+            request->conn = future.get();
+
+            if (!request->conn) {
+                request->result.error = CR_CONNECTION_ERROR;
+                request->result.message = "acquire connection timeout";
+            } else if (MySQLConnection* mysql = mysqlOf(*request)) {
+                request->result = mysql->query(request->sql);
+            } else {
+                rejectNonMySQL(*request);
+            }
+            complete(request);
+        }
+    }
+
+    std::condition_variable ready_cv_;  // 就绪请求条件变量
+#endif
+
+    DBConnectionPool& db_;                     // 连接池
+    AdvancedThreadPool& executor_;             // 执行回调的线程池
+    const AsyncQueryEngineConfig config_;      // 引擎配置
+
+    mutable std::mutex mutex_;                 // 保护以下成员
+    std::deque<RequestPtr> ready_;             // 等待执行的请求（非阻塞模式下已获得连接，阻塞模式下尚未获取）
+    size_t outstanding_ = 0;                   // 已提交未完成的查询数
+    bool running_ = true;                      // I/O线程运行标志
+    std::condition_variable drained_cv_;       // 所有查询完成时通知析构函数
+
+    std::vector<std::thread> io_threads_;      // I/O线程
+};
+
+#endif // ASYNCQUERYENGINE_H
@@ -0,0 +1,169 @@
+
+/*--------连接池压测程序：用可配置延迟的模拟连接驱动连接池，输出吞吐量与获取连接等待时间分布--------*/
+
+// 编译：g++ -std=c++17 -O2 benchmark.cpp -lmysqlclient -pthread -o pool_benchmark
+// 运行：./pool_benchmark --threads 1,4,16,64 --connections 16 --latency-us 500 --ops 2000
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include "dbconnectionpool.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// 压测参数
+struct BenchmarkOptions {
+    vector<int> threads = { 1, 4, 16, 64 };  // 依次测试的并发线程数
+    size_t connections = 16;                 // max_connections
+    size_t shards = 0;                       // 分片数（0 为自动）
+    int latency_us = 500;                    // 每次持有连接的模拟查询耗时
+    int connect_us = 2000;                   // 模拟建立连接耗时
+    int ping_us = 100;                       // 模拟 ping 耗时
+    int ops = 2000;                          // 每线程操作数
+    bool warmup = true;                      // 构造时预热全部连接
+    ValidationPolicy validation = ValidationPolicy::IDLE_THRESHOLD;
+    milliseconds timeout = seconds(5);       // 获取连接超时
+};
+
+// 模拟连接：connect/ping 按配置休眠，模拟网络往返
+class LatencyMockConnection : public DBConn {
+public:
+    LatencyMockConnection(int connect_us, int ping_us) : connect_us_(connect_us), ping_us_(ping_us) {}
+
+    bool connect() override {
+        this_thread::sleep_for(microseconds(connect_us_));
+        return true;
+    }
+
+    bool ping() override {
+        this_thread::sleep_for(microseconds(ping_us_));
+        return true;
+    }
+
+    void reset() override {}
+    bool needsReset() const override { return false; }
+    void close() override {}
+
+private:
+    const int connect_us_;
+    const int ping_us_;
+};
+
+static vector<int> parseList(const string& text) {
+    vector<int> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(atoi(item.c_str()));
+    }
+    return values;
+}
+
+static ValidationPolicy parseValidation(const string& name) {
+    if (name == "borrow") return ValidationPolicy::ON_BORROW;
+    if (name == "background") return ValidationPolicy::BACKGROUND;
+    if (name == "none") return ValidationPolicy::NONE;
+    return ValidationPolicy::IDLE_THRESHOLD;
+}
+
+static void usage() {
+    cout << "用法: pool_benchmark [--threads 1,4,16] [--connections N] [--shards N]\n"
+            "                     [--latency-us N] [--connect-us N] [--ping-us N] [--ops N]\n"
+            "                     [--validation idle|borrow|background|none] [--timeout-ms N] [--no-warmup]\n";
+}
+
+static bool parseArgs(int argc, char** argv, BenchmarkOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        auto next = [&]() -> string { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--threads") opt.threads = parseList(next());
+        else if (arg == "--connections") opt.connections = static_cast<size_t>(atoi(next().c_str()));
+        else if (arg == "--shards") opt.shards = static_cast<size_t>(atoi(next().c_str()));
+        else if (arg == "--latency-us") opt.latency_us = atoi(next().c_str());
+        else if (arg == "--connect-us") opt.connect_us = atoi(next().c_str());
+        else if (arg == "--ping-us") opt.ping_us = atoi(next().c_str());
+        else if (arg == "--ops") opt.ops = atoi(next().c_str());
+        else if (arg == "--validation") opt.validation = parseValidation(next());
+        else if (arg == "--timeout-ms") opt.timeout = milliseconds(atoi(next().c_str()));
+        else if (arg == "--no-warmup") opt.warmup = false;
+        else {
+            usage();
+            return false;
+        }
+    }
+    return !opt.threads.empty() && opt.connections > 0;
+}
+
+// 纳秒转微秒显示
+static string us(uint64_t ns) {
+    ostringstream out;
+    out << fixed << setprecision(1) << ns / 1000.0;
+    return out.str();
+}
+
+static void runOnce(const BenchmarkOptions& opt, int thread_count) {
+    DBPoolConfig config;
+    config.max_connections = opt.connections;
+    config.shards = opt.shards;
+    config.connection_timeout = opt.timeout;
+    config.validation = opt.validation;
+    config.initial_size = opt.warmup ? opt.connections : 0;
+
+    const int connect_us = opt.connect_us;
+    const int ping_us = opt.ping_us;
+    DBConnectionPool pool(config, [connect_us, ping_us]() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<LatencyMockConnection>(connect_us, ping_us);
+    });
+
+    vector<thread> workers;
+    const auto start = steady_clock::now();
+    for (int t = 0; t < thread_count; ++t) {
+        workers.emplace_back([&pool, &opt] {
+            for (int i = 0; i < opt.ops; ++i) {
+                auto conn = pool.getConnection();
+                if (conn && opt.latency_us > 0) {
+                    this_thread::sleep_for(microseconds(opt.latency_us));  // 模拟查询
+                }
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    const double seconds = duration<double>(steady_clock::now() - start).count();
+
+    const DBPoolStats stats = pool.stats();
+    cout << setw(8) << thread_count
+         << setw(14) << fixed << setprecision(0) << stats.acquired / seconds
+         << setw(12) << us(stats.wait.percentile(0.50))
+         << setw(12) << us(stats.wait.percentile(0.99))
+         << setw(12) << us(stats.wait.percentile(0.999))
+         << setw(12) << us(stats.wait.max)
+         << setw(10) << stats.timeouts
+         << setw(10) << stats.created
+         << setw(10) << stats.steals
+         << endl;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        return 1;
+    }
+
+    cout << "连接数=" << opt.connections << " 查询耗时=" << opt.latency_us << "us 建连耗时=" << opt.connect_us
+         << "us ping耗时=" << opt.ping_us << "us 每线程操作数=" << opt.ops << (opt.warmup ? " 预热" : " 不预热") << endl;
+    cout << setw(8) << "线程数" << setw(14) << "吞吐(ops/s)" << setw(12) << "等待p50(us)" << setw(12) << "p99(us)"
+         << setw(12) << "p99.9(us)" << setw(12) << "max(us)" << setw(10) << "超时" << setw(10) << "新建"
+         << setw(10) << "窃取" << endl;
+    for (int threads : opt.threads) {
+        runOnce(opt, threads);
+    }
+    return 0;
+}
@@ -11,11 +11,21 @@
 #include <thread>
 #include <condition_variable>
 #include <functional>
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <list>
 #include <stdexcept>
 #include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdio>
+#include <optional>
+#include <array>
+#include <cmath>
 #include <mysql/mysql.h>
+#include <mysql/errmsg.h>
 
 // DBConn.h - 抽象数据库连接接口
 class DBConn {
@@ -31,6 +41,9 @@ public:
     // 重置连接状态（如回滚事务）
     virtual void reset() = 0;
     
+    // 归还时是否需要 reset()（开启了事务、修改了会话状态等）；默认总是需要
+    virtual bool needsReset() const { return true; }
+    
     // 关闭连接
     virtual void close() = 0;
     
@@ -41,9 +54,34 @@ public:
     auto getIdleDuration() const {
         return std::chrono::steady_clock::now() - last_used;
     }
+    
+    // 记录最近一次校验（ping）成功的时间点
+    void setLastValidated(std::chrono::steady_clock::time_point t) { last_validated = t; }
+    
+    // 距最近一次确认连接可用（归还或校验成功）的时长
+    auto getUnvalidatedDuration() const {
+        return std::chrono::steady_clock::now() - std::max(last_used, last_validated);
+    }
+    
+    // 标记连接已损坏（如查询返回连接级错误），归还时连接池直接关闭它，不再复用
+    void markBroken() { broken_ = true; }
+    bool isBroken() const { return broken_; }
 
 protected:
     std::chrono::steady_clock::time_point last_used;
+    std::chrono::steady_clock::time_point last_validated;
+    bool broken_ = false;
+};
+
+// 查询结果（文本协议）：值为 NULL 时对应 std::nullopt
+struct QueryResult {
+    bool ok = false;                 // 是否执行成功
+    unsigned error = 0;              // 错误码
+    std::string message;             // 错误信息
+    uint64_t affected_rows = 0;      // 影响行数（无结果集的语句）
+    uint64_t insert_id = 0;          // 自增ID
+    std::vector<std::string> columns;                          // 列名
+    std::vector<std::vector<std::optional<std::string>>> rows; // 结果集
 };
 
 // MySQLConnection类 - MySQL具体实现
@@ -81,13 +119,292 @@ public:
         unsigned int connect_timeout = 5; // 5秒连接超时
         mysql_options(conn_, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
         
+        // 设置自动重连选项（客户端选项，只需设置一次；兼容不同MySQL版本）
+        #ifdef MYSQL_OPT_RECONNECT
+            // 使用标准bool类型替代已弃用的my_bool
+            bool reconnect = true;
+            mysql_options(conn_, MYSQL_OPT_RECONNECT, &reconnect);
+        #endif
+        
+        // MariaDB 非阻塞接口（queryStart/queryContinue）要求连接前开启，否则 _start/_cont 没有异步上下文；
+        // 开启后阻塞接口照常可用
+        #ifdef MYSQL_WAIT_READ
+            mysql_options(conn_, MYSQL_OPT_NONBLOCK, 0);
+        #endif
+        
         // 尝试建立实际连接
         auto* conn = mysql_real_connect(conn_, host_.c_str(), user_.c_str(),
                                        pass_.c_str(), db_.c_str(), port_, 
                                        nullptr, 0);
+        broken_ = conn == nullptr;
         return conn != nullptr;
     }
     
+    /**
+     * @brief 执行不返回结果集的SQL语句
+     * @return 是否执行成功；连接级错误（断线、超时等）时同时把连接标记为损坏
+     *
+     * 直接通过 getRawConnection() 执行查询时，可在失败后调用 checkError() 达到同样效果
+     */
+    bool execute(const std::string& sql) {
+        if (conn_ && mysql_real_query(conn_, sql.data(), static_cast<unsigned long>(sql.size())) == 0) {
+            return true;
+        }
+        checkError();
+        return false;
+    }
+    
+    /**
+     * @brief 执行查询并读取全部结果（阻塞）
+     * @return 查询结果；连接级错误时同时把连接标记为损坏
+     */
+    QueryResult query(const std::string& sql) {
+        QueryResult result;
+        if (!conn_ || mysql_real_query(conn_, sql.data(), static_cast<unsigned long>(sql.size())) != 0) {
+            fillError(result);
+            return result;
+        }
+        fillResult(mysql_store_result(conn_), result);
+        return result;
+    }
+
+#ifdef MYSQL_WAIT_READ
+    /**
+     * MariaDB 非阻塞接口：queryStart() 发起查询，返回 0 表示已完成，
+     * 否则返回需要等待的事件（MYSQL_WAIT_READ/WRITE/EXCEPT/TIMEOUT 的组合），
+     * 在 socket() 上等到事件后以发生的事件调用 queryContinue()，直到返回 0
+     */
+    int queryStart(std::string sql, QueryResult& result) {
+        if (!conn_) {
+            fillError(result);
+            return 0;
+        }
+        async_sql_ = std::move(sql);  // 查询完成前缓冲区必须保持有效
+        async_storing_ = false;
+        int err = 0;
+        const int status = mysql_real_query_start(&err, conn_, async_sql_.data(),
+                                                  static_cast<unsigned long>(async_sql_.size()));
+        return status ? status : onQueryDone(err, result);
+    }
+    
+    int queryContinue(int ready, QueryResult& result) {
+        if (!async_storing_) {
+            int err = 0;
+            const int status = mysql_real_query_cont(&err, conn_, ready);
+            return status ? status : onQueryDone(err, result);
+        }
+        MYSQL_RES* res = nullptr;
+        const int status = mysql_store_result_cont(&res, conn_, ready);
+        if (status == 0) {
+            fillResult(res, result);
+        }
+        return status;
+    }
+    
+    // 非阻塞模式下等待事件的套接字
+    int socket() const { return conn_ ? static_cast<int>(mysql_get_socket(conn_)) : -1; }
+    
+    // 等待事件包含 MYSQL_WAIT_TIMEOUT 时的超时时长（毫秒）
+    unsigned waitTimeoutMs() const { return conn_ ? mysql_get_timeout_value_ms(conn_) : 0; }
+#endif
+    
+    /**
+     * @brief 取得 SQL 对应的预处理语句，命中缓存时不再与服务器往返
+     * @return 语句句柄，由连接的 LRU 缓存持有，调用方不能 mysql_stmt_close；失败返回 nullptr
+     *
+     * 句柄在连接关闭、被挤出缓存或下一次对同一 SQL 执行失败前有效
+     */
+    MYSQL_STMT* prepare(const std::string& sql) {
+        if (auto it = stmt_index_.find(sql); it != stmt_index_.end()) {
+            stmt_lru_.splice(stmt_lru_.begin(), stmt_lru_, it->second);  // 移到最近使用端
+            return it->second->second;
+        }
+        if (!conn_) {
+            markBroken();
+            return nullptr;
+        }
+        
+        MYSQL_STMT* stmt = mysql_stmt_init(conn_);
+        if (!stmt) {
+            checkError();
+            return nullptr;
+        }
+        if (mysql_stmt_prepare(stmt, sql.data(), static_cast<unsigned long>(sql.size())) != 0) {
+            checkStmtError(stmt);
+            mysql_stmt_close(stmt);
+            return nullptr;
+        }
+        
+        stmt_lru_.emplace_front(sql, stmt);
+        stmt_index_.emplace(sql, stmt_lru_.begin());
+        while (stmt_lru_.size() > stmt_cache_capacity_) {
+            evictStatement(std::prev(stmt_lru_.end()));
+        }
+        return stmt;
+    }
+    
+    /**
+     * @brief 绑定参数并执行预处理语句（语句按 SQL 文本缓存复用）
+     * @param params 参数数组，长度须等于语句中 ? 的个数；无参数时可为 nullptr
+     * @return 是否执行成功；失败时该语句被移出缓存，连接级错误时连接被标记为损坏
+     */
+    bool executePrepared(const std::string& sql, MYSQL_BIND* params) {
+        MYSQL_STMT* stmt = prepare(sql);
+        if (!stmt) {
+            return false;
+        }
+        if ((params && mysql_stmt_bind_param(stmt, params)) || mysql_stmt_execute(stmt) != 0) {
+            checkStmtError(stmt);
+            evictStatement(stmt_index_.find(sql)->second);
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 数组绑定的批量插入：把 rows 行参数展开成多行 VALUES 的预处理语句，每 rows_per_statement 行一次往返
+     * @param insert_head 不含 VALUES 的语句头，如 "INSERT INTO t (a, b, c)"
+     * @param columns 每行参数个数
+     * @param binds 按行优先排列的 rows * columns 个参数
+     * @param rows_per_statement 每条语句的行数（整块与末尾不足一块的语句各缓存一条）
+     * @return 是否全部成功；失败时已执行的块不会回滚，需要原子性时请在事务中调用
+     */
+    bool executeBatch(const std::string& insert_head, size_t columns, MYSQL_BIND* binds, size_t rows,
+                      size_t rows_per_statement = 256) {
+        if (columns == 0 || rows_per_statement == 0) {
+            return false;
+        }
+        for (size_t done = 0; done < rows; ) {
+            const size_t chunk = std::min(rows_per_statement, rows - done);
+            if (!executePrepared(buildValuesSql(insert_head, columns, chunk), binds + done * columns)) {
+                return false;
+            }
+            done += chunk;
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 一次往返执行多条语句（多语句流水线），并读取、丢弃每条语句的结果
+     * @param statements 不含结尾分号的语句
+     * @param completed 非空时写入成功执行的语句数（遇到错误后服务器不再执行后续语句）
+     * @return 是否全部成功
+     *
+     * 多语句模式只在本次调用期间开启，连接归还后其他使用者的 execute() 不受影响
+     */
+    bool executeMulti(const std::vector<std::string>& statements, size_t* completed = nullptr) {
+        if (completed) *completed = 0;
+        if (statements.empty()) {
+            return true;
+        }
+        if (!conn_ || mysql_set_server_option(conn_, MYSQL_OPTION_MULTI_STATEMENTS_ON) != 0) {
+            checkError();
+            return false;
+        }
+        
+        std::string sql;
+        for (const auto& statement : statements) {
+            sql += statement;
+            sql += ';';
+        }
+        
+        size_t ok = 0;
+        bool success = mysql_real_query(conn_, sql.data(), static_cast<unsigned long>(sql.size())) == 0;
+        while (success) {
+            // 必须取走每条语句的结果，否则连接处于 CR_COMMANDS_OUT_OF_SYNC 状态
+            if (MYSQL_RES* result = mysql_store_result(conn_)) {
+                mysql_free_result(result);
+            }
+            ++ok;
+            const int next = mysql_next_result(conn_);  // 0: 还有结果, -1: 全部完成, >0: 出错
+            if (next < 0) break;
+            success = next == 0;
+        }
+        if (!success) {
+            checkError();
+        }
+        if (completed) *completed = ok;
+        
+        if (!isBroken() && mysql_set_server_option(conn_, MYSQL_OPTION_MULTI_STATEMENTS_OFF) != 0) {
+            checkError();
+        }
+        return success;
+    }
+    
+    /**
+     * @brief 设置预处理语句缓存容量（默认64，最小为1），超出时关闭最久未使用的语句
+     *
+     * prepare() 返回的句柄由缓存持有，至少要保留刚准备好的那一条，因此 0 按 1 处理
+     */
+    void setStatementCacheCapacity(size_t capacity) {
+        stmt_cache_capacity_ = std::max<size_t>(capacity, 1);
+        while (stmt_lru_.size() > stmt_cache_capacity_) {
+            evictStatement(std::prev(stmt_lru_.end()));
+        }
+    }
+    
+    /**
+     * @brief 当前缓存的预处理语句数
+     */
+    size_t cachedStatementCount() const { return stmt_lru_.size(); }
+    
+    /**
+     * @brief 生成多行 VALUES 语句，如 "INSERT INTO t (a, b) VALUES (?,?),(?,?)"
+     */
+    static std::string buildValuesSql(const std::string& insert_head, size_t columns, size_t rows) {
+        std::string row = "(";
+        for (size_t c = 0; c < columns; ++c) {
+            row += c == 0 ? "?" : ",?";
+        }
+        row += ')';
+        
+        std::string sql;
+        sql.reserve(insert_head.size() + 8 + rows * (row.size() + 1));
+        sql += insert_head;
+        sql += " VALUES ";
+        for (size_t r = 0; r < rows; ++r) {
+            if (r > 0) sql += ',';
+            sql += row;
+        }
+        return sql;
+    }
+    
+    /**
+     * @brief 检查最近一次调用的错误码，连接级错误时把连接标记为损坏
+     * @return 最近一次调用的错误码（0 表示无错误）
+     */
+    unsigned checkError() {
+        if (!conn_) {
+            markBroken();
+            return CR_SERVER_GONE_ERROR;
+        }
+        const unsigned err = mysql_errno(conn_);
+        if (isConnectionError(err)) {
+            markBroken();
+        }
+        return err;
+    }
+    
+    /**
+     * @brief 判断错误码是否表示连接本身不可用（而非SQL错误）
+     */
+    static bool isConnectionError(unsigned err) {
+        return err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST ||
+               err == CR_CONNECTION_ERROR || err == CR_CONN_HOST_ERROR ||
+               err == CR_COMMANDS_OUT_OF_SYNC;
+    }
+    
+    /**
+     * @brief 检查预处理语句的错误码，连接级错误时把连接标记为损坏
+     */
+    unsigned checkStmtError(MYSQL_STMT* stmt) {
+        const unsigned err = mysql_stmt_errno(stmt);
+        if (isConnectionError(err)) {
+            markBroken();
+        }
+        return err;
+    }
+    
     /**
      * @brief 检查连接是否仍然有效
      * @return 连接是否有效
@@ -97,32 +414,57 @@ public:
     }
     
     /**
-     * @brief 重置连接状态（回滚事务并设置自动重连）
+     * @brief 重置连接状态（回滚事务并恢复自动提交）
+     *
+     * 连接池只在 needsReset() 为 true 时调用；回滚失败（断线）时连接被标记为损坏
      */
     void reset() override {
         if (conn_) {
             // 1. 回滚任何未提交的事务
-            mysql_rollback(conn_);
+            if (mysql_rollback(conn_)) {
+                checkError();
+                return;
+            }
             
-            // 2. 设置自动重连选项（兼容不同MySQL版本）
-            #ifdef MYSQL_OPT_RECONNECT
-                // 使用标准bool类型替代已弃用的my_bool
-                bool reconnect = true;
-                mysql_options(conn_, MYSQL_OPT_RECONNECT, &reconnect);
-            #endif
+            // 2. 恢复自动提交
+            if (!(conn_->server_status & SERVER_STATUS_AUTOCOMMIT) && mysql_autocommit(conn_, true)) {
+                checkError();
+                return;
+            }
             
-            // 3. 重置连接状态标志
+            // 3. 重置连接状态标志（服务器会同时释放该会话的全部预处理语句）
             #ifdef MYSQL_RESET_CONNECTION
+                clearStatementCache();
                 mysql_reset_connection(conn_);
             #endif
+            dirty_ = false;
         }
     }
     
+    /**
+     * @brief 根据最近一次服务器响应的状态位判断是否需要重置，不产生网络往返
+     *
+     * 事务未结束、关闭了自动提交、服务器报告会话状态变化（需开启 session_track_*），
+     * 或调用过 markDirty() 时返回 true；只读查询的连接归还时不再回滚
+     */
+    bool needsReset() const override {
+        if (!conn_) return false;
+        const unsigned status = conn_->server_status;
+        return dirty_ || (status & SERVER_STATUS_IN_TRANS) || !(status & SERVER_STATUS_AUTOCOMMIT) ||
+               (status & SERVER_SESSION_STATE_CHANGED);
+    }
+    
+    /**
+     * @brief 标记会话状态已被修改（如 SET 会话变量、创建临时表），归还时强制重置
+     */
+    void markDirty() { dirty_ = true; }
+    
     /**
      * @brief 关闭数据库连接
      */
     void close() override {
         if (conn_) {
+            clearStatementCache();
             mysql_close(conn_);
             mysql_thread_end(); // 清理线程相关资源
             conn_ = nullptr;
@@ -136,20 +478,321 @@ public:
     MYSQL* getRawConnection() const { return conn_; }
 
 private:
+    using StatementList = std::list<std::pair<std::string, MYSQL_STMT*>>;
+    
+    // 记录最近一次调用的错误
+    void fillError(QueryResult& result) {
+        result.ok = false;
+        result.error = checkError();
+        result.message = conn_ ? mysql_error(conn_) : "connection closed";
+    }
+    
+    // 读取结果集（或无结果集语句的影响行数）并释放结果
+    void fillResult(MYSQL_RES* res, QueryResult& result) {
+        if (!res) {
+            if (mysql_field_count(conn_) != 0) {  // 应有结果集却读取失败
+                fillError(result);
+                return;
+            }
+            result.ok = true;
+            result.affected_rows = mysql_affected_rows(conn_);
+            result.insert_id = mysql_insert_id(conn_);
+            return;
+        }
+        
+        const unsigned fields = mysql_num_fields(res);
+        MYSQL_FIELD* meta = mysql_fetch_fields(res);
+        result.columns.reserve(fields);
+        for (unsigned i = 0; i < fields; ++i) {
+            result.columns.emplace_back(meta[i].name);
+        }
+        result.rows.reserve(static_cast<size_t>(mysql_num_rows(res)));
+        while (MYSQL_ROW row = mysql_fetch_row(res)) {
+            const unsigned long* lengths = mysql_fetch_lengths(res);
+            auto& out = result.rows.emplace_back();
+            out.reserve(fields);
+            for (unsigned i = 0; i < fields; ++i) {
+                if (row[i]) out.emplace_back(std::in_place, row[i], lengths[i]);
+                else out.emplace_back(std::nullopt);
+            }
+        }
+        mysql_free_result(res);
+        result.ok = true;
+    }
+
+#ifdef MYSQL_WAIT_READ
+    // 查询阶段完成后开始读取结果
+    int onQueryDone(int err, QueryResult& result) {
+        if (err) {
+            fillError(result);
+            return 0;
+        }
+        async_storing_ = true;
+        MYSQL_RES* res = nullptr;
+        const int status = mysql_store_result_start(&res, conn_);
+        if (status == 0) {
+            fillResult(res, result);
+        }
+        return status;
+    }
+    
+    std::string async_sql_;      // 进行中的非阻塞查询
+    bool async_storing_ = false; // 非阻塞查询是否已进入读取结果阶段
+#endif
+    
+    // 关闭并移出一条缓存的预处理语句
+    void evictStatement(StatementList::iterator it) {
+        mysql_stmt_close(it->second);
+        stmt_index_.erase(it->first);
+        stmt_lru_.erase(it);
+    }
+    
+    // 关闭全部缓存的预处理语句
+    void clearStatementCache() {
+        for (auto& entry : stmt_lru_) {
+            mysql_stmt_close(entry.second);
+        }
+        stmt_lru_.clear();
+        stmt_index_.clear();
+    }
+    
     MYSQL* conn_ = nullptr;     // MySQL连接句柄
     std::string host_;           // 数据库主机地址
     std::string user_;           // 用户名
     std::string pass_;           // 密码
     std::string db_;             // 数据库名称
     unsigned port_ = 3306;       // 端口号
+    
+    StatementList stmt_lru_;     // 预处理语句缓存，表头为最近使用
+    std::unordered_map<std::string, StatementList::iterator> stmt_index_;  // SQL文本 -> 缓存项
+    size_t stmt_cache_capacity_ = 64;  // 预处理语句缓存容量
+    bool dirty_ = false;         // 调用方声明的会话状态修改
+};
+
+/**
+ * MultiRowInsert类 - 文本方式的多行 INSERT 构造器
+ *
+ * 把逐行写入合并成 "INSERT ... VALUES (...),(...)"，语句长度超过 max_bytes 时自动发送一次，
+ * 字符串值通过 mysql_real_escape_string 转义。析构时不会自动发送，最后需调用 flush()：
+ *
+ *   MultiRowInsert insert(*mysql, "INSERT INTO snapshot (id, x, name)");
+ *   for (...) insert.row().value(id).value(x).value(name);
+ *   bool ok = insert.flush();
+ */
+class MultiRowInsert {
+public:
+    /**
+     * @param conn 执行语句的连接
+     * @param insert_head 不含 VALUES 的语句头
+     * @param max_bytes 单条语句的目标长度上限（应小于服务器的 max_allowed_packet）
+     */
+    MultiRowInsert(MySQLConnection& conn, std::string insert_head, size_t max_bytes = 1 << 20)
+        : conn_(conn), head_(std::move(insert_head)), max_bytes_(max_bytes) {}
+    
+    // 开始新的一行；已累计的语句超过 max_bytes 时先发送
+    MultiRowInsert& row() {
+        commitRow();
+        if (sql_.size() >= max_bytes_) {
+            send();
+        }
+        row_ = "(";
+        row_open_ = true;
+        return *this;
+    }
+    
+    MultiRowInsert& value(long long v) {
+        separate();
+        row_ += std::to_string(v);
+        return *this;
+    }
+    
+    MultiRowInsert& value(int v) { return value(static_cast<long long>(v)); }
+    
+    MultiRowInsert& value(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.17g", v);
+        separate();
+        row_ += buf;
+        return *this;
+    }
+    
+    MultiRowInsert& value(const std::string& v) {
+        separate();
+        MYSQL* raw = conn_.getRawConnection();
+        if (!raw) {
+            ok_ = false;
+            return *this;
+        }
+        std::string escaped(v.size() * 2 + 1, '\0');
+        escaped.resize(mysql_real_escape_string(raw, &escaped[0], v.data(), static_cast<unsigned long>(v.size())));
+        row_ += '\'';
+        row_ += escaped;
+        row_ += '\'';
+        return *this;
+    }
+    
+    MultiRowInsert& null() {
+        separate();
+        row_ += "NULL";
+        return *this;
+    }
+    
+    /**
+     * @brief 发送尚未发送的行
+     * @return 自构造以来所有发送是否都成功
+     */
+    bool flush() {
+        commitRow();
+        send();
+        return ok_;
+    }
+    
+    // 已累计但尚未发送的行数
+    size_t pendingRows() const { return rows_ + (row_open_ ? 1 : 0); }
+
+private:
+    void separate() {
+        if (row_.size() > 1) row_ += ',';
+    }
+    
+    void commitRow() {
+        if (!row_open_) return;
+        row_ += ')';
+        if (rows_ == 0) {
+            sql_ = head_;
+            sql_ += " VALUES ";
+        } else {
+            sql_ += ',';
+        }
+        sql_ += row_;
+        ++rows_;
+        row_open_ = false;
+    }
+    
+    void send() {
+        if (rows_ == 0) return;
+        ok_ = conn_.execute(sql_) && ok_;
+        sql_.clear();
+        rows_ = 0;
+    }
+    
+    MySQLConnection& conn_;
+    const std::string head_;
+    const size_t max_bytes_;
+    std::string sql_;        // 已完成的行组成的语句
+    std::string row_;        // 正在构造的行
+    size_t rows_ = 0;        // sql_ 中的行数
+    bool row_open_ = false;
+    bool ok_ = true;
+};
+
+// 取出空闲连接时的校验策略
+enum class ValidationPolicy {
+    ON_BORROW,       // 每次取出都 ping（一次网络往返）
+    IDLE_THRESHOLD,  // 仅当连接超过 validation_threshold 未被确认可用时才 ping（默认）
+    BACKGROUND,      // 取出时不 ping，由清理线程每隔 validation_interval 校验空闲连接
+    NONE             // 从不 ping，只依赖 markBroken() 剔除坏连接
+};
+
+// 连接池配置参数
+struct DBPoolConfig {
+    size_t max_connections = 10;                                       // 最大连接数
+    std::chrono::milliseconds max_idle_time = std::chrono::minutes(10); // 最大空闲时间
+    std::chrono::milliseconds connection_timeout = std::chrono::seconds(5); // 获取连接超时时间
+    ValidationPolicy validation = ValidationPolicy::IDLE_THRESHOLD;    // 取出连接时的校验策略
+    std::chrono::milliseconds validation_threshold = std::chrono::milliseconds(500); // IDLE_THRESHOLD 策略的免校验时长
+    std::chrono::milliseconds validation_interval = std::chrono::seconds(30);        // BACKGROUND 策略的校验周期
+    size_t shards = 0;                                                 // 空闲连接分片数（0 表示取CPU数，且不超过最大连接数）
+    size_t initial_size = 0;                                           // 构造时预先创建的连接数
+    size_t min_idle = 0;                                               // 空闲连接低水位，低于它时由后台线程补充（0 表示不补充）
+    size_t warmup_threads = 4;                                         // 构造时并行建立连接的线程数
+    bool async_reset = false;                                          // 需要重置的连接交给后台线程重置，归还线程不等待
+    bool wait_histograms = true;                                       // 记录获取连接的等待时间直方图（每次获取多两次取时钟）
+};
+
+/**
+ * 对数-线性分桶的等待时间直方图（HDR 风格），单位纳秒
+ * 小于 kSubBuckets 的值逐个计数；其余值按2的幂分段，每段再均分为 kSubBuckets 个桶，
+ * 相对误差不超过 1/kSubBuckets（约6%）；超过 2^kMaxExponent 纳秒（约18分钟）的值计入最后一个桶
+ */
+class WaitHistogram {
+public:
+    static constexpr size_t kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kMaxExponent = 40;
+    static constexpr size_t kBucketCount = kSubBuckets + (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+        if (exponent > kMaxExponent) return kBucketCount - 1;
+        const size_t shift = exponent - kSubBucketBits;
+        const size_t sub = static_cast<size_t>(value >> shift) & (kSubBuckets - 1);
+        return kSubBuckets + (exponent - kSubBucketBits) * kSubBuckets + sub;
+    }
+
+    // 桶内的最大值（百分位按该值报告）
+    static uint64_t bucketUpper(size_t bucket) {
+        if (bucket < kSubBuckets) return bucket;
+        const size_t shift = (bucket - kSubBuckets) / kSubBuckets;
+        const uint64_t sub = (bucket - kSubBuckets) % kSubBuckets;
+        return ((kSubBuckets + sub + 1) << shift) - 1;
+    }
+
+    // 百分位值（p 取 0~1），无样本时返回0
+    uint64_t percentile(double p) const {
+        if (count == 0) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(count))));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucketUpper(i), max);
+        }
+        return max;
+    }
+
+    double mean() const { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0; }
+
+    std::array<uint64_t, kBucketCount> counts{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+};
+
+// 连接池统计快照（计数均为构造以来的累计值）
+struct DBPoolStats {
+    uint64_t acquired = 0;           // 成功取出连接的次数（同步、非阻塞与异步获取）
+    uint64_t timeouts = 0;           // 等待超时次数（getConnection 返回 nullptr 与异步请求超时）
+    uint64_t exhausted = 0;          // tryGetConnection 因无可用连接返回 nullptr 的次数
+    uint64_t steals = 0;             // 从非主分片取得空闲连接的次数
+    uint64_t created = 0;            // 新建连接数（含预热与后台补充）
+    uint64_t create_failures = 0;    // 新建连接失败次数
+    uint64_t closed_idle = 0;        // 因空闲超时关闭的连接数
+    uint64_t closed_broken = 0;      // 因被标记损坏（或重置失败）关闭的连接数
+    uint64_t ping_failures = 0;      // 校验失败并关闭的连接数（取出时与后台校验）
+    uint64_t resets = 0;             // 归还时执行 reset() 的次数
+    uint64_t resets_skipped = 0;     // 归还时连接干净、跳过 reset() 的次数
+    size_t total_connections = 0;    // 当前连接数（含借出中与重置中）
+    size_t idle_connections = 0;     // 当前空闲连接数
+    size_t waiting = 0;              // 当前等待中的请求数（同步与异步）
+    WaitHistogram wait;              // getConnection/asyncGetConnection 的等待时间（纳秒，含立即取得的；仅 wait_histograms 时有数据）
 };
 
-// DBConnectionPool类 - MySQL连接池实现
+/**
+ * DBConnectionPool类 - MySQL连接池实现
+ *
+ * 连接存放在固定容量的槽位数组中，空闲连接按分片存放（每个分片一个互斥锁和一个LIFO栈）：
+ * 线程按首次使用顺序固定映射到一个"主分片"，归还时放回主分片、取出时先查主分片，
+ * 同一线程因此倾向于反复拿到自己刚用过的连接；主分片为空时依次从其他分片窃取。
+ * 取/还连接不经过全局锁，也不做树查找或链表节点分配（归还句柄的控制块存放在槽位内）
+ */
 class DBConnectionPool {
 public:
     // C++11特性：类型别名简化代码
     using ConnectionPtr = std::shared_ptr<DBConn>;
     using Factory = std::function<ConnectionPtr()>;
+    // 异步获取回调：成功时传入连接，超时或连接池销毁时传入 nullptr
+    using AcquireCallback = std::function<void(ConnectionPtr)>;
     
     // C++11特性：删除拷贝构造函数和赋值操作符
     DBConnectionPool(const DBConnectionPool&) = delete;
@@ -165,139 +808,898 @@ public:
     DBConnectionPool(size_t max_conn, Factory factory, 
                     std::chrono::milliseconds max_idle = std::chrono::minutes(10),
                     std::chrono::milliseconds connection_timeout = std::chrono::seconds(5))
-        : max_connections_(max_conn), 
+        : DBConnectionPool(makeConfig(max_conn, max_idle, connection_timeout), std::move(factory)) {}
+    
+    /**
+     * @brief 构造函数
+     * @param config 连接池配置
+     * @param factory 连接工厂函数
+     */
+    DBConnectionPool(DBPoolConfig config, Factory factory)
+        : config_(std::move(config)),
           connection_factory_(std::move(factory)), // C++11移动语义
-          max_idle_time_(max_idle),
-          connection_timeout_(connection_timeout),
-          cleaner_running_(true) {
+          slots_(new Slot[std::max<size_t>(config_.max_connections, 1)]),
+          cleaner_running_(true),
+          filler_running_(true),
+          reset_running_(true) {
+        free_slots_.reserve(config_.max_connections);
+        for (size_t i = config_.max_connections; i > 0; --i) {
+            free_slots_.push_back(static_cast<uint32_t>(i - 1));
+        }
+        
+        size_t shard_count = config_.shards;
+        if (shard_count == 0) {
+            shard_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+        shard_count = std::max<size_t>(std::min(shard_count, config_.max_connections), 1);
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+            shards_.back()->idle.reserve(config_.max_connections);  // 运行期入栈不再分配内存
+        }
+        
+        // 预热：并行建立 max(initial_size, min_idle) 个连接，建立失败不影响构造
+        warmUp(std::min(std::max(config_.initial_size, config_.min_idle), config_.max_connections));
+        
         // 启动清理线程 (C++11 lambda表达式)
         cleaner_thread_ = std::thread([this] { cleanIdleConnections(); });
+        if (config_.min_idle > 0) {
+            filler_thread_ = std::thread([this] { replenishIdleConnections(); });
+        }
+        if (config_.async_reset) {
+            reset_queue_.reserve(config_.max_connections);
+            reset_thread_ = std::thread([this] { resetConnections(); });
+        }
     }
     
     /**
-     * @brief 析构函数，停止清理线程
+     * @brief 析构函数，停止重置线程、补充线程和清理线程
      */
     ~DBConnectionPool() {
-        cleaner_running_ = false;
+        {
+            std::lock_guard<std::mutex> lock(reset_mutex_);
+            reset_running_ = false;
+        }
+        reset_cv_.notify_one();
+        if (reset_thread_.joinable()) {
+            reset_thread_.join();
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(filler_mutex_);
+            filler_running_ = false;
+        }
+        filler_cv_.notify_one();
+        if (filler_thread_.joinable()) {
+            filler_thread_.join();
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(cleaner_mutex_);
+            cleaner_running_ = false;
+        }
         cleaner_cv_.notify_one();
         if (cleaner_thread_.joinable()) {
             cleaner_thread_.join();
         }
+
+        // 仍在等待的异步请求以 nullptr 结束
+        std::list<AsyncWaiter> pending;
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            pending.swap(async_waiters_);
+            async_waiter_count_ = 0;
+        }
+        for (auto& waiter : pending) {
+            waiter.callback(nullptr);
+        }
     }
     
     /**
      * @brief 获取数据库连接
-     * @return 共享指针管理的数据库连接
+     * @return 共享指针管理的数据库连接；超时或新建连接失败时返回 nullptr
      * 
-     * 使用C++11智能指针与lambda自定义删除器
+     * 使用C++11智能指针与自定义删除器，连接使用后自动归还
      */
     ConnectionPtr getConnection() {
-        std::unique_lock<std::mutex> lock(pool_mutex_);
-        
-        // 1. 尝试从空闲队列获取有效连接
-        while (!idle_connections_.empty()) {
-            auto conn = idle_connections_.front();
-            idle_connections_.pop_front();
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + config_.connection_timeout;
+        while (true) {
+            // 1~2. 复用空闲连接或创建新连接
+            uint32_t index = 0;
+            const AcquireResult result = takeConnection(index);
+            if (result == AcquireResult::ACQUIRED) {
+                recordWait(start);
+                return lease(index);
+            }
+            if (result == AcquireResult::CREATE_FAILED) {
+                return nullptr;
+            }
             
-            if (conn->ping()) { // 检查连接是否有效
-                active_connections_.emplace(conn.get(), conn);
-                
-                // C++11特性：lambda捕获的自定义删除器
-                return {conn.get(), [this](DBConn* c) { releaseConnection(c); }};
+            // 3. 等待可用连接（带超时），被唤醒后重新尝试
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            ++sync_waiters_;
+            const bool ready = wait_cv_.wait_until(lock, deadline, [this] {
+                return idle_total_.load() > 0 || created_.load() < config_.max_connections;
+            });
+            --sync_waiters_;
+            
+            // 超时，返回空指针
+            if (!ready) {
+                bump(timeouts_);
+                return nullptr;
             }
         }
+    }
+
+    /**
+     * @brief 非阻塞获取连接
+     * @return 有空闲连接或未达上限时返回连接，否则立即返回 nullptr
+     */
+    ConnectionPtr tryGetConnection() {
+        uint32_t index = 0;
+        if (takeConnection(index) == AcquireResult::ACQUIRED) {
+            return lease(index);
+        }
+        bump(exhausted_);
+        return nullptr;
+    }
+
+    /**
+     * @brief 异步获取连接，调用线程不会阻塞
+     * @param callback 恰好被调用一次：能立即获取时在调用线程同步调用；
+     *                 否则在归还连接的线程上调用（连接直接移交，不回到空闲队列）；
+     *                 超时或连接池销毁时由清理线程/析构线程以 nullptr 调用
+     * @param timeout 等待超时时间
+     *
+     * 回调在锁外执行，但会占用归还连接的线程，应尽快返回且不应抛出异常
+     * （例如只把后续工作投递到线程池）
+     */
+    void asyncGetConnection(AcquireCallback callback, std::chrono::milliseconds timeout) {
+        const auto start = std::chrono::steady_clock::now();
+        uint32_t index = 0;
+        if (takeConnection(index) == AcquireResult::ACQUIRED) {
+            recordWait(start);
+            callback(lease(index));
+            return;
+        }
         
-        // 2. 创建新连接（如果未达上限）
-        if (active_connections_.size() + idle_connections_.size() < max_connections_) {
-            if (auto conn = connection_factory_(); conn && conn->connect()) {
-                // 添加到活动连接
-                active_connections_.emplace(conn.get(), conn);
-                
-                // 设置自定义删除器，连接使用后自动归还
-                return {conn.get(), [this](DBConn* c) { releaseConnection(c); }};
+        const auto deadline = start + timeout;
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            async_waiters_.push_back({ std::move(callback), deadline, start });
+            ++async_waiter_count_;
+        }
+
+        // 截止时间早于清理线程的下一次唤醒时提前唤醒它
+        bool wake_cleaner = false;
+        {
+            std::lock_guard<std::mutex> lock(cleaner_mutex_);
+            if (deadline < earliest_deadline_) {
+                earliest_deadline_ = deadline;
+                wake_cleaner = true;
             }
         }
-        
-        // 3. 等待可用连接（带超时）
-        if (pool_cv_.wait_for(lock, connection_timeout_, [this] {
-            return !idle_connections_.empty() || 
-                   active_connections_.size() + idle_connections_.size() < max_connections_;
-        })) {
-            // 递归尝试获取连接
-            return getConnection();
+        if (wake_cleaner) {
+            cleaner_cv_.notify_one();
         }
         
-        // 超时，返回空指针
-        return nullptr;
+        // 登记后再检查一次：与归还线程"先放回、再检查等待者"配对，不会错过刚归还的连接
+        serveAsyncWaiters();
+    }
+
+    /**
+     * @brief 异步获取连接，使用配置的获取连接超时时间
+     */
+    void asyncGetConnection(AcquireCallback callback) {
+        asyncGetConnection(std::move(callback), config_.connection_timeout);
+    }
+
+    /**
+     * @brief 新建连接失败与校验失败的累计次数（不读取直方图，可在取连接路径上调用）
+     */
+    uint64_t healthFailures() const {
+        return create_failures_.load(std::memory_order_relaxed) + ping_failures_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 最大连接数
+     */
+    size_t maxConnections() const { return config_.max_connections; }
+
+    /**
+     * @brief 统计快照（计数器与直方图分别读取，彼此之间不保证严格一致）
+     */
+    DBPoolStats stats() const {
+        DBPoolStats snapshot;
+        snapshot.acquired = acquired_.load(std::memory_order_relaxed);
+        snapshot.timeouts = timeouts_.load(std::memory_order_relaxed);
+        snapshot.exhausted = exhausted_.load(std::memory_order_relaxed);
+        snapshot.steals = steals_.load(std::memory_order_relaxed);
+        snapshot.created = created_total_.load(std::memory_order_relaxed);
+        snapshot.create_failures = create_failures_.load(std::memory_order_relaxed);
+        snapshot.closed_idle = closed_idle_.load(std::memory_order_relaxed);
+        snapshot.closed_broken = closed_broken_.load(std::memory_order_relaxed);
+        snapshot.ping_failures = ping_failures_.load(std::memory_order_relaxed);
+        snapshot.resets = resets_.load(std::memory_order_relaxed);
+        snapshot.resets_skipped = resets_skipped_.load(std::memory_order_relaxed);
+        snapshot.total_connections = created_.load();
+        snapshot.idle_connections = idle_total_.load();
+        snapshot.waiting = sync_waiters_.load() + async_waiter_count_.load();
+        for (const auto& shard : shards_) {
+            shard->wait.mergeInto(snapshot.wait);
+        }
+        return snapshot;
     }
 
 private:
+    // 取连接的结果
+    enum class AcquireResult {
+        ACQUIRED,       // 已取得连接
+        EXHAUSTED,      // 无空闲连接且已达上限
+        CREATE_FAILED   // 新建连接失败
+    };
+
+    // 归还句柄的控制块存放处：每个槽位两块，因为归还回调中可能立即为同一槽位生成新句柄，
+    // 而此时旧句柄的控制块尚未释放；两块都被占用时退回堆分配
+    static constexpr size_t kLeaseBlockSize = 64;
+    struct LeaseBlock {
+        alignas(std::max_align_t) unsigned char bytes[kLeaseBlockSize];
+        std::atomic<bool> used{ false };
+    };
+
+    // 连接槽位：conn 为空表示槽位未使用
+    struct Slot {
+        ConnectionPtr conn;
+        LeaseBlock leases[2];
+    };
+
+    // 等待时间直方图的原子版本（多线程写入，快照时按桶读取合并）
+    struct WaitRecorder {
+        void record(uint64_t value) {
+            counts[WaitHistogram::bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(value, std::memory_order_relaxed);
+            uint64_t prev = max.load(std::memory_order_relaxed);
+            while (value > prev && !max.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+        }
+
+        void mergeInto(WaitHistogram& out) const {
+            uint64_t total = 0;
+            for (size_t i = 0; i < WaitHistogram::kBucketCount; ++i) {
+                const uint64_t c = counts[i].load(std::memory_order_relaxed);
+                out.counts[i] += c;
+                total += c;
+            }
+            out.count += total;
+            out.sum += sum.load(std::memory_order_relaxed);
+            out.max = std::max(out.max, max.load(std::memory_order_relaxed));
+        }
+
+        std::atomic<uint64_t> counts[WaitHistogram::kBucketCount] = {};
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+    };
+
+    // 空闲连接分片：LIFO 栈，count 供其他线程无锁判断是否为空
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<uint32_t> idle;
+        std::atomic<size_t> count{ 0 };
+        WaitRecorder wait;  // 主分片为该分片的线程记录等待时间，分散写入竞争
+    };
+
+    // 从槽位内的 LeaseBlock 分配 shared_ptr 控制块
+    template <typename T>
+    struct LeaseAllocator {
+        using value_type = T;
+
+        explicit LeaseAllocator(LeaseBlock* b) noexcept : blocks(b) {}
+        template <typename U>
+        LeaseAllocator(const LeaseAllocator<U>& other) noexcept : blocks(other.blocks) {}
+
+        T* allocate(size_t n) {
+            if (n * sizeof(T) <= kLeaseBlockSize && alignof(T) <= alignof(std::max_align_t)) {
+                for (int i = 0; i < 2; ++i) {
+                    bool expected = false;
+                    if (blocks[i].used.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                        return reinterpret_cast<T*>(blocks[i].bytes);
+                    }
+                }
+            }
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t) noexcept {
+            for (int i = 0; i < 2; ++i) {
+                if (reinterpret_cast<unsigned char*>(p) == blocks[i].bytes) {
+                    blocks[i].used.store(false, std::memory_order_release);
+                    return;
+                }
+            }
+            ::operator delete(p);
+        }
+
+        template <typename U>
+        bool operator==(const LeaseAllocator<U>& other) const noexcept { return blocks == other.blocks; }
+        template <typename U>
+        bool operator!=(const LeaseAllocator<U>& other) const noexcept { return blocks != other.blocks; }
+
+        LeaseBlock* blocks;
+    };
+
+    // 归还句柄的删除器：引用计数归零时把槽位交还连接池
+    struct SlotReleaser {
+        DBConnectionPool* pool;
+        uint32_t index;
+        void operator()(DBConn*) const { pool->releaseConnection(index); }
+    };
+
+    // 等待中的异步获取请求
+    struct AsyncWaiter {
+        AcquireCallback callback;
+        std::chrono::steady_clock::time_point deadline;
+        std::chrono::steady_clock::time_point start;  // 发起时间（统计等待时间）
+    };
+
+    static DBPoolConfig makeConfig(size_t max_conn, std::chrono::milliseconds max_idle,
+                                   std::chrono::milliseconds connection_timeout) {
+        DBPoolConfig config;
+        config.max_connections = max_conn;
+        config.max_idle_time = max_idle;
+        config.connection_timeout = connection_timeout;
+        return config;
+    }
+
+    // 线程序号：按线程首次使用连接池的顺序分配，用于确定主分片
+    static size_t threadOrdinal() {
+        static std::atomic<size_t> next{ 0 };
+        thread_local const size_t ordinal = next.fetch_add(1, std::memory_order_relaxed);
+        return ordinal;
+    }
+
+    size_t homeShard() const { return threadOrdinal() % shards_.size(); }
+
+    // 统计计数器加一（不参与同步）
+    static void bump(std::atomic<uint64_t>& counter) { counter.fetch_add(1, std::memory_order_relaxed); }
+
+    // 记录一次获取连接的等待时间
+    void recordWait(std::chrono::steady_clock::time_point start) {
+        if (!config_.wait_histograms) return;
+        const auto waited = std::chrono::steady_clock::now() - start;
+        shards_[homeShard()]->wait.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()));
+    }
+
+    /**
+     * @brief 为槽位中的连接生成归还式智能指针
+     */
+    ConnectionPtr lease(uint32_t index) {
+        bump(acquired_);
+        Slot& slot = slots_[index];
+        return ConnectionPtr(slot.conn.get(), SlotReleaser{ this, index },
+                             LeaseAllocator<char>(slot.leases));
+    }
+
+    /**
+     * @brief 取出空闲连接时是否需要 ping
+     */
+    bool needsValidation(const DBConn& conn) const {
+        switch (config_.validation) {
+        case ValidationPolicy::ON_BORROW:
+            return true;
+        case ValidationPolicy::IDLE_THRESHOLD:
+            return conn.getUnvalidatedDuration() > config_.validation_threshold;
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * @brief 取一个连接：先查主分片，再从其他分片窃取，都为空且未达上限时新建
+     *        ping 与新建连接都不持有任何锁
+     */
+    AcquireResult takeConnection(uint32_t& index) {
+        // 1. 尝试从空闲分片获取有效连接
+        while (popIdle(index)) {
+            DBConn& conn = *slots_[index].conn;
+            if (!needsValidation(conn)) {
+                return AcquireResult::ACQUIRED;
+            }
+            if (conn.ping()) { // 检查连接是否有效
+                conn.setLastValidated(std::chrono::steady_clock::now());
+                return AcquireResult::ACQUIRED;
+            }
+            bump(ping_failures_);
+            destroySlot(index);
+        }
+        
+        // 2. 创建新连接（如果未达上限）
+        if (!reserveSlot(index)) {
+            return AcquireResult::EXHAUSTED;
+        }
+        auto conn = connection_factory_();
+        if (!conn || !conn->connect()) {
+            bump(create_failures_);
+            freeSlot(index);
+            notifySyncWaiters();  // 名额已退回
+            return AcquireResult::CREATE_FAILED;
+        }
+        bump(created_total_);
+        conn->setLastValidated(std::chrono::steady_clock::now());
+        slots_[index].conn = std::move(conn);
+        return AcquireResult::ACQUIRED;
+    }
+
+    /**
+     * @brief 从主分片栈顶取空闲连接，主分片为空时依次窃取其他分片
+     */
+    bool popIdle(uint32_t& index) {
+        const size_t n = shards_.size();
+        const size_t home = homeShard();
+        for (size_t i = 0; i < n; ++i) {
+            Shard& shard = *shards_[(home + i) % n];
+            if (shard.count.load(std::memory_order_relaxed) == 0) continue;
+            
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (shard.idle.empty()) continue;
+                index = shard.idle.back();
+                shard.idle.pop_back();
+                shard.count.store(shard.idle.size(), std::memory_order_relaxed);
+            }
+            idle_total_.fetch_sub(1);
+            if (i != 0) bump(steals_);
+            requestReplenish();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 把空闲连接压入指定分片
+     */
+    void pushIdle(size_t shard_index, uint32_t index) {
+        Shard& shard = *shards_[shard_index];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.idle.push_back(index);
+            shard.count.store(shard.idle.size(), std::memory_order_relaxed);
+        }
+        idle_total_.fetch_add(1);
+    }
+
+    /**
+     * @brief 预留一个槽位（计入连接总数）
+     */
+    bool reserveSlot(uint32_t& index) {
+        size_t created = created_.load();
+        do {
+            if (created >= config_.max_connections) return false;
+        } while (!created_.compare_exchange_weak(created, created + 1));
+        
+        std::lock_guard<std::mutex> lock(slots_mutex_);
+        index = free_slots_.back();
+        free_slots_.pop_back();
+        return true;
+    }
+
+    /**
+     * @brief 退回槽位：先放回空闲槽位表再减少计数，保证计数小于上限时总有槽位可取
+     */
+    void freeSlot(uint32_t index) {
+        {
+            std::lock_guard<std::mutex> lock(slots_mutex_);
+            free_slots_.push_back(index);
+        }
+        created_.fetch_sub(1);
+    }
+
+    /**
+     * @brief 关闭槽位中的连接并退回槽位
+     */
+    void destroySlot(uint32_t index) {
+        ConnectionPtr conn = std::move(slots_[index].conn);
+        conn->close();
+        freeSlot(index);
+        requestReplenish();
+    }
+
+    /**
+     * @brief 在锁外新建一个连接并放入指定分片
+     * @return 未达上限且建立成功时返回 true
+     */
+    bool createIdle(size_t shard_index) {
+        uint32_t index = 0;
+        if (!reserveSlot(index)) {
+            return false;
+        }
+        auto conn = connection_factory_();
+        if (!conn || !conn->connect()) {
+            bump(create_failures_);
+            freeSlot(index);
+            return false;
+        }
+        bump(created_total_);
+        const auto now = std::chrono::steady_clock::now();
+        conn->setLastValidated(now);
+        conn->setLastUsed(now);
+        slots_[index].conn = std::move(conn);
+        pushIdle(shard_index, index);
+        return true;
+    }
+
     /**
-     * @brief 释放连接回连接池
-     * @param raw_conn 原始连接指针
+     * @brief 构造时并行建立 count 个连接，轮流放入各分片
      */
-    void releaseConnection(DBConn* raw_conn) {
-        std::unique_lock<std::mutex> lock(pool_mutex_);
-        auto it = active_connections_.find(raw_conn);
+    void warmUp(size_t count) {
+        if (count == 0) return;
+        std::atomic<size_t> next{ 0 };
+        auto worker = [this, count, &next] {
+            size_t i;
+            while ((i = next.fetch_add(1)) < count) {
+                if (!createIdle(i % shards_.size())) return;  // 数据库不可用时不再继续尝试
+            }
+        };
         
-        if (it != active_connections_.end() && it->second.get() == raw_conn) {
-            // 重置连接状态
-            raw_conn->reset();
+        std::vector<std::thread> workers;
+        const size_t n = std::min(std::max<size_t>(config_.warmup_threads, 1), count);
+        for (size_t t = 1; t < n; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    // 空闲连接低于 min_idle 且未达上限时唤醒补充线程（已有未处理的唤醒时不再加锁）
+    void requestReplenish() {
+        if (idle_total_.load() >= config_.min_idle || created_.load() >= config_.max_connections) {
+            return;
+        }
+        if (!replenish_pending_.exchange(true)) {
+            std::lock_guard<std::mutex> lock(filler_mutex_);
+            filler_cv_.notify_one();
+        }
+    }
+
+    /**
+     * @brief 补充线程：空闲连接低于 min_idle 时逐个在后台建立连接，
+     *        使请求线程不必自己承担 TCP 握手和认证的耗时；建立失败时等待 connection_timeout 后重试
+     */
+    void replenishIdleConnections() {
+        size_t next_shard = 0;
+        std::unique_lock<std::mutex> lock(filler_mutex_);
+        while (filler_running_) {
+            filler_cv_.wait(lock, [this] { return !filler_running_ || replenish_pending_.load(); });
+            if (!filler_running_) break;
+            replenish_pending_ = false;
+            
+            lock.unlock();
+            bool failed = false;
+            while (filler_running_ && idle_total_.load() < config_.min_idle) {
+                if (created_.load() >= config_.max_connections) break;
+                if (!createIdle(next_shard++ % shards_.size())) {
+                    failed = created_.load() < config_.max_connections;
+                    break;
+                }
+                notifyWaiters();
+            }
+            lock.lock();
+            
+            if (failed) {
+                filler_cv_.wait_for(lock, config_.connection_timeout, [this] { return !filler_running_.load(); });
+                replenish_pending_ = true;  // 重试
+            }
+        }
+    }
+
+    // 唤醒一个同步等待者（仅在有线程等待时才触碰等待锁）
+    void notifySyncWaiters() {
+        if (sync_waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            wait_cv_.notify_one();
+        }
+    }
+
+    // 连接变为可用或容量空出后：优先服务异步等待者，再唤醒同步等待者
+    void notifyWaiters() {
+        if (async_waiter_count_.load() > 0) {
+            serveAsyncWaiters();
+        }
+        notifySyncWaiters();
+    }
+
+    /**
+     * @brief 为异步等待者取连接并按 FIFO 顺序移交，回调在锁外执行
+     *        归还线程先放回连接再调用本函数，登记线程先登记再调用本函数，
+     *        两侧都是"先写后查"，因此任何一方都不会遗漏另一方
+     */
+    void serveAsyncWaiters() {
+        while (async_waiter_count_.load() > 0) {
+            uint32_t index = 0;
+            if (takeConnection(index) != AcquireResult::ACQUIRED) {
+                return;  // 暂无可用连接，下一次归还时再服务
+            }
             
-            // 记录最后使用时间
-            raw_conn->setLastUsed(std::chrono::steady_clock::now());
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            if (async_waiters_.empty()) {
+                // 等待者已被其他线程服务或已超时，连接放回空闲分片
+                lock.unlock();
+                pushIdle(homeShard(), index);
+                notifySyncWaiters();
+                return;
+            }
+            AsyncWaiter waiter = std::move(async_waiters_.front());
+            async_waiters_.pop_front();
+            --async_waiter_count_;
+            lock.unlock();
             
-            // 放回空闲队列
-            idle_connections_.push_back(it->second);
-            active_connections_.erase(it);
+            recordWait(waiter.start);
+            waiter.callback(lease(index));
+        }
+    }
+
+    /**
+     * @brief 释放连接回连接池（不持有全局锁）
+     * @param index 连接所在槽位
+     */
+    void releaseConnection(uint32_t index) {
+        DBConn& conn = *slots_[index].conn;
+        
+        // 已损坏的连接直接关闭，不再复用
+        if (conn.isBroken()) {
+            bump(closed_broken_);
+            destroySlot(index);
+            notifyWaiters();
+            return;
+        }
+        
+        // 干净的连接直接放回，需要重置的在锁外重置（或交给后台线程）
+        if (!conn.needsReset()) {
+            bump(resets_skipped_);
+        } else {
+            bump(resets_);
+            if (config_.async_reset) {
+                {
+                    std::lock_guard<std::mutex> lock(reset_mutex_);
+                    reset_queue_.push_back(index);
+                }
+                reset_cv_.notify_one();
+                return;
+            }
+            conn.reset();
+        }
+        rejoinIdle(index, homeShard());
+    }
+    
+    /**
+     * @brief 重置后的连接重新放回空闲分片（重置时发现断线则关闭），并通知等待者
+     */
+    void rejoinIdle(uint32_t index, size_t shard_index) {
+        DBConn& conn = *slots_[index].conn;
+        if (conn.isBroken()) {
+            bump(closed_broken_);
+            destroySlot(index);
+            notifyWaiters();
+            return;
+        }
+        
+        // 记录最后使用时间
+        conn.setLastUsed(std::chrono::steady_clock::now());
+        
+        // 放回分片，并通知等待者
+        pushIdle(shard_index, index);
+        notifyWaiters();
+    }
+    
+    /**
+     * @brief 后台重置线程：依次重置归还的连接后再放回空闲分片；停止前处理完队列中的连接
+     */
+    void resetConnections() {
+        size_t next_shard = 0;
+        std::unique_lock<std::mutex> lock(reset_mutex_);
+        while (true) {
+            reset_cv_.wait(lock, [this] { return !reset_running_ || !reset_queue_.empty(); });
+            if (reset_queue_.empty()) break;  // 已停止且队列为空
             
-            // 通知等待线程
-            pool_cv_.notify_one();
+            std::vector<uint32_t> batch;
+            batch.swap(reset_queue_);
+            lock.unlock();
+            for (uint32_t index : batch) {
+                slots_[index].conn->reset();
+                rejoinIdle(index, next_shard++ % shards_.size());
+            }
+            lock.lock();
         }
     }
     
     /**
-     * @brief 清理空闲时间过长的连接
+     * @brief 清理空闲时间过长的连接；BACKGROUND 策略下同时定期校验空闲连接
      */
     void cleanIdleConnections() {
+        const auto start = std::chrono::steady_clock::now();
+        auto next_clean = start + std::chrono::seconds(30);
+        auto next_validate = config_.validation == ValidationPolicy::BACKGROUND
+            ? start + config_.validation_interval
+            : std::chrono::steady_clock::time_point::max();
+        std::unique_lock<std::mutex> lock(cleaner_mutex_);
         while (cleaner_running_) {
-            std::unique_lock<std::mutex> lock(cleaner_mutex_);
-            // 使用条件变量定时唤醒 (C++11)
-            cleaner_cv_.wait_for(lock, std::chrono::seconds(30), 
-                [this] { return !cleaner_running_; });
+            // 使用条件变量定时唤醒：每30秒清理一次，校验周期到达或异步请求到期时提前唤醒
+            cleaner_cv_.wait_until(lock, std::min({ next_clean, next_validate, earliest_deadline_ }));
             
             if (!cleaner_running_) break;
             
-            std::unique_lock<std::mutex> pool_lock(pool_mutex_);
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= earliest_deadline_) {
+                expireAsyncWaiters(lock, now);
+                continue;
+            }
+            if (now >= next_validate) {
+                lock.unlock();
+                validateIdleConnections();
+                lock.lock();
+                next_validate = std::chrono::steady_clock::now() + config_.validation_interval;
+                continue;
+            }
+            if (now < next_clean) continue;
+            next_clean = now + std::chrono::seconds(30);
             
-            // 清理空闲时间过长的连接
-            auto it = idle_connections_.begin();
-            while (it != idle_connections_.end()) {
-                if ((*it)->getIdleDuration() > max_idle_time_) {
-                    (*it)->close();
-                    it = idle_connections_.erase(it);
+            lock.unlock();
+            removeExpiredIdle();
+            lock.lock();
+        }
+    }
+    
+    /**
+     * @brief 关闭空闲时间超过 max_idle_time 的连接（在分片锁外关闭）
+     */
+    void removeExpiredIdle() {
+        // 至少保留 min_idle 个空闲连接
+        const size_t idle = idle_total_.load();
+        size_t budget = idle > config_.min_idle ? idle - config_.min_idle : 0;
+        
+        std::vector<uint32_t> expired;
+        for (auto& shard : shards_) {
+            if (budget == 0) break;
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            const size_t before = expired.size();
+            auto keep = std::remove_if(shard->idle.begin(), shard->idle.end(), [&](uint32_t index) {
+                if (budget == 0 || slots_[index].conn->getIdleDuration() <= config_.max_idle_time) {
+                    return false;
+                }
+                expired.push_back(index);
+                --budget;
+                return true;
+            });
+            shard->idle.erase(keep, shard->idle.end());
+            shard->count.store(shard->idle.size(), std::memory_order_relaxed);
+            idle_total_.fetch_sub(expired.size() - before);
+        }
+        closed_idle_.fetch_add(expired.size(), std::memory_order_relaxed);
+        for (uint32_t index : expired) {
+            destroySlot(index);
+        }
+        if (!expired.empty()) {
+            notifyWaiters();
+        }
+    }
+    
+    /**
+     * @brief 后台校验空闲连接：逐个取出超过 validation_interval 未确认可用的连接，在锁外 ping，
+     *        可用的放回原分片（或移交给等待者），失效的关闭
+     */
+    void validateIdleConnections() {
+        for (size_t s = 0; s < shards_.size() && cleaner_running_; ++s) {
+            Shard& shard = *shards_[s];
+            while (cleaner_running_) {
+                uint32_t index = 0;
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    auto it = std::find_if(shard.idle.begin(), shard.idle.end(), [this](uint32_t i) {
+                        return slots_[i].conn->getUnvalidatedDuration() >= config_.validation_interval;
+                    });
+                    if (it == shard.idle.end()) break;
+                    index = *it;
+                    shard.idle.erase(it);
+                    shard.count.store(shard.idle.size(), std::memory_order_relaxed);
+                }
+                idle_total_.fetch_sub(1);
+                
+                DBConn& conn = *slots_[index].conn;
+                if (conn.ping()) {
+                    conn.setLastValidated(std::chrono::steady_clock::now());
+                    pushIdle(s, index);
+                } else {
+                    bump(ping_failures_);
+                    destroySlot(index);
+                }
+                notifyWaiters();
+            }
+        }
+    }
+    
+    /**
+     * @brief 以 nullptr 结束已超时的异步请求，并重新计算最早截止时间
+     * @param lock 已持有的 cleaner_mutex_，回调执行期间临时释放
+     */
+    void expireAsyncWaiters(std::unique_lock<std::mutex>& lock, std::chrono::steady_clock::time_point now) {
+        std::vector<AcquireCallback> expired;
+        {
+            std::lock_guard<std::mutex> wait_lock(wait_mutex_);
+            auto earliest = std::chrono::steady_clock::time_point::max();
+            auto it = async_waiters_.begin();
+            while (it != async_waiters_.end()) {
+                if (it->deadline <= now) {
+                    expired.push_back(std::move(it->callback));
+                    it = async_waiters_.erase(it);
+                    --async_waiter_count_;
                 } else {
+                    earliest = std::min(earliest, it->deadline);
                     ++it;
                 }
             }
+            earliest_deadline_ = earliest;
         }
+        
+        timeouts_.fetch_add(expired.size(), std::memory_order_relaxed);
+        
+        // 回调可能再次发起异步获取，不能持有任何锁
+        lock.unlock();
+        for (auto& callback : expired) {
+            callback(nullptr);
+        }
+        lock.lock();
     }
     
-    const size_t max_connections_;                       // 最大连接数
+    const DBPoolConfig config_;                          // 连接池配置
     Factory connection_factory_;                         // 连接创建工厂
-    const std::chrono::milliseconds max_idle_time_;      // 最大空闲时间
-    const std::chrono::milliseconds connection_timeout_; // 获取连接超时时间
     
-    std::list<ConnectionPtr> idle_connections_;          // 空闲连接队列
-    std::map<DBConn*, ConnectionPtr> active_connections_; // 活动连接映射
+    std::unique_ptr<Slot[]> slots_;                      // 连接槽位（容量为最大连接数）
+    std::mutex slots_mutex_;                             // 保护空闲槽位表（仅在新建/关闭连接时使用）
+    std::vector<uint32_t> free_slots_;                   // 未使用的槽位
+    std::atomic<size_t> created_{ 0 };                   // 已创建（含正在创建）的连接数
+    
+    std::vector<std::unique_ptr<Shard>> shards_;         // 空闲连接分片
+    std::atomic<size_t> idle_total_{ 0 };                // 各分片空闲连接总数
     
-    std::mutex pool_mutex_;                              // 连接池互斥锁
-    std::condition_variable pool_cv_;                    // 连接池条件变量
+    std::mutex wait_mutex_;                              // 等待者互斥锁
+    std::condition_variable wait_cv_;                    // 同步等待条件变量
+    std::atomic<size_t> sync_waiters_{ 0 };              // 同步等待的线程数
+    std::list<AsyncWaiter> async_waiters_;               // 异步获取请求（FIFO，受 wait_mutex_ 保护）
+    std::atomic<size_t> async_waiter_count_{ 0 };        // 异步获取请求数（供归还线程无锁判断）
     
     std::thread cleaner_thread_;                         // 清理线程
     std::mutex cleaner_mutex_;                           // 清理线程互斥锁
     std::condition_variable cleaner_cv_;                 // 清理线程条件变量
     std::atomic<bool> cleaner_running_;                  // C++11原子布尔值
+    std::chrono::steady_clock::time_point earliest_deadline_ =
+        std::chrono::steady_clock::time_point::max();    // 异步请求的最早截止时间（受 cleaner_mutex_ 保护）
+    
+    std::thread filler_thread_;                          // 空闲连接补充线程（min_idle > 0 时启动）
+    std::mutex filler_mutex_;                            // 补充线程互斥锁
+    std::condition_variable filler_cv_;                  // 补充线程条件变量
+    std::atomic<bool> filler_running_;                   // 补充线程运行标志
+    std::atomic<bool> replenish_pending_{ false };       // 是否有待处理的补充请求
+    
+    std::thread reset_thread_;                           // 后台重置线程（async_reset 时启动）
+    std::mutex reset_mutex_;                             // 保护待重置队列
+    std::condition_variable reset_cv_;                   // 重置线程条件变量
+    std::vector<uint32_t> reset_queue_;                  // 待重置的连接槽位
+    bool reset_running_;                                 // 重置线程运行标志（受 reset_mutex_ 保护）
+    
+    // 统计计数器（relaxed，仅供 stats() 读取）
+    std::atomic<uint64_t> acquired_{ 0 };
+    std::atomic<uint64_t> timeouts_{ 0 };
+    std::atomic<uint64_t> exhausted_{ 0 };
+    std::atomic<uint64_t> steals_{ 0 };
+    std::atomic<uint64_t> created_total_{ 0 };
+    std::atomic<uint64_t> create_failures_{ 0 };
+    std::atomic<uint64_t> closed_idle_{ 0 };
+    std::atomic<uint64_t> closed_broken_{ 0 };
+    std::atomic<uint64_t> ping_failures_{ 0 };
+    std::atomic<uint64_t> resets_{ 0 };
+    std::atomic<uint64_t> resets_skipped_{ 0 };
 };
 
 #endif
\ No newline at end of file
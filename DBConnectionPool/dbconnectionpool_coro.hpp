@@ -0,0 +1,116 @@
+
+/*--------此为连接池的C++20协程封装，需同时包含线程池协程层，切记需要使用支持C++20及以上的编译器--------*/
+
+#ifndef DBCONNECTIONPOOL_CORO_H
+#define DBCONNECTIONPOOL_CORO_H
+
+#include "dbconnectionpool.hpp"
+#include "asyncqueryengine.hpp"
+#include "../ThreadPool/threadpool_coro.hpp"
+
+/**
+ * 用法：
+ *   Task<void> agent(DBConnectionPool& db, AdvancedThreadPool& pool) {
+ *       auto conn = co_await asyncConnection(db, pool);   // 等待连接期间不占用线程
+ *       if (!conn) co_return;                             // 超时
+ *       ...
+ *   }
+ *
+ *   Task<void> report(AsyncQueryEngine& engine) {
+ *       QueryResult r = co_await asyncQuery(engine, "SELECT ...");  // 查询期间不占用线程，完成后在线程池上恢复
+ *   }
+ */
+
+// co_await 的等待体：连接可立即获取时不挂起，否则挂起到连接归还（或超时）后在线程池上恢复
+class ConnectionAwaitable {
+public:
+    ConnectionAwaitable(DBConnectionPool& pool, AdvancedThreadPool& executor,
+                        std::chrono::milliseconds timeout, TaskPriority priority)
+        : pool_(pool), executor_(executor), timeout_(timeout), priority_(priority) {}
+
+    bool await_ready() {
+        conn_ = pool_.tryGetConnection();
+        return conn_ != nullptr;
+    }
+
+    // 注册回调后协程可能已在其他线程恢复，此后不能再访问 this
+    void await_suspend(std::coroutine_handle<> handle) {
+        DBConnectionPool::ConnectionPtr* slot = &conn_;
+        AdvancedThreadPool* executor = &executor_;
+        const TaskPriority priority = priority_;
+
+        pool_.asyncGetConnection([slot, executor, priority, handle](DBConnectionPool::ConnectionPtr conn) {
+            *slot = std::move(conn);
+            try {
+                // 不在归还连接的线程上继续执行协程
+                executor->post(priority, [handle] { handle.resume(); });
+            }
+            catch (...) {
+                // 线程池已关闭或队列满：就地恢复，保证协程不丢失
+                handle.resume();
+            }
+        }, timeout_);
+    }
+
+    // 超时返回 nullptr
+    DBConnectionPool::ConnectionPtr await_resume() { return std::move(conn_); }
+
+private:
+    DBConnectionPool& pool_;
+    AdvancedThreadPool& executor_;
+    const std::chrono::milliseconds timeout_;
+    const TaskPriority priority_;
+    DBConnectionPool::ConnectionPtr conn_;
+};
+
+/**
+ * @brief 协程中获取数据库连接
+ * @param pool 连接池
+ * @param executor 等待后用于恢复协程的线程池
+ * @param timeout 获取连接超时时间（默认5秒，超时 co_await 结果为 nullptr）
+ * @param priority 恢复协程时使用的任务优先级
+ */
+inline ConnectionAwaitable asyncConnection(DBConnectionPool& pool, AdvancedThreadPool& executor,
+                                           std::chrono::milliseconds timeout = std::chrono::seconds(5),
+                                           TaskPriority priority = TaskPriority::NORMAL) {
+    return ConnectionAwaitable(pool, executor, timeout, priority);
+}
+
+// co_await 的等待体：通过异步查询引擎执行查询，完成回调（已在线程池上）中直接恢复协程
+class QueryAwaitable {
+public:
+    QueryAwaitable(AsyncQueryEngine& engine, std::string sql, TaskPriority priority)
+        : engine_(engine), sql_(std::move(sql)), priority_(priority) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    // 提交后协程可能已在其他线程恢复，此后不能再访问 this
+    void await_suspend(std::coroutine_handle<> handle) {
+        QueryResult* slot = &result_;
+        engine_.query(std::move(sql_), [slot, handle](QueryResult result) {
+            *slot = std::move(result);
+            handle.resume();
+        }, priority_);
+    }
+
+    QueryResult await_resume() { return std::move(result_); }
+
+private:
+    AsyncQueryEngine& engine_;
+    std::string sql_;
+    const TaskPriority priority_;
+    QueryResult result_;
+};
+
+/**
+ * @brief 协程中异步执行查询
+ * @param engine 异步查询引擎
+ * @param sql SQL语句
+ * @param priority 完成后恢复协程时使用的任务优先级
+ */
+inline QueryAwaitable asyncQuery(AsyncQueryEngine& engine, std::string sql,
+                                 TaskPriority priority = TaskPriority::NORMAL) {
+    return QueryAwaitable(engine, std::move(sql), priority);
+}
+
+#endif // DBCONNECTIONPOOL_CORO_H
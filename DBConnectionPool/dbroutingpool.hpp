@@ -0,0 +1,271 @@
+
+/*--------此为多后端读写分离路由连接池，使用时包含该头文件即可，切记需要使用支持C++17及以上的编译器--------*/
+
+#ifndef DBROUTINGPOOL_H
+#define DBROUTINGPOOL_H
+
+#include "dbconnectionpool.hpp"
+
+// 取连接时声明的读写意图
+enum class QueryIntent {
+    READ,   // 只读查询，路由到从库（从库全部不可用时回退主库）
+    WRITE   // 写入或需要读到最新数据的查询，始终路由到主库
+};
+
+// 从库选择策略
+enum class ReplicaSelection {
+    LEAST_OUTSTANDING,  // 借出连接数最少的从库（相同时轮转）
+    LATENCY_WEIGHTED    // 平滑后的连接持有时长 ×（借出连接数 + 1）最小的从库
+};
+
+// 路由连接池配置参数
+struct DBRoutingConfig {
+    ReplicaSelection selection = ReplicaSelection::LEAST_OUTSTANDING;  // 从库选择策略
+    uint32_t eject_after_failures = 3;                                 // 连续失败多少次后摘除从库
+    std::chrono::milliseconds eject_duration = std::chrono::seconds(30); // 摘除时长，到期后试探性恢复
+    bool read_fallback_to_primary = true;                              // 从库都不可用时读请求回退主库
+    double latency_smoothing = 0.2;                                    // 持有时长指数平滑系数
+};
+
+/**
+ * DBRoutingPool类 - 主库 + 多个从库的路由连接池
+ *
+ * 每个后端是一个独立的 DBConnectionPool；写请求走主库，读请求按策略选择从库。
+ * 从库新建连接失败、校验（ping）失败或归还损坏连接都计为失败，连续失败达到阈值即被摘除，
+ * eject_duration 后重新参与选择，此时再失败一次就会再次摘除（被动健康检查，不额外启动线程）
+ */
+class DBRoutingPool {
+public:
+    using ConnectionPtr = DBConnectionPool::ConnectionPtr;
+
+    DBRoutingPool(const DBRoutingPool&) = delete;
+    DBRoutingPool& operator=(const DBRoutingPool&) = delete;
+
+    /**
+     * @brief 构造函数
+     * @param primary 主库连接池
+     * @param replicas 从库连接池（可为空，此时读请求也走主库）
+     * @param config 路由配置
+     */
+    DBRoutingPool(std::unique_ptr<DBConnectionPool> primary,
+                  std::vector<std::unique_ptr<DBConnectionPool>> replicas,
+                  DBRoutingConfig config = DBRoutingConfig())
+        : config_(config) {
+        if (!primary) {
+            throw std::invalid_argument("DBRoutingPool requires a primary pool");
+        }
+        primary_.pool = std::move(primary);
+        replicas_.reserve(replicas.size());
+        for (auto& replica : replicas) {
+            replicas_.push_back(std::make_unique<Backend>());
+            replicas_.back()->pool = std::move(replica);
+        }
+    }
+
+    /**
+     * @brief 构造函数：各后端使用相同的连接池配置
+     * @param config 每个后端的连接池配置
+     * @param primary 主库连接工厂
+     * @param replicas 从库连接工厂
+     * @param routing 路由配置
+     */
+    DBRoutingPool(const DBPoolConfig& config, DBConnectionPool::Factory primary,
+                  const std::vector<DBConnectionPool::Factory>& replicas,
+                  DBRoutingConfig routing = DBRoutingConfig())
+        : DBRoutingPool(std::make_unique<DBConnectionPool>(config, std::move(primary)),
+                        makePools(config, replicas), routing) {}
+
+    /**
+     * @brief 获取连接
+     * @param intent 读写意图
+     * @return 连接；所有候选后端都超时或失败时返回 nullptr
+     *
+     * 读请求先按策略顺序对健康从库做非阻塞获取，都没有空闲连接时在最优从库上等待
+     */
+    ConnectionPtr getConnection(QueryIntent intent = QueryIntent::WRITE) {
+        if (intent == QueryIntent::WRITE || replicas_.empty()) {
+            return acquirePrimary(false);
+        }
+
+        const auto candidates = rankReplicas();
+        for (Backend* backend : candidates) {
+            if (auto conn = acquireFrom(*backend, true)) {
+                return conn;
+            }
+        }
+        const auto now = std::chrono::steady_clock::now();
+        for (Backend* backend : candidates) {
+            if (isEjected(*backend, now)) continue;  // 非阻塞尝试期间刚被摘除
+            if (auto conn = acquireFrom(*backend, false)) {
+                return conn;
+            }
+            break;
+        }
+        return config_.read_fallback_to_primary ? acquirePrimary(false) : nullptr;
+    }
+
+    /**
+     * @brief 非阻塞获取连接，没有可立即取得的连接时返回 nullptr
+     */
+    ConnectionPtr tryGetConnection(QueryIntent intent = QueryIntent::WRITE) {
+        if (intent == QueryIntent::WRITE || replicas_.empty()) {
+            return acquirePrimary(true);
+        }
+        for (Backend* backend : rankReplicas()) {
+            if (auto conn = acquireFrom(*backend, true)) {
+                return conn;
+            }
+        }
+        return config_.read_fallback_to_primary ? acquirePrimary(true) : nullptr;
+    }
+
+    DBConnectionPool& primary() { return *primary_.pool; }
+    DBConnectionPool& replica(size_t i) { return *replicas_.at(i)->pool; }
+    size_t replicaCount() const { return replicas_.size(); }
+
+    // 从库当前是否处于摘除期
+    bool isEjected(size_t i) const {
+        return isEjected(*replicas_.at(i), std::chrono::steady_clock::now());
+    }
+
+    // 从库当前借出的连接数
+    size_t outstanding(size_t i) const {
+        return replicas_.at(i)->outstanding.load(std::memory_order_relaxed);
+    }
+
+private:
+    // 单个后端的路由状态
+    struct alignas(64) Backend {
+        std::unique_ptr<DBConnectionPool> pool;
+        std::atomic<size_t> outstanding{ 0 };          // 借出中的连接数
+        std::atomic<int64_t> latency_ns{ 0 };          // 平滑后的连接持有时长
+        std::atomic<uint32_t> failures{ 0 };           // 连续失败次数
+        std::atomic<uint64_t> seen_failures{ 0 };      // 上次观察到的 healthFailures()
+        std::atomic<int64_t> ejected_until{ 0 };       // 摘除截止时间（steady_clock 纳秒，0 表示健康）
+    };
+
+    // 借出连接的删除器：归还底层连接并更新后端状态
+    struct Lease {
+        DBRoutingPool* router;
+        Backend* backend;
+        ConnectionPtr inner;
+        std::chrono::steady_clock::time_point start;
+        void operator()(DBConn*) {
+            const bool broken = inner->isBroken();
+            inner.reset();  // 先归还给后端连接池
+            router->onReleased(*backend, broken, std::chrono::steady_clock::now() - start);
+        }
+    };
+
+    static std::vector<std::unique_ptr<DBConnectionPool>> makePools(
+        const DBPoolConfig& config, const std::vector<DBConnectionPool::Factory>& factories) {
+        std::vector<std::unique_ptr<DBConnectionPool>> pools;
+        pools.reserve(factories.size());
+        for (const auto& factory : factories) {
+            pools.push_back(std::make_unique<DBConnectionPool>(config, factory));
+        }
+        return pools;
+    }
+
+    static int64_t toNanos(std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    bool isEjected(const Backend& backend, std::chrono::steady_clock::time_point now) const {
+        return backend.ejected_until.load(std::memory_order_relaxed) > toNanos(now);
+    }
+
+    /**
+     * @brief 按策略对健康从库排序（最优在前）
+     */
+    std::vector<Backend*> rankReplicas() {
+        const auto now = std::chrono::steady_clock::now();
+        const size_t n = replicas_.size();
+        const size_t offset = next_.fetch_add(1, std::memory_order_relaxed);  // 轮转起点，打破平局
+
+        std::vector<std::pair<double, Backend*>> ranked;
+        ranked.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            Backend* backend = replicas_[(offset + i) % n].get();
+            if (isEjected(*backend, now)) continue;
+            const double outstanding = static_cast<double>(backend->outstanding.load(std::memory_order_relaxed));
+            double score = outstanding;
+            if (config_.selection == ReplicaSelection::LATENCY_WEIGHTED) {
+                // 没有样本的后端按1纳秒计，优先得到样本
+                const double latency = static_cast<double>(std::max<int64_t>(backend->latency_ns.load(std::memory_order_relaxed), 1));
+                score = latency * (outstanding + 1);
+            }
+            ranked.emplace_back(score, backend);
+        }
+        std::stable_sort(ranked.begin(), ranked.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<Backend*> result;
+        result.reserve(ranked.size());
+        for (auto& entry : ranked) {
+            result.push_back(entry.second);
+        }
+        return result;
+    }
+
+    ConnectionPtr acquirePrimary(bool non_blocking) {
+        ConnectionPtr conn = non_blocking ? primary_.pool->tryGetConnection() : primary_.pool->getConnection();
+        return conn ? wrap(primary_, std::move(conn)) : nullptr;
+    }
+
+    /**
+     * @brief 从指定从库获取连接，并根据其失败计数更新健康状态
+     */
+    ConnectionPtr acquireFrom(Backend& backend, bool non_blocking) {
+        ConnectionPtr conn = non_blocking ? backend.pool->tryGetConnection() : backend.pool->getConnection();
+        const uint64_t total = backend.pool->healthFailures();
+        const uint64_t seen = backend.seen_failures.exchange(total, std::memory_order_relaxed);
+        if (total > seen) {
+            recordFailures(backend, static_cast<uint32_t>(total - seen));
+        } else if (conn) {
+            backend.failures.store(0, std::memory_order_relaxed);
+        }
+        return conn ? wrap(backend, std::move(conn)) : nullptr;
+    }
+
+    ConnectionPtr wrap(Backend& backend, ConnectionPtr conn) {
+        backend.outstanding.fetch_add(1, std::memory_order_relaxed);
+        DBConn* raw = conn.get();
+        return ConnectionPtr(raw, Lease{ this, &backend, std::move(conn), std::chrono::steady_clock::now() });
+    }
+
+    void onReleased(Backend& backend, bool broken, std::chrono::steady_clock::duration held) {
+        backend.outstanding.fetch_sub(1, std::memory_order_relaxed);
+
+        // 指数平滑持有时长（多线程并发更新时允许丢失个别样本）
+        const int64_t sample = std::chrono::duration_cast<std::chrono::nanoseconds>(held).count();
+        const int64_t prev = backend.latency_ns.load(std::memory_order_relaxed);
+        const int64_t next = prev == 0 ? sample
+            : static_cast<int64_t>(prev + config_.latency_smoothing * static_cast<double>(sample - prev));
+        backend.latency_ns.store(next, std::memory_order_relaxed);
+
+        if (broken && &backend != &primary_) {
+            recordFailures(backend, 1);
+        }
+    }
+
+    /**
+     * @brief 累加连续失败次数，达到阈值时摘除从库；摘除期满后只需再失败一次即重新摘除
+     */
+    void recordFailures(Backend& backend, uint32_t count) {
+        const uint32_t failures = backend.failures.fetch_add(count, std::memory_order_relaxed) + count;
+        if (failures < config_.eject_after_failures) return;
+
+        const auto until = std::chrono::steady_clock::now() + config_.eject_duration;
+        backend.ejected_until.store(toNanos(until), std::memory_order_relaxed);
+        backend.failures.store(config_.eject_after_failures > 0 ? config_.eject_after_failures - 1 : 0,
+                               std::memory_order_relaxed);
+    }
+
+    const DBRoutingConfig config_;                     // 路由配置
+    Backend primary_;                                  // 主库
+    std::vector<std::unique_ptr<Backend>> replicas_;   // 从库
+    std::atomic<size_t> next_{ 0 };                    // 轮转计数
+};
+
+#endif // DBROUTINGPOOL_H
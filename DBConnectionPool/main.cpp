@@ -7,7 +7,15 @@
 #include <chrono>
 #include <random>
 #include <cassert>
+#include <cstring>
 #include "dbconnectionpool.hpp" // 实现的连接池头文件
+#include "dbroutingpool.hpp"    // 读写分离路由连接池
+#if __cplusplus >= 202002L
+#include "asyncqueryengine.hpp" // 异步查询引擎（需 C++20）
+#endif
+#ifdef MYSQL_WAIT_READ
+#include <poll.h>
+#endif
 
 using namespace std;
 using namespace std::chrono;
@@ -39,13 +47,18 @@ public:
     }
     
     bool ping() override {
+        ping_count++;
         return ping_success && connected;
     }
     
     void reset() override {
         // 模拟重置操作
+        reset_count++;
+        dirty = false;
     }
     
+    bool needsReset() const override { return dirty; }
+    
     void close() override {
         connected = false;
     }
@@ -53,10 +66,17 @@ public:
     // 测试辅助函数
     void setPingSuccess(bool success) { ping_success = success; }
     bool isConnected() const { return connected; }
+    int pingCount() const { return ping_count; }
+    int resetCount() const { return reset_count; }
+    void setDirty() { dirty = true; }  // 模拟开启事务
 
 private:
-    bool connected;
-    bool ping_success;
+    // 清理线程可能在后台 ping，状态使用原子变量
+    atomic<bool> connected;
+    atomic<bool> ping_success;
+    atomic<int> ping_count{0};
+    atomic<int> reset_count{0};
+    atomic<bool> dirty{false};
 };
 
 // ==================== 单元测试 ====================
@@ -122,8 +142,380 @@ void test_invalid_connection_replacement() {
     TEST(conn2 != nullptr);
 }
 
+void test_try_get_connection() {
+    auto factory = []() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<MockDBConnection>();
+    };
+    
+    DBConnectionPool pool(1, factory);
+    
+    auto conn1 = pool.tryGetConnection();
+    
+    // 已达上限时应立即返回 nullptr，而不是等待超时
+    auto start = steady_clock::now();
+    auto conn2 = pool.tryGetConnection();
+    TEST(conn1 != nullptr && conn2 == nullptr && steady_clock::now() - start < milliseconds(100));
+}
+
+void test_async_connection_handoff() {
+    auto factory = []() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<MockDBConnection>();
+    };
+    
+    DBConnectionPool pool(1, factory);
+    auto conn1 = pool.getConnection();
+    DBConn* conn1_ptr = conn1.get();
+    
+    DBConnectionPool::ConnectionPtr received;
+    int calls = 0;
+    pool.asyncGetConnection([&](DBConnectionPool::ConnectionPtr conn) {
+        received = std::move(conn);
+        calls++;
+    });
+    bool waiting = (calls == 0);
+    
+    // 归还连接时，回调在归还线程上收到同一个连接
+    conn1.reset();
+    TEST(waiting && calls == 1 && received.get() == conn1_ptr);
+}
+
+void test_async_connection_timeout() {
+    auto factory = []() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<MockDBConnection>();
+    };
+    
+    DBConnectionPool pool(1, factory);
+    auto conn1 = pool.getConnection();
+    
+    mutex m;
+    condition_variable cv;
+    bool done = false;
+    bool got_null = false;
+    auto start = steady_clock::now();
+    pool.asyncGetConnection([&](DBConnectionPool::ConnectionPtr conn) {
+        lock_guard<mutex> lock(m);
+        got_null = (conn == nullptr);
+        done = true;
+        cv.notify_one();
+    }, milliseconds(50));
+    
+    // 超时后由清理线程以 nullptr 回调，不必等到30秒的清理周期
+    unique_lock<mutex> lock(m);
+    bool signaled = cv.wait_for(lock, seconds(2), [&] { return done; });
+    TEST(signaled && got_null && steady_clock::now() - start >= milliseconds(50));
+}
+
+void test_validation_idle_threshold() {
+    auto factory = []() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<MockDBConnection>();
+    };
+    
+    DBPoolConfig config;
+    config.max_connections = 2;
+    config.validation = ValidationPolicy::IDLE_THRESHOLD;
+    config.validation_threshold = milliseconds(100);
+    DBConnectionPool pool(config, factory);
+    
+    MockDBConnection* mock = nullptr;
+    {
+        auto conn = pool.getConnection();
+        mock = static_cast<MockDBConnection*>(conn.get());
+    }
+    
+    // 刚归还的连接直接复用，不做 ping
+    pool.getConnection();
+    bool skipped = (mock->pingCount() == 0);
+    
+    // 空闲超过阈值后取出时才 ping
+    this_thread::sleep_for(milliseconds(150));
+    pool.getConnection();
+    TEST(skipped && mock->pingCount() == 1);
+}
+
+void test_validation_on_borrow() {
+    auto factory = []() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<MockDBConnection>();
+    };
+    
+    DBPoolConfig config;
+    config.max_connections = 2;
+    config.validation = ValidationPolicy::ON_BORROW;
+    DBConnectionPool pool(config, factory);
+    
+    MockDBConnection* mock = nullptr;
+    {
+        auto conn = pool.getConnection();
+        mock = static_cast<MockDBConnection*>(conn.get());
+    }
+    pool.getConnection();
+    pool.getConnection();
+    TEST(mock->pingCount() == 2);
+}
+
+void test_mark_broken() {
+    atomic<int> created{0};
+    auto factory = [&created]() -> DBConnectionPool::ConnectionPtr {
+        created++;
+        return make_shared<MockDBConnection>();
+    };
+    
+    DBConnectionPool pool(1, factory);
+    {
+        auto conn = pool.getConnection();
+        conn->markBroken(); // 模拟查询时发现连接已断开
+    }
+    
+    // 损坏的连接归还时被关闭，容量空出，下一次获取创建新连接
+    auto conn2 = pool.getConnection();
+    TEST(conn2 != nullptr && created == 2);
+}
+
+void test_background_validation() {
+    atomic<int> created{0};
+    auto factory = [&created]() -> DBConnectionPool::ConnectionPtr {
+        created++;
+        return make_shared<MockDBConnection>();
+    };
+    
+    DBPoolConfig config;
+    config.max_connections = 1;
+    config.validation = ValidationPolicy::BACKGROUND;
+    config.validation_interval = milliseconds(50);
+    DBConnectionPool pool(config, factory);
+    
+    {
+        auto conn = pool.getConnection();
+        static_cast<MockDBConnection*>(conn.get())->setPingSuccess(false);
+    }
+    
+    // 取出时不 ping，清理线程在后台发现失效连接并关闭它
+    this_thread::sleep_for(milliseconds(300));
+    auto conn2 = pool.getConnection();
+    TEST(conn2 != nullptr && created == 2);
+}
+
 // ==================== MySQL 集成测试 ====================
 
+// 测试分片：两个线程交错归还后，各自再次获取拿到的是自己用过的连接（单一LIFO队列会拿到对方的）
+void test_shard_affinity() {
+    DBPoolConfig config;
+    config.max_connections = 2;
+    config.shards = 2;
+    DBConnectionPool pool(config, []() { return make_shared<MockDBConnection>(); });
+    
+    atomic<int> step{0};
+    auto wait_step = [&step](int s) { while (step.load() < s) this_thread::yield(); };
+    DBConn* first = nullptr;
+    DBConn* again = nullptr;
+    
+    // 两个线程先后首次使用连接池，主分片相邻，因此互不相同
+    thread a([&] {
+        auto conn = pool.getConnection();
+        first = conn.get();
+        step = 1;
+        wait_step(2);
+        conn.reset();   // 先归还
+        step = 3;
+        wait_step(4);
+        again = pool.getConnection().get();
+    });
+    thread b([&] {
+        wait_step(1);
+        auto conn = pool.getConnection();
+        step = 2;
+        wait_step(3);
+        conn.reset();   // 后归还
+        step = 4;
+    });
+    a.join();
+    b.join();
+    
+    TEST(first != nullptr && again == first);
+}
+
+// 测试分片：多线程并发获取时连接总数不超过上限
+void test_shard_concurrent_limit() {
+    atomic<int> created{0};
+    atomic<int> in_use{0};
+    atomic<int> max_in_use{0};
+    atomic<int> failures{0};
+    DBPoolConfig config;
+    config.max_connections = 3;
+    config.shards = 3;
+    DBConnectionPool pool(config, [&created]() -> DBConnectionPool::ConnectionPtr {
+        created++;
+        return make_shared<MockDBConnection>();
+    });
+    
+    vector<thread> workers;
+    for (int t = 0; t < 6; ++t) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < 200; ++i) {
+                auto conn = pool.getConnection();
+                if (!conn) { failures++; continue; }
+                int now = ++in_use;
+                int prev = max_in_use.load();
+                while (now > prev && !max_in_use.compare_exchange_weak(prev, now)) {}
+                this_thread::yield();
+                --in_use;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    
+    TEST(failures == 0 && created <= 3 && max_in_use <= 3);
+}
+
+// 测试预热：构造时并行建立 initial_size 个连接，之后取连接不再新建
+void test_warm_up() {
+    atomic<int> created{0};
+    DBPoolConfig config;
+    config.max_connections = 8;
+    config.initial_size = 4;
+    config.warmup_threads = 4;
+    
+    auto start = steady_clock::now();
+    DBConnectionPool pool(config, [&created]() -> DBConnectionPool::ConnectionPtr {
+        created++;
+        this_thread::sleep_for(milliseconds(100)); // 模拟握手耗时
+        return make_shared<MockDBConnection>();
+    });
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+    
+    auto conn = pool.getConnection();
+    TEST(conn != nullptr && created == 4 && elapsed < 400);
+}
+
+// 测试低水位补充：空闲连接被取走后由后台线程补足 min_idle
+void test_min_idle_replenish() {
+    atomic<int> created{0};
+    DBPoolConfig config;
+    config.max_connections = 4;
+    config.min_idle = 2;
+    DBConnectionPool pool(config, [&created]() -> DBConnectionPool::ConnectionPtr {
+        created++;
+        return make_shared<MockDBConnection>();
+    });
+    
+    auto conn1 = pool.getConnection();
+    auto conn2 = pool.getConnection();
+    
+    // 两个空闲连接都被取走，后台补充到上限为止
+    auto deadline = steady_clock::now() + seconds(2);
+    while (created < 4 && steady_clock::now() < deadline) {
+        this_thread::sleep_for(milliseconds(10));
+    }
+    auto conn3 = pool.tryGetConnection();
+    TEST(created == 4 && conn3 != nullptr);
+}
+
+// 测试归还：干净的连接不重置，开启过事务的连接重置一次
+void test_reset_only_dirty() {
+    DBConnectionPool pool(1, []() { return make_shared<MockDBConnection>(); });
+    
+    MockDBConnection* mock = nullptr;
+    {
+        auto conn = pool.getConnection();
+        mock = static_cast<MockDBConnection*>(conn.get());
+    }
+    bool clean_skipped = mock->resetCount() == 0;
+    {
+        auto conn = pool.getConnection();
+        static_cast<MockDBConnection*>(conn.get())->setDirty();
+    }
+    TEST(clean_skipped && mock->resetCount() == 1);
+}
+
+// 测试后台重置：归还线程不执行重置，连接重置完成后才能再次取出
+void test_async_reset() {
+    DBPoolConfig config;
+    config.max_connections = 1;
+    config.async_reset = true;
+    DBConnectionPool pool(config, []() { return make_shared<MockDBConnection>(); });
+    
+    MockDBConnection* mock = nullptr;
+    {
+        auto conn = pool.getConnection();
+        mock = static_cast<MockDBConnection*>(conn.get());
+        mock->setDirty();
+    }
+    auto conn = pool.getConnection();  // 等待后台重置完成
+    TEST(conn.get() == mock && mock->resetCount() == 1 && !mock->needsReset());
+}
+
+// 测试统计快照：取出、超时、非阻塞失败、损坏关闭与等待时间
+void test_pool_stats() {
+    DBConnectionPool pool(1, []() { return make_shared<MockDBConnection>(); },
+                          minutes(10), milliseconds(50));
+    {
+        auto conn = pool.getConnection();
+        TEST(pool.tryGetConnection() == nullptr);
+        TEST(pool.getConnection() == nullptr);   // 等待 50ms 后超时
+        conn->markBroken();
+    }
+    auto conn = pool.getConnection();
+    
+    DBPoolStats stats = pool.stats();
+    TEST(stats.acquired == 2 && stats.timeouts == 1 && stats.exhausted == 1);
+    TEST(stats.created == 2 && stats.closed_broken == 1);
+    TEST(stats.total_connections == 1 && stats.idle_connections == 0);
+    // 两次成功获取都有等待样本；超时的那次不计入
+    TEST(stats.wait.count == 2 && stats.wait.percentile(1.0) < 50000000);
+}
+
+// 计数工厂：factory 为 nullptr 时模拟无法建立连接
+static DBConnectionPool::Factory countingFactory(atomic<int>& created, bool fail = false) {
+    return [&created, fail]() -> DBConnectionPool::ConnectionPtr {
+        created++;
+        return fail ? nullptr : make_shared<MockDBConnection>();
+    };
+}
+
+// 测试读写分离：写请求走主库，读请求走从库
+void test_routing_read_write() {
+    atomic<int> primary{0}, replica1{0}, replica2{0};
+    DBPoolConfig config;
+    config.max_connections = 2;
+    DBRoutingPool router(config, countingFactory(primary),
+                         { countingFactory(replica1), countingFactory(replica2) });
+    
+    auto w = router.getConnection(QueryIntent::WRITE);
+    auto r = router.getConnection(QueryIntent::READ);
+    TEST(w && r && primary == 1 && replica1 + replica2 == 1);
+}
+
+// 测试最少借出：两个读连接同时借出时分布在两个从库
+void test_routing_least_outstanding() {
+    atomic<int> primary{0}, replica1{0}, replica2{0};
+    DBPoolConfig config;
+    config.max_connections = 2;
+    DBRoutingPool router(config, countingFactory(primary),
+                         { countingFactory(replica1), countingFactory(replica2) });
+    
+    auto r1 = router.getConnection(QueryIntent::READ);
+    auto r2 = router.getConnection(QueryIntent::READ);
+    TEST(r1 && r2 && replica1 == 1 && replica2 == 1 && primary == 0);
+    TEST(router.outstanding(0) == 1 && router.outstanding(1) == 1);
+}
+
+// 测试摘除：无法建立连接的从库连续失败后被摘除，读请求仍然成功
+void test_routing_ejection() {
+    atomic<int> primary{0}, bad{0}, good{0};
+    DBPoolConfig config;
+    config.max_connections = 2;
+    DBRoutingConfig routing;
+    routing.eject_after_failures = 2;
+    DBRoutingPool router(config, countingFactory(primary),
+                         { countingFactory(bad, true), countingFactory(good) }, routing);
+    
+    bool all_ok = true;
+    for (int i = 0; i < 6; ++i) {
+        all_ok = all_ok && router.getConnection(QueryIntent::READ) != nullptr;
+    }
+    TEST(all_ok && router.isEjected(0) && !router.isEjected(1));
+    TEST(bad == 2 && primary == 0);  // 摘除后不再尝试坏从库
+}
+
 void test_mysql_basic_operations() {
     // MySQL连接工厂
     auto mysql_factory = []() -> DBConnectionPool::ConnectionPtr {
@@ -289,6 +681,161 @@ void performance_test(int thread_count, int operations_per_thread) {
          << " ops/秒" << endl;
 }
 
+
+// 测试预处理语句缓存与批量写入（需要真实MySQL）
+void test_mysql_batch_operations() {
+    auto mysql_factory = []() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<MySQLConnection>("127.0.0.1", 3306, 
+                                           "root", "123456", "test_db");
+    };
+    
+    DBConnectionPool mysql_pool(2, mysql_factory);
+    auto conn = mysql_pool.getConnection();
+    TEST(conn != nullptr);
+    if (!conn) return;
+    auto* mysql = dynamic_cast<MySQLConnection*>(conn.get());
+    
+    TEST(mysql->execute("CREATE TABLE IF NOT EXISTS batch_test ("
+                        "id INT NOT NULL, name VARCHAR(32) NOT NULL, value DOUBLE NOT NULL)"));
+    
+    // 1. 数组绑定：1000 行参数按 256 行一条语句写入
+    const size_t rows = 1000;
+    vector<int> ids(rows);
+    vector<double> values(rows);
+    vector<MYSQL_BIND> binds(rows * 3);
+    static char name[] = "bind";
+    unsigned long name_len = 4;
+    for (size_t r = 0; r < rows; ++r) {
+        ids[r] = static_cast<int>(r);
+        values[r] = r * 0.5;
+        MYSQL_BIND* row = &binds[r * 3];
+        memset(row, 0, sizeof(MYSQL_BIND) * 3);
+        row[0].buffer_type = MYSQL_TYPE_LONG;
+        row[0].buffer = &ids[r];
+        row[1].buffer_type = MYSQL_TYPE_STRING;
+        row[1].buffer = name;
+        row[1].buffer_length = name_len;
+        row[1].length = &name_len;
+        row[2].buffer_type = MYSQL_TYPE_DOUBLE;
+        row[2].buffer = &values[r];
+    }
+    TEST(mysql->executeBatch("INSERT INTO batch_test (id, name, value)", 3, binds.data(), rows));
+    TEST(mysql->cachedStatementCount() == 2); // 256 行整块与末尾 232 行各一条
+    
+    // 2. 多行 INSERT 构造器（含需要转义的字符串）
+    MultiRowInsert insert(*mysql, "INSERT INTO batch_test (id, name, value)", 4096);
+    for (int i = 0; i < 500; ++i) {
+        insert.row().value(i).value(string("it's")).value(i * 1.5);
+    }
+    TEST(insert.flush());
+    
+    // 3. 多语句流水线
+    size_t completed = 0;
+    TEST(mysql->executeMulti({ "UPDATE batch_test SET value = 0 WHERE id = 1",
+                               "DELETE FROM batch_test WHERE id >= 990",
+                               "SELECT COUNT(*) FROM batch_test" }, &completed));
+    TEST(completed == 3);
+    
+    // 预处理语句查询总行数
+    MYSQL_STMT* stmt = mysql->prepare("SELECT COUNT(*) FROM batch_test");
+    TEST(stmt != nullptr && mysql_stmt_execute(stmt) == 0);
+    long long count = 0;
+    MYSQL_BIND result;
+    memset(&result, 0, sizeof(result));
+    result.buffer_type = MYSQL_TYPE_LONGLONG;
+    result.buffer = &count;
+    TEST(mysql_stmt_bind_result(stmt, &result) == 0 && mysql_stmt_fetch(stmt) == 0);
+    mysql_stmt_free_result(stmt);
+    TEST(count == 1490);
+    
+    // 容量设为 0 时按 1 处理：刚准备的语句仍由缓存持有，可以执行
+    mysql->setStatementCacheCapacity(0);
+    TEST(mysql->cachedStatementCount() == 1);
+    TEST(mysql->executeBatch("INSERT INTO batch_test (id, name, value)", 3, binds.data(), 10, 4));
+    TEST(mysql->cachedStatementCount() == 1);
+    mysql->setStatementCacheCapacity(64);
+    
+    TEST(mysql->execute("DROP TABLE batch_test"));
+}
+// 测试 MariaDB 非阻塞查询接口（需要真实MySQL，客户端库为 MariaDB Connector/C 时才编译）
+void test_mysql_nonblocking_query() {
+#ifdef MYSQL_WAIT_READ
+    MySQLConnection conn("127.0.0.1", 3306, "root", "123456", "test_db");
+    TEST(conn.connect());
+    
+    // 按返回的等待事件 poll 套接字，直到查询完成
+    QueryResult result;
+    int status = conn.queryStart("SELECT 1 + 1", result);
+    while (status != 0) {
+        pollfd fd{ conn.socket(), 0, 0 };
+        if (status & MYSQL_WAIT_READ) fd.events |= POLLIN;
+        if (status & MYSQL_WAIT_WRITE) fd.events |= POLLOUT;
+        if (status & MYSQL_WAIT_EXCEPT) fd.events |= POLLPRI;
+        const int timeout = (status & MYSQL_WAIT_TIMEOUT) ? static_cast<int>(conn.waitTimeoutMs()) : -1;
+        const int n = poll(&fd, 1, timeout);
+        int ready = 0;
+        if (n == 0) ready |= MYSQL_WAIT_TIMEOUT;
+        if (fd.revents & (POLLIN | POLLERR | POLLHUP)) ready |= MYSQL_WAIT_READ;
+        if (fd.revents & POLLOUT) ready |= MYSQL_WAIT_WRITE;
+        if (fd.revents & POLLPRI) ready |= MYSQL_WAIT_EXCEPT;
+        status = conn.queryContinue(ready, result);
+    }
+    TEST(result.ok && result.rows.size() == 1 && result.rows[0][0] == "2");
+    
+    // 非阻塞模式下阻塞接口照常可用
+    TEST(conn.execute("DO 1"));
+#endif
+}
+
+// 测试异步查询引擎：并发查询多于连接数，结果经线程池回调返回（MariaDB 客户端库下走非阻塞事件循环）
+void test_mysql_async_query_engine() {
+#if __cplusplus >= 202002L
+    auto mysql_factory = []() -> DBConnectionPool::ConnectionPtr {
+        return make_shared<MySQLConnection>("127.0.0.1", 3306, 
+                                           "root", "123456", "test_db");
+    };
+    DBConnectionPool mysql_pool(2, mysql_factory);
+    ThreadPoolConfig config;
+    config.mode = PoolMode::FIXED;
+    config.min_threads = 2;
+    AdvancedThreadPool executor(config);
+    
+    vector<future<QueryResult>> results;
+    {
+        AsyncQueryEngine engine(mysql_pool, executor);
+        for (int i = 0; i < 8; ++i) {
+            results.push_back(engine.query("SELECT " + to_string(i) + ", SLEEP(0.01)"));
+        }
+    }
+    bool all_ok = true;
+    for (int i = 0; i < 8; ++i) {
+        QueryResult r = results[i].get();
+        all_ok = all_ok && r.ok && r.rows.size() == 1 && r.rows[0][0] == to_string(i);
+    }
+    TEST(all_ok);
+    
+#ifndef MYSQL_WAIT_READ
+    // 阻塞模式：排队的请求不占用连接，1 个I/O线程只用 1 个连接，另一个连接仍可立即取得
+    AsyncQueryEngineConfig engine_config;
+    engine_config.io_threads = 1;
+    vector<future<QueryResult>> slow;
+    {
+        AsyncQueryEngine engine(mysql_pool, executor, engine_config);
+        for (int i = 0; i < 4; ++i) {
+            slow.push_back(engine.query("SELECT SLEEP(0.1)"));
+        }
+        this_thread::sleep_for(milliseconds(20));
+        const auto start = steady_clock::now();
+        auto conn = mysql_pool.getConnection();
+        TEST(conn != nullptr && steady_clock::now() - start < milliseconds(50));
+    }
+    for (auto& f : slow) {
+        TEST(f.get().ok);
+    }
+#endif
+#endif
+}
+
 // ==================== 异常测试 ====================
 
 void test_connection_timeout() {
@@ -324,10 +871,30 @@ int main() {
     test_max_connections();
     test_invalid_connection_replacement();
     test_connection_timeout();
+    test_try_get_connection();
+    test_async_connection_handoff();
+    test_async_connection_timeout();
+    test_validation_idle_threshold();
+    test_validation_on_borrow();
+    test_mark_broken();
+    test_background_validation();
+    test_shard_affinity();
+    test_shard_concurrent_limit();
+    test_warm_up();
+    test_min_idle_replenish();
+    test_reset_only_dirty();
+    test_async_reset();
+    test_pool_stats();
+    test_routing_read_write();
+    test_routing_least_outstanding();
+    test_routing_ejection();
     
     // 集成测试
     cout << "\n[集成测试]" << endl;
     test_mysql_basic_operations();
+    test_mysql_batch_operations();
+    test_mysql_nonblocking_query();
+    test_mysql_async_query_engine();
     
     // 性能测试
     cout << "\n[性能测试]" << endl;
@@ -12,6 +12,9 @@
 #include <mutex>
 #include <shared_mutex>
 #include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <type_traits>
 
 // LevelDB 管理器异常类
 class LevelDBException : public std::runtime_error {
@@ -20,15 +23,55 @@ public:
         : std::runtime_error(msg + ": " + status.ToString()) {}
 };
 
-// LevelDB 管理器类 - 单例模式
+// 扫描选项
+struct ScanOptions {
+    bool fill_cache = true;                       // 读到的数据块是否放入块缓存（一次性的大范围扫描建议关闭）
+    bool verify_checksums = false;                // 是否校验读到的数据块
+    const leveldb::Snapshot* snapshot = nullptr;  // 在指定快照上读取（nullptr 为当前最新数据）
+
+    leveldb::ReadOptions toReadOptions() const {
+        leveldb::ReadOptions read_options;
+        read_options.fill_cache = fill_cache;
+        read_options.verify_checksums = verify_checksums;
+        read_options.snapshot = snapshot;
+        return read_options;
+    }
+};
+
+// 数据库实例配置参数（每个实例独立设置）
+struct LevelDBConfig {
+    bool create_if_missing = true;             // 创建缺失的数据库
+    size_t block_cache_size = 100 * 1048576;   // 块缓存大小（0 表示使用 LevelDB 内置的 8MB 缓存）
+    size_t write_buffer_size = 64 * 1048576;   // 写缓冲区大小
+    int bloom_bits_per_key = 10;               // 布隆过滤器每键位数（0 表示不使用）
+    int max_open_files = 1000;                 // 最大打开文件数
+    size_t block_size = 4 * 1024;              // 数据块大小
+    bool compression = true;                   // 是否启用 Snappy 压缩
+};
+
+// LevelDB 管理器类
+//
+// 既可以通过 getInstance() 使用进程内的默认实例（以及按名称区分的具名实例），
+// 也可以直接构造多个独立实例。所有读写操作与 shutdown() 之间是线程安全的：
+// 进行中的读写完成后才会关闭；已创建的迭代器、快照和扫描持有数据库引用，最后一个释放时才真正关闭
 class LevelDBManager {
+    struct Database;  // 已打开的数据库（定义见私有部分）
+    
 public:
+    using ScanOptions = ::ScanOptions;  // 与 ShardedLevelDBManager::ScanOptions 对应，供按存储类型参数化的代码使用
+    
     // 删除拷贝构造函数和赋值运算符
     LevelDBManager(const LevelDBManager&) = delete;
     LevelDBManager& operator=(const LevelDBManager&) = delete;
     
+    LevelDBManager() = default;
+    
+    ~LevelDBManager() {
+        shutdown();
+    }
+    
     /**
-     * @brief 获取 LevelDB 管理器单例
+     * @brief 获取默认 LevelDB 管理器实例
      * @return LevelDBManager 实例
      */
     static LevelDBManager& getInstance() {
@@ -36,57 +79,88 @@ public:
         return instance;
     }
     
+    /**
+     * @brief 获取具名 LevelDB 管理器实例，首次访问时创建
+     * @param name 实例名称
+     * @return LevelDBManager 实例（进程退出前一直有效）
+     */
+    static LevelDBManager& getInstance(const std::string& name) {
+        static std::mutex registry_mutex;
+        static std::unordered_map<std::string, std::unique_ptr<LevelDBManager>> registry;
+        
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto& instance = registry[name];
+        if (!instance) {
+            instance = std::make_unique<LevelDBManager>();
+        }
+        return *instance;
+    }
+    
     /**
      * @brief 初始化 LevelDB 数据库
      * @param db_path 数据库路径
      * @param options 数据库选项 (可选)
      * 
-     * 如果未提供 options，将使用优化过的默认选项：
+     * 如果未提供 options，将使用 LevelDBConfig 的默认配置：
      * - 创建缺失的数据库
      * - 100MB 块缓存
      * - 10位布隆过滤器
      * - 64MB 写缓冲区
+     *
+     * 提供 options 时其中的 block_cache/filter_policy 由调用方负责释放
      */
     void initialize(const std::string& db_path, 
                    const leveldb::Options* options = nullptr) {
-        std::lock_guard<std::mutex> lock(init_mutex_);
-        
-        if (db_) {
-            throw LevelDBException("LevelDB already initialized", leveldb::Status::OK());
+        if (!options) {
+            initialize(db_path, LevelDBConfig());
+            return;
         }
+        open(db_path, *options, std::make_shared<Database>());
+    }
+    
+    /**
+     * @brief 按实例配置初始化 LevelDB 数据库，块缓存与过滤器由本实例持有
+     * @param db_path 数据库路径
+     * @param config 实例配置
+     */
+    void initialize(const std::string& db_path, const LevelDBConfig& config) {
+        auto database = std::make_shared<Database>();
         
         leveldb::Options opts;
-        if (options) {
-            opts = *options;
-        } else {
-            // 设置优化的默认选项
-            opts.create_if_missing = true;
-            opts.block_cache = leveldb::NewLRUCache(100 * 1048576); // 100MB 缓存
-            opts.filter_policy = leveldb::NewBloomFilterPolicy(10);  // 10位布隆过滤器
-            opts.write_buffer_size = 64 * 1048576; // 64MB 写缓冲区
+        opts.create_if_missing = config.create_if_missing;
+        opts.write_buffer_size = config.write_buffer_size;
+        opts.max_open_files = config.max_open_files;
+        opts.block_size = config.block_size;
+        opts.compression = config.compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+        if (config.block_cache_size > 0) {
+            database->block_cache.reset(leveldb::NewLRUCache(config.block_cache_size));
+            opts.block_cache = database->block_cache.get();
         }
-        
-        leveldb::DB* db_ptr = nullptr;
-        leveldb::Status status = leveldb::DB::Open(opts, db_path, &db_ptr);
-        
-        if (!status.ok()) {
-            throw LevelDBException("Failed to open LevelDB database", status);
+        if (config.bloom_bits_per_key > 0) {
+            database->filter_policy.reset(leveldb::NewBloomFilterPolicy(config.bloom_bits_per_key));
+            opts.filter_policy = database->filter_policy.get();
         }
         
-        db_.reset(db_ptr);
-        db_path_ = db_path;
-        initialized_ = true;
+        open(db_path, opts, std::move(database));
     }
     
     /**
      * @brief 关闭数据库并释放资源
+     *
+     * 等待进行中的读写完成；仍存活的迭代器、快照持有的引用释放后数据库才真正关闭。
+     * 先置关闭标志让新的读写直接抛出异常，再取独占锁：shared_mutex 偏向读者，
+     * 持续的读写流量下否则可能一直拿不到锁
      */
     void shutdown() {
-        std::lock_guard<std::mutex> lock(init_mutex_);
-        if (db_) {
-            db_.reset();
+        std::shared_ptr<Database> database;
+        closing_.fetch_add(1, std::memory_order_acq_rel);
+        {
+            std::unique_lock<std::shared_mutex> lock(db_mutex_);
+            database.swap(db_);
             initialized_ = false;
         }
+        closing_.fetch_sub(1, std::memory_order_acq_rel);
+        // 在锁外析构，避免阻塞其他实例方法
     }
     
     /**
@@ -102,6 +176,7 @@ public:
      * @return 数据库路径
      */
     std::string getDBPath() const {
+        std::shared_lock<std::shared_mutex> lock(db_mutex_);
         return db_path_;
     }
     
@@ -109,16 +184,15 @@ public:
      * @brief 获取原始数据库对象指针
      * @return leveldb::DB 指针
      * 
-     * 注意：使用前必须确保数据库已初始化
+     * 注意：使用前必须确保数据库已初始化，且返回的指针不受 shutdown() 保护，
+     * 需要与 shutdown() 并发时使用本类的接口或迭代器
      */
     leveldb::DB* getDB() const {
-        if (!initialized_ || !db_) {
-            throw LevelDBException("LevelDB not initialized", leveldb::Status::IOError("Not initialized"));
-        }
-        return db_.get();
+        auto lock = lockShared();
+        return checkedDB();
     }
     
-    // 基本操作封装
+    // 基本操作封装（键值参数为 leveldb::Slice，可直接传入 std::string 或栈上缓冲区）
     
     /**
      * @brief 写入键值对
@@ -126,11 +200,12 @@ public:
      * @param value 值
      * @param sync 是否同步写入 (默认 false)
      */
-    void put(const std::string& key, const std::string& value, bool sync = false) {
+    void put(const leveldb::Slice& key, const leveldb::Slice& value, bool sync = false) {
         leveldb::WriteOptions write_options;
         write_options.sync = sync;
         
-        leveldb::Status status = db_->Put(write_options, key, value);
+        auto lock = lockShared();
+        leveldb::Status status = checkedDB()->Put(write_options, key, value);
         if (!status.ok()) {
             throw LevelDBException("Put operation failed", status);
         }
@@ -140,11 +215,13 @@ public:
      * @brief 读取键值对
      * @param key 键
      * @param value 存储读取结果的字符串引用
+     * @param options 读取选项（可指定快照）
      * @return 是否成功找到键值
      */
-    bool get(const std::string& key, std::string& value) {
-        leveldb::ReadOptions read_options;
-        leveldb::Status status = db_->Get(read_options, key, &value);
+    bool get(const leveldb::Slice& key, std::string& value, const ScanOptions& options = ScanOptions()) {
+        leveldb::ReadOptions read_options = options.toReadOptions();
+        auto lock = lockShared();
+        leveldb::Status status = checkedDB()->Get(read_options, key, &value);
         
         if (status.IsNotFound()) {
             return false;
@@ -161,11 +238,12 @@ public:
      * @param key 键
      * @param sync 是否同步删除 (默认 false)
      */
-    void del(const std::string& key, bool sync = false) {
+    void del(const leveldb::Slice& key, bool sync = false) {
         leveldb::WriteOptions write_options;
         write_options.sync = sync;
         
-        leveldb::Status status = db_->Delete(write_options, key);
+        auto lock = lockShared();
+        leveldb::Status status = checkedDB()->Delete(write_options, key);
         if (!status.ok() && !status.IsNotFound()) {
             throw LevelDBException("Delete operation failed", status);
         }
@@ -176,10 +254,11 @@ public:
      * @param key 键
      * @return 是否存在
      */
-    bool exists(const std::string& key) {
+    bool exists(const leveldb::Slice& key) {
         std::string value;
         leveldb::ReadOptions read_options;
-        leveldb::Status status = db_->Get(read_options, key, &value);
+        auto lock = lockShared();
+        leveldb::Status status = checkedDB()->Get(read_options, key, &value);
         
         if (status.IsNotFound()) {
             return false;
@@ -198,14 +277,18 @@ public:
      */
     class BatchWriter {
     public:
-        BatchWriter() = default;
+        // 写入默认实例
+        BatchWriter() : manager_(&LevelDBManager::getInstance()) {}
+        
+        // 写入指定实例
+        explicit BatchWriter(LevelDBManager& manager) : manager_(&manager) {}
         
         /**
          * @brief 添加写入操作
          * @param key 键
          * @param value 值
          */
-        void put(const std::string& key, const std::string& value) {
+        void put(const leveldb::Slice& key, const leveldb::Slice& value) {
             batch_.Put(key, value);
         }
         
@@ -213,7 +296,7 @@ public:
          * @brief 添加删除操作
          * @param key 键
          */
-        void del(const std::string& key) {
+        void del(const leveldb::Slice& key) {
             batch_.Delete(key);
         }
         
@@ -225,7 +308,7 @@ public:
             leveldb::WriteOptions write_options;
             write_options.sync = sync;
             
-            leveldb::Status status = LevelDBManager::getInstance().getDB()->Write(write_options, &batch_);
+            leveldb::Status status = manager_->write(write_options, &batch_);
             if (!status.ok()) {
                 throw LevelDBException("Batch commit failed", status);
             }
@@ -241,39 +324,53 @@ public:
         }
         
     private:
+        LevelDBManager* manager_;     // 目标实例
         leveldb::WriteBatch batch_;
     };
     
     /**
-     * @brief 创建批量写入器
+     * @brief 创建写入本实例的批量写入器
      * @return BatchWriter 实例
      */
     BatchWriter createBatch() {
-        return BatchWriter();
+        return BatchWriter(*this);
     }
     
     // 迭代器接口
     
     /**
      * @brief 键值对迭代器
+     *
+     * 可指定扫描选项和上界（不包含）：越过上界即视为无效，调用方无需自己比较键。
+     * keySlice()/valueSlice() 直接返回指向 LevelDB 内部缓冲区的视图，在 next()/seek() 前有效。
+     * 通过 createIterator() 创建的迭代器持有数据库引用，期间 shutdown() 不会使其失效
      */
     class Iterator {
     public:
-        explicit Iterator(leveldb::DB* db) 
-            : db_(db), it_(db->NewIterator(leveldb::ReadOptions())) {
+        explicit Iterator(leveldb::DB* db,
+                          const ScanOptions& options = ScanOptions(),
+                          std::string upper_bound = std::string())
+            : it_(db->NewIterator(options.toReadOptions())),
+              upper_bound_(std::move(upper_bound)) {
             it_->SeekToFirst();
         }
         
-        ~Iterator() {
-            delete it_;
+        Iterator(std::shared_ptr<const Database> database,
+                 const ScanOptions& options = ScanOptions(),
+                 std::string upper_bound = std::string())
+            : database_(std::move(database)),
+              it_(database_->db->NewIterator(options.toReadOptions())),
+              upper_bound_(std::move(upper_bound)) {
+            it_->SeekToFirst();
         }
         
         /**
          * @brief 检查迭代器是否有效
-         * @return 是否有效
+         * @return 是否有效（已越过上界时返回 false）
          */
         bool valid() const {
-            return it_->Valid();
+            return it_->Valid() &&
+                   (upper_bound_.empty() || it_->key().compare(upper_bound_) < 0);
         }
         
         /**
@@ -299,11 +396,25 @@ public:
             return it_->value().ToString();
         }
         
+        /**
+         * @brief 获取当前键（不拷贝）
+         */
+        leveldb::Slice keySlice() const {
+            return it_->key();
+        }
+        
+        /**
+         * @brief 获取当前值（不拷贝）
+         */
+        leveldb::Slice valueSlice() const {
+            return it_->value();
+        }
+        
         /**
          * @brief 移动到指定键
          * @param key 要查找的键
          */
-        void seek(const std::string& key) {
+        void seek(const leveldb::Slice& key) {
             it_->Seek(key);
         }
         
@@ -315,23 +426,131 @@ public:
         }
         
         /**
-         * @brief 移动到最后一个键
+         * @brief 移动到最后一个键（有上界时为上界之前的最后一个键）
          */
         void seekToLast() {
-            it_->SeekToLast();
+            if (upper_bound_.empty()) {
+                it_->SeekToLast();
+                return;
+            }
+            it_->Seek(upper_bound_);
+            if (it_->Valid()) {
+                it_->Prev();
+            } else {
+                it_->SeekToLast();
+            }
+        }
+        
+        /**
+         * @brief 获取迭代状态
+         */
+        leveldb::Status status() const {
+            return it_->status();
         }
         
     private:
-        leveldb::DB* db_;
-        leveldb::Iterator* it_;
+        std::shared_ptr<const Database> database_;  // 数据库引用（须先于 it_ 声明，后于 it_ 析构）
+        std::unique_ptr<leveldb::Iterator> it_;
+        std::string upper_bound_;                   // 上界（不包含），为空表示不限
     };
     
     /**
      * @brief 创建迭代器
+     * @param options 扫描选项
+     * @param upper_bound 上界（不包含），为空表示不限
      * @return Iterator 实例
      */
-    Iterator createIterator() {
-        return Iterator(getDB());
+    Iterator createIterator(const ScanOptions& options = ScanOptions(),
+                            std::string upper_bound = std::string()) {
+        return Iterator(acquire(), options, std::move(upper_bound));
+    }
+    
+    /**
+     * @brief 快照（RAII），析构时释放
+     */
+    class Snapshot {
+    public:
+        explicit Snapshot(std::shared_ptr<const Database> database)
+            : database_(std::move(database)), snapshot_(database_->db->GetSnapshot()) {}
+        ~Snapshot() { database_->db->ReleaseSnapshot(snapshot_); }
+        
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        
+        const leveldb::Snapshot* get() const { return snapshot_; }
+        
+    private:
+        std::shared_ptr<const Database> database_;
+        const leveldb::Snapshot* snapshot_;
+    };
+    
+    /**
+     * @brief 创建快照，配合 ScanOptions::snapshot 在一致的视图上多次扫描
+     */
+    std::unique_ptr<Snapshot> createSnapshot() {
+        return std::make_unique<Snapshot>(acquire());
+    }
+    
+    // 零拷贝扫描
+    
+    /**
+     * @brief 遍历 [start_key, upper_bound) 内的键值对，不拷贝键值
+     * @param start_key 起始键 (包含)
+     * @param upper_bound 上界 (不包含)，为空表示扫描到末尾
+     * @param visitor 访问函数，参数为 (leveldb::Slice, leveldb::Slice) 或 (std::string_view, std::string_view)；
+     *                返回 bool 时返回 false 即提前结束扫描
+     * @param options 扫描选项
+     * @return 访问过的键值对数量
+     *
+     * 传给 visitor 的视图只在本次调用内有效，需要保留时自行拷贝
+     */
+    template <typename Visitor>
+    size_t scan(const leveldb::Slice& start_key,
+                const leveldb::Slice& upper_bound,
+                Visitor&& visitor,
+                const ScanOptions& options = ScanOptions()) {
+        Iterator it(acquire(), options, upper_bound.ToString());
+        size_t visited = 0;
+        for (it.seek(start_key); it.valid(); it.next()) {
+            ++visited;
+            if (!visit(visitor, it.keySlice(), it.valueSlice())) {
+                break;
+            }
+        }
+        
+        if (!it.status().ok()) {
+            throw LevelDBException("Scan failed", it.status());
+        }
+        return visited;
+    }
+    
+    /**
+     * @brief 遍历具有指定前缀的键值对，不拷贝键值
+     * @param prefix 键前缀
+     * @param visitor 访问函数，约定同 scan()
+     * @param options 扫描选项
+     * @return 访问过的键值对数量
+     */
+    template <typename Visitor>
+    size_t scanPrefix(const leveldb::Slice& prefix,
+                      Visitor&& visitor,
+                      const ScanOptions& options = ScanOptions()) {
+        return scan(prefix, prefixUpperBound(prefix), std::forward<Visitor>(visitor), options);
+    }
+    
+    /**
+     * @brief 计算前缀扫描的上界：大于所有以 prefix 开头的键的最小键
+     * @return 上界；prefix 为空或全为 0xff 时返回空串（不限）
+     */
+    static std::string prefixUpperBound(const leveldb::Slice& prefix) {
+        std::string bound = prefix.ToString();
+        while (!bound.empty() && static_cast<unsigned char>(bound.back()) == 0xff) {
+            bound.pop_back();
+        }
+        if (!bound.empty()) {
+            bound.back() = static_cast<char>(static_cast<unsigned char>(bound.back()) + 1);
+        }
+        return bound;
     }
     
     // 范围查询
@@ -341,25 +560,18 @@ public:
      * @param start_key 起始键 (包含)
      * @param end_key 结束键 (不包含)
      * @param callback 处理每个键值对的回调函数
+     *
+     * 兼容接口：键值拷贝到复用的缓冲区后回调，热点路径请使用 scan()
      */
     void rangeQuery(const std::string& start_key, 
                    const std::string& end_key,
                    std::function<void(const std::string&, const std::string&)> callback) {
-        leveldb::ReadOptions read_options;
-        std::unique_ptr<leveldb::Iterator> it(db_->NewIterator(read_options));
-        
-        for (it->Seek(start_key); it->Valid(); it->Next()) {
-            std::string key = it->key().ToString();
-            if (!end_key.empty() && key >= end_key) {
-                break;
-            }
-            
-            callback(key, it->value().ToString());
-        }
-        
-        if (!it->status().ok()) {
-            throw LevelDBException("Range query failed", it->status());
-        }
+        std::string key, value;
+        scan(start_key, end_key, [&](const leveldb::Slice& k, const leveldb::Slice& v) {
+            key.assign(k.data(), k.size());
+            value.assign(v.data(), v.size());
+            callback(key, value);
+        });
     }
     
     // 前缀查询
@@ -371,14 +583,7 @@ public:
      */
     void prefixQuery(const std::string& prefix,
                     std::function<void(const std::string&, const std::string&)> callback) {
-        std::string end_key = prefix;
-        if (!end_key.empty()) {
-            // 找到前缀结束位置
-            char last_char = end_key.back();
-            end_key.back() = static_cast<char>(last_char + 1);
-        }
-        
-        rangeQuery(prefix, end_key, callback);
+        rangeQuery(prefix, prefixUpperBound(prefix), std::move(callback));
     }
     
     // 性能统计
@@ -389,7 +594,8 @@ public:
      */
     std::string getStats() {
         std::string stats;
-        if (db_->GetProperty("leveldb.stats", &stats)) {
+        auto lock = lockShared();
+        if (checkedDB()->GetProperty("leveldb.stats", &stats)) {
             return stats;
         }
         return "Statistics not available";
@@ -403,21 +609,106 @@ public:
     void compactRange(const std::string& start_key, const std::string& end_key) {
         leveldb::Slice start(start_key);
         leveldb::Slice end(end_key);
-        db_->CompactRange(&start, &end);
+        auto lock = lockShared();
+        checkedDB()->CompactRange(start_key.empty() ? nullptr : &start,
+                                  end_key.empty() ? nullptr : &end);
     }
 
+    /**
+     * @brief 按 visitor 的参数类型传递 Slice 或 string_view，并解释其返回值（扫描类接口共用）
+     * @return 是否继续扫描
+     */
+    template <typename Visitor>
+    static bool visit(Visitor& visitor, const leveldb::Slice& key, const leveldb::Slice& value) {
+        if constexpr (std::is_invocable_v<Visitor&, const leveldb::Slice&, const leveldb::Slice&>) {
+            using Result = std::invoke_result_t<Visitor&, const leveldb::Slice&, const leveldb::Slice&>;
+            if constexpr (std::is_convertible_v<Result, bool>) {
+                return static_cast<bool>(visitor(key, value));
+            } else {
+                visitor(key, value);
+                return true;
+            }
+        } else {
+            static_assert(std::is_invocable_v<Visitor&, std::string_view, std::string_view>,
+                          "visitor must accept (leveldb::Slice, leveldb::Slice) or (std::string_view, std::string_view)");
+            const std::string_view k(key.data(), key.size());
+            const std::string_view v(value.data(), value.size());
+            using Result = std::invoke_result_t<Visitor&, std::string_view, std::string_view>;
+            if constexpr (std::is_convertible_v<Result, bool>) {
+                return static_cast<bool>(visitor(k, v));
+            } else {
+                visitor(k, v);
+                return true;
+            }
+        }
+    }
+    
 private:
-    LevelDBManager() 
-        : initialized_(false) {}
+    /**
+     * @brief 已打开的数据库及其独占的块缓存、过滤器（析构顺序：先关库，再释放缓存与过滤器）
+     */
+    struct Database {
+        std::unique_ptr<leveldb::Cache> block_cache;
+        std::unique_ptr<const leveldb::FilterPolicy> filter_policy;
+        std::unique_ptr<leveldb::DB> db;
+    };
     
-    ~LevelDBManager() {
-        shutdown();
+    // 打开数据库并替换当前实例状态
+    void open(const std::string& db_path, const leveldb::Options& options,
+              std::shared_ptr<Database> database) {
+        std::unique_lock<std::shared_mutex> lock(db_mutex_);
+        
+        if (db_) {
+            throw LevelDBException("LevelDB already initialized", leveldb::Status::OK());
+        }
+        
+        leveldb::DB* db_ptr = nullptr;
+        leveldb::Status status = leveldb::DB::Open(options, db_path, &db_ptr);
+        
+        if (!status.ok()) {
+            throw LevelDBException("Failed to open LevelDB database", status);
+        }
+        
+        database->db.reset(db_ptr);
+        db_ = std::move(database);
+        db_path_ = db_path;
+        initialized_ = true;
+    }
+    
+    // 读写操作取共享锁；正在关闭时直接抛出异常，不再与 shutdown() 争锁
+    std::shared_lock<std::shared_mutex> lockShared() const {
+        if (closing_.load(std::memory_order_acquire) > 0) {
+            throw LevelDBException("LevelDB is shutting down", leveldb::Status::IOError("Shutting down"));
+        }
+        return std::shared_lock<std::shared_mutex>(db_mutex_);
+    }
+    
+    // 调用方须持有 db_mutex_
+    leveldb::DB* checkedDB() const {
+        if (!db_) {
+            throw LevelDBException("LevelDB not initialized", leveldb::Status::IOError("Not initialized"));
+        }
+        return db_->db.get();
+    }
+    
+    // 获取数据库引用，供迭代器、快照等生命周期跨越多次调用的对象持有
+    std::shared_ptr<const Database> acquire() const {
+        auto lock = lockShared();
+        checkedDB();
+        return db_;
+    }
+    
+    // 批量写入
+    leveldb::Status write(const leveldb::WriteOptions& options, leveldb::WriteBatch* batch) {
+        auto lock = lockShared();
+        return checkedDB()->Write(options, batch);
     }
     
-    std::mutex init_mutex_;                  // 初始化互斥锁
-    std::unique_ptr<leveldb::DB> db_;        // LevelDB 数据库实例
+    mutable std::shared_mutex db_mutex_;     // 保护 db_ 与 db_path_：读写操作共享持有，初始化与关闭独占持有
+    std::shared_ptr<Database> db_;           // LevelDB 数据库实例
     std::string db_path_;                    // 数据库路径
     std::atomic<bool> initialized_{false};   // 初始化标志
+    std::atomic<int> closing_{0};            // 进行中的 shutdown() 数，非零时新的读写直接失败
 };
 
 #endif
\ No newline at end of file
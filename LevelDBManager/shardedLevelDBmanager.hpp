@@ -0,0 +1,407 @@
+#ifndef SHARDEDLEVELDBMANAGER_H
+#define SHARDEDLEVELDBMANAGER_H
+
+#include "levelDBmanager.hpp"
+#include "terrainKeyCodec.hpp"
+#include "advancedthreadpool.hpp"
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+// 键到分片的路由方式
+enum class ShardRouting {
+    HASH,    // 整个键的哈希：写入最均匀，前缀扫描需要访问所有分片
+    PREFIX   // 路由前缀的哈希：同一前缀（如同一网格）落在同一分片，前缀扫描只访问一个分片
+};
+
+// 单个分片的配置
+struct LevelDBShardSpec {
+    std::string path;        // 数据库路径（可分布在不同磁盘上）
+    LevelDBConfig config;    // 该分片的缓存、写缓冲区等参数
+};
+
+// 分片管理器配置参数
+struct ShardedLevelDBConfig {
+    ShardRouting routing = ShardRouting::PREFIX;    // 路由方式
+    // PREFIX 路由提取键的路由前缀，返回 false 时按整个键路由；默认按地形键的网格编号（见 TerrainKeyCodec::routingPrefix）
+    std::function<bool(std::string_view, std::string_view&)> routing_prefix = &TerrainKeyCodec::routingPrefix;
+    std::function<size_t(std::string_view)> router; // 自定义路由（如按区域映射），返回值对分片数取模；设置后忽略 routing
+    AdvancedThreadPool* pool = nullptr;             // 并行提交各分片批量写入与压缩的线程池（不持有；为空时依次执行）
+};
+
+/**
+ * ShardedLevelDBSnapshot类 - 跨分片快照（RAII），由 ShardedLevelDBManager::createSnapshot() 创建
+ *
+ * 依次在每个分片上创建，各分片的快照不是同一时刻的视图；PREFIX 路由下同一网格的数据在同一分片，网格内一致
+ */
+class ShardedLevelDBSnapshot {
+public:
+    explicit ShardedLevelDBSnapshot(std::vector<std::unique_ptr<LevelDBManager::Snapshot>> shards)
+        : shards_(std::move(shards)) {}
+
+    ShardedLevelDBSnapshot(const ShardedLevelDBSnapshot&) = delete;
+    ShardedLevelDBSnapshot& operator=(const ShardedLevelDBSnapshot&) = delete;
+
+    const ShardedLevelDBSnapshot* get() const { return this; }
+
+    const leveldb::Snapshot* shard(size_t index) const { return shards_[index]->get(); }
+
+private:
+    std::vector<std::unique_ptr<LevelDBManager::Snapshot>> shards_;
+};
+
+// 分片管理器的扫描选项：同 ScanOptions，快照为跨分片快照
+struct ShardedScanOptions {
+    bool fill_cache = true;
+    bool verify_checksums = false;
+    const ShardedLevelDBSnapshot* snapshot = nullptr;
+
+    ScanOptions forShard(size_t index) const {
+        ScanOptions options;
+        options.fill_cache = fill_cache;
+        options.verify_checksums = verify_checksums;
+        options.snapshot = snapshot ? snapshot->shard(index) : nullptr;
+        return options;
+    }
+};
+
+/**
+ * ShardedLevelDBManager类 - 把键按哈希或前缀路由到 N 个独立的 LevelDB 实例
+ *
+ * 每个分片是一个独立的 LevelDBManager，各自拥有块缓存、写缓冲区与后台压缩线程，
+ * 写入吞吐与压缩可以随分片数并行扩展。路由哈希使用 FNV-1a，跨进程、跨平台稳定，
+ * 因此同一组分片重新打开后键仍落在原来的分片上（分片数变化时需要重新导入数据）。
+ * 读写、扫描、批量写入与快照接口与 LevelDBManager 一致，可以直接作为 BasicTerrainStorageEngine 的存储
+ */
+class ShardedLevelDBManager {
+public:
+    using Snapshot = ShardedLevelDBSnapshot;
+    using ScanOptions = ShardedScanOptions;
+
+    ShardedLevelDBManager(const ShardedLevelDBManager&) = delete;
+    ShardedLevelDBManager& operator=(const ShardedLevelDBManager&) = delete;
+
+    /**
+     * @brief 构造函数：并行打开所有分片，任一分片打开失败时关闭已打开的分片并抛出异常
+     * @param shards 分片配置
+     * @param config 路由配置
+     */
+    explicit ShardedLevelDBManager(const std::vector<LevelDBShardSpec>& shards,
+                                   ShardedLevelDBConfig config = ShardedLevelDBConfig())
+        : config_(std::move(config)) {
+        if (shards.empty()) {
+            throw std::invalid_argument("ShardedLevelDBManager requires at least one shard");
+        }
+        shards_.reserve(shards.size());
+        for (size_t i = 0; i < shards.size(); ++i) {
+            shards_.push_back(std::make_unique<LevelDBManager>());
+        }
+        try {
+            // 打开只发生一次（可能要回放日志），没有线程池时也每个分片一个线程
+            runAll([&](auto&& task) {
+                std::vector<std::thread> threads;
+                threads.reserve(shards_.size());
+                for (size_t i = 0; i < shards_.size(); ++i) {
+                    threads.emplace_back(task, i);
+                }
+                for (auto& t : threads) {
+                    t.join();
+                }
+            }, [&](size_t i) {
+                shards_[i]->initialize(shards[i].path, shards[i].config);
+            });
+        } catch (...) {
+            shutdown();
+            throw;
+        }
+    }
+
+    ~ShardedLevelDBManager() {
+        shutdown();
+    }
+
+    /**
+     * @brief 关闭所有分片（与进行中的读写之间线程安全，可重复调用）
+     */
+    void shutdown() {
+        for (auto& shard : shards_) {
+            shard->shutdown();
+        }
+    }
+
+    size_t shardCount() const { return shards_.size(); }
+
+    LevelDBManager& shard(size_t index) { return *shards_.at(index); }
+
+    /**
+     * @brief 计算键所属的分片
+     */
+    size_t shardOf(std::string_view key) const {
+        if (config_.router) {
+            return config_.router(key) % shards_.size();
+        }
+        std::string_view prefix;
+        if (config_.routing == ShardRouting::PREFIX && config_.routing_prefix &&
+            config_.routing_prefix(key, prefix)) {
+            key = prefix;
+        }
+        return static_cast<size_t>(hashKey(key) % shards_.size());
+    }
+
+    // 基本操作：路由到键所属的分片
+
+    void put(const leveldb::Slice& key, const leveldb::Slice& value, bool sync = false) {
+        shardFor(key).put(key, value, sync);
+    }
+
+    bool get(const leveldb::Slice& key, std::string& value, const ScanOptions& options = ScanOptions()) {
+        const size_t index = shardOf(view(key));
+        return shards_[index]->get(key, value, options.forShard(index));
+    }
+
+    void del(const leveldb::Slice& key, bool sync = false) {
+        shardFor(key).del(key, sync);
+    }
+
+    bool exists(const leveldb::Slice& key) {
+        return shardFor(key).exists(key);
+    }
+
+    /**
+     * @brief 跨分片批量写入：按分片拆分为多个 WriteBatch
+     *
+     * 每个分片内部的写入是原子的，不同分片之间不保证原子性
+     */
+    class BatchWriter {
+    public:
+        explicit BatchWriter(ShardedLevelDBManager& manager)
+            : manager_(manager), touched_(manager.shardCount(), 0) {
+            batches_.reserve(manager.shardCount());
+            for (size_t i = 0; i < manager.shardCount(); ++i) {
+                batches_.emplace_back(manager.shard(i));
+            }
+        }
+
+        void put(const leveldb::Slice& key, const leveldb::Slice& value) {
+            const size_t index = manager_.shardOf(view(key));
+            batches_[index].put(key, value);
+            touched_[index] = 1;
+        }
+
+        void del(const leveldb::Slice& key) {
+            const size_t index = manager_.shardOf(view(key));
+            batches_[index].del(key);
+            touched_[index] = 1;
+        }
+
+        /**
+         * @brief 提交各分片的批量操作（只提交有写入的分片；设置了线程池时并行提交）
+         * @param sync 是否同步写入 (默认 false)
+         */
+        void commit(bool sync = false) {
+            std::vector<size_t> pending;
+            for (size_t i = 0; i < touched_.size(); ++i) {
+                if (touched_[i]) pending.push_back(i);
+            }
+            manager_.forEach(pending, [&](size_t i) {
+                batches_[i].commit(sync);
+                touched_[i] = 0;
+            });
+        }
+
+        void clear() {
+            for (auto& batch : batches_) {
+                batch.clear();
+            }
+            std::fill(touched_.begin(), touched_.end(), 0);
+        }
+
+    private:
+        ShardedLevelDBManager& manager_;
+        std::vector<LevelDBManager::BatchWriter> batches_;  // 每个分片一个
+        std::vector<uint8_t> touched_;                      // 各分片批次是否有待提交的操作
+    };
+
+    BatchWriter createBatch() {
+        return BatchWriter(*this);
+    }
+
+    std::unique_ptr<Snapshot> createSnapshot() {
+        std::vector<std::unique_ptr<LevelDBManager::Snapshot>> snapshots;
+        snapshots.reserve(shards_.size());
+        for (auto& shard : shards_) {
+            snapshots.push_back(shard->createSnapshot());
+        }
+        return std::make_unique<Snapshot>(std::move(snapshots));
+    }
+
+    // 扫描
+
+    /**
+     * @brief 扫描所有分片中 [start_key, upper_bound) 内的键值对，按键归并后依次访问
+     * @param visitor 访问函数，约定同 LevelDBManager::scan()；返回 false 时结束整个扫描
+     * @param options 扫描选项
+     * @return 访问过的键值对数量
+     *
+     * 结果与单个实例一样整体按键有序
+     */
+    template <typename Visitor>
+    size_t scan(const leveldb::Slice& start_key,
+                const leveldb::Slice& upper_bound,
+                Visitor&& visitor,
+                const ScanOptions& options = ScanOptions()) {
+        if (shards_.size() == 1) {
+            return shards_[0]->scan(start_key, upper_bound, std::forward<Visitor>(visitor), options.forShard(0));
+        }
+        std::vector<LevelDBManager::Iterator> its;
+        its.reserve(shards_.size());
+        const std::string bound = upper_bound.ToString();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            its.push_back(shards_[i]->createIterator(options.forShard(i), bound));
+            its.back().seek(start_key);
+        }
+
+        // 小顶堆：堆顶为当前键最小的分片
+        auto greater = [&its](size_t a, size_t b) {
+            return its[a].keySlice().compare(its[b].keySlice()) > 0;
+        };
+        std::vector<size_t> heap;
+        heap.reserve(its.size());
+        for (size_t i = 0; i < its.size(); ++i) {
+            if (its[i].valid()) heap.push_back(i);
+        }
+        std::make_heap(heap.begin(), heap.end(), greater);
+
+        size_t visited = 0;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            auto& it = its[heap.back()];
+            ++visited;
+            if (!LevelDBManager::visit(visitor, it.keySlice(), it.valueSlice())) {
+                break;
+            }
+            it.next();
+            if (it.valid()) {
+                std::push_heap(heap.begin(), heap.end(), greater);
+            } else {
+                heap.pop_back();
+            }
+        }
+
+        for (auto& it : its) {
+            if (!it.status().ok()) {
+                throw LevelDBException("Scan failed", it.status());
+            }
+        }
+        return visited;
+    }
+
+    /**
+     * @brief 扫描具有指定前缀的键值对
+     *
+     * PREFIX 路由下前缀已包含完整的路由前缀时，所有匹配的键都在同一分片，只扫描该分片；
+     * 否则归并扫描所有分片
+     */
+    template <typename Visitor>
+    size_t scanPrefix(const leveldb::Slice& prefix,
+                      Visitor&& visitor,
+                      const ScanOptions& options = ScanOptions()) {
+        std::string_view routed;
+        if (!config_.router && config_.routing == ShardRouting::PREFIX && config_.routing_prefix &&
+            config_.routing_prefix(view(prefix), routed)) {
+            const size_t index = shardOf(view(prefix));
+            return shards_[index]->scanPrefix(prefix, std::forward<Visitor>(visitor), options.forShard(index));
+        }
+        return scan(prefix, LevelDBManager::prefixUpperBound(prefix), std::forward<Visitor>(visitor), options);
+    }
+
+    // 维护
+
+    /**
+     * @brief 压缩所有分片的键范围（设置了线程池时并行压缩）
+     */
+    void compactRange(const std::string& start_key, const std::string& end_key) {
+        std::vector<size_t> all(shards_.size());
+        for (size_t i = 0; i < all.size(); ++i) all[i] = i;
+        forEach(all, [&](size_t i) {
+            shards_[i]->compactRange(start_key, end_key);
+        });
+    }
+
+    /**
+     * @brief 获取各分片的性能统计信息
+     */
+    std::string getStats() {
+        std::string stats;
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            stats += "=== shard " + std::to_string(i) + " (" + shards_[i]->getDBPath() + ") ===\n";
+            stats += shards_[i]->getStats();
+            stats += "\n";
+        }
+        return stats;
+    }
+
+    /**
+     * @brief 64位 FNV-1a 哈希（结果与平台、标准库实现无关）
+     */
+    static uint64_t hashKey(std::string_view key) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : key) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+private:
+    static std::string_view view(const leveldb::Slice& slice) {
+        return std::string_view(slice.data(), slice.size());
+    }
+
+    LevelDBManager& shardFor(const leveldb::Slice& key) {
+        return *shards_[shardOf(view(key))];
+    }
+
+    /**
+     * @brief 对指定分片执行 func：设置了线程池且不止一个分片时在线程池上并行，否则依次执行
+     *
+     * 不要在 config_.pool 的任务中提交批量写入或压缩，否则线程池占满时会互相等待
+     */
+    template <typename Func>
+    void forEach(const std::vector<size_t>& indices, Func&& func) {
+        runAll([&](auto&& task) {
+            if (config_.pool == nullptr || indices.size() < 2) {
+                for (size_t i : indices) task(i);
+                return;
+            }
+            config_.pool->parallel_for(size_t{ 0 }, indices.size(), 1, [&](size_t k) {
+                task(indices[k]);
+            }).get();
+        }, func);
+    }
+
+    /**
+     * @brief 由 launch 调度 func 在各分片上执行（每个分片都会执行），全部结束后重新抛出第一个异常
+     */
+    template <typename Launch, typename Func>
+    void runAll(Launch&& launch, Func&& func) {
+        std::vector<std::exception_ptr> errors(shards_.size());
+        launch([&](size_t i) {
+            try {
+                func(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+        for (auto& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    const ShardedLevelDBConfig config_;                     // 路由配置
+    std::vector<std::unique_ptr<LevelDBManager>> shards_;   // 分片
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef TERRAINAGGREGATE_HPP
+#define TERRAINAGGREGATE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+/**
+ * TerrainAggregate类 - 一个区域内数据点的聚合值
+ *
+ * 统计点数与可解析为数值（高程）的值的最小、最大值与总和，均值由总和与样本数得出。
+ * 无法解析为数值的值只计入点数。add()/merge() 精确；remove() 在移除的值不是极值时精确，
+ * 移除极值后需要调用方从下一层重新聚合。
+ *
+ * serialize() 输出定长 41 字节：[版本 1B][点数 8B][样本数 8B][最小值 8B][最大值 8B][总和 8B]，小端序
+ */
+struct TerrainAggregate {
+    uint64_t count = 0;     // 数据点数
+    uint64_t samples = 0;   // 值为数值的点数
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+
+    static constexpr size_t kEncodedSize = 41;
+
+    bool empty() const { return count == 0; }
+
+    // 数值样本的均值（没有样本时为 NaN）
+    double mean() const {
+        return samples > 0 ? sum / static_cast<double>(samples) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /**
+     * @brief 把数据点的值解析为数值（允许首尾空白，其余字符必须完整构成一个数）
+     */
+    static bool parseValue(std::string_view value, double& number) {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+        if (!value.empty() && value.front() == '+') value.remove_prefix(1);
+        const char* end = value.data() + value.size();
+        const auto result = std::from_chars(value.data(), end, number);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    void add(std::string_view value) {
+        ++count;
+        double number;
+        if (parseValue(value, number)) {
+            ++samples;
+            min = std::min(min, number);
+            max = std::max(max, number);
+            sum += number;
+        }
+    }
+
+    void merge(const TerrainAggregate& other) {
+        count += other.count;
+        samples += other.samples;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        sum += other.sum;
+    }
+
+    /**
+     * @brief 移除一个此前加入的值
+     * @return 结果是否精确；移除的值等于当前极值时返回 false，需要重新聚合
+     */
+    bool remove(std::string_view value) {
+        if (count > 0) {
+            --count;
+        }
+        double number;
+        if (!parseValue(value, number) || samples == 0) {
+            return true;
+        }
+        --samples;
+        sum -= number;
+        if (samples == 0) {
+            min = std::numeric_limits<double>::infinity();
+            max = -std::numeric_limits<double>::infinity();
+            sum = 0.0;
+            return true;
+        }
+        return number > min && number < max;
+    }
+
+    void serialize(std::string& out) const {
+        out.resize(kEncodedSize);
+        out[0] = '\x01';
+        putLE64(&out[1], count);
+        putLE64(&out[9], samples);
+        putLE64(&out[17], std::bit_cast<uint64_t>(min));
+        putLE64(&out[25], std::bit_cast<uint64_t>(max));
+        putLE64(&out[33], std::bit_cast<uint64_t>(sum));
+    }
+
+    bool deserialize(std::string_view in) {
+        if (in.size() != kEncodedSize || in[0] != '\x01') {
+            *this = TerrainAggregate();
+            return false;
+        }
+        count = getLE64(in.data() + 1);
+        samples = getLE64(in.data() + 9);
+        min = std::bit_cast<double>(getLE64(in.data() + 17));
+        max = std::bit_cast<double>(getLE64(in.data() + 25));
+        sum = std::bit_cast<double>(getLE64(in.data() + 33));
+        return true;
+    }
+
+private:
+    static void putLE64(char* out, uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            out[i] = static_cast<char>(v >> (8 * i));
+        }
+    }
+
+    static uint64_t getLE64(const char* in) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+        }
+        return v;
+    }
+};
+
+#endif // TERRAINAGGREGATE_HPP
@@ -0,0 +1,313 @@
+#ifndef TERRAINGRIDCACHE_HPP
+#define TERRAINGRIDCACHE_HPP
+
+#include "terrainGridTile.hpp"
+#include "terrainKeyCodec.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <functional>
+
+// 网格数据缓存项（发布到缓存后读者可见的版本不再修改，更新时复制后整体替换）
+struct GridCacheItem {
+    std::string grid_id;
+    GridTile tile;  // 按定点坐标排序的列式数据点
+
+    // 计入缓存容量的字节数
+    size_t memoryBytes() const {
+        return sizeof(GridCacheItem) + grid_id.capacity() + tile.memoryBytes();
+    }
+};
+
+/**
+ * GridCache类 - 分片的并发网格缓存
+ *
+ * 网格ID哈希到 N 个分片，每个分片一把读写锁：get() 只持共享锁，命中时原子地增加访问计数，
+ * 读取之间互不阻塞。容量同时按网格数与字节数限制，上限在分片间均分，分片之间不互相借用，
+ * 因此容量是近似上界：网格在分片间分布不均时，热点分片可能在总数未达上限时就开始淘汰。
+ *
+ * 淘汰采用带计数的 CLOCK：访问计数饱和于 3，时钟指针经过时减一，为 0 时淘汰；新网格计数为 0。
+ * 范围扫描只访问一次的网格在下一圈即被淘汰，反复访问的热点网格需要多圈不被访问才会淘汰。
+ *
+ * 缓存项对读者不可变：写入通过 update() 复制网格后替换，读者持有的 shared_ptr 始终是完整的旧版本；
+ * 无人持有时 update() 原地修改，因此放入缓存的项须由非 const 的 GridCacheItem 创建
+ */
+class GridCache {
+public:
+    using ItemPtr = std::shared_ptr<const GridCacheItem>;
+
+    /**
+     * @param max_grids 最多缓存的网格数
+     * @param max_bytes 最多占用的字节数（0 表示不限）
+     * @param shard_count 分片数（容量较小时自动减少，保证每个分片至少容纳 8 个网格）
+     */
+    explicit GridCache(size_t max_grids, size_t max_bytes = 0, size_t shard_count = 16) {
+        max_grids = max_grids > 0 ? max_grids : 1000;
+        shard_count = std::max<size_t>(1, std::min(shard_count, max_grids / 8));
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+            shards_.back()->max_grids = (max_grids + shard_count - 1) / shard_count;
+            shards_.back()->max_bytes = max_bytes > 0 ? (max_bytes + shard_count - 1) / shard_count : 0;
+        }
+    }
+
+    // 获取缓存项
+    ItemPtr get(const std::string& grid_id) const {
+        const Shard& shard = shardOf(grid_id);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.index.find(grid_id);
+        if (it == shard.index.end()) {
+            return nullptr;
+        }
+        const Entry& entry = *shard.ring[it->second];
+        uint8_t freq = entry.freq.load(std::memory_order_relaxed);
+        if (freq < kMaxFrequency) {
+            entry.freq.compare_exchange_weak(freq, freq + 1, std::memory_order_relaxed);
+        }
+        return entry.item;
+    }
+
+    /**
+     * @brief 按网格行列查找缓存项，不计入访问次数、不分配内存
+     *
+     * 供范围扫描使用：扫描经过的网格不会因此被视为热点
+     */
+    ItemPtr peek(uint32_t row, uint32_t col) const {
+        TerrainKeyCodec::Buffer buf;
+        const std::string_view grid_id(buf, TerrainKeyCodec::formatGridId(row, col, buf) - buf);
+        const Shard& shard = shardOf(grid_id);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.index.find(grid_id);
+        return it == shard.index.end() ? nullptr : shard.ring[it->second]->item;
+    }
+
+    // 是否已缓存（不计入访问次数，供预取判断）
+    bool contains(const std::string& grid_id) const {
+        const Shard& shard = shardOf(grid_id);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.index.count(grid_id) > 0;
+    }
+
+    /**
+     * @brief 加载网格前获取的令牌，配合 put(grid_id, item, token) 使用
+     *
+     * 加载期间若有写入落在该分片未缓存的网格上，令牌失效，避免把加载时读到的旧数据放入缓存
+     */
+    uint64_t loadToken(const std::string& grid_id) const {
+        const Shard& shard = shardOf(grid_id);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.write_epoch;
+    }
+
+    // 添加或替换缓存项
+    void put(const std::string& grid_id, ItemPtr item) {
+        Shard& shard = shardOf(grid_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        insert(shard, grid_id, std::move(item));
+    }
+
+    /**
+     * @brief 令牌仍有效时添加缓存项
+     * @return 是否放入缓存
+     */
+    bool put(const std::string& grid_id, ItemPtr item, uint64_t token) {
+        Shard& shard = shardOf(grid_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (shard.write_epoch != token) {
+            return false;
+        }
+        return insert(shard, grid_id, std::move(item));
+    }
+
+    /**
+     * @brief 复制已缓存的网格、交给 fn 修改后替换（写时复制）
+     * @return 网格是否在缓存中；不在时使该分片当前的加载令牌失效
+     *
+     * 同一分片内的更新串行执行，调用方应在数据写入数据库之后调用。
+     * 没有读者持有该网格时（引用只剩缓存自身）直接原地修改，连续写入同一网格不再逐次复制整个网格
+     */
+    bool update(const std::string& grid_id, const std::function<void(GridTile&)>& fn) {
+        Shard& shard = shardOf(grid_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.index.find(grid_id);
+        if (it == shard.index.end()) {
+            ++shard.write_epoch;
+            return false;
+        }
+        Entry& entry = *shard.ring[it->second];
+        if (entry.item.use_count() == 1) {
+            // 持有独占锁时读者无法取得新引用；acquire 与最后一个读者释放引用同步
+            std::atomic_thread_fence(std::memory_order_acquire);
+            fn(std::const_pointer_cast<GridCacheItem>(entry.item)->tile);
+        } else {
+            auto copy = std::make_shared<GridCacheItem>(*entry.item);
+            fn(copy->tile);
+            entry.item = std::move(copy);
+        }
+        const size_t bytes = entry.item->memoryBytes();
+        shard.bytes = shard.bytes - entry.bytes + bytes;
+        entry.bytes = bytes;
+        while (shard.max_bytes > 0 && shard.bytes > shard.max_bytes && shard.index.size() > 1) {
+            evictOne(shard);
+        }
+        return true;
+    }
+
+    // 移除缓存项，并使该分片当前的加载令牌失效
+    void remove(const std::string& grid_id) {
+        Shard& shard = shardOf(grid_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        ++shard.write_epoch;
+        auto it = shard.index.find(grid_id);
+        if (it != shard.index.end()) {
+            release(shard, it->second);
+        }
+    }
+
+    // 清除所有缓存
+    void clear() {
+        for (auto& shard : shards_) {
+            std::unique_lock<std::shared_mutex> lock(shard->mutex);
+            shard->index.clear();
+            shard->ring.clear();
+            shard->free_slots.clear();
+            shard->hand = 0;
+            shard->bytes = 0;
+            ++shard->write_epoch;
+        }
+    }
+
+    // 获取当前缓存的网格数
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard : shards_) {
+            std::shared_lock<std::shared_mutex> lock(shard->mutex);
+            total += shard->index.size();
+        }
+        return total;
+    }
+
+    // 获取当前缓存占用的字节数
+    size_t bytes() const {
+        size_t total = 0;
+        for (const auto& shard : shards_) {
+            std::shared_lock<std::shared_mutex> lock(shard->mutex);
+            total += shard->bytes;
+        }
+        return total;
+    }
+
+    size_t shardCount() const { return shards_.size(); }
+
+private:
+    static constexpr uint8_t kMaxFrequency = 3;
+
+    struct Entry {
+        std::string grid_id;
+        ItemPtr item;
+        size_t bytes = 0;
+        mutable std::atomic<uint8_t> freq{ 0 };
+    };
+
+    // 网格ID哈希，支持 std::string_view 直接查找
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::vector<std::unique_ptr<Entry>> ring;            // 时钟环，空槽为 nullptr
+        std::vector<size_t> free_slots;                      // 环中的空槽下标
+        std::unordered_map<std::string, size_t, KeyHash, std::equal_to<>> index;  // 网格ID -> 环中下标
+        size_t hand = 0;                                     // 时钟指针
+        size_t bytes = 0;
+        size_t max_grids = 0;
+        size_t max_bytes = 0;
+        uint64_t write_epoch = 0;                            // 未命中写入计数，用于使加载令牌失效
+    };
+
+    Shard& shardOf(std::string_view grid_id) const {
+        return *shards_[KeyHash()(grid_id) % shards_.size()];
+    }
+
+    // 调用方持有分片独占锁；单个网格超过分片字节上限时不缓存
+    bool insert(Shard& shard, const std::string& grid_id, ItemPtr item) {
+        const size_t bytes = item->memoryBytes();
+        auto it = shard.index.find(grid_id);
+        if (it != shard.index.end()) {
+            Entry& entry = *shard.ring[it->second];
+            shard.bytes = shard.bytes - entry.bytes + bytes;
+            entry.bytes = bytes;
+            entry.item = std::move(item);
+        } else {
+            if (shard.max_bytes > 0 && bytes > shard.max_bytes) {
+                return false;
+            }
+            while (!shard.index.empty() &&
+                   (shard.index.size() >= shard.max_grids ||
+                    (shard.max_bytes > 0 && shard.bytes + bytes > shard.max_bytes))) {
+                evictOne(shard);
+            }
+            auto entry = std::make_unique<Entry>();
+            entry->grid_id = grid_id;
+            entry->item = std::move(item);
+            entry->bytes = bytes;
+            size_t slot;
+            if (!shard.free_slots.empty()) {
+                slot = shard.free_slots.back();
+                shard.free_slots.pop_back();
+                shard.ring[slot] = std::move(entry);
+            } else {
+                slot = shard.ring.size();
+                shard.ring.push_back(std::move(entry));
+            }
+            shard.index.emplace(grid_id, slot);
+            shard.bytes += bytes;
+        }
+        while (shard.max_bytes > 0 && shard.bytes > shard.max_bytes && shard.index.size() > 1) {
+            evictOne(shard);
+        }
+        return true;
+    }
+
+    // 转动时钟指针淘汰一个网格（调用方保证分片非空）；计数最多为 3，至多转 4 圈
+    static void evictOne(Shard& shard) {
+        while (true) {
+            if (shard.hand >= shard.ring.size()) {
+                shard.hand = 0;
+            }
+            const size_t slot = shard.hand++;
+            Entry* entry = shard.ring[slot].get();
+            if (!entry) {
+                continue;
+            }
+            uint8_t freq = entry->freq.load(std::memory_order_relaxed);
+            if (freq > 0) {
+                entry->freq.store(freq - 1, std::memory_order_relaxed);
+                continue;
+            }
+            release(shard, slot);
+            return;
+        }
+    }
+
+    static void release(Shard& shard, size_t slot) {
+        Entry& entry = *shard.ring[slot];
+        shard.bytes -= entry.bytes;
+        shard.index.erase(entry.grid_id);
+        shard.ring[slot].reset();
+        shard.free_slots.push_back(slot);
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+#endif // TERRAINGRIDCACHE_HPP
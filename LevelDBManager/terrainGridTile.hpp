@@ -0,0 +1,402 @@
+#ifndef TERRAINGRIDTILE_HPP
+#define TERRAINGRIDTILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef TERRAIN_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef TERRAIN_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+// 网格块中值数据的压缩算法（需在编译时开启 TERRAIN_WITH_LZ4 / TERRAIN_WITH_ZSTD）
+enum class TileCompression : uint8_t {
+    NONE = 0,
+    LZ4 = 1,
+    ZSTD = 2
+};
+
+/**
+ * GridTile类 - 单个网格的列式数据点存储
+ *
+ * 数据点按 (经度, 纬度) 定点坐标升序排列，坐标、值偏移、值长度分别存放在连续数组中，
+ * 所有值拼接在一块内存（arena）里。每个点的固定开销为 16 字节，
+ * 不再有 unordered_map 节点与两个 std::string 的堆分配；
+ * 点查询为二分查找，范围过滤是对连续整数数组的顺序扫描
+ *
+ * serialize() 输出的编码块格式：
+ *   [版本 1B][压缩算法 1B][点数 varint][值总长 varint]
+ *   [经度差分 varint × n][纬度差分 zigzag varint × n][值长度 varint × n][值数据（可压缩）]
+ * 经度升序存放，差分后通常只占 1~2 字节；纬度在同一经度内升序、跨经度回跳，用 zigzag 编码
+ */
+class GridTile {
+public:
+    GridTile() = default;
+
+    size_t size() const { return lon_.size(); }
+    bool empty() const { return lon_.empty(); }
+
+    uint32_t lon(size_t i) const { return lon_[i]; }
+    uint32_t lat(size_t i) const { return lat_[i]; }
+
+    std::string_view value(size_t i) const {
+        return std::string_view(arena_.data() + offset_[i], length_[i]);
+    }
+
+    /**
+     * @brief 追加数据点（批量构建用），追加完成后须调用 finalize()
+     */
+    void append(uint32_t lon, uint32_t lat, std::string_view value) {
+        lon_.push_back(lon);
+        lat_.push_back(lat);
+        offset_.push_back(static_cast<uint32_t>(arena_.size()));
+        length_.push_back(static_cast<uint32_t>(value.size()));
+        arena_.append(value.data(), value.size());
+    }
+
+    /**
+     * @brief 结束批量构建：按坐标排序（输入已有序时只做一次检查）并释放多余容量
+     */
+    void finalize() {
+        if (!isSorted()) {
+            sortByCoordinate();
+        }
+        lon_.shrink_to_fit();
+        lat_.shrink_to_fit();
+        offset_.shrink_to_fit();
+        length_.shrink_to_fit();
+        arena_.shrink_to_fit();
+    }
+
+    /**
+     * @brief 查找数据点
+     * @return 下标；不存在时返回 npos
+     */
+    size_t find(uint32_t lon, uint32_t lat) const {
+        const size_t i = lowerBound(lon, lat);
+        return (i < size() && lon_[i] == lon && lat_[i] == lat) ? i : npos;
+    }
+
+    /**
+     * @brief 插入或更新数据点，保持坐标有序
+     *
+     * 更新时旧值留在 arena 中成为碎片，碎片超过一半时整理
+     */
+    void upsert(uint32_t lon, uint32_t lat, std::string_view value) {
+        const size_t i = lowerBound(lon, lat);
+        const uint32_t offset = static_cast<uint32_t>(arena_.size());
+        arena_.append(value.data(), value.size());
+
+        if (i < size() && lon_[i] == lon && lat_[i] == lat) {
+            garbage_ += length_[i];
+            offset_[i] = offset;
+            length_[i] = static_cast<uint32_t>(value.size());
+            if (garbage_ * 2 > arena_.size()) {
+                compact();
+            }
+            return;
+        }
+        lon_.insert(lon_.begin() + i, lon);
+        lat_.insert(lat_.begin() + i, lat);
+        offset_.insert(offset_.begin() + i, offset);
+        length_.insert(length_.begin() + i, static_cast<uint32_t>(value.size()));
+    }
+
+    /**
+     * @brief 遍历坐标落在闭区间 [lon_lo, lon_hi] × [lat_lo, lat_hi] 内的数据点
+     * @param fn 以下标调用
+     * @return 检查过的数据点数（经度在区间内的点）
+     *
+     * 先二分定位经度下界，再顺序扫描到经度上界，纬度条件在连续数组上判断
+     */
+    template <typename Func>
+    size_t forEachInBox(uint32_t lon_lo, uint32_t lon_hi, uint32_t lat_lo, uint32_t lat_hi, Func&& fn) const {
+        if (lon_lo > lon_hi || lat_lo > lat_hi) return 0;
+        const size_t n = size();
+        const size_t first = std::lower_bound(lon_.begin(), lon_.end(), lon_lo) - lon_.begin();
+        size_t i = first;
+        for (; i < n && lon_[i] <= lon_hi; ++i) {
+            if (lat_[i] >= lat_lo && lat_[i] <= lat_hi) {
+                fn(i);
+            }
+        }
+        return i - first;
+    }
+
+    /**
+     * @brief 占用的堆内存字节数（按容量计）
+     */
+    size_t memoryBytes() const {
+        return (lon_.capacity() + lat_.capacity() + offset_.capacity() + length_.capacity()) * sizeof(uint32_t) +
+               arena_.capacity();
+    }
+
+    /**
+     * @brief 编码为网格块
+     * @param out [输出] 编码结果（覆盖原内容）
+     * @param compression 值数据的压缩算法；压缩后不更小时按不压缩存放
+     */
+    void serialize(std::string& out, TileCompression compression = TileCompression::NONE) const {
+        if (!compressionSupported(compression)) {
+            throw std::invalid_argument("GridTile: 压缩算法未编译进当前版本");
+        }
+        const size_t n = size();
+        size_t values_size = 0;
+        for (size_t i = 0; i < n; ++i) {
+            values_size += length_[i];
+        }
+
+        out.clear();
+        out.reserve(16 + n * 6 + values_size);
+        out.push_back(static_cast<char>(kFormatVersion));
+        const size_t compression_pos = out.size();
+        out.push_back(static_cast<char>(TileCompression::NONE));
+        putVarint(out, n);
+        putVarint(out, values_size);
+
+        uint32_t prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            putVarint(out, lon_[i] - prev);
+            prev = lon_[i];
+        }
+        prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const int64_t delta = static_cast<int64_t>(lat_[i]) - prev;
+            putVarint(out, static_cast<uint64_t>((delta << 1) ^ (delta >> 63)));
+            prev = lat_[i];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            putVarint(out, length_[i]);
+        }
+
+        const size_t values_pos = out.size();
+        for (size_t i = 0; i < n; ++i) {
+            out.append(arena_, offset_[i], length_[i]);
+        }
+        if (compression != TileCompression::NONE && values_size > 0) {
+            std::string compressed;
+            if (compress(compression, std::string_view(out.data() + values_pos, values_size), compressed) &&
+                compressed.size() < values_size) {
+                out.resize(values_pos);
+                out += compressed;
+                out[compression_pos] = static_cast<char>(compression);
+            }
+        }
+    }
+
+    /**
+     * @brief 从网格块解码，替换当前内容
+     * @return 格式错误、数据截断或压缩算法不可用时返回 false（内容被清空）
+     */
+    bool deserialize(std::string_view data) {
+        *this = GridTile();
+        const char* p = data.data();
+        const char* end = p + data.size();
+        uint64_t n, values_size;
+        if (end - p < 2 || static_cast<uint8_t>(p[0]) != kFormatVersion) {
+            return false;
+        }
+        const auto compression = static_cast<TileCompression>(p[1]);
+        p += 2;
+        // 每个点至少占 3 字节，据此拒绝明显错误的点数，避免按损坏的长度分配内存
+        if (!getVarint(p, end, n) || !getVarint(p, end, values_size) ||
+            n > static_cast<uint64_t>(end - p) / 3 || values_size > UINT32_MAX) {
+            return false;
+        }
+
+        lon_.resize(n);
+        lat_.resize(n);
+        offset_.resize(n);
+        length_.resize(n);
+        uint64_t v;
+        uint64_t lon = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!getVarint(p, end, v) || (lon += v) > UINT32_MAX) return clearAndFail();
+            lon_[i] = static_cast<uint32_t>(lon);
+        }
+        int64_t lat = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!getVarint(p, end, v)) return clearAndFail();
+            lat += static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+            if (lat < 0 || lat > UINT32_MAX) return clearAndFail();
+            lat_[i] = static_cast<uint32_t>(lat);
+        }
+        uint64_t offset = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!getVarint(p, end, v) || (offset + v) > values_size) return clearAndFail();
+            offset_[i] = static_cast<uint32_t>(offset);
+            length_[i] = static_cast<uint32_t>(v);
+            offset += v;
+        }
+        if (offset != values_size) return clearAndFail();
+
+        const std::string_view payload(p, static_cast<size_t>(end - p));
+        if (compression == TileCompression::NONE) {
+            if (payload.size() != values_size) return clearAndFail();
+            arena_.assign(payload.data(), payload.size());
+        } else if (!decompress(compression, payload, values_size, arena_)) {
+            return clearAndFail();
+        }
+        return true;
+    }
+
+    static bool compressionSupported(TileCompression compression) {
+        switch (compression) {
+        case TileCompression::NONE:
+            return true;
+        case TileCompression::LZ4:
+#ifdef TERRAIN_WITH_LZ4
+            return true;
+#else
+            return false;
+#endif
+        case TileCompression::ZSTD:
+#ifdef TERRAIN_WITH_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    static constexpr uint8_t kFormatVersion = 1;
+
+    bool clearAndFail() {
+        *this = GridTile();
+        return false;
+    }
+
+    static void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    static bool getVarint(const char*& p, const char* end, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            const auto byte = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) return true;
+        }
+        return false;
+    }
+
+    static bool compress(TileCompression compression, std::string_view in, std::string& out) {
+        switch (compression) {
+#ifdef TERRAIN_WITH_LZ4
+        case TileCompression::LZ4: {
+            out.resize(LZ4_compressBound(static_cast<int>(in.size())));
+            const int n = LZ4_compress_default(in.data(), &out[0], static_cast<int>(in.size()),
+                                               static_cast<int>(out.size()));
+            if (n <= 0) return false;
+            out.resize(n);
+            return true;
+        }
+#endif
+#ifdef TERRAIN_WITH_ZSTD
+        case TileCompression::ZSTD: {
+            out.resize(ZSTD_compressBound(in.size()));
+            const size_t n = ZSTD_compress(&out[0], out.size(), in.data(), in.size(), 3);
+            if (ZSTD_isError(n)) return false;
+            out.resize(n);
+            return true;
+        }
+#endif
+        default:
+            (void)in;
+            (void)out;
+            return false;
+        }
+    }
+
+    static bool decompress(TileCompression compression, std::string_view in, size_t raw_size, std::string& out) {
+        out.resize(raw_size);
+        switch (compression) {
+#ifdef TERRAIN_WITH_LZ4
+        case TileCompression::LZ4:
+            return LZ4_decompress_safe(in.data(), &out[0], static_cast<int>(in.size()),
+                                       static_cast<int>(raw_size)) == static_cast<int>(raw_size);
+#endif
+#ifdef TERRAIN_WITH_ZSTD
+        case TileCompression::ZSTD:
+            return ZSTD_decompress(&out[0], raw_size, in.data(), in.size()) == raw_size;
+#endif
+        default:
+            (void)in;
+            return false;
+        }
+    }
+
+    size_t lowerBound(uint32_t lon, uint32_t lat) const {
+        size_t i = std::lower_bound(lon_.begin(), lon_.end(), lon) - lon_.begin();
+        const size_t n = size();
+        while (i < n && lon_[i] == lon && lat_[i] < lat) {
+            ++i;  // 同一经度的点通常很少，线性前进即可
+        }
+        return i;
+    }
+
+    bool isSorted() const {
+        for (size_t i = 1; i < size(); ++i) {
+            if (lon_[i] < lon_[i - 1] || (lon_[i] == lon_[i - 1] && lat_[i] < lat_[i - 1])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void sortByCoordinate() {
+        std::vector<uint32_t> order(size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+            return lon_[a] != lon_[b] ? lon_[a] < lon_[b] : lat_[a] < lat_[b];
+        });
+        auto permute = [&order](std::vector<uint32_t>& column) {
+            std::vector<uint32_t> sorted(column.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                sorted[i] = column[order[i]];
+            }
+            column.swap(sorted);
+        };
+        permute(lon_);
+        permute(lat_);
+        permute(offset_);
+        permute(length_);
+    }
+
+    // 按当前顺序重写 arena，去掉被覆盖的旧值
+    void compact() {
+        std::string arena;
+        arena.reserve(arena_.size() - garbage_);
+        for (size_t i = 0; i < size(); ++i) {
+            const uint32_t offset = static_cast<uint32_t>(arena.size());
+            arena.append(arena_, offset_[i], length_[i]);
+            offset_[i] = offset;
+        }
+        arena_.swap(arena);
+        garbage_ = 0;
+    }
+
+    std::vector<uint32_t> lon_;      // 经度定点数（升序）
+    std::vector<uint32_t> lat_;      // 纬度定点数（同一经度内升序）
+    std::vector<uint32_t> offset_;   // 值在 arena_ 中的偏移
+    std::vector<uint32_t> length_;   // 值长度
+    std::string arena_;              // 所有值连续存放
+    size_t garbage_ = 0;             // arena_ 中已被覆盖的字节数
+};
+
+#endif // TERRAINGRIDTILE_HPP
@@ -0,0 +1,528 @@
+#ifndef TERRAINKEYCODEC_HPP
+#define TERRAINKEYCODEC_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <vector>
+#include <utility>
+
+// 地形数据点键格式
+enum class TerrainKeyFormat {
+    TEXT,    // 旧格式 "G_rrr_ccc|lon|lat"，仅用于读写尚未迁移的数据库
+    BINARY   // 紧凑的二进制格式，按字节序比较与 (网格, 经度, 纬度) 的数值顺序一致
+};
+
+// 二进制键中网格编号的排列顺序
+enum class GridOrder {
+    ROW_MAJOR,  // 先行后列
+    MORTON      // Z 序（行列按位交错），空间上相邻的网格在键空间中也大多相邻
+};
+
+/**
+ * TerrainKeyCodec类 - 地形数据点键的编码与解码
+ *
+ * 二进制键共 17 字节，所有整数均为大端序：
+ *   [0]      格式标记：0x01 行优先 / 0x02 Z 序（旧文本键以 'G' 开头，两者不会混淆）
+ *   [1..8]   网格编号：行优先为 row << 32 | col，Z 序为 row/col 按位交错
+ *   [9..12]  经度定点数：round((lon + 180) * 1e7)
+ *   [13..16] 纬度定点数：round((lat + 90) * 1e7)
+ * 定点精度与旧文本键的 7 位小数一致。编码写入调用方提供的缓冲区，编解码都不分配内存
+ *
+ * 整网格存储（StorageLayout::GRID_TILES）使用另外两个键空间：
+ *   网格块键 [0x03/0x04][网格编号]                     共 9 字节，值为整网格的编码块
+ *   覆盖键   [0x05/0x06][网格编号][经度][纬度]         共 17 字节，值为尚未合并进网格块的单点写入
+ *
+ * 细节层次金字塔的聚合单元使用独立的键空间（与存放方式、键格式无关）：
+ *   聚合键   [0x07/0x08][层级 1B][单元编号]             共 10 字节，单元编号按该层的行列计算
+ */
+class TerrainKeyCodec {
+public:
+    static constexpr char kRowMajorTag = '\x01';
+    static constexpr char kMortonTag = '\x02';
+    static constexpr char kTileRowMajorTag = '\x03';
+    static constexpr char kTileMortonTag = '\x04';
+    static constexpr char kOverlayRowMajorTag = '\x05';
+    static constexpr char kOverlayMortonTag = '\x06';
+    static constexpr char kLodRowMajorTag = '\x07';
+    static constexpr char kLodMortonTag = '\x08';
+    static constexpr size_t kLodKeySize = 10;
+    static constexpr size_t kBinaryKeySize = 17;
+    static constexpr size_t kGridPrefixSize = 9;   // 格式标记 + 网格编号
+    static constexpr size_t kMaxKeySize = 48;      // 任一格式的键长上限，用于栈上缓冲区
+    static constexpr double kScale = 1e7;          // 定点数比例
+    static constexpr int64_t kLonOffset = 1800000000LL;
+    static constexpr int64_t kLatOffset = 900000000LL;
+    static constexpr const char* kLegacyPrefix = "G_";
+
+    using Buffer = char[kMaxKeySize];
+
+    explicit TerrainKeyCodec(TerrainKeyFormat format = TerrainKeyFormat::BINARY,
+                             GridOrder order = GridOrder::ROW_MAJOR)
+        : format_(format), order_(order) {}
+
+    TerrainKeyFormat format() const { return format_; }
+    GridOrder order() const { return order_; }
+
+    /**
+     * @brief 编码数据点键
+     * @param out 输出缓冲区（至少 kMaxKeySize 字节）
+     * @return 键长
+     */
+    size_t encode(uint32_t row, uint32_t col, double lon, double lat, char* out) const {
+        if (format_ == TerrainKeyFormat::TEXT) {
+            return encodeText(row, col, lon, lat, out);
+        }
+        size_t n = encodeGridPrefix(row, col, out);
+        putBE32(out + n, toFixedLon(lon));
+        putBE32(out + n + 4, toFixedLat(lat));
+        return kBinaryKeySize;
+    }
+
+    std::string encode(uint32_t row, uint32_t col, double lon, double lat) const {
+        Buffer buf;
+        return std::string(buf, encode(row, col, lon, lat, buf));
+    }
+
+    /**
+     * @brief 编码网格内所有数据点键的公共前缀
+     * @return 前缀长度
+     */
+    size_t encodeGridPrefix(uint32_t row, uint32_t col, char* out) const {
+        if (format_ == TerrainKeyFormat::TEXT) {
+            char* p = formatGridId(row, col, out);
+            *p++ = '|';
+            return static_cast<size_t>(p - out);
+        }
+        out[0] = order_ == GridOrder::MORTON ? kMortonTag : kRowMajorTag;
+        putBE64(out + 1, gridCode(row, col));
+        return kGridPrefixSize;
+    }
+
+    std::string gridPrefix(uint32_t row, uint32_t col) const {
+        Buffer buf;
+        return std::string(buf, encodeGridPrefix(row, col, buf));
+    }
+
+    /**
+     * @brief 提取分片路由前缀（ShardedLevelDBConfig::routing_prefix 的默认值）
+     * @param prefix 输出：二进制数据点、网格块与覆盖键为网格编号（不含格式标记，同一网格的三种键落在同一分片），
+     *               聚合键为整个键，其余键（含旧文本键）为第一个 '|' 之前的部分
+     * @return key 是否包含完整的路由前缀（前缀扫描据此判断是否只访问一个分片）
+     */
+    static bool routingPrefix(std::string_view key, std::string_view& prefix) {
+        if (!key.empty() && key[0] >= kRowMajorTag && key[0] <= kOverlayMortonTag) {
+            if (key.size() < kGridPrefixSize) return false;
+            prefix = key.substr(1, kGridPrefixSize - 1);
+            return true;
+        }
+        if (!key.empty() && (key[0] == kLodRowMajorTag || key[0] == kLodMortonTag)) {
+            if (key.size() < kLodKeySize) return false;
+            prefix = key.substr(0, kLodKeySize);
+            return true;
+        }
+        const size_t delim = key.find('|');
+        if (delim == std::string_view::npos) return false;
+        prefix = key.substr(0, delim);
+        return true;
+    }
+
+    /**
+     * @brief 编码网格块键
+     * @return 键长（9 字节）
+     */
+    size_t encodeTileKey(uint64_t grid_code, char* out) const {
+        out[0] = order_ == GridOrder::MORTON ? kTileMortonTag : kTileRowMajorTag;
+        putBE64(out + 1, grid_code);
+        return kGridPrefixSize;
+    }
+
+    /**
+     * @brief 编码覆盖键
+     * @return 键长（17 字节）
+     */
+    size_t encodeOverlayKey(uint64_t grid_code, uint32_t fixed_lon, uint32_t fixed_lat, char* out) const {
+        encodeOverlayPrefix(grid_code, out);
+        putBE32(out + kGridPrefixSize, fixed_lon);
+        putBE32(out + kGridPrefixSize + 4, fixed_lat);
+        return kBinaryKeySize;
+    }
+
+    // 网格内所有覆盖键的公共前缀
+    size_t encodeOverlayPrefix(uint64_t grid_code, char* out) const {
+        out[0] = overlayTag();
+        putBE64(out + 1, grid_code);
+        return kGridPrefixSize;
+    }
+
+    char overlayTag() const {
+        return order_ == GridOrder::MORTON ? kOverlayMortonTag : kOverlayRowMajorTag;
+    }
+
+    /**
+     * @brief 编码聚合单元键
+     * @param level 金字塔层级（从 1 开始）
+     * @param cell_code 单元在该层行列上的编号（同 gridCode）
+     * @return 键长（10 字节）
+     */
+    size_t encodeLodKey(uint8_t level, uint64_t cell_code, char* out) const {
+        out[0] = order_ == GridOrder::MORTON ? kLodMortonTag : kLodRowMajorTag;
+        out[1] = static_cast<char>(level);
+        putBE64(out + 2, cell_code);
+        return kLodKeySize;
+    }
+
+    /**
+     * @brief 解码聚合单元键
+     */
+    bool decodeLodKey(std::string_view key, uint8_t& level, uint64_t& cell_code) const {
+        const char tag = order_ == GridOrder::MORTON ? kLodMortonTag : kLodRowMajorTag;
+        if (key.size() != kLodKeySize || key[0] != tag) {
+            return false;
+        }
+        level = static_cast<uint8_t>(key[1]);
+        cell_code = getBE64(key.data() + 2);
+        return true;
+    }
+
+    /**
+     * @brief 解码网格块键中的网格编号
+     */
+    bool decodeTileKey(std::string_view key, uint64_t& grid_code) const {
+        const char tag = order_ == GridOrder::MORTON ? kTileMortonTag : kTileRowMajorTag;
+        if (key.size() != kGridPrefixSize || key[0] != tag) {
+            return false;
+        }
+        grid_code = getBE64(key.data() + 1);
+        return true;
+    }
+
+    /**
+     * @brief 解码覆盖键中的网格编号与定点坐标
+     */
+    bool decodeOverlayKey(std::string_view key, uint64_t& grid_code, uint32_t& lon, uint32_t& lat) const {
+        if (key.size() != kBinaryKeySize || key[0] != overlayTag()) {
+            return false;
+        }
+        grid_code = getBE64(key.data() + 1);
+        lon = getBE32(key.data() + kGridPrefixSize);
+        lat = getBE32(key.data() + kGridPrefixSize + 4);
+        return true;
+    }
+
+    /**
+     * @brief 解码数据点键中的经纬度
+     * @return 键格式不符时返回 false
+     */
+    bool decode(std::string_view key, double& lon, double& lat) const {
+        if (format_ == TerrainKeyFormat::TEXT) {
+            return decodeText(key, lon, lat);
+        }
+        const char tag = order_ == GridOrder::MORTON ? kMortonTag : kRowMajorTag;
+        if (key.size() != kBinaryKeySize || key[0] != tag) {
+            return false;
+        }
+        lon = fromFixedLon(getBE32(key.data() + kGridPrefixSize));
+        lat = fromFixedLat(getBE32(key.data() + kGridPrefixSize + 4));
+        return true;
+    }
+
+    /**
+     * @brief 解码数据点键中的定点坐标
+     * @return 键格式不符时返回 false
+     */
+    bool decodeFixed(std::string_view key, uint32_t& lon, uint32_t& lat) const {
+        if (format_ == TerrainKeyFormat::TEXT) {
+            double lon_deg, lat_deg;
+            if (!decodeText(key, lon_deg, lat_deg)) return false;
+            lon = toFixedLon(lon_deg);
+            lat = toFixedLat(lat_deg);
+            return true;
+        }
+        const char tag = order_ == GridOrder::MORTON ? kMortonTag : kRowMajorTag;
+        if (key.size() != kBinaryKeySize || key[0] != tag) {
+            return false;
+        }
+        lon = getBE32(key.data() + kGridPrefixSize);
+        lat = getBE32(key.data() + kGridPrefixSize + 4);
+        return true;
+    }
+
+    /**
+     * @brief 格式化网格ID "G_rrr_ccc"（至少3位，超出时自动加宽）
+     * @return 写入结束位置
+     */
+    static char* formatGridId(uint32_t row, uint32_t col, char* out) {
+        *out++ = 'G';
+        *out++ = '_';
+        out = putPadded(row, out);
+        *out++ = '_';
+        return putPadded(col, out);
+    }
+
+    static std::string formatGridId(uint32_t row, uint32_t col) {
+        Buffer buf;
+        return std::string(buf, formatGridId(row, col, buf));
+    }
+
+    /**
+     * @brief 解析网格ID "G_rrr_ccc"
+     */
+    static bool parseGridId(std::string_view grid_id, uint32_t& row, uint32_t& col) {
+        if (grid_id.size() < 5 || grid_id[0] != 'G' || grid_id[1] != '_') return false;
+        const char* p = grid_id.data() + 2;
+        const char* end = grid_id.data() + grid_id.size();
+        auto r = std::from_chars(p, end, row);
+        if (r.ec != std::errc() || r.ptr == end || *r.ptr != '_') return false;
+        auto c = std::from_chars(r.ptr + 1, end, col);
+        return c.ec == std::errc() && c.ptr == end;
+    }
+
+    /**
+     * @brief 解析旧文本键 "G_rrr_ccc|lon|lat" 中的经纬度
+     */
+    static bool decodeText(std::string_view key, double& lon, double& lat) {
+        size_t first_delim = key.find('|');
+        if (first_delim == std::string_view::npos) return false;
+
+        size_t second_delim = key.find('|', first_delim + 1);
+        if (second_delim == std::string_view::npos) return false;
+
+        return parseDouble(key.substr(first_delim + 1, second_delim - first_delim - 1), lon) &&
+               parseDouble(key.substr(second_delim + 1), lat);
+    }
+
+    // 经纬度与定点数互相转换（先做整数运算再除，保证 7 位小数的坐标精确往返）
+    static uint32_t toFixedLon(double lon) {
+        return static_cast<uint32_t>(std::llround(lon * kScale) + kLonOffset);
+    }
+
+    static uint32_t toFixedLat(double lat) {
+        return static_cast<uint32_t>(std::llround(lat * kScale) + kLatOffset);
+    }
+
+    static double fromFixedLon(uint32_t fixed) {
+        return static_cast<double>(static_cast<int64_t>(fixed) - kLonOffset) / kScale;
+    }
+
+    static double fromFixedLat(uint32_t fixed) {
+        return static_cast<double>(static_cast<int64_t>(fixed) - kLatOffset) / kScale;
+    }
+
+    /**
+     * @brief 把查询范围 [min, max]（度）转换为定点数闭区间 [lo, hi]
+     * @return 区间非空时返回 true
+     *
+     * 结果是满足 fromFixed(lo) >= min、fromFixed(hi) <= max 的最紧区间，
+     * 用定点数比较与用解码后的浮点坐标比较得到的结果完全一致
+     */
+    static bool fixedLonRange(double min_lon, double max_lon, uint32_t& lo, uint32_t& hi) {
+        return fixedRange(min_lon, max_lon, kLonOffset, lo, hi);
+    }
+
+    static bool fixedLatRange(double min_lat, double max_lat, uint32_t& lo, uint32_t& hi) {
+        return fixedRange(min_lat, max_lat, kLatOffset, lo, hi);
+    }
+
+    // 行列按位交错：行占奇数位，列占偶数位
+    static uint64_t morton(uint32_t row, uint32_t col) {
+        return (spreadBits(row) << 1) | spreadBits(col);
+    }
+
+    static void unmorton(uint64_t code, uint32_t& row, uint32_t& col) {
+        row = compactBits(code >> 1);
+        col = compactBits(code);
+    }
+
+    uint64_t gridCode(uint32_t row, uint32_t col) const {
+        return order_ == GridOrder::MORTON ? morton(row, col)
+                                           : (static_cast<uint64_t>(row) << 32) | col;
+    }
+
+    void decodeGridCode(uint64_t code, uint32_t& row, uint32_t& col) const {
+        if (order_ == GridOrder::MORTON) {
+            unmorton(code, row, col);
+        } else {
+            row = static_cast<uint32_t>(code >> 32);
+            col = static_cast<uint32_t>(code);
+        }
+    }
+
+    // 网格编号闭区间
+    using CodeRange = std::pair<uint64_t, uint64_t>;
+
+    /**
+     * @brief 计算覆盖网格矩形 [row_begin, row_end] × [col_begin, col_end] 的最少网格编号区间
+     * @return 升序、互不相邻的闭区间；区间内的每个编号都落在矩形内
+     *
+     * 行优先时每行一个区间；Z 序时按四叉树分解，完全落在矩形内的子块整块输出，
+     * 区间数与矩形周长同阶，与面积无关
+     */
+    std::vector<CodeRange> coverRanges(uint32_t row_begin, uint32_t row_end,
+                                       uint32_t col_begin, uint32_t col_end) const {
+        std::vector<CodeRange> ranges;
+        if (row_begin > row_end || col_begin > col_end) {
+            return ranges;
+        }
+        if (order_ == GridOrder::ROW_MAJOR) {
+            for (uint64_t row = row_begin; row <= row_end; ++row) {
+                appendRange(ranges, (row << 32) | col_begin, (row << 32) | col_end);
+            }
+            return ranges;
+        }
+        int level = 0;
+        while (level < 32 && (1ULL << level) <= std::max(row_end, col_end)) {
+            ++level;
+        }
+        coverMorton(0, 0, level, row_begin, row_end, col_begin, col_end, ranges);
+        return ranges;
+    }
+
+    /**
+     * @brief 编码区间扫描的边界键：格式标记 + 网格编号 + 经度定点数
+     * @return 键长（13 字节）
+     *
+     * 同一网格内的数据点按经度排序，起止网格可以借此跳过查询经度范围之外的点
+     */
+    size_t encodeScanBound(uint64_t grid_code, uint32_t fixed_lon, char* out) const {
+        out[0] = order_ == GridOrder::MORTON ? kMortonTag : kRowMajorTag;
+        putBE64(out + 1, grid_code);
+        putBE32(out + kGridPrefixSize, fixed_lon);
+        return kGridPrefixSize + 4;
+    }
+
+    static void putBE32(char* out, uint32_t v) {
+        for (int i = 3; i >= 0; --i) {
+            out[i] = static_cast<char>(v & 0xff);
+            v >>= 8;
+        }
+    }
+
+    static void putBE64(char* out, uint64_t v) {
+        for (int i = 7; i >= 0; --i) {
+            out[i] = static_cast<char>(v & 0xff);
+            v >>= 8;
+        }
+    }
+
+    static uint32_t getBE32(const char* in) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) {
+            v = (v << 8) | static_cast<unsigned char>(in[i]);
+        }
+        return v;
+    }
+
+    static uint64_t getBE64(const char* in) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v = (v << 8) | static_cast<unsigned char>(in[i]);
+        }
+        return v;
+    }
+
+private:
+    static bool fixedRange(double min, double max, int64_t offset, uint32_t& lo, uint32_t& hi) {
+        const double limit = static_cast<double>(offset) / kScale;
+        auto fromFixed = [offset](int64_t f) { return static_cast<double>(f - offset) / kScale; };
+
+        int64_t l = std::llround(std::max(min, -limit) * kScale) + offset;
+        if (fromFixed(l) < min) ++l;
+        int64_t h = std::llround(std::min(max, limit) * kScale) + offset;
+        if (fromFixed(h) > max) --h;
+        if (l > h || h < 0 || l > 2 * offset) {
+            return false;
+        }
+        lo = static_cast<uint32_t>(std::max<int64_t>(l, 0));
+        hi = static_cast<uint32_t>(std::min<int64_t>(h, 2 * offset));
+        return true;
+    }
+
+    // 追加区间，与上一个区间相邻时合并
+    static void appendRange(std::vector<CodeRange>& ranges, uint64_t lo, uint64_t hi) {
+        if (!ranges.empty() && ranges.back().second + 1 == lo) {
+            ranges.back().second = hi;
+        } else {
+            ranges.emplace_back(lo, hi);
+        }
+    }
+
+    // 四叉树分解：(row, col) 为边长 2^level 的对齐子块左上角，子块按 Z 序升序访问
+    static void coverMorton(uint64_t row, uint64_t col, int level,
+                            uint64_t row_begin, uint64_t row_end,
+                            uint64_t col_begin, uint64_t col_end,
+                            std::vector<CodeRange>& ranges) {
+        const uint64_t side = 1ULL << level;
+        const uint64_t row_last = row + side - 1;
+        const uint64_t col_last = col + side - 1;
+        if (row > row_end || row_last < row_begin || col > col_end || col_last < col_begin) {
+            return;
+        }
+        const uint64_t lo = morton(static_cast<uint32_t>(row), static_cast<uint32_t>(col));
+        if (row >= row_begin && row_last <= row_end && col >= col_begin && col_last <= col_end) {
+            const uint64_t hi = level >= 32 ? ~0ULL : lo + side * side - 1;
+            appendRange(ranges, lo, hi);
+            return;
+        }
+        const uint64_t half = side >> 1;
+        const int child = level - 1;
+        coverMorton(row, col, child, row_begin, row_end, col_begin, col_end, ranges);
+        coverMorton(row, col + half, child, row_begin, row_end, col_begin, col_end, ranges);
+        coverMorton(row + half, col, child, row_begin, row_end, col_begin, col_end, ranges);
+        coverMorton(row + half, col + half, child, row_begin, row_end, col_begin, col_end, ranges);
+    }
+
+    // 旧文本键：网格ID + 两个 7 位小数的定点格式坐标
+    static size_t encodeText(uint32_t row, uint32_t col, double lon, double lat, char* out) {
+        char* p = formatGridId(row, col, out);
+        char* end = out + kMaxKeySize;
+        *p++ = '|';
+        p = std::to_chars(p, end, lon, std::chars_format::fixed, 7).ptr;
+        *p++ = '|';
+        p = std::to_chars(p, end, lat, std::chars_format::fixed, 7).ptr;
+        return static_cast<size_t>(p - out);
+    }
+
+    // 解析完整的浮点数字段（不要求以 '\0' 结尾）
+    static bool parseDouble(std::string_view text, double& out) {
+        const char* end = text.data() + text.size();
+        auto result = std::from_chars(text.data(), end, out);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    // 至少 3 位的十进制数
+    static char* putPadded(uint32_t v, char* out) {
+        if (v < 100) *out++ = '0';
+        if (v < 10) *out++ = '0';
+        return std::to_chars(out, out + 10, v).ptr;
+    }
+
+    static uint64_t spreadBits(uint32_t v) {
+        uint64_t x = v;
+        x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+        x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+        x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        x = (x | (x << 2)) & 0x3333333333333333ULL;
+        x = (x | (x << 1)) & 0x5555555555555555ULL;
+        return x;
+    }
+
+    static uint32_t compactBits(uint64_t x) {
+        x &= 0x5555555555555555ULL;
+        x = (x | (x >> 1)) & 0x3333333333333333ULL;
+        x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+        x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+        x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+        x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+        return static_cast<uint32_t>(x);
+    }
+
+    TerrainKeyFormat format_;
+    GridOrder order_;
+};
+
+#endif // TERRAINKEYCODEC_HPP
@@ -2,16 +2,31 @@
 #define TERRAINSTORAGEENGINE_HPP
 
 #include "levelDBmanager.hpp"
+#include "shardedLevelDBmanager.hpp"
+#include "terrainKeyCodec.hpp"
+#include "terrainGridCache.hpp"
+#include "terrainAggregate.hpp"
+#include "advancedthreadpool.hpp"
+#include <array>
 #include <cmath>
 #include <memory>
 #include <unordered_map>
-#include <list>
 #include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <queue>
+#include <tuple>
+#include <exception>
+#include <map>
+#include <set>
+#include <future>
+#include <atomic>
 #include <vector>
 #include <functional>
-#include <sstream>
-#include <iomanip>
 #include <stdexcept>
+#include <string_view>
 
 // 地形数据存储引擎异常类
 class TerrainStorageException : public std::runtime_error {
@@ -20,122 +35,195 @@ public:
         : std::runtime_error("TerrainStorageEngine: " + msg) {}
 };
 
-// 网格数据缓存项
-struct GridCacheItem {
-    std::string grid_id;
-    std::unordered_map<std::string, std::string> data; // 键值对: <生成键, 地形数据>
+// 范围查询执行方式
+enum class RangeQueryMode {
+    CURVE_SCAN,  // 把查询框分解为最少的连续键区间逐个扫描，结果流式返回，不填充网格缓存
+    GRID_WALK    // 逐行逐列遍历网格，未缓存的网格整体加载进缓存后过滤
 };
 
-// LRU缓存实现
-class GridLRUCache {
-public:
-    explicit GridLRUCache(size_t capacity) 
-        : capacity_(capacity > 0 ? capacity : 1000) {}
+// 数据在 LevelDB 中的存放方式
+enum class StorageLayout {
+    POINT_KEYS,  // 每个数据点一个键
+    GRID_TILES   // 每个网格一个编码块，单点写入先进入覆盖键空间，再合并进网格块
+};
 
-    // 获取缓存项
-    std::shared_ptr<GridCacheItem> get(const std::string& grid_id) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto map_it = cache_map_.find(grid_id);
-        if (map_it == cache_map_.end()) {
-            return nullptr;
-        }
-        
-        // 移动到访问列表前端
-        access_list_.splice(access_list_.begin(), access_list_, map_it->second.second);
-        return map_it->second.first;
-    }
+// 地形存储引擎配置参数
+struct TerrainStorageConfig {
+    TerrainKeyFormat key_format = TerrainKeyFormat::BINARY;  // 数据点键格式
+    GridOrder grid_order = GridOrder::ROW_MAJOR;             // 二进制键中网格的排列顺序（范围查询为主时建议 MORTON）
+    bool migrate_legacy_keys = false;                        // 构造时把旧文本键迁移为二进制键
+    RangeQueryMode range_query_mode = RangeQueryMode::CURVE_SCAN; // 范围查询执行方式
+    StorageLayout storage_layout = StorageLayout::POINT_KEYS;     // 存放方式（GRID_TILES 要求二进制键格式）
+    TileCompression tile_compression = TileCompression::NONE;     // 网格块中值数据的压缩算法
+    size_t overlay_merge_threshold = 256;                         // 单个网格的覆盖写入达到该点数时触发合并
+    bool background_merge = true;                                 // 由后台线程合并；否则只在 mergeTiles() 中合并
+    size_t cache_capacity_bytes = 0;                              // 网格缓存字节上限（0 表示只按网格数限制）
+    size_t cache_shards = 16;                                     // 网格缓存分片数（容量在分片间均分，分布不均时为近似上界）
+    AdvancedThreadPool* loader_pool = nullptr;                    // 后台加载与预取网格的线程池（不持有，须比引擎存活更久）
+    bool async_miss_load = false;                                 // 点未命中时直接读取该点，网格交给 loader_pool 后台加载（仅 POINT_KEYS）
+    AdvancedThreadPool* worker_pool = nullptr;                    // 批量写入编码排序与并行范围查询的线程池（不持有）
+    size_t ingest_batch_bytes = 4 * 1048576;                      // 批量写入时单个 WriteBatch 的键值字节上限
+    size_t lod_levels = 0;                                        // 细节层次金字塔层数（0 关闭）：第 k 层单元边长为 grid_size × 2^(k-1)
+};
 
-    // 添加缓存项
-    void put(const std::string& grid_id, std::shared_ptr<GridCacheItem> item) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (cache_map_.find(grid_id) != cache_map_.end()) {
-            // 已存在则更新
-            access_list_.erase(cache_map_[grid_id].second);
-        } else if (cache_map_.size() >= capacity_) {
-            // 淘汰最久未使用的网格
-            auto last = access_list_.back();
-            cache_map_.erase(last);
-            access_list_.pop_back();
-        }
-        
-        // 添加新项到前端
-        access_list_.push_front(grid_id);
-        cache_map_[grid_id] = {item, access_list_.begin()};
-    }
+// 网格加载统计
+struct GridLoadStats {
+    size_t loads = 0;         // 实际从数据库加载的网格数
+    size_t coalesced = 0;     // 等待进行中的同一网格加载、未重复读库的次数
+    size_t background = 0;    // 交给线程池后台加载的网格数（未命中异步加载与邻居预取）
+};
 
-    // 移除缓存项
-    void remove(const std::string& grid_id) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = cache_map_.find(grid_id);
-        if (it != cache_map_.end()) {
-            access_list_.erase(it->second.second);
-            cache_map_.erase(it);
-        }
-    }
+// 实体移动游标：由调用方按实体保存，get() 据此判断实体是否进入了新网格
+struct MovementCursor {
+    int64_t row = -1;
+    int64_t col = -1;
+};
+
+// 范围查询统计
+struct RangeQueryStats {
+    size_t key_ranges = 0;       // 发起的 LevelDB 区间扫描次数
+    size_t cached_grids = 0;     // 直接从网格缓存读取的网格数
+    size_t points_visited = 0;   // 检查过的数据点数
+    size_t points_returned = 0;  // 落在查询范围内并回调的数据点数
+};
+
+// 按分辨率查询返回的单元：第 0 层为单个原始数据点，第 k 层为预聚合单元
+struct TerrainCell {
+    size_t level = 0;
+    double min_lon = 0.0;
+    double min_lat = 0.0;
+    double max_lon = 0.0;
+    double max_lat = 0.0;
+    TerrainAggregate aggregate;
+};
+
+// parallelRangeQuery 交付的一批数据点：坐标与值分别连续存放，只在 sink 调用期间有效
+struct TerrainPointChunk {
+    uint32_t row = 0;                   // 来源网格
+    uint32_t col = 0;
+    std::vector<double> lon;
+    std::vector<double> lat;
+    std::vector<uint32_t> value_end;    // 第 i 个值在 values 中的结束偏移
+    std::string values;                 // 所有值首尾相接
 
-    // 清除所有缓存
-    void clear() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        cache_map_.clear();
-        access_list_.clear();
+    size_t size() const { return lon.size(); }
+    bool empty() const { return lon.empty(); }
+
+    std::string_view value(size_t i) const {
+        const uint32_t begin = i == 0 ? 0 : value_end[i - 1];
+        return std::string_view(values.data() + begin, value_end[i] - begin);
     }
 
-    // 获取当前缓存大小
-    size_t size() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return cache_map_.size();
+    void push(double point_lon, double point_lat, std::string_view point_value) {
+        lon.push_back(point_lon);
+        lat.push_back(point_lat);
+        values.append(point_value.data(), point_value.size());
+        value_end.push_back(static_cast<uint32_t>(values.size()));
     }
+};
 
-private:
-    size_t capacity_;
-    std::list<std::string> access_list_;
-    std::unordered_map<std::string, 
-        std::pair<std::shared_ptr<GridCacheItem>, 
-        std::list<std::string>::iterator>> cache_map_;
-    mutable std::mutex mutex_;
+// 并行范围查询参数
+struct ParallelQueryOptions {
+    AdvancedThreadPool* pool = nullptr;  // 执行网格扫描的线程池（为空时使用 TerrainStorageConfig::worker_pool）
+    size_t max_in_flight = 8;            // 同时扫描、缓冲结果的网格数上限
+    size_t chunk_points = 4096;          // 每批最多的数据点数
+    bool ordered = false;                // 按网格编号顺序交付；否则按扫描完成的顺序交付
 };
 
 // 地形数据存储引擎
-class TerrainStorageEngine {
+//
+// Storage 为 LevelDBManager（单个实例）或 ShardedLevelDBManager（按网格分片到多个实例），
+// 两者提供相同的读写、扫描、批量写入与快照接口
+template <typename Storage = LevelDBManager>
+class BasicTerrainStorageEngine {
 public:
+    using BatchWriter = typename Storage::BatchWriter;
+    using ScanOptions = typename Storage::ScanOptions;
+    using SnapshotView = decltype(ScanOptions::snapshot);  // 快照句柄（Storage::Snapshot::get() 的返回值）
+
     /**
      * @brief 构造函数
-     * @param db_manager LevelDB管理器引用
+     * @param db_manager 存储（LevelDBManager 或 ShardedLevelDBManager）引用
      * @param min_lon 最小经度
      * @param min_lat 最小纬度
      * @param max_lon 最大经度
      * @param max_lat 最大纬度
      * @param grid_size 网格大小（单位：度）
-     * @param cache_capacity 缓存容量（网格数量）
+     * @param cache_capacity 缓存容量（网格数量，字节上限见 TerrainStorageConfig::cache_capacity_bytes）
+     * @param config 引擎配置
+     *
+     * 以二进制键格式打开仍包含旧文本键的数据库时，若未设置 migrate_legacy_keys 则抛出异常，
+     * 避免旧数据被静默忽略；也可以用 TerrainKeyFormat::TEXT 按旧格式继续读写。
+     * GRID_TILES 存放方式与 POINT_KEYS 使用不同的键空间，切换存放方式不会读到另一种方式写入的数据
      */
-    TerrainStorageEngine(LevelDBManager& db_manager,
+    BasicTerrainStorageEngine(Storage& db_manager,
                         double min_lon, double min_lat,
                         double max_lon, double max_lat,
                         double grid_size,
-                        size_t cache_capacity = 1000)
+                        size_t cache_capacity = 1000,
+                        TerrainStorageConfig config = TerrainStorageConfig())
         : db_manager_(db_manager),
           min_lon_(min_lon),
           min_lat_(min_lat),
           max_lon_(max_lon),
           max_lat_(max_lat),
           grid_size_(grid_size),
-          cache_(cache_capacity) {
+          codec_(config.key_format, config.grid_order),
+          range_query_mode_(config.range_query_mode),
+          layout_(config.storage_layout),
+          tile_compression_(config.tile_compression),
+          merge_threshold_(std::max<size_t>(config.overlay_merge_threshold, 1)),
+          cache_(cache_capacity, config.cache_capacity_bytes, config.cache_shards),
+          loader_pool_(config.loader_pool),
+          async_miss_load_(config.async_miss_load && config.loader_pool != nullptr &&
+                           config.storage_layout == StorageLayout::POINT_KEYS),
+          worker_pool_(config.worker_pool),
+          ingest_batch_bytes_(std::max<size_t>(config.ingest_batch_bytes, 1)),
+          lod_levels_(std::min<size_t>(config.lod_levels, kMaxLodLevels)) {
         
         if (grid_size_ <= 0.0) {
             throw TerrainStorageException("Grid size must be positive");
         }
+        if (layout_ == StorageLayout::GRID_TILES) {
+            if (codec_.format() != TerrainKeyFormat::BINARY) {
+                throw TerrainStorageException("GRID_TILES 存放方式要求二进制键格式");
+            }
+            if (!GridTile::compressionSupported(tile_compression_)) {
+                throw TerrainStorageException("网格块压缩算法未编译进当前版本（TERRAIN_WITH_LZ4 / TERRAIN_WITH_ZSTD）");
+            }
+        }
         
         // 计算网格行列数
         grid_cols_ = static_cast<int>(std::ceil((max_lon - min_lon) / grid_size_));
         grid_rows_ = static_cast<int>(std::ceil((max_lat - min_lat) / grid_size_));
         
-        // 固定网格ID宽度为3位
-        id_width_ = 3;
+        if (codec_.format() == TerrainKeyFormat::BINARY && hasLegacyKeys()) {
+            if (!config.migrate_legacy_keys) {
+                throw TerrainStorageException("数据库中存在旧格式文本键，请设置 migrate_legacy_keys 迁移或使用 TerrainKeyFormat::TEXT");
+            }
+            migrateLegacyKeys();
+        }
+        
+        if (layout_ == StorageLayout::GRID_TILES && config.background_merge) {
+            merger_ = std::thread([this] { mergeLoop(); });
+        }
+    }
+    
+    ~BasicTerrainStorageEngine() {
+        waitForBackgroundLoads();
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            stop_merger_ = true;
+        }
+        merge_cv_.notify_all();
+        if (merger_.joinable()) {
+            merger_.join();
+        }
     }
     
+    BasicTerrainStorageEngine(const BasicTerrainStorageEngine&) = delete;
+    BasicTerrainStorageEngine& operator=(const BasicTerrainStorageEngine&) = delete;
+    
     /**
      * @brief 检查坐标是否在有效范围内
      * @param lon 经度
@@ -160,17 +248,53 @@ public:
                 std::to_string(lon) + ", " + std::to_string(lat) + ")");
         }
 
-        std::string grid_id = computeGridId(lon, lat);
-        std::string key = generateKey(lon, lat, grid_id);
+        TerrainKeyCodec::Buffer key_buf;
+        const leveldb::Slice key = encodeKey(lon, lat, key_buf);
+        uint32_t row, col;
+        gridCell(lon, lat, row, col);
+        const uint32_t fixed_lon = TerrainKeyCodec::toFixedLon(lon);
+        const uint32_t fixed_lat = TerrainKeyCodec::toFixedLat(lat);
         
-        // 更新缓存（如果存在）
-        auto cache_item = cache_.get(grid_id);
-        if (cache_item) {
-            cache_item->data[key] = value;
+        // 开启金字塔时同一顶层单元内的写入串行执行，写入后按差值更新各层聚合。
+        // 网格已缓存时旧值在更新缓存网格时顺带取出，未缓存时才在写入前单独读取
+        std::unique_lock<std::mutex> lod_lock;
+        std::string old_value;
+        bool replaced = false;
+        bool old_from_tile = false;
+        if (lod_levels_ > 0) {
+            lod_lock = std::unique_lock<std::mutex>(lodMutex(row, col));
+            old_from_tile = cache_.peek(row, col) != nullptr;
+            if (!old_from_tile) {
+                replaced = lookupStored(lon, lat, old_value);
+            }
+        }
+        
+        if (layout_ == StorageLayout::GRID_TILES) {
+            // 写入覆盖键；与网格合并互斥，避免合并删除覆盖键时丢失刚写入的值
+            std::shared_lock<std::shared_mutex> lock(tile_mutex_);
+            db_manager_.put(key, value, sync);
+            noteOverlayWrite(gridCode(lon, lat));
+        } else {
+            // 写入数据库
+            db_manager_.put(key, value, sync);
         }
         
-        // 写入数据库
-        db_manager_.put(key, value, sync);
+        // 写入数据库之后再更新缓存（如果存在），未缓存时使进行中的加载作废
+        const bool cached = cache_.update(TerrainKeyCodec::formatGridId(row, col), [&](GridTile& tile) {
+            if (old_from_tile) {
+                const size_t i = tile.find(fixed_lon, fixed_lat);
+                if (i != GridTile::npos) {
+                    old_value.assign(tile.value(i).data(), tile.value(i).size());
+                    replaced = true;
+                }
+            }
+            tile.upsert(fixed_lon, fixed_lat, value);
+        });
+        
+        if (lod_levels_ > 0) {
+            // 网格在判断与更新之间被淘汰时旧值未知，改由数据重新聚合
+            updateLodPoint(row, col, replaced ? &old_value : nullptr, value, !old_from_tile || cached);
+        }
     }
     
     /**
@@ -185,68 +309,146 @@ public:
             return false;
         }
         
-        std::string grid_id = computeGridId(lon, lat);
-        std::string key = generateKey(lon, lat, grid_id);
+        uint32_t row, col;
+        gridCell(lon, lat, row, col);
+        TerrainKeyCodec::Buffer key_buf;
+        const leveldb::Slice key(key_buf, codec_.encode(row, col, lon, lat, key_buf));
+        
+        const uint32_t fixed_lon = TerrainKeyCodec::toFixedLon(lon);
+        const uint32_t fixed_lat = TerrainKeyCodec::toFixedLat(lat);
         
         // 首先尝试从缓存获取
-        auto cache_item = cache_.get(grid_id);
+        auto cache_item = cache_.get(TerrainKeyCodec::formatGridId(row, col));
         if (cache_item) {
-            auto it = cache_item->data.find(key);
-            if (it != cache_item->data.end()) {
-                value = it->second;
+            const size_t i = cache_item->tile.find(fixed_lon, fixed_lat);
+            if (i != GridTile::npos) {
+                const std::string_view cached = cache_item->tile.value(i);
+                value.assign(cached.data(), cached.size());
                 return true;
             }
         }
         
+        if (layout_ == StorageLayout::GRID_TILES) {
+            // 网格块包含网格内的全部点：已缓存时不存在即未命中，未缓存时一次 Get 加载整个网格
+            if (cache_item) {
+                return false;
+            }
+            cache_item = loadGridToCache(row, col);
+            const size_t i = cache_item->tile.find(fixed_lon, fixed_lat);
+            if (i == GridTile::npos) {
+                return false;
+            }
+            const std::string_view loaded = cache_item->tile.value(i);
+            value.assign(loaded.data(), loaded.size());
+            return true;
+        }
+        
         // 缓存未命中，从数据库获取
         if (db_manager_.get(key, value)) {
-            // 如果网格不在缓存中，则加载整个网格
+            // 如果网格不在缓存中，则加载整个网格（开启 async_miss_load 时交给后台加载）
             if (!cache_item) {
-                loadGridToCache(grid_id);
+                requestGrid(row, col);
             } else {
-                // 如果网格在缓存中，但该点不在，则更新缓存
-                cache_item->data[key] = value;
+                // 如果网格在缓存中，但该点不在，则补入缓存（不覆盖期间写入的新值）
+                cache_.update(cache_item->grid_id, [&](GridTile& tile) {
+                    if (tile.find(fixed_lon, fixed_lat) == GridTile::npos) {
+                        tile.upsert(fixed_lon, fixed_lat, value);
+                    }
+                });
             }
             return true;
         } else {
             // 即使点不存在，也加载整个网格到缓存
             if (!cache_item) {
-                loadGridToCache(grid_id);
+                requestGrid(row, col);
             }
             return false;
         }
     }
     
+    /**
+     * @brief 获取地形数据点，并在实体进入新网格时预取相邻网格
+     * @param cursor 该实体的移动游标（调用方按实体保存，初始为默认值）
+     *
+     * 进入新网格后把周围 8 个网格交给 loader_pool 后台加载，移动方向前方的网格优先提交；
+     * 未设置 loader_pool 时不预取
+     */
+    bool get(double lon, double lat, std::string& value, MovementCursor& cursor) {
+        const bool found = get(lon, lat, value);
+        if (isWithinBounds(lon, lat)) {
+            uint32_t row, col;
+            gridCell(lon, lat, row, col);
+            if (cursor.row != row || cursor.col != col) {
+                prefetchNeighbours(row, col, cursor);
+                cursor.row = row;
+                cursor.col = col;
+            }
+        }
+        return found;
+    }
+    
+    /**
+     * @brief 等待已提交的后台网格加载全部结束
+     */
+    void waitForBackgroundLoads() {
+        std::unique_lock<std::mutex> lock(loads_mutex_);
+        loads_cv_.wait(lock, [this] { return pending_loads_ == 0; });
+    }
+    
+    /**
+     * @brief 获取网格加载统计
+     */
+    GridLoadStats getLoadStats() const {
+        GridLoadStats stats;
+        stats.loads = grid_loads_.load(std::memory_order_relaxed);
+        stats.coalesced = coalesced_loads_.load(std::memory_order_relaxed);
+        stats.background = background_loads_.load(std::memory_order_relaxed);
+        return stats;
+    }
+    
     /**
      * @brief 批量存储地形数据点
      * @param data 地形数据向量<经度, 纬度, 值>
+     *
+     * 坐标校验与键编码分段交给 worker_pool 并行执行（调用线程同样参与），各段排序后按键顺序归并，
+     * 以不超过 ingest_batch_bytes 的 WriteBatch 分块提交：一块在后台提交时填充下一块。
+     * 坐标超出范围时在写入任何数据之前抛出异常；分块提交不是原子的，提交失败时之前的块已写入。
+     * 同一坐标出现多次时以最后一次为准；全部提交后按网格更新缓存，每个网格只复制一次
      */
     void batchPut(const std::vector<std::tuple<double, double, std::string>>& data) {
-        auto batch = db_manager_.createBatch();
-        
-        for (const auto& item : data) {
-            double lon = std::get<0>(item);
-            double lat = std::get<1>(item);
-            const std::string& value = std::get<2>(item);
-            
-            if (!isWithinBounds(lon, lat)) {
-                throw TerrainStorageException("坐标超出范围: (" + 
-                    std::to_string(lon) + ", " + std::to_string(lat) + ")");
-            }
-
-            std::string grid_id = computeGridId(lon, lat);
-            std::string key = generateKey(lon, lat, grid_id);
-            
-            // 更新缓存（如果存在）
-            auto cache_item = cache_.get(grid_id);
-            if (cache_item) {
-                cache_item->data[key] = value;
-            }
-            
-            batch.put(key, value);
+        const auto lod_locks = lockAllLod();
+        if (layout_ == StorageLayout::GRID_TILES) {
+            batchPutTiles(data);
+            return;
+        }
+        ingestPoints(data, true, nullptr);
+    }
+    
+    /**
+     * @brief 初始导入：批量写入后整体压缩写入的键范围
+     * @param data 地形数据向量<经度, 纬度, 值>
+     * @param compact 导入结束后是否压缩（默认 true）
+     *
+     * 面向空库或离线导入，期间不应有并发读写。与 batchPut 一样并行编码、按键排序后分块提交，
+     * 但不逐网格维护缓存（导入后清空缓存）。按键顺序写入时 memtable 刷出的文件互不重叠，
+     * LevelDB 的后台压缩多为直接下移文件；全部写入后再对写入的键范围压缩一次，后续读取不再经过 L0 的重叠文件
+     */
+    void bulkLoad(const std::vector<std::tuple<double, double, std::string>>& data, bool compact = true) {
+        const auto lod_locks = lockAllLod();
+        std::pair<std::string, std::string> key_range;
+        if (layout_ == StorageLayout::GRID_TILES) {
+            batchPutTiles(data);
+            TerrainKeyCodec::Buffer key_buf;
+            codec_.encodeTileKey(0, key_buf);
+            key_range.first.assign(key_buf, 1);
+            key_range.second = LevelDBManager::prefixUpperBound(leveldb::Slice(key_buf, 1));
+        } else {
+            ingestPoints(data, false, &key_range);
+        }
+        cache_.clear();
+        if (compact && !key_range.first.empty()) {
+            db_manager_.compactRange(key_range.first, key_range.second);
         }
-        
-        batch.commit();
     }
     
     /**
@@ -256,31 +458,334 @@ public:
      * @param max_lon 最大经度
      * @param max_lat 最大纬度
      * @param callback 回调函数 (经度, 纬度, 值)
+     * @param stats [输出] 查询统计（可选）
+     *
+     * 执行方式由 TerrainStorageConfig::range_query_mode 决定
      */
     void rangeQuery(double min_lon, double min_lat,
                    double max_lon, double max_lat,
-                   std::function<void(double, double, const std::string&)> callback) {
+                   std::function<void(double, double, const std::string&)> callback,
+                   RangeQueryStats* stats = nullptr) {
+        RangeQueryStats local;
+        RangeQueryStats& st = stats ? *stats : local;
+        st = RangeQueryStats();
+        if (min_lon > max_lon || min_lat > max_lat) {
+            return;
+        }
+        
         // 计算覆盖的网格范围
-        int start_col = std::max(0, lonToGridCol(min_lon));
-        int end_col = std::min(grid_cols_ - 1, lonToGridCol(max_lon));
-        int start_row = std::max(0, latToGridRow(min_lat));
-        int end_row = std::min(grid_rows_ - 1, latToGridRow(max_lat));
+        int start_row, end_row, start_col, end_col;
+        if (!coveredGrids(min_lon, min_lat, max_lon, max_lat, start_row, end_row, start_col, end_col)) {
+            return;
+        }
+        
+        if (range_query_mode_ == RangeQueryMode::CURVE_SCAN) {
+            curveScan(start_row, end_row, start_col, end_col,
+                      min_lon, min_lat, max_lon, max_lat, callback, st);
+            return;
+        }
         
         // 遍历所有覆盖的网格
         for (int row = start_row; row <= end_row; ++row) {
             for (int col = start_col; col <= end_col; ++col) {
-                std::string grid_id = formatGridId(row, col);
-                processGrid(grid_id, min_lon, min_lat, max_lon, max_lat, callback);
+                processGrid(row, col, min_lon, min_lat, max_lon, max_lat, callback, st);
             }
         }
     }
     
+    /**
+     * @brief 并行范围查询，结果按批交付
+     * @param sink 接收一批数据点，返回 false 即取消查询；总在调用线程上执行，无需自行同步
+     * @param options 并行参数
+     * @param stats [输出] 查询统计（可选）
+     * @return 查询是否完整执行（被 sink 取消时为 false）
+     *
+     * 覆盖的网格按网格编号排列，最多 max_in_flight 个网格同时交给线程池扫描，
+     * 所有扫描在查询开始时创建的同一快照上进行，结果不受查询期间的写入影响（因此不读网格缓存）。
+     * 调用线程在等待时接手尚未开始的网格，线程池繁忙或拒绝时退化为顺序扫描。
+     * 扫描中的异常在调用线程上重新抛出；sink 抛出的异常在已开始的网格扫描结束后原样传出
+     */
+    bool parallelRangeQuery(double min_lon, double min_lat,
+                            double max_lon, double max_lat,
+                            const std::function<bool(const TerrainPointChunk&)>& sink,
+                            const ParallelQueryOptions& options = ParallelQueryOptions(),
+                            RangeQueryStats* stats = nullptr) {
+        RangeQueryStats local;
+        RangeQueryStats& st = stats ? *stats : local;
+        st = RangeQueryStats();
+        int start_row, end_row, start_col, end_col;
+        if (min_lon > max_lon || min_lat > max_lat ||
+            !coveredGrids(min_lon, min_lat, max_lon, max_lat, start_row, end_row, start_col, end_col)) {
+            return true;
+        }
+        
+        struct GridScan {
+            uint32_t row = 0;
+            uint32_t col = 0;
+            std::atomic<bool> claimed{ false };   // 线程池任务与调用线程谁先领取谁执行
+            bool done = false;                    // 受 Shared::mutex 保护
+            std::vector<TerrainPointChunk> chunks;
+            RangeQueryStats stats;
+            std::exception_ptr error;
+        };
+        struct Shared {
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::atomic<bool> cancelled{ false };
+        };
+        
+        auto shared = std::make_shared<Shared>();
+        auto snapshot = db_manager_.createSnapshot();
+        const QueryBox box{ min_lon, min_lat, max_lon, max_lat };
+        SnapshotView view = snapshot->get();
+        const size_t chunk_points = std::max<size_t>(options.chunk_points, 1);
+        
+        // 只在领取到网格后执行，此时调用线程仍在等待，引用的快照与引擎均有效
+        auto run = [this, shared, box, view, chunk_points](GridScan& scan) {
+            try {
+                TerrainPointChunk chunk;
+                chunk.row = scan.row;
+                chunk.col = scan.col;
+                scanGridSnapshot(scan.row, scan.col, box, view, [&](double lon, double lat, std::string_view value) {
+                    chunk.push(lon, lat, value);
+                    if (chunk.size() >= chunk_points) {
+                        scan.chunks.push_back(std::move(chunk));
+                        chunk = TerrainPointChunk();
+                        chunk.row = scan.row;
+                        chunk.col = scan.col;
+                    }
+                    return !shared->cancelled.load(std::memory_order_relaxed);
+                }, scan.stats);
+                if (!chunk.empty()) {
+                    scan.chunks.push_back(std::move(chunk));
+                }
+            } catch (...) {
+                scan.error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            scan.done = true;
+            shared->cv.notify_all();
+        };
+        
+        std::vector<LodCell> grids;
+        for (const auto& range : codec_.coverRanges(start_row, end_row, start_col, end_col)) {
+            for (uint64_t code = range.first; code <= range.second; ++code) {
+                LodCell grid;
+                codec_.decodeGridCode(code, grid.first, grid.second);
+                grids.push_back(grid);
+            }
+        }
+        
+        AdvancedThreadPool* pool = options.pool ? options.pool : worker_pool_;
+        const size_t max_in_flight = std::max<size_t>(options.max_in_flight, 1);
+        std::deque<std::shared_ptr<GridScan>> window;   // 已提交未交付的网格，按网格编号顺序
+        size_t next = 0;
+        
+        // 无论以何种方式退出（完成、取消、扫描出错或 sink 抛出异常）：未开始的网格不再执行，
+        // 等待已开始的网格结束，之后才释放快照；正常完成时窗口为空，不做任何事
+        auto drain = [&] {
+            shared->cancelled = true;
+            for (auto& scan : window) {
+                if (scan->claimed.exchange(true)) {
+                    std::unique_lock<std::mutex> lock(shared->mutex);
+                    shared->cv.wait(lock, [&] { return scan->done; });
+                }
+            }
+            window.clear();
+        };
+        struct DrainOnExit {
+            decltype(drain)& fn;
+            ~DrainOnExit() { fn(); }
+        } drain_on_exit{ drain };
+        
+        while (next < grids.size() || !window.empty()) {
+            while (window.size() < max_in_flight && next < grids.size()) {
+                auto scan = std::make_shared<GridScan>();
+                scan->row = grids[next].first;
+                scan->col = grids[next].second;
+                ++next;
+                window.push_back(scan);
+                if (pool) {
+                    // 提交失败时保持未领取，由调用线程执行
+                    pool->try_post(TaskPriority::NORMAL, [scan, run] {
+                        if (!scan->claimed.exchange(true)) {
+                            run(*scan);
+                        }
+                    });
+                }
+            }
+            
+            // 选出下一个交付的网格：有序时为窗口首个，否则为任一已完成的网格；
+            // 目标尚未开始时由调用线程接手执行
+            std::shared_ptr<GridScan> ready;
+            {
+                std::unique_lock<std::mutex> lock(shared->mutex);
+                while (!ready) {
+                    auto it = window.begin();
+                    if (!options.ordered) {
+                        it = std::find_if(window.begin(), window.end(), [](const auto& scan) { return scan->done; });
+                        if (it == window.end()) {
+                            it = std::find_if(window.begin(), window.end(),
+                                              [](const auto& scan) { return !scan->claimed.load(); });
+                        }
+                    }
+                    if (it != window.end() && ((*it)->done || !(*it)->claimed.exchange(true))) {
+                        if (!(*it)->done) {
+                            lock.unlock();
+                            run(**it);
+                            lock.lock();
+                        }
+                        ready = *it;
+                        window.erase(it);
+                    } else {
+                        shared->cv.wait(lock);
+                    }
+                }
+            }
+            
+            if (ready->error) {
+                std::rethrow_exception(ready->error);
+            }
+            st.key_ranges += ready->stats.key_ranges;
+            st.points_visited += ready->stats.points_visited;
+            st.points_returned += ready->stats.points_returned;
+            for (const auto& chunk : ready->chunks) {
+                if (!sink(chunk)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 按分辨率查询地形数据
+     * @param resolution 期望的单元边长（度）
+     * @param callback 回调函数，每个单元一次
+     * @param stats [输出] 查询统计（可选；聚合层的点数统计的是单元数）
+     *
+     * 选择单元边长不超过 resolution 的最粗层级（见 lodLevelFor）：第 0 层逐点返回原始数据，
+     * 每点一个单元；第 k 层返回与查询框相交的聚合单元（单元可能部分超出查询框），
+     * 每个区间只 Seek 一次，读取的单元数与查询框面积 / 单元面积同阶，与原始点数无关
+     */
+    void rangeQuery(double min_lon, double min_lat,
+                    double max_lon, double max_lat,
+                    double resolution,
+                    const std::function<void(const TerrainCell&)>& callback,
+                    RangeQueryStats* stats = nullptr) {
+        const size_t level = lodLevelFor(resolution);
+        if (level == 0) {
+            TerrainCell cell;
+            rangeQuery(min_lon, min_lat, max_lon, max_lat, [&](double lon, double lat, const std::string& value) {
+                cell.min_lon = cell.max_lon = lon;
+                cell.min_lat = cell.max_lat = lat;
+                cell.aggregate = TerrainAggregate();
+                cell.aggregate.add(value);
+                callback(cell);
+            }, stats);
+            return;
+        }
+        
+        RangeQueryStats local;
+        RangeQueryStats& st = stats ? *stats : local;
+        st = RangeQueryStats();
+        int start_row, end_row, start_col, end_col;
+        if (min_lon > max_lon || min_lat > max_lat ||
+            !coveredGrids(min_lon, min_lat, max_lon, max_lat, start_row, end_row, start_col, end_col)) {
+            return;
+        }
+        
+        const size_t shift = level - 1;
+        const double cell_size = grid_size_ * static_cast<double>(1ULL << shift);
+        for (const auto& range : codec_.coverRanges(start_row >> shift, end_row >> shift,
+                                                    start_col >> shift, end_col >> shift)) {
+            TerrainKeyCodec::Buffer lo_buf, hi_buf;
+            const leveldb::Slice start(lo_buf, codec_.encodeLodKey(static_cast<uint8_t>(level), range.first, lo_buf));
+            const std::string end = LevelDBManager::prefixUpperBound(
+                leveldb::Slice(hi_buf, codec_.encodeLodKey(static_cast<uint8_t>(level), range.second, hi_buf)));
+            ++st.key_ranges;
+            db_manager_.scan(start, end, [&](std::string_view key, std::string_view value) {
+                uint8_t key_level;
+                uint64_t code;
+                TerrainCell cell;
+                ++st.points_visited;
+                if (!codec_.decodeLodKey(key, key_level, code) || !cell.aggregate.deserialize(value)) {
+                    return;
+                }
+                uint32_t row, col;
+                codec_.decodeGridCode(code, row, col);
+                cell.level = level;
+                cell.min_lon = min_lon_ + col * cell_size;
+                cell.min_lat = min_lat_ + row * cell_size;
+                cell.max_lon = std::min(max_lon_, cell.min_lon + cell_size);
+                cell.max_lat = std::min(max_lat_, cell.min_lat + cell_size);
+                ++st.points_returned;
+                callback(cell);
+            });
+        }
+    }
+    
+    /**
+     * @brief 选择与分辨率匹配的金字塔层级
+     * @param resolution 期望的单元边长（度）
+     * @return 单元边长不超过 resolution 的最粗层级，不超过 lod_levels；
+     *         小于 grid_size 或未开启金字塔时为 0（原始数据点）
+     */
+    size_t lodLevelFor(double resolution) const {
+        if (lod_levels_ == 0 || resolution < grid_size_) {
+            return 0;
+        }
+        size_t level = 1;
+        while (level < lod_levels_ && grid_size_ * static_cast<double>(1ULL << level) <= resolution) {
+            ++level;
+        }
+        return level;
+    }
+    
+    /**
+     * @brief 由全部数据重建细节层次金字塔
+     *
+     * 在已有数据的库上首次开启 lod_levels，或批量写入中途提交失败后调用；与写入互斥
+     */
+    void rebuildLodPyramid() {
+        if (lod_levels_ == 0) {
+            return;
+        }
+        const auto lod_locks = lockAllLod();
+        auto batch = db_manager_.createBatch();
+        TerrainKeyCodec::Buffer key_buf;
+        codec_.encodeLodKey(1, 0, key_buf);
+        db_manager_.scanPrefix(leveldb::Slice(key_buf, 1), [&](const leveldb::Slice& key, const leveldb::Slice&) {
+            batch.del(key);
+        });
+        
+        // 逐网格读取：网格归属取自键中的网格编号，不能由解码后的坐标重新计算
+        // （定点坐标舍入后，网格边界附近的点会被算到相邻网格，与增量维护的结果不一致）
+        std::map<LodCell, TerrainAggregate> grids;
+        for (const auto& range : codec_.coverRanges(0, grid_rows_ - 1, 0, grid_cols_ - 1)) {
+            for (uint64_t code = range.first; code <= range.second; ++code) {
+                LodCell cell;
+                codec_.decodeGridCode(code, cell.first, cell.second);
+                TerrainAggregate aggregate = aggregateGrid(cell.first, cell.second);
+                if (!aggregate.empty()) {
+                    grids.emplace(cell, aggregate);
+                }
+            }
+        }
+        writeLodLevels(std::move(grids), batch);
+        batch.commit();
+    }
+    
     /**
      * @brief 预加载网格数据到缓存
      * @param grid_id 网格ID
      */
     void preloadGrid(const std::string& grid_id) {
-        loadGridToCache(grid_id);
+        uint32_t row, col;
+        if (!TerrainKeyCodec::parseGridId(grid_id, row, col)) {
+            throw TerrainStorageException("无效的网格ID: " + grid_id);
+        }
+        loadGridToCache(row, col);
     }
     
     /**
@@ -306,6 +811,13 @@ public:
         return cache_.size();
     }
     
+    /**
+     * @brief 获取缓存占用的字节数
+     */
+    size_t getCacheBytes() const {
+        return cache_.bytes();
+    }
+    
     /**
      * @brief 计算网格ID
      * @param lon 经度
@@ -313,9 +825,100 @@ public:
      * @return 网格ID字符串
      */
     std::string computeGridId(double lon, double lat) const {
-        int col = lonToGridCol(lon);
-        int row = latToGridRow(lat);
-        return formatGridId(row, col);
+        uint32_t row, col;
+        gridCell(lon, lat, row, col);
+        return TerrainKeyCodec::formatGridId(row, col);
+    }
+    
+    /**
+     * @brief 检查数据库中是否存在旧格式文本键
+     */
+    bool hasLegacyKeys() {
+        return db_manager_.scanPrefix(TerrainKeyCodec::kLegacyPrefix,
+            [](const leveldb::Slice&, const leveldb::Slice&) { return false; }) > 0;
+    }
+    
+    /**
+     * @brief 把旧格式文本键迁移为当前的二进制键
+     * @param batch_size 每个写批次包含的数据点数
+     * @return 迁移的数据点数
+     *
+     * 在快照上扫描旧键，每批原子地写入新键并删除旧键，中途失败后重新调用即可继续；
+     * 无法解析或超出当前范围的旧键保持不动
+     */
+    size_t migrateLegacyKeys(size_t batch_size = 1000) {
+        if (codec_.format() != TerrainKeyFormat::BINARY) {
+            throw TerrainStorageException("只有二进制键格式的引擎可以迁移旧键");
+        }
+        
+        auto snapshot = db_manager_.createSnapshot();
+        ScanOptions options;
+        options.snapshot = snapshot->get();
+        options.fill_cache = false;
+        
+        // GRID_TILES 方式下旧键先迁移为覆盖键，最后统一合并进网格块
+        std::shared_lock<std::shared_mutex> tile_lock(tile_mutex_, std::defer_lock);
+        if (layout_ == StorageLayout::GRID_TILES) {
+            tile_lock.lock();
+        }
+        
+        auto batch = db_manager_.createBatch();
+        size_t migrated = 0;
+        size_t pending = 0;
+        db_manager_.scanPrefix(TerrainKeyCodec::kLegacyPrefix,
+            [&](const leveldb::Slice& key, const leveldb::Slice& value) {
+                double lon, lat;
+                if (!TerrainKeyCodec::decodeText(std::string_view(key.data(), key.size()), lon, lat) ||
+                    !isWithinBounds(lon, lat)) {
+                    return;
+                }
+                TerrainKeyCodec::Buffer key_buf;
+                batch.put(encodeKey(lon, lat, key_buf), value);
+                batch.del(key);
+                ++migrated;
+                if (++pending >= batch_size) {
+                    batch.commit();
+                    pending = 0;
+                }
+            }, options);
+        if (pending > 0) {
+            batch.commit();
+        }
+        if (tile_lock.owns_lock()) {
+            tile_lock.unlock();
+            mergeTiles();
+        }
+        
+        cache_.clear();
+        return migrated;
+    }
+    
+    /**
+     * @brief 把所有覆盖键合并进网格块（仅 GRID_TILES 方式）
+     * @return 合并的数据点数
+     *
+     * 后台合并只处理覆盖写入达到阈值的网格；需要立即整理全部覆盖键时调用本函数
+     */
+    size_t mergeTiles() {
+        if (layout_ != StorageLayout::GRID_TILES) {
+            return 0;
+        }
+        std::vector<uint64_t> codes;
+        const char tag = codec_.overlayTag();
+        db_manager_.scanPrefix(leveldb::Slice(&tag, 1),
+            [&](std::string_view key, std::string_view) {
+                uint64_t code;
+                uint32_t lon, lat;
+                if (codec_.decodeOverlayKey(key, code, lon, lat) && (codes.empty() || codes.back() != code)) {
+                    codes.push_back(code);
+                }
+            }, gridScanOptions());
+        
+        size_t merged = 0;
+        for (uint64_t code : codes) {
+            merged += mergeGrid(code);
+        }
+        return merged;
     }
 
 private:
@@ -331,107 +934,1064 @@ private:
         return static_cast<int>((normalized - min_lat_) / grid_size_);
     }
     
-    // 格式化网格ID
-    std::string formatGridId(int row, int col) const {
-        std::ostringstream oss;
-        oss << "G_" 
-            << std::setw(3) << std::setfill('0') << row << "_"
-            << std::setw(3) << std::setfill('0') << col;
-        return oss.str();
+    // 计算坐标所在的网格行列
+    void gridCell(double lon, double lat, uint32_t& row, uint32_t& col) const {
+        row = static_cast<uint32_t>(latToGridRow(lat));
+        col = static_cast<uint32_t>(lonToGridCol(lon));
+    }
+    
+    // 把数据点键编码到调用方的栈上缓冲区（GRID_TILES 方式下为覆盖键）
+    leveldb::Slice encodeKey(double lon, double lat, char* buf) const {
+        uint32_t row, col;
+        gridCell(lon, lat, row, col);
+        if (layout_ == StorageLayout::GRID_TILES) {
+            return leveldb::Slice(buf, codec_.encodeOverlayKey(codec_.gridCode(row, col),
+                TerrainKeyCodec::toFixedLon(lon), TerrainKeyCodec::toFixedLat(lat), buf));
+        }
+        return leveldb::Slice(buf, codec_.encode(row, col, lon, lat, buf));
     }
     
-    // 生成数据点键
-    std::string generateKey(double lon, double lat, const std::string& grid_id) const {
-        std::ostringstream oss;
-        oss << grid_id << "|"
-            << std::fixed << std::setprecision(7) << lon << "|"
-            << std::fixed << std::setprecision(7) << lat;
-        return oss.str();
+    uint64_t gridCode(double lon, double lat) const {
+        uint32_t row, col;
+        gridCell(lon, lat, row, col);
+        return codec_.gridCode(row, col);
     }
     
     // 处理单个网格内的数据
-    void processGrid(const std::string& grid_id,
+    void processGrid(uint32_t row, uint32_t col,
                     double min_lon, double min_lat,
                     double max_lon, double max_lat,
-                    std::function<void(double, double, const std::string&)> callback) {
+                    const std::function<void(double, double, const std::string&)>& callback,
+                    RangeQueryStats& stats) {
         // 尝试从缓存获取
-        auto cache_item = cache_.get(grid_id);
+        auto cache_item = cache_.get(TerrainKeyCodec::formatGridId(row, col));
+        const bool cached = cache_item != nullptr;
         
-        if (!cache_item) {
+        if (cached) {
+            ++stats.cached_grids;
+        } else {
             // 缓存未命中，加载网格
-            cache_item = loadGridToCache(grid_id);
+            cache_item = loadGridToCache(row, col);
+            ++stats.key_ranges;
         }
         
         if (cache_item) {
-            // 处理缓存中的数据
-            for (const auto& kv : cache_item->data) {
-                // 从键中解析经纬度
-                double lon, lat;
-                if (parseKey(kv.first, lon, lat)) {
-                    // 检查点是否在查询范围内
-                    if (lon >= min_lon && lon <= max_lon &&
-                        lat >= min_lat && lat <= max_lat) {
-                        callback(lon, lat, kv.second);
-                    }
-                }
-            }
+            const size_t examined = filterCachedGrid(cache_item->tile, min_lon, min_lat, max_lon, max_lat, callback, stats);
+            // 刚从数据库加载的网格按读取的全部点计数
+            stats.points_visited += cached ? examined : cache_item->tile.size();
         } else {
-            // 后备方案：直接从数据库查询
-            std::string start_key = grid_id + "|";
-            std::string end_key = grid_id + "|~";  // ~是ASCII中较大的字符
-            
-            db_manager_.rangeQuery(start_key, end_key, 
-                [&](const std::string& key, const std::string& value) {
+            // 后备方案：直接从数据库扫描，只为范围内的点构造值
+            TerrainKeyCodec::Buffer prefix_buf;
+            const leveldb::Slice prefix(prefix_buf, codec_.encodeGridPrefix(row, col, prefix_buf));
+            db_manager_.scanPrefix(prefix,
+                [&](std::string_view key, std::string_view value) {
+                    ++stats.points_visited;
                     double lon, lat;
-                    if (parseKey(key, lon, lat)) {
+                    if (codec_.decode(key, lon, lat)) {
                         if (lon >= min_lon && lon <= max_lon &&
                             lat >= min_lat && lat <= max_lat) {
-                            callback(lon, lat, value);
+                            ++stats.points_returned;
+                            callback(lon, lat, std::string(value));
                         }
                     }
-                });
+                }, gridScanOptions());
         }
     }
     
-    // 加载网格数据到缓存
-    std::shared_ptr<GridCacheItem> loadGridToCache(const std::string& grid_id) {
-        auto cache_item = std::make_shared<GridCacheItem>();
-        cache_item->grid_id = grid_id;
+    // 过滤已缓存网格中落在查询范围内的点，返回检查过的点数
+    size_t filterCachedGrid(const GridTile& tile,
+                          double min_lon, double min_lat,
+                          double max_lon, double max_lat,
+                          const std::function<void(double, double, const std::string&)>& callback,
+                          RangeQueryStats& stats) const {
+        // 查询范围换算为定点数闭区间，比较结果与按解码后的经纬度比较一致
+        uint32_t lon_lo, lon_hi, lat_lo, lat_hi;
+        if (!TerrainKeyCodec::fixedLonRange(min_lon, max_lon, lon_lo, lon_hi) ||
+            !TerrainKeyCodec::fixedLatRange(min_lat, max_lat, lat_lo, lat_hi)) {
+            return 0;
+        }
         
-        std::string start_key = grid_id + "|";
-        std::string end_key = grid_id + "|~";  // ~是ASCII中较大的字符
+        // 经度范围外的点由二分跳过，不计入检查数
+        std::string value_buf;
+        return tile.forEachInBox(lon_lo, lon_hi, lat_lo, lat_hi, [&](size_t i) {
+            ++stats.points_returned;
+            const std::string_view value = tile.value(i);
+            value_buf.assign(value.data(), value.size());
+            callback(TerrainKeyCodec::fromFixedLon(tile.lon(i)), TerrainKeyCodec::fromFixedLat(tile.lat(i)), value_buf);
+        });
+    }
+    
+    /**
+     * @brief 空间填充曲线范围查询
+     *
+     * 把覆盖的网格矩形分解为最少的连续网格编号区间，每个区间只发起一次扫描；
+     * 起止边界带上查询经度，跳过首尾网格中经度范围外的点。已在缓存中的网格直接读取缓存，
+     * 其余网格流式扫描，不放入缓存，大范围查询不会冲掉热点网格
+     */
+    void curveScan(uint32_t start_row, uint32_t end_row, uint32_t start_col, uint32_t end_col,
+                   double min_lon, double min_lat, double max_lon, double max_lat,
+                   const std::function<void(double, double, const std::string&)>& callback,
+                   RangeQueryStats& stats) {
+        if (codec_.format() == TerrainKeyFormat::TEXT) {
+            // 文本键的网格ID不是定长编码，退化为逐网格流式扫描
+            for (uint32_t row = start_row; row <= end_row; ++row) {
+                for (uint32_t col = start_col; col <= end_col; ++col) {
+                    TerrainKeyCodec::Buffer prefix_buf;
+                    const size_t n = codec_.encodeGridPrefix(row, col, prefix_buf);
+                    const std::string bound = LevelDBManager::prefixUpperBound(leveldb::Slice(prefix_buf, n));
+                    scanKeyRange(leveldb::Slice(prefix_buf, n), bound,
+                                 min_lon, min_lat, max_lon, max_lat, callback, stats);
+                }
+            }
+            return;
+        }
+        
+        // 边界经度裁剪到引擎范围内，保证定点数不溢出
+        const uint32_t fixed_min_lon = TerrainKeyCodec::toFixedLon(std::max(min_lon, min_lon_));
+        const uint32_t fixed_max_lon = TerrainKeyCodec::toFixedLon(std::min(max_lon, max_lon_));
+        const bool check_cache = cache_.size() > 0;
         
-        // 从数据库加载整个网格的数据
-        db_manager_.rangeQuery(start_key, end_key, 
-            [&](const std::string& key, const std::string& value) {
-                cache_item->data[key] = value;
+        // 扫描网格编号闭区间 [lo, hi]
+        auto scanCodes = [&](uint64_t lo, uint64_t hi) {
+            if (layout_ == StorageLayout::GRID_TILES) {
+                scanTileCodes(lo, hi, min_lon, min_lat, max_lon, max_lat, callback, stats);
+                return;
+            }
+            char start_buf[TerrainKeyCodec::kMaxKeySize];
+            char end_buf[TerrainKeyCodec::kMaxKeySize];
+            const leveldb::Slice start(start_buf, codec_.encodeScanBound(lo, fixed_min_lon, start_buf));
+            const leveldb::Slice end(end_buf, codec_.encodeScanBound(hi, fixed_max_lon + 1, end_buf));
+            scanKeyRange(start, end, min_lon, min_lat, max_lon, max_lat, callback, stats);
+        };
+        
+        for (const auto& range : codec_.coverRanges(start_row, end_row, start_col, end_col)) {
+            uint64_t run_start = range.first;
+            for (uint64_t code = range.first; check_cache && code <= range.second; ++code) {
+                uint32_t row, col;
+                codec_.decodeGridCode(code, row, col);
+                auto cache_item = cache_.peek(row, col);
+                if (!cache_item) {
+                    continue;
+                }
+                // 缓存中的网格把区间拆开：之前的部分先扫描，缓存网格直接过滤
+                if (code > run_start) {
+                    scanCodes(run_start, code - 1);
+                }
+                ++stats.cached_grids;
+                stats.points_visited += filterCachedGrid(cache_item->tile, min_lon, min_lat, max_lon, max_lat, callback, stats);
+                run_start = code + 1;
+            }
+            if (run_start <= range.second) {
+                scanCodes(run_start, range.second);
+            }
+        }
+    }
+    
+    // 流式扫描 [start, end) 并回调落在查询范围内的点（值缓冲区复用，不逐点分配）
+    void scanKeyRange(const leveldb::Slice& start, const leveldb::Slice& end,
+                      double min_lon, double min_lat, double max_lon, double max_lat,
+                      const std::function<void(double, double, const std::string&)>& callback,
+                      RangeQueryStats& stats) {
+        ++stats.key_ranges;
+        std::string value_buf;
+        db_manager_.scan(start, end,
+            [&](std::string_view key, std::string_view value) {
+                ++stats.points_visited;
+                double lon, lat;
+                if (codec_.decode(key, lon, lat) &&
+                    lon >= min_lon && lon <= max_lon &&
+                    lat >= min_lat && lat <= max_lat) {
+                    ++stats.points_returned;
+                    value_buf.assign(value.data(), value.size());
+                    callback(lon, lat, value_buf);
+                }
             });
+    }
+    
+    // 加载网格数据到缓存
+    /**
+     * @brief 加载网格到缓存：同一网格同时只有一个加载在读库，其余调用方等待其结果
+     *
+     * 后台已登记但尚未开始的加载由调用方直接接手执行，线程池繁忙时不会阻塞在队列上
+     */
+    GridCache::ItemPtr loadGridToCache(uint32_t row, uint32_t col) {
+        const std::string grid_id = TerrainKeyCodec::formatGridId(row, col);
+        bool created;
+        auto load = joinGridLoad(grid_id, created);
+        if (!load->claimed.exchange(true)) {
+            runGridLoad(row, col, grid_id, load);
+        } else {
+            coalesced_loads_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return load->future.get();
+    }
+    
+    // 进行中的网格加载
+    struct GridLoad {
+        std::promise<GridCache::ItemPtr> promise;
+        std::shared_future<GridCache::ItemPtr> future = promise.get_future().share();
+        std::atomic<bool> claimed{ false };   // 是否已有线程在执行该加载
+    };
+    
+    // 加入或登记网格加载
+    std::shared_ptr<GridLoad> joinGridLoad(const std::string& grid_id, bool& created) {
+        std::lock_guard<std::mutex> lock(loads_mutex_);
+        auto& load = loads_[grid_id];
+        created = !load;
+        if (created) {
+            load = std::make_shared<GridLoad>();
+        }
+        return load;
+    }
+    
+    // 执行网格加载并发布结果（异常同样交给所有等待者），之后注销
+    void runGridLoad(uint32_t row, uint32_t col, const std::string& grid_id, const std::shared_ptr<GridLoad>& load) {
+        try {
+            // 登记之前可能已有加载完成
+            GridCache::ItemPtr item = cache_.get(grid_id);
+            if (!item) {
+                item = readGridIntoCache(row, col);
+                grid_loads_.fetch_add(1, std::memory_order_relaxed);
+            }
+            load->promise.set_value(std::move(item));
+        } catch (...) {
+            load->promise.set_exception(std::current_exception());
+        }
+        std::lock_guard<std::mutex> lock(loads_mutex_);
+        auto it = loads_.find(grid_id);
+        if (it != loads_.end() && it->second == load) {
+            loads_.erase(it);
+        }
+    }
+    
+    /**
+     * @brief 把网格交给 loader_pool 后台加载
+     * @return 网格已缓存、已在加载或已提交时返回 true；没有线程池或提交被拒绝时返回 false
+     */
+    bool scheduleGridLoad(uint32_t row, uint32_t col) {
+        if (!loader_pool_) {
+            return false;
+        }
+        const std::string grid_id = TerrainKeyCodec::formatGridId(row, col);
+        if (cache_.contains(grid_id)) {
+            return true;
+        }
+        bool created;
+        auto load = joinGridLoad(grid_id, created);
+        if (!created) {
+            return true;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(loads_mutex_);
+            ++pending_loads_;
+        }
+        // 任务对象销毁时（执行完毕或线程池关闭时丢弃）注销计数，析构函数据此等待
+        std::shared_ptr<void> pending(nullptr, [this](void*) {
+            std::lock_guard<std::mutex> lock(loads_mutex_);
+            if (--pending_loads_ == 0) {
+                loads_cv_.notify_all();
+            }
+        });
+        const SubmitStatus status = loader_pool_->try_post(TaskPriority::LOW,
+            [this, row, col, grid_id, load, pending] {
+                if (!load->claimed.exchange(true)) {
+                    runGridLoad(row, col, grid_id, load);
+                }
+            });
+        if (status != SubmitStatus::ACCEPTED && status != SubmitStatus::RAN_IN_CALLER) {
+            // 被拒绝：注销登记；已加入的调用方会自行接手执行
+            std::lock_guard<std::mutex> lock(loads_mutex_);
+            auto it = loads_.find(grid_id);
+            if (it != loads_.end() && it->second == load) {
+                loads_.erase(it);
+            }
+            return false;
+        }
+        background_loads_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // 点未命中后加载所在网格：开启 async_miss_load 时后台加载，否则（或提交失败时）同步加载
+    void requestGrid(uint32_t row, uint32_t col) {
+        if (!async_miss_load_ || !scheduleGridLoad(row, col)) {
+            loadGridToCache(row, col);
+        }
+    }
+    
+    // 预取相邻网格：按与移动方向的夹角排序，前方的网格先提交
+    void prefetchNeighbours(uint32_t row, uint32_t col, const MovementCursor& cursor) {
+        if (!loader_pool_) {
+            return;
+        }
+        int64_t dr = 0, dc = 0;
+        if (cursor.row >= 0) {
+            dr = (static_cast<int64_t>(row) > cursor.row) - (static_cast<int64_t>(row) < cursor.row);
+            dc = (static_cast<int64_t>(col) > cursor.col) - (static_cast<int64_t>(col) < cursor.col);
+        }
+        std::vector<std::pair<int64_t, std::pair<int64_t, int64_t>>> neighbours;
+        for (int64_t r = -1; r <= 1; ++r) {
+            for (int64_t c = -1; c <= 1; ++c) {
+                const int64_t nr = static_cast<int64_t>(row) + r;
+                const int64_t nc = static_cast<int64_t>(col) + c;
+                if ((r == 0 && c == 0) || nr < 0 || nc < 0 || nr >= grid_rows_ || nc >= grid_cols_) {
+                    continue;
+                }
+                neighbours.push_back({ -(r * dr + c * dc), { nr, nc } });
+            }
+        }
+        std::stable_sort(neighbours.begin(), neighbours.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& neighbour : neighbours) {
+            scheduleGridLoad(static_cast<uint32_t>(neighbour.second.first),
+                             static_cast<uint32_t>(neighbour.second.second));
+        }
+    }
+    
+    // 从数据库读取网格并放入缓存；加载期间有写入落在未缓存的网格上时，结果照常返回但不放入缓存
+    GridCache::ItemPtr readGridIntoCache(uint32_t row, uint32_t col) {
+        auto cache_item = std::make_shared<GridCacheItem>();
+        cache_item->grid_id = TerrainKeyCodec::formatGridId(row, col);
+        const uint64_t token = cache_.loadToken(cache_item->grid_id);
+        
+        readGrid(row, col, cache_item->tile);
         
         // 放入缓存
-        cache_.put(grid_id, cache_item);
+        cache_.put(cache_item->grid_id, cache_item, token);
         
         return cache_item;
     }
     
-    // 从键中解析经纬度
-    bool parseKey(const std::string& key, double& lon, double& lat) const {
-        size_t first_delim = key.find('|');
-        if (first_delim == std::string::npos) return false;
+    // 从数据库读取整个网格（零拷贝扫描，仅在追加进 GridTile 时拷贝一次）
+    void readGrid(uint32_t row, uint32_t col, GridTile& tile) {
+        if (layout_ == StorageLayout::GRID_TILES) {
+            std::shared_lock<std::shared_mutex> lock(tile_mutex_);
+            readTile(codec_.gridCode(row, col), tile, nullptr);
+            return;
+        }
+        TerrainKeyCodec::Buffer prefix_buf;
+        const leveldb::Slice prefix(prefix_buf, codec_.encodeGridPrefix(row, col, prefix_buf));
+        db_manager_.scanPrefix(prefix,
+            [&](std::string_view key, std::string_view value) {
+                uint32_t lon, lat;
+                if (codec_.decodeFixed(key, lon, lat)) {
+                    tile.append(lon, lat, value);
+                }
+            }, gridScanOptions());
+        tile.finalize();
+    }
+    
+    // 整网格扫描的读选项：数据会进入网格缓存，不再占用 LevelDB 块缓存
+    static ScanOptions gridScanOptions() {
+        ScanOptions options;
+        options.fill_cache = false;
+        return options;
+    }
+    
+    /**
+     * @brief 读取网格块并叠加尚未合并的覆盖点（调用方持有 tile_mutex_，或在快照上读取）
+     * @param merged 非空时把读到的覆盖键加入该批次删除，用于合并
+     * @param snapshot 在指定快照上读取（网格块与覆盖键删除在同一批次中提交，快照上两者一致）
+     * @return 叠加的覆盖点数
+     */
+    size_t readTile(uint64_t code, GridTile& tile, BatchWriter* merged,
+                    SnapshotView snapshot = nullptr) {
+        ScanOptions options = gridScanOptions();
+        options.snapshot = snapshot;
+        ScanOptions get_options;
+        get_options.snapshot = snapshot;
+        TerrainKeyCodec::Buffer key_buf;
+        std::string blob;
+        if (db_manager_.get(leveldb::Slice(key_buf, codec_.encodeTileKey(code, key_buf)), blob, get_options)) {
+            if (!tile.deserialize(blob)) {
+                throw TerrainStorageException("网格块数据损坏: " + gridIdOf(code));
+            }
+        } else {
+            tile = GridTile();
+        }
         
-        size_t second_delim = key.find('|', first_delim + 1);
-        if (second_delim == std::string::npos) return false;
+        size_t overlay = 0;
+        const leveldb::Slice prefix(key_buf, codec_.encodeOverlayPrefix(code, key_buf));
+        db_manager_.scanPrefix(prefix,
+            [&](const leveldb::Slice& key, const leveldb::Slice& value) {
+                uint64_t key_code;
+                uint32_t lon, lat;
+                if (codec_.decodeOverlayKey(std::string_view(key.data(), key.size()), key_code, lon, lat)) {
+                    tile.upsert(lon, lat, std::string_view(value.data(), value.size()));
+                    if (merged) merged->del(key);
+                    ++overlay;
+                }
+            }, options);
+        return overlay;
+    }
+    
+    // 把一个网格的覆盖点合并进网格块，编码块与覆盖键删除在同一批次中原子提交
+    size_t mergeGrid(uint64_t code) {
+        std::unique_lock<std::shared_mutex> lock(tile_mutex_);
+        {
+            std::lock_guard<std::mutex> merge_lock(merge_mutex_);
+            pending_overlay_.erase(code);
+        }
+        GridTile tile;
+        auto batch = db_manager_.createBatch();
+        const size_t merged = readTile(code, tile, &batch);
+        if (merged == 0) {
+            return 0;
+        }
+        std::string blob;
+        tile.serialize(blob, tile_compression_);
+        TerrainKeyCodec::Buffer key_buf;
+        batch.put(leveldb::Slice(key_buf, codec_.encodeTileKey(code, key_buf)), blob);
+        batch.commit();
+        return merged;
+    }
+    
+    using LodCell = std::pair<uint32_t, uint32_t>;  // <行, 列>，按所在层计算
+    
+    static constexpr size_t kMaxLodLevels = 31;
+    static constexpr size_t kLodLockStripes = 64;  // 金字塔写锁分段数
+    
+    // 单点写入只修改所在顶层单元及其下各层，按顶层单元选择分段锁，不同顶层单元的写入互不阻塞
+    std::mutex& lodMutex(uint32_t row, uint32_t col) {
+        const size_t shift = lod_levels_ - 1;
+        const uint64_t cell = (static_cast<uint64_t>(row >> shift) << 32) | (col >> shift);
+        return lod_mutexes_[((cell * 0x9E3779B97F4A7C15ULL) >> 32) % kLodLockStripes];
+    }
+    
+    // 批量写入与重建可能修改任意单元：按下标顺序获取全部分段锁（未开启金字塔时不加锁）
+    std::vector<std::unique_lock<std::mutex>> lockAllLod() {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        if (lod_levels_ > 0) {
+            locks.reserve(kLodLockStripes);
+            for (auto& mutex : lod_mutexes_) {
+                locks.emplace_back(mutex);
+            }
+        }
+        return locks;
+    }
+    
+    // 计算查询框覆盖的网格范围（裁剪到引擎范围内），不相交时返回 false
+    bool coveredGrids(double min_lon, double min_lat, double max_lon, double max_lat,
+                      int& start_row, int& end_row, int& start_col, int& end_col) const {
+        start_col = std::max(0, lonToGridCol(min_lon));
+        end_col = std::min(grid_cols_ - 1, lonToGridCol(max_lon));
+        start_row = std::max(0, latToGridRow(min_lat));
+        end_row = std::min(grid_rows_ - 1, latToGridRow(max_lat));
+        return start_col <= end_col && start_row <= end_row;
+    }
+    
+    struct QueryBox {
+        double min_lon;
+        double min_lat;
+        double max_lon;
+        double max_lat;
+    };
+    
+    /**
+     * @brief 在快照上扫描单个网格，把落在查询框内的点交给 emit（返回 false 即停止）
+     *
+     * 逐点存储时起止键带上查询经度，只扫描网格内经度范围内的点；网格块方式读取网格块并叠加覆盖键
+     */
+    void scanGridSnapshot(uint32_t row, uint32_t col, const QueryBox& box, SnapshotView snapshot,
+                          const std::function<bool(double, double, std::string_view)>& emit,
+                          RangeQueryStats& stats) {
+        if (layout_ == StorageLayout::GRID_TILES) {
+            ++stats.key_ranges;
+            GridTile tile;
+            readTile(codec_.gridCode(row, col), tile, nullptr, snapshot);
+            uint32_t lon_lo, lon_hi, lat_lo, lat_hi;
+            if (!TerrainKeyCodec::fixedLonRange(box.min_lon, box.max_lon, lon_lo, lon_hi) ||
+                !TerrainKeyCodec::fixedLatRange(box.min_lat, box.max_lat, lat_lo, lat_hi)) {
+                return;
+            }
+            bool more = true;
+            stats.points_visited += tile.forEachInBox(lon_lo, lon_hi, lat_lo, lat_hi, [&](size_t i) {
+                if (more) {
+                    ++stats.points_returned;
+                    more = emit(TerrainKeyCodec::fromFixedLon(tile.lon(i)), TerrainKeyCodec::fromFixedLat(tile.lat(i)),
+                                tile.value(i));
+                }
+            });
+            return;
+        }
         
-        try {
-            lon = std::stod(key.substr(first_delim + 1, second_delim - first_delim - 1));
-            lat = std::stod(key.substr(second_delim + 1));
+        char start_buf[TerrainKeyCodec::kMaxKeySize];
+        char end_buf[TerrainKeyCodec::kMaxKeySize];
+        leveldb::Slice start;
+        std::string end;
+        if (codec_.format() == TerrainKeyFormat::TEXT) {
+            start = leveldb::Slice(start_buf, codec_.encodeGridPrefix(row, col, start_buf));
+            end = LevelDBManager::prefixUpperBound(start);
+        } else {
+            const uint64_t code = codec_.gridCode(row, col);
+            const uint32_t fixed_min_lon = TerrainKeyCodec::toFixedLon(std::max(box.min_lon, min_lon_));
+            const uint32_t fixed_max_lon = TerrainKeyCodec::toFixedLon(std::min(box.max_lon, max_lon_));
+            start = leveldb::Slice(start_buf, codec_.encodeScanBound(code, fixed_min_lon, start_buf));
+            end.assign(end_buf, codec_.encodeScanBound(code, fixed_max_lon + 1, end_buf));
+        }
+        
+        ScanOptions options;
+        options.snapshot = snapshot;
+        ++stats.key_ranges;
+        db_manager_.scan(start, end, [&](std::string_view key, std::string_view value) {
+            ++stats.points_visited;
+            double lon, lat;
+            if (codec_.decode(key, lon, lat) &&
+                lon >= box.min_lon && lon <= box.max_lon &&
+                lat >= box.min_lat && lat <= box.max_lat) {
+                ++stats.points_returned;
+                return emit(lon, lat, value);
+            }
             return true;
+        }, options);
+    }
+    
+    // 读取坐标处当前存储的值（写入前取旧值以维护聚合），调用方持有该点的金字塔分段锁
+    bool lookupStored(double lon, double lat, std::string& value) {
+        uint32_t row, col;
+        gridCell(lon, lat, row, col);
+        const uint32_t fixed_lon = TerrainKeyCodec::toFixedLon(lon);
+        const uint32_t fixed_lat = TerrainKeyCodec::toFixedLat(lat);
+        
+        // 已缓存的网格是完整的；网格块方式下未缓存时读取整个网格（一次 Get）
+        GridCache::ItemPtr cache_item = cache_.peek(row, col);
+        GridTile loaded;
+        const GridTile* tile = cache_item ? &cache_item->tile : nullptr;
+        if (!tile && layout_ == StorageLayout::GRID_TILES) {
+            readGrid(row, col, loaded);
+            tile = &loaded;
+        }
+        if (tile) {
+            const size_t i = tile->find(fixed_lon, fixed_lat);
+            if (i == GridTile::npos) {
+                return false;
+            }
+            value.assign(tile->value(i).data(), tile->value(i).size());
+            return true;
+        }
+        TerrainKeyCodec::Buffer key_buf;
+        return db_manager_.get(leveldb::Slice(key_buf, codec_.encode(row, col, lon, lat, key_buf)), value);
+    }
+    
+    bool readAggregate(size_t level, const LodCell& cell, TerrainAggregate& aggregate) {
+        TerrainKeyCodec::Buffer key_buf;
+        const size_t n = codec_.encodeLodKey(static_cast<uint8_t>(level), codec_.gridCode(cell.first, cell.second), key_buf);
+        std::string value;
+        aggregate = TerrainAggregate();
+        return db_manager_.get(leveldb::Slice(key_buf, n), value) && aggregate.deserialize(value);
+    }
+    
+    // 空单元删除聚合键，按分辨率查询只读到有数据的单元
+    void writeAggregate(BatchWriter& batch, size_t level, const LodCell& cell,
+                        const TerrainAggregate& aggregate) {
+        TerrainKeyCodec::Buffer key_buf;
+        const leveldb::Slice key(key_buf, codec_.encodeLodKey(static_cast<uint8_t>(level),
+                                                              codec_.gridCode(cell.first, cell.second), key_buf));
+        if (aggregate.empty()) {
+            batch.del(key);
+            return;
+        }
+        std::string value;
+        aggregate.serialize(value);
+        batch.put(key, value);
+    }
+    
+    // 由网格内全部数据点计算第 1 层聚合
+    TerrainAggregate aggregateGrid(uint32_t row, uint32_t col) {
+        GridTile tile;
+        readGrid(row, col, tile);
+        return aggregateTile(tile);
+    }
+    
+    static TerrainAggregate aggregateTile(const GridTile& tile) {
+        TerrainAggregate aggregate;
+        for (size_t i = 0; i < tile.size(); ++i) {
+            aggregate.add(tile.value(i));
+        }
+        return aggregate;
+    }
+    
+    // 由下一层的 4 个子单元重新聚合；below 中的子单元已更新，其余从数据库读取
+    TerrainAggregate aggregateChildren(size_t level, const LodCell& cell,
+                                       const std::map<LodCell, TerrainAggregate>& below) {
+        TerrainAggregate aggregate;
+        for (uint32_t dr = 0; dr < 2; ++dr) {
+            for (uint32_t dc = 0; dc < 2; ++dc) {
+                const LodCell child(cell.first * 2 + dr, cell.second * 2 + dc);
+                auto it = below.find(child);
+                TerrainAggregate child_aggregate;
+                if (it != below.end()) {
+                    child_aggregate = it->second;
+                } else {
+                    readAggregate(level - 1, child, child_aggregate);
+                }
+                aggregate.merge(child_aggregate);
+            }
+        }
+        return aggregate;
+    }
+    
+    /**
+     * @brief 写入已更新的第 1 层单元，并逐层重新聚合它们的父单元
+     * @param updated 第 1 层单元（网格行列）的新聚合值
+     *
+     * 每个父单元由 4 个子单元合并，写入量与更新的网格数成正比，不重建整个金字塔
+     */
+    void writeLodLevels(std::map<LodCell, TerrainAggregate> updated, BatchWriter& batch) {
+        for (size_t level = 1; level <= lod_levels_ && !updated.empty(); ++level) {
+            for (const auto& cell : updated) {
+                writeAggregate(batch, level, cell.first, cell.second);
+            }
+            if (level == lod_levels_) {
+                break;
+            }
+            std::set<LodCell> parents;
+            for (const auto& cell : updated) {
+                parents.emplace(cell.first.first >> 1, cell.first.second >> 1);
+            }
+            std::map<LodCell, TerrainAggregate> next;
+            for (const auto& parent : parents) {
+                next.emplace(parent, aggregateChildren(level + 1, parent, updated));
+            }
+            updated = std::move(next);
+        }
+    }
+    
+    /**
+     * @brief 单点写入后逐层更新聚合单元（调用方持有该点的金字塔分段锁）
+     * @param old_value 被覆盖的旧值（新增点时为空）
+     * @param old_known 是否确知旧值（为 false 时 old_value 不可信）
+     *
+     * 每层按差值更新；旧值未知或是该层单元的极值时差值不精确，第 1 层由网格数据、其上各层由子单元重新聚合
+     */
+    void updateLodPoint(uint32_t row, uint32_t col, const std::string* old_value, const std::string& value,
+                        bool old_known) {
+        auto batch = db_manager_.createBatch();
+        std::map<LodCell, TerrainAggregate> below;
+        for (size_t level = 1; level <= lod_levels_; ++level) {
+            const LodCell cell(row >> (level - 1), col >> (level - 1));
+            TerrainAggregate aggregate;
+            readAggregate(level, cell, aggregate);
+            const bool exact = old_known && (!old_value || aggregate.remove(*old_value));
+            aggregate.add(value);
+            if (!exact) {
+                aggregate = level == 1 ? aggregateGrid(row, col) : aggregateChildren(level, cell, below);
+            }
+            writeAggregate(batch, level, cell, aggregate);
+            below = { { cell, aggregate } };
+        }
+        batch.commit();
+    }
+    
+    // 批量写入中的一个数据点：按二进制键的顺序（网格编号、经度、纬度）排序，index 指回输入
+    struct IngestEntry {
+        uint64_t code;
+        uint32_t lon;
+        uint32_t lat;
+        size_t index;
+        
+        bool operator<(const IngestEntry& other) const {
+            return std::tie(code, lon, lat, index) < std::tie(other.code, other.lon, other.lat, other.index);
+        }
+    };
+    
+    static constexpr size_t kIngestSegmentPoints = 65536;  // 并行编码与排序的分段大小
+    
+    /**
+     * @brief 把下标 [0, n) 交给 worker_pool_ 与调用线程共同执行
+     *
+     * 各线程按原子计数领取下标，调用线程同样参与领取，线程池繁忙、拒绝或调用方自身就是池中线程时
+     * 退化为在调用线程内顺序执行，不会互相等待。全部下标执行完后重新抛出第一个异常
+     */
+    void parallelFor(size_t n, const std::function<void(size_t)>& fn) {
+        struct State {
+            std::atomic<size_t> next{ 0 };
+            size_t n = 0;
+            size_t done = 0;
+            const std::function<void(size_t)>* fn = nullptr;  // 只在领取到下标后使用，此时调用方仍在等待
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::exception_ptr error;
+        };
+        if (n == 0) {
+            return;
+        }
+        auto state = std::make_shared<State>();
+        state->n = n;
+        state->fn = &fn;
+        auto work = [](State& st) {
+            for (size_t i; (i = st.next.fetch_add(1, std::memory_order_relaxed)) < st.n;) {
+                std::exception_ptr error;
+                try {
+                    (*st.fn)(i);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(st.mutex);
+                if (error && !st.error) {
+                    st.error = error;
+                }
+                if (++st.done == st.n) {
+                    st.cv.notify_all();
+                }
+            }
+        };
+        
+        if (worker_pool_ && n > 1) {
+            const size_t helpers = std::min(n - 1, std::max<size_t>(worker_pool_->worker_count(), 1));
+            for (size_t i = 0; i < helpers; ++i) {
+                const SubmitStatus status = worker_pool_->try_post(TaskPriority::NORMAL, [state, work] { work(*state); });
+                if (status != SubmitStatus::ACCEPTED && status != SubmitStatus::RAN_IN_CALLER) {
+                    break;
+                }
+            }
+        }
+        work(*state);
+        
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&] { return state->done == state->n; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+    
+    /**
+     * @brief POINT_KEYS 方式的批量写入
+     * @param update_cache 提交后是否按网格更新缓存
+     * @param key_range [输出] 写入的最小与最大键（可选）
+     */
+    void ingestPoints(const std::vector<std::tuple<double, double, std::string>>& data,
+                      bool update_cache, std::pair<std::string, std::string>* key_range) {
+        // 并行校验坐标并计算排序键，每段各自排序
+        const size_t segments = (data.size() + kIngestSegmentPoints - 1) / kIngestSegmentPoints;
+        std::vector<std::vector<IngestEntry>> runs(segments);
+        parallelFor(segments, [&](size_t segment) {
+            const size_t begin = segment * kIngestSegmentPoints;
+            const size_t end = std::min(data.size(), begin + kIngestSegmentPoints);
+            std::vector<IngestEntry>& run = runs[segment];
+            run.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                const double lon = std::get<0>(data[i]);
+                const double lat = std::get<1>(data[i]);
+                if (!isWithinBounds(lon, lat)) {
+                    throw TerrainStorageException("坐标超出范围: (" + 
+                        std::to_string(lon) + ", " + std::to_string(lat) + ")");
+                }
+                run.push_back({ gridCode(lon, lat), TerrainKeyCodec::toFixedLon(lon),
+                                TerrainKeyCodec::toFixedLat(lat), i });
+            }
+            std::sort(run.begin(), run.end());
+        });
+        
+        // 多路归并各段，按键顺序写入；同一坐标按输入顺序相邻，后写入的覆盖先写入的
+        using Cursor = std::pair<size_t, size_t>;  // <段, 段内位置>
+        auto later = [&](const Cursor& a, const Cursor& b) {
+            return runs[b.first][b.second] < runs[a.first][a.second];
+        };
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+        for (size_t r = 0; r < runs.size(); ++r) {
+            if (!runs[r].empty()) {
+                heap.emplace(r, 0);
+            }
+        }
+        
+        std::vector<size_t> written;                          // 按键顺序写入的输入下标
+        std::vector<std::pair<uint64_t, size_t>> grid_runs;   // <网格编号, 在 written 中的结束位置>
+        const bool track_grids = update_cache || lod_levels_ > 0;
+        if (track_grids) {
+            written.reserve(data.size());
+        }
+        
+        // 双缓冲：一块在后台提交时填充另一块，最多两块驻留内存
+        BatchWriter batches[2] = { db_manager_.createBatch(), db_manager_.createBatch() };
+        size_t current = 0;
+        size_t batch_bytes = 0;
+        std::future<void> committing;
+        auto flush = [&] {
+            if (committing.valid()) {
+                committing.get();
+            }
+            committing = std::async(std::launch::async, [batch = &batches[current]] { batch->commit(); });
+            current ^= 1;
+            batch_bytes = 0;
+        };
+        
+        try {
+            while (!heap.empty()) {
+                const Cursor cursor = heap.top();
+                heap.pop();
+                const IngestEntry& entry = runs[cursor.first][cursor.second];
+                if (cursor.second + 1 < runs[cursor.first].size()) {
+                    heap.emplace(cursor.first, cursor.second + 1);
+                }
+                
+                const auto& point = data[entry.index];
+                TerrainKeyCodec::Buffer key_buf;
+                const leveldb::Slice key = encodeKey(std::get<0>(point), std::get<1>(point), key_buf);
+                batches[current].put(key, std::get<2>(point));
+                batch_bytes += key.size() + std::get<2>(point).size();
+                
+                if (key_range) {
+                    if (key_range->first.empty() || key.compare(key_range->first) < 0) {
+                        key_range->first.assign(key.data(), key.size());
+                    }
+                    if (key_range->second.empty() || key.compare(key_range->second) > 0) {
+                        key_range->second.assign(key.data(), key.size());
+                    }
+                }
+                if (track_grids) {
+                    if (grid_runs.empty() || grid_runs.back().first != entry.code) {
+                        grid_runs.emplace_back(entry.code, 0);
+                    }
+                    written.push_back(entry.index);
+                    grid_runs.back().second = written.size();
+                }
+                if (batch_bytes >= ingest_batch_bytes_) {
+                    flush();
+                }
+            }
+            if (batch_bytes > 0) {
+                flush();
+            }
+            if (committing.valid()) {
+                committing.get();
+            }
         } catch (...) {
-            return false;
+            // 部分块可能已提交：移除涉及的网格并使进行中的加载作废，之后按需重新加载
+            if (committing.valid()) {
+                committing.wait();
+            }
+            for (const auto& grid : grid_runs) {
+                cache_.remove(gridIdOf(grid.first));
+            }
+            if (!update_cache) {
+                cache_.clear();
+            }
+            throw;
+        }
+        
+        if (lod_levels_ > 0) {
+            updateLodGrids(data, written, grid_runs);
+        }
+        if (!update_cache) {
+            return;
+        }
+        
+        // 提交成功后按网格更新缓存（如果存在），每个网格只复制一次
+        size_t begin = 0;
+        for (const auto& grid : grid_runs) {
+            cache_.update(gridIdOf(grid.first), [&](GridTile& tile) {
+                for (size_t i = begin; i < grid.second; ++i) {
+                    const auto& point = data[written[i]];
+                    tile.upsert(TerrainKeyCodec::toFixedLon(std::get<0>(point)),
+                                TerrainKeyCodec::toFixedLat(std::get<1>(point)),
+                                std::get<2>(point));
+                }
+            });
+            begin = grid.second;
         }
     }
-
+    
+    /**
+     * @brief 批量写入提交后更新涉及网格的聚合（调用方持有全部金字塔分段锁）
+     *
+     * 尚无聚合的网格此前没有数据，直接由本批数据聚合（同一坐标只取最后一次）；
+     * 已有数据的网格无法得知被覆盖的旧值，由网格数据重新聚合
+     */
+    void updateLodGrids(const std::vector<std::tuple<double, double, std::string>>& data,
+                        const std::vector<size_t>& written,
+                        const std::vector<std::pair<uint64_t, size_t>>& grid_runs) {
+        std::map<LodCell, TerrainAggregate> updated;
+        size_t begin = 0;
+        for (const auto& grid : grid_runs) {
+            LodCell cell;
+            codec_.decodeGridCode(grid.first, cell.first, cell.second);
+            TerrainAggregate aggregate;
+            if (readAggregate(1, cell, aggregate) && !aggregate.empty()) {
+                aggregate = aggregateGrid(cell.first, cell.second);
+            } else {
+                aggregate = TerrainAggregate();
+                for (size_t i = begin; i < grid.second; ++i) {
+                    const auto& point = data[written[i]];
+                    if (i + 1 < grid.second) {
+                        const auto& next = data[written[i + 1]];
+                        if (TerrainKeyCodec::toFixedLon(std::get<0>(next)) == TerrainKeyCodec::toFixedLon(std::get<0>(point)) &&
+                            TerrainKeyCodec::toFixedLat(std::get<1>(next)) == TerrainKeyCodec::toFixedLat(std::get<1>(point))) {
+                            continue;  // 被同批次后面的写入覆盖
+                        }
+                    }
+                    aggregate.add(std::get<2>(point));
+                }
+            }
+            updated.emplace(cell, aggregate);
+            begin = grid.second;
+        }
+        auto batch = db_manager_.createBatch();
+        writeLodLevels(std::move(updated), batch);
+        batch.commit();
+    }
+    
+    // GRID_TILES 方式的批量写入：按网格分组，每个网格读出后整体重写为一个编码块
+    void batchPutTiles(const std::vector<std::tuple<double, double, std::string>>& data) {
+        std::map<uint64_t, std::vector<const std::tuple<double, double, std::string>*>> grids;
+        for (const auto& item : data) {
+            const double lon = std::get<0>(item);
+            const double lat = std::get<1>(item);
+            if (!isWithinBounds(lon, lat)) {
+                throw TerrainStorageException("坐标超出范围: (" + 
+                    std::to_string(lon) + ", " + std::to_string(lat) + ")");
+            }
+            grids[gridCode(lon, lat)].push_back(&item);
+        }
+        
+        std::unique_lock<std::shared_mutex> lock(tile_mutex_);
+        auto batch = db_manager_.createBatch();
+        std::vector<std::shared_ptr<GridCacheItem>> updated;
+        std::map<LodCell, TerrainAggregate> lod_updated;
+        std::string blob;
+        for (const auto& grid : grids) {
+            auto cache_item = std::make_shared<GridCacheItem>();
+            cache_item->grid_id = gridIdOf(grid.first);
+            readTile(grid.first, cache_item->tile, &batch);
+            for (const auto* point : grid.second) {
+                cache_item->tile.upsert(TerrainKeyCodec::toFixedLon(std::get<0>(*point)),
+                                        TerrainKeyCodec::toFixedLat(std::get<1>(*point)),
+                                        std::get<2>(*point));
+            }
+            cache_item->tile.serialize(blob, tile_compression_);
+            TerrainKeyCodec::Buffer key_buf;
+            batch.put(leveldb::Slice(key_buf, codec_.encodeTileKey(grid.first, key_buf)), blob);
+            if (lod_levels_ > 0) {
+                LodCell cell;
+                codec_.decodeGridCode(grid.first, cell.first, cell.second);
+                lod_updated.emplace(cell, aggregateTile(cache_item->tile));
+            }
+            if (cache_.contains(cache_item->grid_id)) {
+                updated.push_back(std::move(cache_item));
+            }
+        }
+        // 网格块包含网格内的全部点，聚合与网格块在同一批次中写入
+        writeLodLevels(std::move(lod_updated), batch);
+        batch.commit();
+        
+        // 提交成功后替换已缓存的网格
+        for (auto& cache_item : updated) {
+            cache_.put(cache_item->grid_id, cache_item);
+        }
+    }
+    
+    /**
+     * @brief 流式扫描网格编号闭区间 [lo, hi] 内的网格块（GRID_TILES 方式）
+     *
+     * 先扫描区间内的覆盖键（通常很少），再扫描网格块，两者都按网格编号升序，逐网格叠加后过滤
+     */
+    void scanTileCodes(uint64_t lo, uint64_t hi,
+                       double min_lon, double min_lat, double max_lon, double max_lat,
+                       const std::function<void(double, double, const std::string&)>& callback,
+                       RangeQueryStats& stats) {
+        struct OverlayPoint {
+            uint64_t code;
+            uint32_t lon;
+            uint32_t lat;
+            std::string value;
+        };
+        
+        std::shared_lock<std::shared_mutex> lock(tile_mutex_);
+        TerrainKeyCodec::Buffer lo_buf, hi_buf;
+        std::vector<OverlayPoint> overlay;
+        {
+            const leveldb::Slice start(lo_buf, codec_.encodeOverlayPrefix(lo, lo_buf));
+            const std::string end = LevelDBManager::prefixUpperBound(
+                leveldb::Slice(hi_buf, codec_.encodeOverlayPrefix(hi, hi_buf)));
+            ++stats.key_ranges;
+            db_manager_.scan(start, end, [&](std::string_view key, std::string_view value) {
+                OverlayPoint point;
+                if (codec_.decodeOverlayKey(key, point.code, point.lon, point.lat)) {
+                    point.value.assign(value.data(), value.size());
+                    overlay.push_back(std::move(point));
+                }
+            });
+        }
+        
+        size_t next = 0;
+        GridTile tile;
+        auto applyOverlay = [&](uint64_t code) {
+            for (; next < overlay.size() && overlay[next].code == code; ++next) {
+                tile.upsert(overlay[next].lon, overlay[next].lat, overlay[next].value);
+            }
+        };
+        auto filter = [&] {
+            filterCachedGrid(tile, min_lon, min_lat, max_lon, max_lat, callback, stats);
+            stats.points_visited += tile.size();
+        };
+        // 只有覆盖点、尚无网格块的网格
+        auto flushOverlayBefore = [&](uint64_t code, bool all) {
+            while (next < overlay.size() && (all || overlay[next].code < code)) {
+                tile = GridTile();
+                applyOverlay(overlay[next].code);
+                filter();
+            }
+        };
+        
+        const leveldb::Slice start(lo_buf, codec_.encodeTileKey(lo, lo_buf));
+        const std::string end = LevelDBManager::prefixUpperBound(
+            leveldb::Slice(hi_buf, codec_.encodeTileKey(hi, hi_buf)));
+        ++stats.key_ranges;
+        db_manager_.scan(start, end, [&](std::string_view key, std::string_view value) {
+            uint64_t code;
+            if (!codec_.decodeTileKey(key, code)) {
+                return;
+            }
+            flushOverlayBefore(code, false);
+            if (!tile.deserialize(value)) {
+                throw TerrainStorageException("网格块数据损坏: " + gridIdOf(code));
+            }
+            applyOverlay(code);
+            filter();
+        }, gridScanOptions());
+        flushOverlayBefore(0, true);
+    }
+    
+    // 记录覆盖写入，网格的覆盖点数达到阈值时交给后台线程合并
+    void noteOverlayWrite(uint64_t code) {
+        if (!merger_.joinable()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        if (++pending_overlay_[code] == merge_threshold_) {
+            merge_queue_.push_back(code);
+            merge_cv_.notify_one();
+        }
+    }
+    
+    // 后台合并线程
+    void mergeLoop() {
+        std::unique_lock<std::mutex> lock(merge_mutex_);
+        while (true) {
+            merge_cv_.wait(lock, [this] { return stop_merger_ || !merge_queue_.empty(); });
+            if (stop_merger_) {
+                return;
+            }
+            const uint64_t code = merge_queue_.front();
+            merge_queue_.pop_front();
+            lock.unlock();
+            try {
+                mergeGrid(code);
+            } catch (const std::exception&) {
+                // 合并失败时覆盖点仍然可读，下次触发或 mergeTiles() 时重试
+            }
+            lock.lock();
+        }
+    }
+    
+    std::string gridIdOf(uint64_t code) const {
+        uint32_t row, col;
+        codec_.decodeGridCode(code, row, col);
+        return TerrainKeyCodec::formatGridId(row, col);
+    }
+    
 private:
-    LevelDBManager& db_manager_;  // LevelDB管理器引用
+    Storage& db_manager_;  // 存储引用
     
     // 地理空间参数
     double min_lon_;
@@ -443,9 +2003,44 @@ private:
     // 网格参数
     int grid_rows_;
     int grid_cols_;
-    int id_width_;  // 网格ID格式化宽度
     
-    GridLRUCache cache_;  // 网格数据缓存
+    TerrainKeyCodec codec_;             // 数据点键编解码
+    RangeQueryMode range_query_mode_;   // 范围查询执行方式
+    StorageLayout layout_;              // 存放方式
+    TileCompression tile_compression_;  // 网格块值数据压缩算法
+    size_t merge_threshold_;            // 触发后台合并的覆盖点数
+    GridCache cache_;                   // 网格数据缓存
+    
+    // 网格加载：同一网格只有一个进行中的加载，后台加载提交到 loader_pool_
+    AdvancedThreadPool* loader_pool_;
+    bool async_miss_load_;
+    std::mutex loads_mutex_;                                              // 保护 loads_ 与 pending_loads_
+    std::condition_variable loads_cv_;
+    std::unordered_map<std::string, std::shared_ptr<GridLoad>> loads_;    // 进行中的网格加载
+    size_t pending_loads_ = 0;                                            // 已提交未结束的后台加载
+    std::atomic<size_t> grid_loads_{ 0 };
+    std::atomic<size_t> coalesced_loads_{ 0 };
+    std::atomic<size_t> background_loads_{ 0 };
+    
+    // 批量写入
+    AdvancedThreadPool* worker_pool_;   // 并行编码与排序（可为空）
+    size_t ingest_batch_bytes_;         // 单个 WriteBatch 的字节上限
+    
+    // 细节层次金字塔：单点写入持所在顶层单元的分段锁，批量写入与重建持全部分段锁（均先于 tile_mutex_ 获取）
+    size_t lod_levels_;
+    std::array<std::mutex, kLodLockStripes> lod_mutexes_;
+    
+    // GRID_TILES 方式：覆盖写入与读取持共享锁，网格合并与批量重写持独占锁
+    std::shared_mutex tile_mutex_;
+    std::mutex merge_mutex_;                                  // 保护以下合并队列状态
+    std::condition_variable merge_cv_;
+    std::unordered_map<uint64_t, size_t> pending_overlay_;    // 各网格自上次合并后的覆盖写入数
+    std::deque<uint64_t> merge_queue_;                        // 待后台合并的网格编号
+    bool stop_merger_ = false;
+    std::thread merger_;                                      // 后台合并线程
 };
 
+using TerrainStorageEngine = BasicTerrainStorageEngine<LevelDBManager>;
+using ShardedTerrainStorageEngine = BasicTerrainStorageEngine<ShardedLevelDBManager>;
+
 #endif // TERRAIN_STORAGE_ENGINE_HPP
\ No newline at end of file
@@ -0,0 +1,98 @@
+// test_bulk_ingest.cpp
+#include "test_terrain_storage.hpp"
+
+namespace {
+
+using PointData = std::vector<std::tuple<double, double, std::string>>;
+
+size_t countAll(TerrainStorageEngine& engine) {
+    size_t count = 0;
+    engine.rangeQuery(116.0, 39.0, 117.5, 41.0, [&](double, double, const std::string&) { ++count; });
+    return count;
+}
+
+} // namespace
+
+// 测试并行编码、分块提交：跨段的重复坐标以最后一次为准，已缓存的网格随之更新
+TEST_F(TerrainStorageTest, ParallelChunkedBatchPut) {
+    AdvancedThreadPool pool(fixedPoolConfig(2));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.worker_pool = &pool;
+    config.ingest_batch_bytes = 4096;  // 强制分成大量小块
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    PointData data = generateBatchData(150000);  // 3 个编码分段
+    engine.put(std::get<0>(data[10]), std::get<1>(data[10]), "old");
+    const std::string cached_grid = engine.computeGridId(std::get<0>(data[10]), std::get<1>(data[10]));
+    engine.preloadGrid(cached_grid);
+
+    // 后一个分段中覆盖前一个分段的点
+    PointMap expected;
+    record(expected, data);
+    for (size_t i = 0; i < 1000; ++i) {
+        const double lon = std::get<0>(data[i * 7]);
+        const double lat = std::get<1>(data[i * 7]);
+        data.emplace_back(lon, lat, "dup" + std::to_string(i));
+        expected[{ lon, lat }] = "dup" + std::to_string(i);
+    }
+
+    engine.batchPut(data);
+    EXPECT_EQ(countAll(engine), expected.size());
+
+    // 已缓存的网格：直接从缓存读到新值
+    std::string value;
+    ASSERT_TRUE(engine.get(std::get<0>(data[10]), std::get<1>(data[10]), value));
+    EXPECT_EQ(value, expected[std::make_pair(std::get<0>(data[10]), std::get<1>(data[10]))]);
+
+    engine.clearCache();
+    size_t i = 0;
+    for (const auto& point : expected) {
+        if (i++ % 97 == 0) {
+            ASSERT_TRUE(engine.get(point.first.first, point.first.second, value));
+            EXPECT_EQ(value, point.second);
+        }
+    }
+}
+
+// 测试任一分段中的坐标越界时不写入任何数据
+TEST_F(TerrainStorageTest, BatchPutRejectsBeforeWriting) {
+    AdvancedThreadPool pool(fixedPoolConfig(2));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.worker_pool = &pool;
+    config.ingest_batch_bytes = 1024;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    PointData data = generateBatchData(100000);
+    data.emplace_back(120.0, 40.0, "outside");
+    EXPECT_THROW(engine.batchPut(data), TerrainStorageException);
+    EXPECT_EQ(countAll(engine), 0);
+}
+
+// 测试初始导入：写入后压缩，不保留缓存，结果与 batchPut 一致
+TEST_F(TerrainStorageTest, BulkLoad) {
+    AdvancedThreadPool pool(fixedPoolConfig(2));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.worker_pool = &pool;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    const PointData data = generateBatchData(50000);
+    engine.preloadGrid(engine.computeGridId(std::get<0>(data[0]), std::get<1>(data[0])));
+    engine.bulkLoad(data);
+    EXPECT_EQ(engine.getCacheSize(), 0);
+    EXPECT_EQ(countAll(engine), data.size());
+    for (size_t i = 0; i < data.size(); i += 101) {
+        std::string value;
+        ASSERT_TRUE(engine.get(std::get<0>(data[i]), std::get<1>(data[i]), value));
+        EXPECT_EQ(value, std::get<2>(data[i]));
+    }
+
+    TerrainStorageConfig tile_config;
+    tile_config.storage_layout = StorageLayout::GRID_TILES;
+    tile_config.background_merge = false;
+    TerrainStorageEngine tiles(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, tile_config);
+    tiles.bulkLoad(data);
+    EXPECT_EQ(countAll(tiles), data.size());
+}
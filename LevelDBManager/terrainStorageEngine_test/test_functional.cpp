@@ -97,4 +97,124 @@ TEST_F(TerrainStorageTest, GridBoundaryQuery) {
     ASSERT_EQ(values.size(), 2);
     EXPECT_TRUE(std::find(values.begin(), values.end(), "grid1") != values.end());
     EXPECT_TRUE(std::find(values.begin(), values.end(), "grid2") != values.end());
-}
\ No newline at end of file
+}
+
+// 测试零拷贝扫描：上界、提前结束、前缀与快照
+TEST_F(TerrainStorageTest, ZeroCopyScan) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    for (int i = 0; i < 10; ++i) {
+        db.put("scan|" + std::to_string(i), "v" + std::to_string(i));
+    }
+    db.put("scan}", "outside");
+    
+    // 上界不包含
+    std::vector<std::string> keys;
+    size_t visited = db.scan("scan|2", "scan|5", [&](const leveldb::Slice& key, const leveldb::Slice&) {
+        keys.push_back(key.ToString());
+    });
+    ASSERT_EQ(visited, 3);
+    EXPECT_EQ(keys, (std::vector<std::string>{ "scan|2", "scan|3", "scan|4" }));
+    
+    // 访问函数返回 false 时提前结束
+    size_t seen = 0;
+    visited = db.scanPrefix("scan|", [&](std::string_view, std::string_view value) {
+        EXPECT_EQ(value.substr(0, 1), "v");
+        return ++seen < 4;
+    });
+    EXPECT_EQ(visited, 4);
+    EXPECT_EQ(seen, 4);
+    
+    // 快照上的扫描看不到之后的写入；关闭 fill_cache 不影响结果
+    auto snapshot = db.createSnapshot();
+    db.put("scan|a", "late");
+    ScanOptions options;
+    options.snapshot = snapshot->get();
+    options.fill_cache = false;
+    EXPECT_EQ(db.scanPrefix("scan|", [](const leveldb::Slice&, const leveldb::Slice&) {}, options), 10);
+    EXPECT_EQ(db.scanPrefix("scan|", [](const leveldb::Slice&, const leveldb::Slice&) {}), 11);
+    
+    // 带上界的迭代器
+    auto it = db.createIterator(ScanOptions(), LevelDBManager::prefixUpperBound("scan|"));
+    it.seekToLast();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.keySlice().ToString(), "scan|a");
+    
+    // 兼容接口 prefixQuery 结果不变
+    size_t count = 0;
+    db.prefixQuery("scan|", [&](const std::string& key, const std::string&) {
+        EXPECT_EQ(key.compare(0, 5, "scan|"), 0);
+        ++count;
+    });
+    EXPECT_EQ(count, 11);
+    EXPECT_EQ(LevelDBManager::prefixUpperBound(std::string("a\xff\xff")), "b");
+    EXPECT_EQ(LevelDBManager::prefixUpperBound(std::string("\xff")), "");
+}
+
+
+// 测试空间填充曲线范围查询与网格遍历结果一致，且不填充缓存
+TEST_F(TerrainStorageTest, CurveRangeQueryMatchesGridWalk) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig walk_config;
+    walk_config.range_query_mode = RangeQueryMode::GRID_WALK;
+    TerrainStorageConfig morton_config;
+    morton_config.grid_order = GridOrder::MORTON;
+    TerrainStorageEngine walk(db, 116.0, 39.0, 117.5, 41.0, 0.01, 500, walk_config);
+    TerrainStorageEngine morton(db, 116.0, 39.0, 117.5, 41.0, 0.01, 500, morton_config);
+    
+    auto data = generateBatchData(20000);
+    terrain_store_->batchPut(data);  // 行优先二进制键，walk 与 terrain_store_ 共用
+    morton.batchPut(data);           // Z 序二进制键与行优先键标记不同，互不干扰
+    
+    auto collect = [](TerrainStorageEngine& engine, double x0, double y0, double x1, double y1,
+                      RangeQueryStats* stats) {
+        std::vector<std::string> values;
+        engine.rangeQuery(x0, y0, x1, y1, [&](double, double, const std::string& value) {
+            values.push_back(value);
+        }, stats);
+        std::sort(values.begin(), values.end());
+        return values;
+    };
+    
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> lon_dist(115.9, 117.6);
+    std::uniform_real_distribution<double> lat_dist(38.9, 41.1);
+    for (int i = 0; i < 30; ++i) {
+        double x0 = lon_dist(gen), x1 = lon_dist(gen), y0 = lat_dist(gen), y1 = lat_dist(gen);
+        if (x0 > x1) std::swap(x0, x1);
+        if (y0 > y1) std::swap(y0, y1);
+        
+        RangeQueryStats walk_stats, row_stats, morton_stats;
+        auto expected = collect(walk, x0, y0, x1, y1, &walk_stats);
+        walk.clearCache();
+        EXPECT_EQ(collect(*terrain_store_, x0, y0, x1, y1, &row_stats), expected);
+        EXPECT_EQ(collect(morton, x0, y0, x1, y1, &morton_stats), expected);
+        EXPECT_EQ(morton_stats.points_returned, expected.size());
+        // 行优先每行一个区间，Z 序按四叉树分块，两者的扫描次数都不超过逐网格遍历
+        EXPECT_LE(row_stats.key_ranges, walk_stats.key_ranges);
+        EXPECT_LE(morton_stats.key_ranges, walk_stats.key_ranges);
+        EXPECT_LE(row_stats.points_visited, walk_stats.points_visited);
+    }
+    EXPECT_EQ(terrain_store_->getCacheSize(), 0);
+    EXPECT_EQ(morton.getCacheSize(), 0);
+    
+    // 已缓存的网格直接从缓存读取，结果不变
+    const double x0 = 116.40, y0 = 39.90, x1 = 116.45, y1 = 39.95;
+    auto expected = collect(walk, x0, y0, x1, y1, nullptr);
+    morton.preloadGrid(morton.computeGridId(116.425, 39.925));
+    RangeQueryStats stats;
+    EXPECT_EQ(collect(morton, x0, y0, x1, y1, &stats), expected);
+    EXPECT_EQ(stats.cached_grids, 1);
+    
+    // Z 序区间分解：与行优先网格一一覆盖同一矩形
+    TerrainKeyCodec codec(TerrainKeyFormat::BINARY, GridOrder::MORTON);
+    size_t cells = 0;
+    for (const auto& range : codec.coverRanges(3, 17, 5, 40)) {
+        for (uint64_t code = range.first; code <= range.second; ++code) {
+            uint32_t row, col;
+            codec.decodeGridCode(code, row, col);
+            ASSERT_TRUE(row >= 3 && row <= 17 && col >= 5 && col <= 40);
+            ++cells;
+        }
+    }
+    EXPECT_EQ(cells, 15u * 36u);
+}
@@ -0,0 +1,162 @@
+// test_grid_cache.cpp
+#include "test_terrain_storage.hpp"
+#include <thread>
+#include <atomic>
+
+namespace {
+
+GridCache::ItemPtr makeItem(const std::string& grid_id, size_t points, size_t value_size = 16) {
+    auto item = std::make_shared<GridCacheItem>();
+    item->grid_id = grid_id;
+    for (size_t i = 0; i < points; ++i) {
+        item->tile.append(static_cast<uint32_t>(i), 0, std::string(value_size, 'v'));
+    }
+    item->tile.finalize();
+    return item;
+}
+
+} // namespace
+
+// 测试按字节与网格数限制容量，超过分片上限的网格不缓存
+TEST(GridCacheTest, ByteCapacity) {
+    const size_t max_bytes = 256 * 1024;
+    GridCache cache(1000, max_bytes, 4);
+    ASSERT_EQ(cache.shardCount(), 4);
+
+    for (int i = 0; i < 200; ++i) {
+        cache.put("G_" + std::to_string(i), makeItem("G_" + std::to_string(i), 10 + (i % 7) * 50));
+        EXPECT_LE(cache.bytes(), max_bytes);
+    }
+    EXPECT_GT(cache.size(), 0);
+    EXPECT_LT(cache.size(), 200);
+
+    cache.put("huge", makeItem("huge", 10000));
+    EXPECT_EQ(cache.get("huge"), nullptr);
+
+    GridCache small(20, 0, 16);  // 容量小时分片数自动减少
+    EXPECT_EQ(small.shardCount(), 2);
+    for (int i = 0; i < 100; ++i) {
+        small.put("G_" + std::to_string(i), makeItem("G_" + std::to_string(i), 1));
+    }
+    EXPECT_LE(small.size(), 20);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.bytes(), 0);
+}
+
+// 测试 peek() 不计入访问次数：只被扫描查看过的网格照常淘汰
+TEST(GridCacheTest, PeekDoesNotTouch) {
+    GridCache cache(8, 0, 1);
+    const std::string peeked = TerrainKeyCodec::formatGridId(1, 2);
+    cache.put(peeked, makeItem(peeked, 1));
+    ASSERT_NE(cache.peek(1, 2), nullptr);
+    EXPECT_EQ(cache.peek(2, 1), nullptr);
+
+    const std::string hot = TerrainKeyCodec::formatGridId(3, 4);
+    cache.put(hot, makeItem(hot, 1));
+    for (int i = 0; i < 8; ++i) {
+        const std::string id = "scan_" + std::to_string(i);
+        cache.put(id, makeItem(id, 1));
+        EXPECT_NE(cache.get(hot), nullptr);
+        cache.peek(1, 2);
+    }
+    EXPECT_EQ(cache.peek(1, 2), nullptr);
+    EXPECT_NE(cache.peek(3, 4), nullptr);
+}
+
+// 测试一次性扫描大量网格时，反复访问的热点网格不被冲掉
+TEST(GridCacheTest, ScanResistance) {
+    GridCache cache(64, 0, 1);
+    std::vector<std::string> hot;
+    for (int i = 0; i < 16; ++i) {
+        hot.push_back("hot_" + std::to_string(i));
+        cache.put(hot.back(), makeItem(hot.back(), 1));
+    }
+
+    for (int i = 0; i < 5000; ++i) {
+        if (i % 16 == 0) {
+            for (const auto& id : hot) {
+                ASSERT_NE(cache.get(id), nullptr) << id << " evicted after " << i << " scanned grids";
+            }
+        }
+        const std::string id = "scan_" + std::to_string(i);
+        cache.put(id, makeItem(id, 1));
+    }
+    EXPECT_EQ(cache.size(), 64);
+}
+
+// 测试写时复制：读者持有的旧版本不受更新影响，无读者时原地修改，加载期间的写入使加载结果不进入缓存
+TEST(GridCacheTest, CopyOnWriteAndLoadToken) {
+    GridCache cache(100);
+    cache.put("G_001_001", makeItem("G_001_001", 3));
+
+    auto before = cache.get("G_001_001");
+    ASSERT_TRUE(cache.update("G_001_001", [](GridTile& tile) { tile.upsert(100, 0, "new"); }));
+    auto after = cache.get("G_001_001");
+    EXPECT_EQ(before->tile.size(), 3);
+    EXPECT_EQ(after->tile.size(), 4);
+    EXPECT_EQ(cache.bytes(), after->memoryBytes());
+
+    // 没有读者持有时原地修改，不再复制网格
+    before.reset();
+    const GridCacheItem* published = after.get();
+    after.reset();
+    ASSERT_TRUE(cache.update("G_001_001", [](GridTile& tile) { tile.upsert(101, 0, "more"); }));
+    after = cache.get("G_001_001");
+    EXPECT_EQ(after.get(), published);
+    EXPECT_EQ(after->tile.size(), 5);
+    EXPECT_EQ(cache.bytes(), after->memoryBytes());
+    after.reset();
+
+    const uint64_t token = cache.loadToken("G_002_002");
+    EXPECT_FALSE(cache.update("G_002_002", [](GridTile&) { FAIL(); }));
+    EXPECT_FALSE(cache.put("G_002_002", makeItem("G_002_002", 1), token));
+    EXPECT_EQ(cache.get("G_002_002"), nullptr);
+    EXPECT_TRUE(cache.put("G_002_002", makeItem("G_002_002", 1), cache.loadToken("G_002_002")));
+
+    cache.remove("G_001_001");
+    EXPECT_EQ(cache.size(), 1);
+}
+
+// 测试并发读写同一缓存网格：读者总是看到完整的网格版本
+TEST_F(TerrainStorageTest, ConcurrentCachedGridAccess) {
+    terrain_store_->put(116.4001, 39.9001, "seed");
+    terrain_store_->preloadGrid(terrain_store_->computeGridId(116.4001, 39.9001));
+
+    std::atomic<bool> done{ false };
+    std::thread writer([&] {
+        for (int i = 1; i < 80; ++i) {
+            terrain_store_->put(116.4001 + i * 0.0001, 39.9001, "v" + std::to_string(i));
+        }
+        done = true;
+    });
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&] {
+            size_t last = 0;
+            while (!done) {
+                size_t count = 0;
+                terrain_store_->rangeQuery(116.40, 39.90, 116.41, 39.91,
+                    [&](double, double, const std::string& value) {
+                        EXPECT_FALSE(value.empty());
+                        ++count;
+                    });
+                EXPECT_GE(count, last);  // 写入只增加点，快照中的点数单调不减
+                last = count;
+                std::string value;
+                EXPECT_TRUE(terrain_store_->get(116.4001, 39.9001, value));
+            }
+        });
+    }
+    writer.join();
+    for (auto& r : readers) {
+        r.join();
+    }
+
+    size_t count = 0;
+    terrain_store_->rangeQuery(116.40, 39.90, 116.41, 39.91, [&](double, double, const std::string&) { ++count; });
+    EXPECT_EQ(count, 80);
+    EXPECT_EQ(terrain_store_->getCacheSize(), 1);
+    EXPECT_GT(terrain_store_->getCacheBytes(), 0);
+}
@@ -0,0 +1,102 @@
+// test_grid_loading.cpp
+#include "test_terrain_storage.hpp"
+#include <thread>
+#include <atomic>
+
+// 测试多个线程同时未命中同一网格时只加载一次
+TEST_F(TerrainStorageTest, SingleFlightGridLoad) {
+    std::vector<std::tuple<double, double, std::string>> data;
+    for (int i = 0; i < 2000; ++i) {
+        data.emplace_back(116.4001 + (i % 50) * 0.0001, 39.9001 + (i / 50) * 0.0002, "p" + std::to_string(i));
+    }
+    terrain_store_->batchPut(data);
+    terrain_store_->clearCache();
+
+    std::atomic<int> ready{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            ++ready;
+            while (ready < 4) std::this_thread::yield();
+            std::string value;
+            EXPECT_TRUE(terrain_store_->get(std::get<0>(data[t]), std::get<1>(data[t]), value));
+            EXPECT_EQ(value, std::get<2>(data[t]));
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(terrain_store_->getLoadStats().loads, 1);
+    EXPECT_EQ(terrain_store_->getCacheSize(), 1);
+}
+
+// 测试点未命中时立即返回，网格在线程池中后台加载；排队中的加载由同步调用方接手
+TEST_F(TerrainStorageTest, AsyncMissLoad) {
+    AdvancedThreadPool pool(fixedPoolConfig(1));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.loader_pool = &pool;
+    config.async_miss_load = true;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+    engine.put(116.4051, 39.9051, "a");
+    engine.put(116.4052, 39.9052, "b");
+
+    // 占住唯一的工作线程，后台加载只能排队
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    pool.post([opened] { opened.wait(); });
+
+    std::string value;
+    ASSERT_TRUE(engine.get(116.4051, 39.9051, value));
+    EXPECT_EQ(value, "a");
+    EXPECT_EQ(engine.getCacheSize(), 0);
+    EXPECT_EQ(engine.getLoadStats().background, 1);
+
+    // 同步加载接手排队中的同一网格，后台任务随后空转
+    engine.preloadGrid(engine.computeGridId(116.4051, 39.9051));
+    EXPECT_EQ(engine.getCacheSize(), 1);
+    gate.set_value();
+    engine.waitForBackgroundLoads();
+    EXPECT_EQ(engine.getLoadStats().loads, 1);
+
+    ASSERT_TRUE(engine.get(116.4052, 39.9052, value));
+    EXPECT_EQ(value, "b");
+
+    // 另一个网格：后台加载完成后进入缓存
+    engine.put(116.5051, 39.9051, "c");
+    ASSERT_TRUE(engine.get(116.5051, 39.9051, value));
+    engine.waitForBackgroundLoads();
+    EXPECT_EQ(engine.getCacheSize(), 2);
+    EXPECT_EQ(engine.getLoadStats().loads, 2);
+}
+
+// 测试实体进入新网格时预取相邻网格
+TEST_F(TerrainStorageTest, NeighbourPrefetch) {
+    AdvancedThreadPool pool(fixedPoolConfig(2));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.loader_pool = &pool;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    MovementCursor cursor;
+    std::string value;
+    engine.get(116.405, 39.905, value, cursor);
+    engine.waitForBackgroundLoads();
+    EXPECT_EQ(engine.getCacheSize(), 9);  // 当前网格 + 8 个邻居
+
+    // 同一网格内移动不触发预取
+    engine.get(116.406, 39.906, value, cursor);
+    EXPECT_EQ(engine.getLoadStats().background, 8);
+
+    // 向东进入相邻网格：只需加载新露出的 3 个网格
+    engine.get(116.415, 39.905, value, cursor);
+    engine.waitForBackgroundLoads();
+    EXPECT_EQ(engine.getCacheSize(), 12);
+    EXPECT_EQ(engine.getLoadStats().background, 11);
+
+    // 范围角落只有 3 个邻居
+    MovementCursor corner;
+    engine.get(116.0001, 39.0001, value, corner);
+    engine.waitForBackgroundLoads();
+    EXPECT_EQ(engine.getCacheSize(), 16);
+}
@@ -0,0 +1,124 @@
+// test_grid_tile.cpp
+#include "test_terrain_storage.hpp"
+#include <unordered_map>
+#include <iostream>
+
+// 测试乱序追加后排序与点查询
+TEST(GridTileTest, AppendFinalizeFind) {
+    GridTile tile;
+    tile.append(30, 5, "c");
+    tile.append(10, 7, "a");
+    tile.append(30, 1, "b");
+    tile.append(20, 2, "");
+    tile.finalize();
+
+    ASSERT_EQ(tile.size(), 4);
+    EXPECT_EQ(tile.lon(0), 10u);
+    EXPECT_EQ(tile.lon(1), 20u);
+    EXPECT_EQ(tile.lat(2), 1u);
+    EXPECT_EQ(tile.lat(3), 5u);
+
+    size_t i = tile.find(30, 5);
+    ASSERT_NE(i, GridTile::npos);
+    EXPECT_EQ(tile.value(i), "c");
+    i = tile.find(20, 2);
+    ASSERT_NE(i, GridTile::npos);
+    EXPECT_EQ(tile.value(i), "");
+    EXPECT_EQ(tile.find(30, 3), GridTile::npos);
+    EXPECT_EQ(tile.find(40, 5), GridTile::npos);
+    EXPECT_EQ(GridTile().find(1, 1), GridTile::npos);
+}
+
+// 测试插入保持有序、覆盖更新与 arena 整理
+TEST(GridTileTest, UpsertAndCompact) {
+    GridTile tile;
+    tile.upsert(5, 5, "five");
+    tile.upsert(1, 1, "one");
+    tile.upsert(3, 9, "three");
+    ASSERT_EQ(tile.size(), 3);
+    EXPECT_EQ(tile.lon(1), 3u);
+
+    // 反复覆盖同一点，碎片超过一半时整理，内存不随更新次数增长
+    const std::string big(1000, 'x');
+    for (int i = 0; i < 100; ++i) {
+        tile.upsert(3, 9, big + std::to_string(i));
+    }
+    EXPECT_EQ(tile.size(), 3);
+    EXPECT_LT(tile.memoryBytes(), 8 * big.size());
+    EXPECT_EQ(tile.value(tile.find(3, 9)), big + "99");
+    EXPECT_EQ(tile.value(tile.find(1, 1)), "one");
+    EXPECT_EQ(tile.value(tile.find(5, 5)), "five");
+}
+
+// 测试矩形过滤与按浮点坐标比较的结果一致
+TEST(GridTileTest, BoxFilterMatchesDoubleCompare) {
+    GridTile tile;
+    std::vector<std::pair<double, double>> points;
+    for (int i = 0; i < 50; ++i) {
+        for (int j = 0; j < 50; ++j) {
+            const double lon = 116.4 + i * 0.0002;
+            const double lat = 39.9 + j * 0.0002;
+            points.emplace_back(lon, lat);
+            tile.append(TerrainKeyCodec::toFixedLon(lon), TerrainKeyCodec::toFixedLat(lat), "v");
+        }
+    }
+    tile.finalize();
+
+    // 边界恰好落在数据点上、以及落在两个定点数之间
+    const double boxes[][4] = {
+        { 116.4020, 39.9020, 116.4040, 39.9060 },
+        { 116.40201, 39.90199, 116.40399999, 39.90600001 },
+        { 116.0, 39.0, 117.0, 40.0 },
+        { 116.405, 39.0, 116.404, 40.0 },
+    };
+    for (const auto& box : boxes) {
+        size_t expected = 0;
+        for (const auto& p : points) {
+            const double lon = TerrainKeyCodec::fromFixedLon(TerrainKeyCodec::toFixedLon(p.first));
+            const double lat = TerrainKeyCodec::fromFixedLat(TerrainKeyCodec::toFixedLat(p.second));
+            if (lon >= box[0] && lon <= box[2] && lat >= box[1] && lat <= box[3]) ++expected;
+        }
+
+        size_t actual = 0;
+        uint32_t lon_lo, lon_hi, lat_lo, lat_hi;
+        if (TerrainKeyCodec::fixedLonRange(box[0], box[2], lon_lo, lon_hi) &&
+            TerrainKeyCodec::fixedLatRange(box[1], box[3], lat_lo, lat_hi)) {
+            tile.forEachInBox(lon_lo, lon_hi, lat_lo, lat_hi, [&](size_t i) {
+                const double lon = TerrainKeyCodec::fromFixedLon(tile.lon(i));
+                const double lat = TerrainKeyCodec::fromFixedLat(tile.lat(i));
+                EXPECT_TRUE(lon >= box[0] && lon <= box[2] && lat >= box[1] && lat <= box[3]);
+                ++actual;
+            });
+        }
+        EXPECT_EQ(actual, expected);
+    }
+
+    uint32_t lo, hi;
+    EXPECT_FALSE(TerrainKeyCodec::fixedLonRange(200.0, 210.0, lo, hi));
+    ASSERT_TRUE(TerrainKeyCodec::fixedLatRange(-100.0, 100.0, lo, hi));
+    EXPECT_EQ(lo, 0u);
+    EXPECT_EQ(hi, TerrainKeyCodec::toFixedLat(90.0));
+}
+
+// 对比列式网格与原 unordered_map<键, 值> 的内存占用
+TEST(GridTileTest, MemoryFootprint) {
+    TerrainKeyCodec codec;
+    GridTile tile;
+    std::unordered_map<std::string, std::string> map;
+    const size_t count = 10000;
+    for (size_t i = 0; i < count; ++i) {
+        const double lon = 116.4 + (i % 100) * 0.0001;
+        const double lat = 39.9 + (i / 100) * 0.0001;
+        const std::string value = "elevation:" + std::to_string(i % 1000);
+        tile.append(TerrainKeyCodec::toFixedLon(lon), TerrainKeyCodec::toFixedLat(lat), value);
+        map.emplace(codec.encode(90, 40, lon, lat), value);
+    }
+    tile.finalize();
+
+    // 每个 map 节点：next 指针 + 缓存的哈希值 + 两个 std::string，另加桶数组；不计字符串的堆外存储
+    const size_t map_bytes = map.size() * (2 * sizeof(void*) + 2 * sizeof(std::string)) +
+                             map.bucket_count() * sizeof(void*);
+    std::cout << "列式网格: " << tile.memoryBytes() << " 字节, unordered_map: 至少 "
+              << map_bytes << " 字节" << std::endl;
+    EXPECT_LT(tile.memoryBytes() * 2, map_bytes);
+}
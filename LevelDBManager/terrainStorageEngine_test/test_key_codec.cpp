@@ -0,0 +1,94 @@
+// test_key_codec.cpp
+#include "test_terrain_storage.hpp"
+
+// 测试二进制键的往返精度与键长
+TEST(TerrainKeyCodecTest, BinaryRoundTrip) {
+    TerrainKeyCodec codec;
+    const std::vector<std::pair<double, double>> points = {
+        { 116.402, 39.901 }, { -179.9999999, -89.9999999 }, { 180.0, 90.0 }, { 0.0000001, -0.0000001 }
+    };
+    for (const auto& point : points) {
+        TerrainKeyCodec::Buffer buf;
+        size_t n = codec.encode(12, 34, point.first, point.second, buf);
+        ASSERT_EQ(n, TerrainKeyCodec::kBinaryKeySize);
+
+        double lon, lat;
+        ASSERT_TRUE(codec.decode(std::string_view(buf, n), lon, lat));
+        EXPECT_EQ(lon, point.first);
+        EXPECT_EQ(lat, point.second);
+    }
+
+    double lon, lat;
+    EXPECT_FALSE(codec.decode("G_001_002|116.0000000|39.0000000", lon, lat));
+    EXPECT_FALSE(TerrainKeyCodec(TerrainKeyFormat::BINARY, GridOrder::MORTON)
+                     .decode(codec.encode(1, 2, 116.0, 39.0), lon, lat));
+}
+
+// 测试字节序与数值顺序一致（包括旧文本键在 999 行之后出错的情况）
+TEST(TerrainKeyCodecTest, OrderPreserving) {
+    TerrainKeyCodec codec;
+    EXPECT_LT(codec.encode(999, 5, 116.0, 39.0), codec.encode(1000, 5, 116.0, 39.0));
+    EXPECT_LT(codec.encode(3, 999, 116.0, 39.0), codec.encode(3, 1000, 116.0, 39.0));
+    EXPECT_LT(codec.encode(3, 4, -1.5, 39.0), codec.encode(3, 4, -1.25, 39.0));
+    EXPECT_LT(codec.encode(3, 4, 116.0, -10.0), codec.encode(3, 4, 116.0, 10.0));
+
+    const std::string prefix = codec.gridPrefix(3, 4);
+    EXPECT_EQ(codec.encode(3, 4, 116.0, 39.0).compare(0, prefix.size(), prefix), 0);
+
+    uint32_t row, col;
+    TerrainKeyCodec::unmorton(TerrainKeyCodec::morton(0xABCD, 0x1234), row, col);
+    EXPECT_EQ(row, 0xABCDu);
+    EXPECT_EQ(col, 0x1234u);
+    EXPECT_EQ(TerrainKeyCodec::morton(1, 0), 2u);
+    EXPECT_EQ(TerrainKeyCodec::morton(0, 1), 1u);
+}
+
+// 测试文本格式与旧实现（ostringstream）生成的键逐字节一致
+TEST(TerrainKeyCodecTest, TextCompatible) {
+    TerrainKeyCodec codec(TerrainKeyFormat::TEXT);
+    EXPECT_EQ(codec.encode(90, 40, 116.40499, 39.90499), "G_090_040|116.4049900|39.9049900");
+    EXPECT_EQ(codec.gridPrefix(7, 1234), "G_007_1234|");
+
+    double lon, lat;
+    ASSERT_TRUE(codec.decode("G_090_040|116.4049900|39.9049900", lon, lat));
+    EXPECT_DOUBLE_EQ(lon, 116.40499);
+    EXPECT_DOUBLE_EQ(lat, 39.90499);
+
+    uint32_t row, col;
+    ASSERT_TRUE(TerrainKeyCodec::parseGridId("G_050_030", row, col));
+    EXPECT_EQ(row, 50u);
+    EXPECT_EQ(col, 30u);
+    EXPECT_FALSE(TerrainKeyCodec::parseGridId("G_050", row, col));
+}
+
+// 测试旧文本键数据库的兼容读写与迁移
+TEST_F(TerrainStorageTest, LegacyKeyMigration) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig legacy;
+    legacy.key_format = TerrainKeyFormat::TEXT;
+    {
+        TerrainStorageEngine old_engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, legacy);
+        old_engine.batchPut({ { 116.402, 39.901, "a" }, { 116.403, 39.902, "b" }, { 117.1, 40.5, "c" } });
+        std::string value;
+        ASSERT_TRUE(db.get("G_090_040|116.4020000|39.9010000", value));
+        EXPECT_EQ(value, "a");
+    }
+
+    // 二进制格式打开旧库且未要求迁移时拒绝，避免旧数据被静默忽略
+    EXPECT_THROW(TerrainStorageEngine(db, 116.0, 39.0, 117.5, 41.0, 0.01), TerrainStorageException);
+
+    TerrainStorageConfig migrate;
+    migrate.migrate_legacy_keys = true;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, migrate);
+    EXPECT_FALSE(engine.hasLegacyKeys());
+
+    std::string value;
+    ASSERT_TRUE(engine.get(116.403, 39.902, value));
+    EXPECT_EQ(value, "b");
+    ASSERT_TRUE(engine.get(117.1, 40.5, value));
+    EXPECT_EQ(value, "c");
+
+    size_t count = 0;
+    engine.rangeQuery(116.40, 39.90, 116.41, 39.91, [&](double, double, const std::string&) { ++count; });
+    EXPECT_EQ(count, 2);
+}
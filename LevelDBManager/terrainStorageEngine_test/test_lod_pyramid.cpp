@@ -0,0 +1,243 @@
+// test_lod_pyramid.cpp
+#include "test_terrain_storage.hpp"
+#include <map>
+#include <thread>
+
+namespace {
+
+using CellMap = std::map<std::pair<uint32_t, uint32_t>, TerrainAggregate>;
+using TerrainPoints = std::vector<std::tuple<double, double, std::string>>;
+
+// 固定种子生成测试点，失败时可复现
+TerrainPoints generatePoints(size_t count, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> lon_dist(116.0, 117.5);
+    std::uniform_real_distribution<double> lat_dist(39.0, 41.0);
+    std::uniform_real_distribution<double> elevation_dist(0.0, 2000.0);
+    TerrainPoints points;
+    points.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const double lon = lon_dist(gen);
+        const double lat = lat_dist(gen);
+        points.emplace_back(lon, lat, std::to_string(elevation_dist(gen)));
+    }
+    return points;
+}
+
+// 由原始输入坐标逐点计算第 level 层各单元的聚合值
+// （不用查询回的坐标：定点编码舍入后，网格边界附近的点会被算到相邻网格）
+CellMap bruteForce(TerrainStorageEngine& engine, const PointMap& model, size_t level) {
+    CellMap cells;
+    for (const auto& [coord, value] : model) {
+        uint32_t row, col;
+        EXPECT_TRUE(TerrainKeyCodec::parseGridId(engine.computeGridId(coord.first, coord.second), row, col));
+        cells[{ row >> (level - 1), col >> (level - 1) }].add(value);
+    }
+    return cells;
+}
+
+CellMap queryLevel(TerrainStorageEngine& engine, size_t level, double grid_size) {
+    CellMap cells;
+    const double cell_size = grid_size * static_cast<double>(1ULL << (level - 1));
+    engine.rangeQuery(116.0, 39.0, 117.5, 41.0, cell_size, [&](const TerrainCell& cell) {
+        EXPECT_EQ(cell.level, level);
+        const auto row = static_cast<uint32_t>(std::lround((cell.min_lat - 39.0) / cell_size));
+        const auto col = static_cast<uint32_t>(std::lround((cell.min_lon - 116.0) / cell_size));
+        EXPECT_TRUE(cells.emplace(std::make_pair(row, col), cell.aggregate).second);
+    });
+    return cells;
+}
+
+void expectPyramidMatches(TerrainStorageEngine& engine, const PointMap& model, size_t levels, double grid_size) {
+    for (size_t level = 1; level <= levels; ++level) {
+        const CellMap expected = bruteForce(engine, model, level);
+        const CellMap actual = queryLevel(engine, level, grid_size);
+        ASSERT_EQ(actual.size(), expected.size()) << "level " << level;
+        for (const auto& cell : expected) {
+            auto it = actual.find(cell.first);
+            ASSERT_NE(it, actual.end()) << "level " << level;
+            EXPECT_EQ(it->second.count, cell.second.count);
+            EXPECT_EQ(it->second.samples, cell.second.samples);
+            EXPECT_EQ(it->second.min, cell.second.min);
+            EXPECT_EQ(it->second.max, cell.second.max);
+            EXPECT_NEAR(it->second.sum, cell.second.sum, 1e-6 * std::max(1.0, std::abs(cell.second.sum)));
+        }
+    }
+}
+
+// 覆盖写入、改写极值、非数值与新增点，再批量覆盖已有网格；每次写入同步记入 model
+void mutate(TerrainStorageEngine& engine, const TerrainPoints& data, PointMap& model) {
+    auto put = [&](double lon, double lat, const std::string& value) {
+        engine.put(lon, lat, value);
+        model[{ lon, lat }] = value;
+    };
+    for (size_t i = 0; i < 300; ++i) {
+        const auto& point = data[i * 13];
+        put(std::get<0>(point), std::get<1>(point), "5000");  // 新的最大值
+        if (i % 2 == 0) {
+            put(std::get<0>(point), std::get<1>(point), "-1");  // 移除最大值，写入新的最小值
+        }
+        if (i % 5 == 0) {
+            put(std::get<0>(point), std::get<1>(point), "n/a");
+        }
+    }
+    put(116.00005, 39.00005, "7");
+    TerrainPoints overlap;
+    for (size_t i = 0; i < 2000; ++i) {
+        const auto& point = data[i * 3];
+        overlap.emplace_back(std::get<0>(point), std::get<1>(point), std::to_string(i));
+    }
+    overlap.emplace_back(117.49995, 40.99995, "1");
+    engine.batchPut(overlap);
+    record(model, overlap);
+}
+
+} // namespace
+
+// 测试聚合值的增删、合并与编码
+TEST(TerrainAggregateTest, AddRemoveMerge) {
+    double number;
+    EXPECT_TRUE(TerrainAggregate::parseValue("1234.500000", number));
+    EXPECT_EQ(number, 1234.5);
+    EXPECT_TRUE(TerrainAggregate::parseValue(" -3 ", number));
+    EXPECT_FALSE(TerrainAggregate::parseValue("elevation:12", number));
+    EXPECT_FALSE(TerrainAggregate::parseValue("", number));
+
+    TerrainAggregate a;
+    a.add("10");
+    a.add("20");
+    a.add("30");
+    a.add("seed");
+    EXPECT_EQ(a.count, 4u);
+    EXPECT_EQ(a.samples, 3u);
+    EXPECT_DOUBLE_EQ(a.mean(), 20.0);
+    EXPECT_TRUE(a.remove("20"));    // 非极值，差值精确
+    EXPECT_TRUE(a.remove("seed"));
+    EXPECT_FALSE(a.remove("30"));   // 移除最大值，需重新聚合
+    EXPECT_EQ(a.count, 1u);
+
+    TerrainAggregate b;
+    b.add("-5");
+    b.merge(a);
+    EXPECT_EQ(b.min, -5.0);
+    EXPECT_TRUE(std::isnan(TerrainAggregate().mean()));
+
+    std::string blob;
+    b.serialize(blob);
+    TerrainAggregate decoded;
+    ASSERT_TRUE(decoded.deserialize(blob));
+    EXPECT_EQ(decoded.count, b.count);
+    EXPECT_EQ(decoded.min, b.min);
+    EXPECT_EQ(decoded.max, b.max);
+    EXPECT_FALSE(decoded.deserialize(blob.substr(1)));
+}
+
+// 测试逐点存储下的增量维护：各层聚合与由原始数据计算的结果一致，重建后不变
+TEST_F(TerrainStorageTest, LodIncrementalMatchesRebuild) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.lod_levels = 4;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    EXPECT_EQ(engine.lodLevelFor(0.005), 0);
+    EXPECT_EQ(engine.lodLevelFor(0.01), 1);
+    EXPECT_EQ(engine.lodLevelFor(0.035), 2);
+    EXPECT_EQ(engine.lodLevelFor(10.0), 4);
+
+    const auto data = generatePoints(20000, 20240601);
+    PointMap model;
+    engine.batchPut(data);
+    record(model, data);
+    engine.preloadGrid(engine.computeGridId(std::get<0>(data[0]), std::get<1>(data[0])));
+    mutate(engine, data, model);
+    expectPyramidMatches(engine, model, 4, 0.01);
+
+    engine.rebuildLodPyramid();
+    expectPyramidMatches(engine, model, 4, 0.01);
+}
+
+// 测试网格块存储下的增量维护
+TEST_F(TerrainStorageTest, LodWithGridTiles) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.lod_levels = 3;
+    config.storage_layout = StorageLayout::GRID_TILES;
+    config.grid_order = GridOrder::MORTON;
+    config.background_merge = false;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    const auto data = generatePoints(10000, 20240602);
+    PointMap model;
+    engine.batchPut(data);
+    record(model, data);
+    mutate(engine, data, model);
+    expectPyramidMatches(engine, model, 3, 0.01);
+    engine.mergeTiles();
+    expectPyramidMatches(engine, model, 3, 0.01);
+}
+
+// 测试多线程单点写入：不同顶层单元的写入并行执行，同一单元内串行，结果与逐点计算一致
+TEST_F(TerrainStorageTest, LodConcurrentPuts) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.lod_levels = 3;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    const auto data = generatePoints(4000, 20240603);
+    engine.batchPut(data);
+    engine.preloadGrid(engine.computeGridId(std::get<0>(data[1]), std::get<1>(data[1])));
+
+    // 各线程改写互不相同的点（含已缓存网格中的点），点分布在全部顶层单元中
+    constexpr size_t kThreads = 4;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < 800; i += kThreads) {
+                const auto& point = data[i];
+                engine.put(std::get<0>(point), std::get<1>(point), i % 3 == 0 ? "5000" : "-1");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    PointMap model;
+    record(model, data);
+    for (size_t i = 0; i < 800; ++i) {
+        model[{ std::get<0>(data[i]), std::get<1>(data[i]) }] = i % 3 == 0 ? "5000" : "-1";
+    }
+    expectPyramidMatches(engine, model, 3, 0.01);
+}
+
+// 测试粗分辨率查询只读取聚合单元：读取量由单元数决定，与原始点数无关
+TEST_F(TerrainStorageTest, LodCoarseQuery) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.lod_levels = 6;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+    const auto data = generateBatchData(50000);
+    engine.bulkLoad(data);
+
+    RangeQueryStats stats;
+    size_t points = 0;
+    engine.rangeQuery(116.0, 39.0, 117.5, 41.0, 0.32, [&](const TerrainCell& cell) {
+        EXPECT_EQ(cell.level, 6);
+        EXPECT_GE(cell.aggregate.min, 0.0);
+        EXPECT_LE(cell.aggregate.max, 2000.0);
+        points += cell.aggregate.count;
+    }, &stats);
+    EXPECT_EQ(points, data.size());
+    EXPECT_LE(stats.points_visited, 5u * 7u);  // 150×200 个网格，每单元 32×32 个网格
+
+    // 第 0 层：逐点返回
+    size_t raw = 0;
+    engine.rangeQuery(116.40, 39.90, 116.45, 39.95, 0.001, [&](const TerrainCell& cell) {
+        EXPECT_EQ(cell.level, 0);
+        EXPECT_EQ(cell.aggregate.count, 1);
+        ++raw;
+    });
+    size_t expected = 0;
+    engine.rangeQuery(116.40, 39.90, 116.45, 39.95, [&](double, double, const std::string&) { ++expected; });
+    EXPECT_EQ(raw, expected);
+}
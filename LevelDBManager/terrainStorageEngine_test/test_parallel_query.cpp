@@ -0,0 +1,160 @@
+// test_parallel_query.cpp
+#include "test_terrain_storage.hpp"
+
+namespace {
+
+// 收集并行查询结果，同时记录各批次的来源网格
+PointMap parallelQuery(TerrainStorageEngine& engine, double min_lon, double min_lat, double max_lon, double max_lat,
+                       const ParallelQueryOptions& options, std::vector<std::pair<uint32_t, uint32_t>>* grids = nullptr) {
+    PointMap points;
+    EXPECT_TRUE(engine.parallelRangeQuery(min_lon, min_lat, max_lon, max_lat, [&](const TerrainPointChunk& chunk) {
+        EXPECT_FALSE(chunk.empty());
+        EXPECT_LE(chunk.size(), options.chunk_points);
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            EXPECT_TRUE(points.emplace(std::make_pair(chunk.lon[i], chunk.lat[i]), std::string(chunk.value(i))).second);
+        }
+        if (grids) grids->emplace_back(chunk.row, chunk.col);
+        return true;
+    }, options));
+    return points;
+}
+
+} // namespace
+
+// 测试并行查询与顺序查询结果一致；有序交付时批次按网格编号排列（ROW_MAJOR 即先行后列）
+TEST_F(TerrainStorageTest, ParallelRangeQueryMatchesSequential) {
+    AdvancedThreadPool pool(fixedPoolConfig(4));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100);
+    engine.bulkLoad(generateBatchData(50000));
+
+    const PointMap expected = collect(engine, 116.30, 39.80, 116.62, 40.07);
+    ASSERT_FALSE(expected.empty());
+
+    ParallelQueryOptions options;
+    options.pool = &pool;
+    options.max_in_flight = 6;
+    options.chunk_points = 3;
+    EXPECT_EQ(parallelQuery(engine, 116.30, 39.80, 116.62, 40.07, options), expected);
+
+    options.ordered = true;
+    std::vector<std::pair<uint32_t, uint32_t>> grids;
+    EXPECT_EQ(parallelQuery(engine, 116.30, 39.80, 116.62, 40.07, options, &grids), expected);
+    EXPECT_TRUE(std::is_sorted(grids.begin(), grids.end()));
+
+    // 未指定线程池时在调用线程上顺序扫描
+    options.pool = nullptr;
+    RangeQueryStats stats;
+    size_t returned = 0;
+    EXPECT_TRUE(engine.parallelRangeQuery(116.30, 39.80, 116.62, 40.07, [&](const TerrainPointChunk& chunk) {
+        returned += chunk.size();
+        return true;
+    }, options, &stats));
+    EXPECT_EQ(returned, expected.size());
+    EXPECT_EQ(stats.points_returned, expected.size());
+    EXPECT_GE(stats.points_visited, stats.points_returned);
+}
+
+// 测试所有网格在同一快照上扫描：sink 中写入的点不出现在本次结果中
+TEST_F(TerrainStorageTest, ParallelRangeQuerySnapshot) {
+    AdvancedThreadPool pool(fixedPoolConfig(4));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100);
+    engine.bulkLoad(generateBatchData(20000));
+    const PointMap expected = collect(engine, 116.0, 39.0, 116.5, 39.5);
+
+    ParallelQueryOptions options;
+    options.pool = &pool;
+    options.max_in_flight = 2;
+    size_t returned = 0;
+    bool written = false;
+    EXPECT_TRUE(engine.parallelRangeQuery(116.0, 39.0, 116.5, 39.5, [&](const TerrainPointChunk& chunk) {
+        if (!written) {
+            for (int i = 0; i < 50; ++i) {
+                engine.put(116.4 + i * 0.001, 39.4, "late");
+            }
+            written = true;
+        }
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            EXPECT_NE(chunk.value(i), "late");
+        }
+        returned += chunk.size();
+        return true;
+    }, options));
+    EXPECT_EQ(returned, expected.size());
+}
+
+// 测试 sink 返回 false 即取消查询，之后不再交付
+TEST_F(TerrainStorageTest, ParallelRangeQueryCancel) {
+    AdvancedThreadPool pool(fixedPoolConfig(4));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100);
+    engine.bulkLoad(generateBatchData(20000));
+
+    ParallelQueryOptions options;
+    options.pool = &pool;
+    options.chunk_points = 1;
+    size_t chunks = 0;
+    EXPECT_FALSE(engine.parallelRangeQuery(116.0, 39.0, 117.5, 41.0, [&](const TerrainPointChunk&) {
+        return ++chunks < 5;
+    }, options));
+    EXPECT_EQ(chunks, 5u);
+
+    // 空查询框视为完整执行
+    EXPECT_TRUE(engine.parallelRangeQuery(118.0, 42.0, 119.0, 43.0, [](const TerrainPointChunk&) {
+        ADD_FAILURE();
+        return true;
+    }, options));
+}
+
+// 测试网格块存储：网格块与未合并的覆盖点在同一快照上读取
+TEST_F(TerrainStorageTest, ParallelRangeQueryGridTiles) {
+    AdvancedThreadPool pool(fixedPoolConfig(4));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.storage_layout = StorageLayout::GRID_TILES;
+    config.grid_order = GridOrder::MORTON;
+    config.background_merge = false;
+    config.worker_pool = &pool;
+    TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    const auto data = generateBatchData(20000);
+    engine.batchPut(data);
+    for (size_t i = 0; i < 200; ++i) {
+        engine.put(std::get<0>(data[i]), std::get<1>(data[i]), "overlay" + std::to_string(i));
+    }
+
+    const PointMap expected = collect(engine, 116.2, 39.6, 116.9, 40.3);
+    ParallelQueryOptions options;  // 使用 worker_pool
+    options.chunk_points = 64;
+    EXPECT_EQ(parallelQuery(engine, 116.2, 39.6, 116.9, 40.3, options), expected);
+}
+
+// 测试 sink 抛出异常：异常原样传给调用方，已开始的网格扫描结束后才返回，之后可以立即销毁引擎
+TEST_F(TerrainStorageTest, ParallelRangeQuerySinkThrows) {
+    AdvancedThreadPool pool(fixedPoolConfig(4));
+    LevelDBManager& db = LevelDBManager::getInstance();
+    auto engine = std::make_unique<TerrainStorageEngine>(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100);
+    engine->bulkLoad(generateBatchData(20000));
+
+    ParallelQueryOptions options;
+    options.pool = &pool;
+    options.max_in_flight = 16;
+    size_t chunks = 0;
+    EXPECT_THROW(engine->parallelRangeQuery(116.0, 39.0, 117.5, 41.0, [&](const TerrainPointChunk&) -> bool {
+        if (++chunks == 3) {
+            throw std::runtime_error("sink failed");
+        }
+        return true;
+    }, options), std::runtime_error);
+    EXPECT_EQ(chunks, 3u);
+
+    // 之后的查询不受影响
+    options.chunk_points = 4096;
+    EXPECT_EQ(parallelQuery(*engine, 116.0, 39.0, 116.5, 39.5, options),
+              collect(*engine, 116.0, 39.0, 116.5, 39.5));
+
+    // 立即销毁引擎：线程池中尚未执行的任务已被取消，不再访问引擎与快照
+    engine.reset();
+    pool.shutdown();
+}
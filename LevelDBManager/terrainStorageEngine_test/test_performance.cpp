@@ -1,31 +1,51 @@
 // test_performance.cpp
 #include "test_terrain_storage.hpp"
 
-// 测试大规模数据插入性能
+// 测试大规模数据插入性能（10万点；设置环境变量 TERRAIN_PERF_10M 时追加 100万与 1000万点）
 TEST_F(TerrainStorageTest, MassiveInsertPerformance) {
-    // 生成10万个点
-    auto data = generateBatchData(100000);
+    AdvancedThreadPool pool(fixedPoolConfig(std::max(1u, std::thread::hardware_concurrency())));
+    TerrainStorageConfig config;
+    config.worker_pool = &pool;
     
-    // 测量批量存储时间
-    auto duration = measureTime("插入100,000点", [&]{
-        terrain_store_->batchPut(data);
-    });
+    std::vector<size_t> sizes = { 100000 };
+    if (std::getenv("TERRAIN_PERF_10M")) {
+        sizes.push_back(1000000);
+        sizes.push_back(10000000);
+    }
     
-    // 验证数据量
-    size_t count = 0;
-    terrain_store_->rangeQuery(116.0, 39.0, 117.5, 41.0, 
-        [&](double, double, const std::string&) {
-            count++;
+    LevelDBManager& db = LevelDBManager::getInstance();
+    for (size_t points : sizes) {
+        // 每轮从空库开始
+        db.shutdown();
+        fs::remove_all(db_path_);
+        fs::create_directory(db_path_);
+        db.initialize(db_path_.string());
+        TerrainStorageEngine engine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 500, config);
+        
+        auto data = generateBatchData(points);
+        const std::string label = "插入" + std::to_string(points) + "点";
+        
+        // 测量批量存储时间
+        auto duration = measureTime(label, [&]{
+            engine.batchPut(data);
         });
-    
-    EXPECT_GE(count, 100000);
-    
-    // 记录插入速率
-    double rate = 100000.0 / (duration.count() / 1000.0);
-    std::string rate_str = "插入速率: " + std::to_string(static_cast<int>(rate)) + " 点/秒";
-    std::cout << rate_str << std::endl;
-    if (report_file_.is_open()) {
-        report_file_ << rate_str << std::endl;
+        
+        // 验证数据量
+        size_t count = 0;
+        engine.rangeQuery(116.0, 39.0, 117.5, 41.0, 
+            [&](double, double, const std::string&) {
+                count++;
+            });
+        
+        EXPECT_GE(count, points);
+        
+        // 记录插入速率
+        double rate = points / (std::max<int64_t>(duration.count(), 1) / 1000.0);
+        std::string rate_str = label + " 插入速率: " + std::to_string(static_cast<int>(rate)) + " 点/秒";
+        std::cout << rate_str << std::endl;
+        if (report_file_.is_open()) {
+            report_file_ << rate_str << std::endl;
+        }
     }
 }
 
@@ -79,6 +99,40 @@ TEST_F(TerrainStorageTest, CacheHitPerformance) {
     }
 }
 
+// 整网格存储与逐点存储的冷缓存读取对比：加载网格由前缀扫描变为一次 Get 加解码
+TEST_F(TerrainStorageTest, TileColdGetPerformance) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.storage_layout = StorageLayout::GRID_TILES;
+    TerrainStorageEngine tiles(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100000, config);
+    
+    auto data = generateBatchData(100000);
+    measureTime("逐点存储 批量写入10万点", [&] { terrain_store_->batchPut(data); });
+    measureTime("整网格存储 批量写入10万点", [&] { tiles.batchPut(data); });
+    
+    auto coldGets = [&](const std::string& label, TerrainStorageEngine& engine) {
+        engine.clearCache();
+        size_t found = 0;
+        auto duration = measureTime(label, [&] {
+            for (size_t i = 0; i < data.size(); i += 10) {
+                std::string value;
+                found += engine.get(std::get<0>(data[i]), std::get<1>(data[i]), value);
+            }
+        });
+        EXPECT_EQ(found, data.size() / 10);
+        return duration;
+    };
+    auto point_duration = coldGets("逐点存储 1万次冷缓存查询", *terrain_store_);
+    auto tile_duration = coldGets("整网格存储 1万次冷缓存查询", tiles);
+    
+    std::string result = "冷缓存查询 逐点存储 " + std::to_string(point_duration.count()) +
+                         " ms, 整网格存储 " + std::to_string(tile_duration.count()) + " ms";
+    std::cout << result << std::endl;
+    if (report_file_.is_open()) {
+        report_file_ << result << std::endl;
+    }
+}
+
 // 测试范围查询性能
 TEST_F(TerrainStorageTest, RangeQueryPerformance) {
     // 生成10万个点
@@ -163,4 +217,56 @@ TEST_F(TerrainStorageTest, HotspotOptimization) {
             report_file_ << result << std::endl;
         }
     }
-}
\ No newline at end of file
+}
+
+// 空间填充曲线索引与网格遍历对比：区间扫描次数、检查点数与耗时
+TEST_F(TerrainStorageTest, SpatialIndexBenchmark) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig walk_config;
+    walk_config.range_query_mode = RangeQueryMode::GRID_WALK;
+    TerrainStorageConfig morton_config;
+    morton_config.grid_order = GridOrder::MORTON;
+    TerrainStorageEngine walk(db, 116.0, 39.0, 117.5, 41.0, 0.01, 500, walk_config);
+    TerrainStorageEngine morton(db, 116.0, 39.0, 117.5, 41.0, 0.01, 500, morton_config);
+    
+    auto data = generateBatchData(100000);
+    terrain_store_->batchPut(data);
+    morton.batchPut(data);
+    
+    struct Box { const char* name; double x0, y0, x1, y1; };
+    const std::vector<Box> boxes = {
+        { "小范围(1km)", 116.402, 39.902, 116.411, 39.911 },
+        { "中范围(10km)", 116.40, 39.90, 116.50, 40.00 },
+        { "大范围(100km)", 116.0, 39.0, 117.0, 40.0 },
+    };
+    
+    auto run = [&](const std::string& label, TerrainStorageEngine& engine, const Box& box) {
+        engine.clearCache();
+        RangeQueryStats stats;
+        auto duration = measureTime(std::string(box.name) + " " + label, [&] {
+            engine.rangeQuery(box.x0, box.y0, box.x1, box.y1,
+                              [](double, double, const std::string&) {}, &stats);
+        });
+        std::string line = "  区间扫描 " + std::to_string(stats.key_ranges) +
+                           " 次, 检查 " + std::to_string(stats.points_visited) +
+                           " 点, 返回 " + std::to_string(stats.points_returned) + " 点";
+        std::cout << line << std::endl;
+        if (report_file_.is_open()) {
+            report_file_ << line << std::endl;
+        }
+        return std::make_pair(stats, duration);
+    };
+    
+    for (const auto& box : boxes) {
+        auto walked = run("网格遍历", walk, box);
+        auto row_major = run("行优先区间扫描", *terrain_store_, box);
+        auto curve = run("Z序区间扫描", morton, box);
+        
+        EXPECT_EQ(row_major.first.points_returned, walked.first.points_returned);
+        EXPECT_EQ(curve.first.points_returned, walked.first.points_returned);
+        EXPECT_LE(row_major.first.points_visited, walked.first.points_visited);
+        EXPECT_LE(curve.first.points_visited, walked.first.points_visited);
+        EXPECT_LE(row_major.first.key_ranges, walked.first.key_ranges);
+        EXPECT_LE(curve.first.key_ranges, walked.first.key_ranges);
+    }
+}
@@ -0,0 +1,243 @@
+// test_sharded.cpp
+#include "test_terrain_storage.hpp"
+#include <thread>
+#include <atomic>
+#include <set>
+
+// 测试固件类：每个用例使用独立的临时目录
+class ShardedLevelDBTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root_ = fs::temp_directory_path() / "sharded_db_test";
+        fs::remove_all(root_);
+        fs::create_directories(root_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(root_);
+    }
+
+    std::vector<LevelDBShardSpec> makeShards(size_t count) {
+        std::vector<LevelDBShardSpec> shards(count);
+        for (size_t i = 0; i < count; ++i) {
+            shards[i].path = (root_ / ("shard" + std::to_string(i))).string();
+            shards[i].config.block_cache_size = 8 * 1048576;
+            shards[i].config.write_buffer_size = 4 * 1048576;
+        }
+        return shards;
+    }
+
+    fs::path root_;
+};
+
+// 测试独立实例与具名实例互不影响
+TEST_F(ShardedLevelDBTest, IndependentInstances) {
+    LevelDBManager a;
+    LevelDBManager b;
+    LevelDBConfig config;
+    config.block_cache_size = 0;
+    config.bloom_bits_per_key = 0;
+    a.initialize((root_ / "a").string(), config);
+    b.initialize((root_ / "b").string());
+
+    a.put("key", "from_a");
+    std::string value;
+    EXPECT_FALSE(b.get("key", value));
+    ASSERT_TRUE(a.get("key", value));
+    EXPECT_EQ(value, "from_a");
+
+    auto batch = b.createBatch();
+    batch.put("batch_key", "from_b");
+    batch.commit();
+    EXPECT_TRUE(b.exists("batch_key"));
+    EXPECT_FALSE(a.exists("batch_key"));
+
+    EXPECT_EQ(&LevelDBManager::getInstance("terrain"), &LevelDBManager::getInstance("terrain"));
+    EXPECT_NE(&LevelDBManager::getInstance("terrain"), &LevelDBManager::getInstance());
+
+    a.shutdown();
+    EXPECT_THROW(a.put("key", "value"), LevelDBException);
+}
+
+// 测试按前缀路由：同一前缀落在同一分片，前缀扫描只访问该分片
+TEST_F(ShardedLevelDBTest, PrefixRouting) {
+    ShardedLevelDBManager db(makeShards(4));
+    ASSERT_EQ(db.shardCount(), 4);
+
+    auto batch = db.createBatch();
+    for (int grid = 0; grid < 16; ++grid) {
+        for (int point = 0; point < 10; ++point) {
+            batch.put("G" + std::to_string(grid) + "|" + std::to_string(point), std::to_string(grid));
+        }
+    }
+    batch.commit();
+
+    std::set<size_t> used;
+    for (int grid = 0; grid < 16; ++grid) {
+        const std::string prefix = "G" + std::to_string(grid) + "|";
+        const size_t owner = db.shardOf(prefix);
+        used.insert(owner);
+
+        size_t count = 0;
+        db.scanPrefix(prefix, [&](std::string_view key, std::string_view value) {
+            EXPECT_EQ(key.substr(0, prefix.size()), prefix);
+            EXPECT_EQ(value, std::to_string(grid));
+            ++count;
+        });
+        EXPECT_EQ(count, 10);
+        EXPECT_EQ(db.shard(owner).scanPrefix(prefix, [](const leveldb::Slice&, const leveldb::Slice&) {}), 10);
+    }
+    EXPECT_GT(used.size(), 1);  // 数据分布到多个分片
+
+    std::string value;
+    ASSERT_TRUE(db.get("G3|7", value));
+    EXPECT_EQ(value, "3");
+    db.del("G3|7");
+    EXPECT_FALSE(db.exists("G3|7"));
+
+    // 全分片扫描与提前结束
+    EXPECT_EQ(db.scan("", "", [](const leveldb::Slice&, const leveldb::Slice&) {}), 159);
+    size_t seen = 0;
+    EXPECT_EQ(db.scan("", "", [&](const leveldb::Slice&, const leveldb::Slice&) { return ++seen < 5; }), 5);
+
+    // 多分片扫描按键归并，整体有序
+    std::string last;
+    db.scan("", "", [&](std::string_view key, std::string_view) {
+        EXPECT_LT(last, key);
+        last.assign(key);
+    });
+
+    // 跨分片快照：之后的写入不可见
+    auto snapshot = db.createSnapshot();
+    db.put("G3|7", "new");
+    ShardedLevelDBManager::ScanOptions options;
+    options.snapshot = snapshot->get();
+    EXPECT_FALSE(db.get("G3|7", value, options));
+    EXPECT_EQ(db.scan("", "", [](const leveldb::Slice&, const leveldb::Slice&) {}, options), 159);
+    EXPECT_EQ(db.scan("", "", [](const leveldb::Slice&, const leveldb::Slice&) {}), 160);
+}
+
+// 测试二进制地形键按网格编号路由：同一网格的数据点、网格块与覆盖键落在同一分片
+TEST_F(ShardedLevelDBTest, TerrainKeyRouting) {
+    ShardedLevelDBManager db(makeShards(4));
+    TerrainKeyCodec codec(TerrainKeyFormat::BINARY, GridOrder::MORTON);
+
+    std::set<size_t> used;
+    for (uint32_t row = 0; row < 8; ++row) {
+        for (uint32_t col = 0; col < 8; ++col) {
+            const uint64_t code = codec.gridCode(row, col);
+            char point[TerrainKeyCodec::kMaxKeySize];
+            char tile[TerrainKeyCodec::kMaxKeySize];
+            char overlay[TerrainKeyCodec::kMaxKeySize];
+            const size_t owner = db.shardOf(std::string_view(point, codec.encode(row, col, 116.0, 39.0, point)));
+            EXPECT_EQ(db.shardOf(std::string_view(tile, codec.encodeTileKey(code, tile))), owner);
+            EXPECT_EQ(db.shardOf(std::string_view(overlay, codec.encodeOverlayKey(code, 1, 2, overlay))), owner);
+            EXPECT_EQ(db.shardOf(codec.gridPrefix(row, col)), owner);
+            used.insert(owner);
+        }
+    }
+    EXPECT_GT(used.size(), 1);
+}
+
+// 测试地形存储引擎使用分片存储：读写、范围查询与批量写入结果与单实例一致
+TEST_F(ShardedLevelDBTest, TerrainEngineOnShards) {
+    AdvancedThreadPool pool(fixedPoolConfig(2));
+    ShardedLevelDBConfig routing;
+    routing.pool = &pool;
+    ShardedLevelDBManager db(makeShards(4), routing);
+
+    for (StorageLayout layout : { StorageLayout::POINT_KEYS, StorageLayout::GRID_TILES }) {
+        TerrainStorageConfig config;
+        config.grid_order = GridOrder::MORTON;
+        config.storage_layout = layout;
+        config.lod_levels = 2;
+        ShardedTerrainStorageEngine engine(db, 116.0, 39.0, 117.0, 40.0, 0.1, 100, config);
+
+        const std::string tag = layout == StorageLayout::POINT_KEYS ? "p" : "t";
+        std::vector<std::tuple<double, double, std::string>> data;
+        for (int i = 0; i < 400; ++i) {
+            data.emplace_back(116.0 + (i % 20) * 0.049, 39.0 + (i / 20) * 0.049, tag + std::to_string(i));
+        }
+        engine.batchPut(data);
+        engine.put(116.55, 39.55, tag + "single");
+
+        std::string value;
+        ASSERT_TRUE(engine.get(116.55, 39.55, value));
+        EXPECT_EQ(value, tag + "single");
+        engine.clearCache();
+        ASSERT_TRUE(engine.get(116.0 + 3 * 0.049, 39.0 + 2 * 0.049, value));
+        EXPECT_EQ(value, tag + "43");
+
+        size_t count = 0;
+        engine.rangeQuery(116.0, 39.0, 117.0, 40.0, [&](double, double, const std::string&) { ++count; });
+        EXPECT_EQ(count, 401);
+
+        TerrainAggregate total;
+        engine.rangeQuery(116.0, 39.0, 117.0, 40.0, 0.4, [&](const TerrainCell& cell) {
+            total.merge(cell.aggregate);
+        });
+        EXPECT_EQ(total.count, 401);
+    }
+}
+
+// 测试哈希路由与自定义路由
+TEST_F(ShardedLevelDBTest, HashAndCustomRouting) {
+    ShardedLevelDBConfig hash_config;
+    hash_config.routing = ShardRouting::HASH;
+    ShardedLevelDBManager hashed(makeShards(2), hash_config);
+    EXPECT_EQ(hashed.shardOf("abc"), ShardedLevelDBManager::hashKey("abc") % 2);
+    for (int i = 0; i < 50; ++i) {
+        hashed.put("P|" + std::to_string(i), "v");
+    }
+    EXPECT_EQ(hashed.scanPrefix("P|", [](std::string_view, std::string_view) {}), 50);
+    hashed.shutdown();
+
+    ShardedLevelDBConfig region_config;
+    region_config.router = [](std::string_view key) { return key.substr(0, 5) == "north" ? 0 : 1; };
+    std::vector<LevelDBShardSpec> shards = makeShards(2);
+    for (auto& spec : shards) spec.path += "_region";
+    ShardedLevelDBManager regions(shards, region_config);
+    regions.put("north|1", "n");
+    regions.put("south|1", "s");
+    EXPECT_TRUE(regions.shard(0).exists("north|1"));
+    EXPECT_TRUE(regions.shard(1).exists("south|1"));
+}
+
+// 测试读写与 shutdown() 并发：关闭后的操作抛出异常而不是访问已释放的数据库
+TEST_F(ShardedLevelDBTest, ConcurrentShutdown) {
+    LevelDBManager db;
+    db.initialize((root_ / "concurrent").string());
+    db.put("seed", "value");
+
+    auto iter = db.createIterator();
+    std::atomic<int> failures{ 0 };
+    std::vector<std::thread> workers;
+    // 一直读写直到 shutdown() 之后抛出异常；截止时间只防止 shutdown() 拿不到锁时测试挂起
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t] {
+            std::string value;
+            for (int i = 0; std::chrono::steady_clock::now() < deadline; ++i) {
+                try {
+                    db.put("k" + std::to_string(t) + "_" + std::to_string(i % 100), "v");
+                    db.get("seed", value);
+                } catch (const LevelDBException&) {
+                    ++failures;
+                    break;
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    db.shutdown();
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    EXPECT_EQ(failures, 4);
+    EXPECT_FALSE(db.isInitialized());
+    // shutdown() 之前创建的迭代器仍然可用
+    iter.seekToFirst();
+    ASSERT_TRUE(iter.valid());
+    EXPECT_EQ(iter.key(), "seed");
+}
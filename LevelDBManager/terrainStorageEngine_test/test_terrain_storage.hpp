@@ -7,10 +7,39 @@
 #include <random>
 #include <chrono>
 #include <fstream>
+#include <map>
 #include <type_traits>
 
 namespace fs = std::filesystem;
 
+// 测试用线程池配置：固定 threads 个线程
+inline ThreadPoolConfig fixedPoolConfig(size_t threads) {
+    ThreadPoolConfig config;
+    config.mode = PoolMode::FIXED;
+    config.min_threads = threads;
+    return config;
+}
+
+// 数据点集合：坐标 -> 值
+using PointMap = std::map<std::pair<double, double>, std::string>;
+
+// 收集范围查询结果（同一坐标只应返回一次）
+inline PointMap collect(TerrainStorageEngine& engine, double x0, double y0, double x1, double y1,
+                        RangeQueryStats* stats = nullptr) {
+    PointMap points;
+    engine.rangeQuery(x0, y0, x1, y1, [&](double lon, double lat, const std::string& value) {
+        EXPECT_TRUE(points.emplace(std::make_pair(lon, lat), value).second);
+    }, stats);
+    return points;
+}
+
+// 按写入顺序记录每个坐标最后写入的值（按原始输入坐标）
+inline void record(PointMap& model, const std::vector<std::tuple<double, double, std::string>>& points) {
+    for (const auto& [lon, lat, value] : points) {
+        model[{ lon, lat }] = value;
+    }
+}
+
 // 测试固件类
 class TerrainStorageTest : public ::testing::Test {
 protected:
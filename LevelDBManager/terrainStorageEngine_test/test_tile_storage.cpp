@@ -0,0 +1,160 @@
+// test_tile_storage.cpp
+#include "test_terrain_storage.hpp"
+#include <thread>
+
+namespace {
+
+size_t countPrefix(LevelDBManager& db, char tag) {
+    return db.scanPrefix(leveldb::Slice(&tag, 1), [](const leveldb::Slice&, const leveldb::Slice&) {});
+}
+
+} // namespace
+
+// 测试网格块编码的往返、差分压缩效果与损坏数据检测
+TEST(GridTileTest, SerializeRoundTrip) {
+    GridTile tile;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        tile.append(2963000000u + i * 37, 1299000000u + (i * 7919) % 10000, "h" + std::to_string(i % 50));
+    }
+    tile.upsert(2963000000u, 1299000000u, "updated");  // 带碎片的 arena 也按点顺序编码
+    tile.finalize();
+
+    std::string blob;
+    tile.serialize(blob);
+    // 坐标差分后每点约 3~4 字节，远小于两个 4 字节定点数加 4 字节长度
+    EXPECT_LT(blob.size(), tile.size() * 8 + 4000);
+
+    GridTile decoded;
+    ASSERT_TRUE(decoded.deserialize(blob));
+    ASSERT_EQ(decoded.size(), tile.size());
+    for (size_t i = 0; i < tile.size(); ++i) {
+        EXPECT_EQ(decoded.lon(i), tile.lon(i));
+        EXPECT_EQ(decoded.lat(i), tile.lat(i));
+        EXPECT_EQ(decoded.value(i), tile.value(i));
+    }
+
+    GridTile empty;
+    empty.serialize(blob);
+    ASSERT_TRUE(decoded.deserialize(blob));
+    EXPECT_TRUE(decoded.empty());
+
+    tile.serialize(blob);
+    EXPECT_FALSE(decoded.deserialize(blob.substr(0, blob.size() - 1)));
+    EXPECT_TRUE(decoded.empty());
+    EXPECT_FALSE(decoded.deserialize(std::string("\x7f", 1) + blob.substr(1)));
+    EXPECT_FALSE(decoded.deserialize(""));
+
+    if (!GridTile::compressionSupported(TileCompression::LZ4)) {
+        EXPECT_THROW(tile.serialize(blob, TileCompression::LZ4), std::invalid_argument);
+    }
+    for (TileCompression compression : { TileCompression::LZ4, TileCompression::ZSTD }) {
+        if (!GridTile::compressionSupported(compression)) continue;
+        tile.serialize(blob, compression);
+        ASSERT_TRUE(decoded.deserialize(blob));
+        EXPECT_EQ(decoded.value(decoded.find(2963000000u, 1299000000u)), "updated");
+    }
+}
+
+// 测试整网格存储：批量写入生成网格块，单点写入进入覆盖键，查询结果与逐点存储一致
+TEST_F(TerrainStorageTest, TileLayoutReadWrite) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.storage_layout = StorageLayout::GRID_TILES;
+    config.background_merge = false;
+    TerrainStorageEngine tiles(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    auto data = generateBatchData(5000);
+    terrain_store_->batchPut(data);
+    tiles.batchPut(data);
+    EXPECT_EQ(countPrefix(db, TerrainKeyCodec::kOverlayRowMajorTag), 0);
+    const size_t tile_count = countPrefix(db, TerrainKeyCodec::kTileRowMajorTag);
+    EXPECT_GT(tile_count, 0);
+    EXPECT_LT(tile_count, data.size());
+
+    for (size_t i = 0; i < data.size(); i += 37) {
+        std::string value;
+        ASSERT_TRUE(tiles.get(std::get<0>(data[i]), std::get<1>(data[i]), value));
+        EXPECT_EQ(value, std::get<2>(data[i]));
+    }
+    std::string value;
+    EXPECT_FALSE(tiles.get(116.00001, 39.00001, value));
+
+    // 单点写入：已缓存与未缓存的网格都能读到，重新打开（清空缓存）后依然可见
+    tiles.put(std::get<0>(data[0]), std::get<1>(data[0]), "overwritten");
+    tiles.put(117.4999, 40.9999, "new_point");
+    EXPECT_EQ(countPrefix(db, TerrainKeyCodec::kOverlayRowMajorTag), 2);
+    tiles.clearCache();
+    ASSERT_TRUE(tiles.get(std::get<0>(data[0]), std::get<1>(data[0]), value));
+    EXPECT_EQ(value, "overwritten");
+    ASSERT_TRUE(tiles.get(117.4999, 40.9999, value));
+    EXPECT_EQ(value, "new_point");
+
+    terrain_store_->put(std::get<0>(data[0]), std::get<1>(data[0]), "overwritten");
+    terrain_store_->put(117.4999, 40.9999, "new_point");
+
+    // 范围查询：区间扫描覆盖键与网格块，网格遍历经缓存，两种方式结果都与逐点存储一致
+    const double boxes[][4] = {
+        { 116.3, 39.8, 116.6, 40.1 },
+        { 117.3, 40.8, 117.5, 41.0 },
+        { 116.0, 39.0, 117.5, 41.0 },
+    };
+    TerrainStorageConfig walk_config = config;
+    walk_config.range_query_mode = RangeQueryMode::GRID_WALK;
+    TerrainStorageEngine walk(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, walk_config);
+    for (const auto& box : boxes) {
+        tiles.clearCache();
+        auto expected = collect(*terrain_store_, box[0], box[1], box[2], box[3]);
+        EXPECT_EQ(collect(tiles, box[0], box[1], box[2], box[3]), expected);
+        EXPECT_EQ(collect(walk, box[0], box[1], box[2], box[3]), expected);
+    }
+    EXPECT_EQ(tiles.getCacheSize(), 0);
+
+    // 合并后覆盖键清空，结果不变
+    EXPECT_EQ(tiles.mergeTiles(), 2);
+    EXPECT_EQ(countPrefix(db, TerrainKeyCodec::kOverlayRowMajorTag), 0);
+    EXPECT_EQ(tiles.mergeTiles(), 0);
+    tiles.clearCache();
+    ASSERT_TRUE(tiles.get(std::get<0>(data[0]), std::get<1>(data[0]), value));
+    EXPECT_EQ(value, "overwritten");
+    EXPECT_EQ(collect(tiles, 116.0, 39.0, 117.5, 41.0), collect(*terrain_store_, 116.0, 39.0, 117.5, 41.0));
+
+    TerrainStorageConfig text = config;
+    text.key_format = TerrainKeyFormat::TEXT;
+    EXPECT_THROW(TerrainStorageEngine(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, text), TerrainStorageException);
+}
+
+// 测试后台合并：覆盖写入达到阈值后由后台线程合并进网格块，并发读写结果正确
+TEST_F(TerrainStorageTest, TileBackgroundMerge) {
+    LevelDBManager& db = LevelDBManager::getInstance();
+    TerrainStorageConfig config;
+    config.storage_layout = StorageLayout::GRID_TILES;
+    config.overlay_merge_threshold = 8;
+    TerrainStorageEngine tiles(db, 116.0, 39.0, 117.5, 41.0, 0.01, 100, config);
+
+    std::thread writer([&] {
+        for (int i = 0; i < 64; ++i) {
+            tiles.put(116.4001 + i * 0.0001, 39.9001, "v" + std::to_string(i));
+        }
+    });
+    for (int round = 0; round < 20; ++round) {
+        size_t count = 0;
+        tiles.rangeQuery(116.40, 39.90, 116.41, 39.91, [&](double, double, const std::string&) { ++count; });
+        EXPECT_LE(count, 64);
+    }
+    writer.join();
+
+    // 等待后台合并完成（64 个点触发 8 次合并）
+    for (int i = 0; i < 200 && countPrefix(db, TerrainKeyCodec::kOverlayRowMajorTag) > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(countPrefix(db, TerrainKeyCodec::kOverlayRowMajorTag), 0);
+    EXPECT_EQ(countPrefix(db, TerrainKeyCodec::kTileRowMajorTag), 1);
+
+    tiles.clearCache();
+    size_t count = 0;
+    tiles.rangeQuery(116.40, 39.90, 116.41, 39.91, [&](double lon, double, const std::string& value) {
+        EXPECT_EQ(value, "v" + std::to_string(std::lround((lon - 116.4001) / 0.0001)));
+        ++count;
+    });
+    EXPECT_EQ(count, 64);
+}
@@ -7,6 +7,8 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <deque>
+#include <memory>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
@@ -19,11 +21,33 @@
 #include <stop_token>
 #include <cassert>
 #include <iomanip>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <algorithm>
+#include <ranges>
+#include <cmath>
+#include <array>
+#include <coroutine>
+#include <string>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 // 线程池支持的模式
 enum class PoolMode {
     FIXED,   // 固定数量的线程
     CACHED,  // 线程数量可动态增长
+    WORK_STEALING, // 固定数量线程 + 每线程本地队列，空闲线程从其他线程窃取任务
 };
 
 // 任务优先级
@@ -33,174 +57,2198 @@ enum class TaskPriority {
     LOW    // 数值最大（确保在最大堆中优先出队）
 };
 
+// 就绪队列实现（FIXED/CACHED模式；WORK_STEALING模式使用自己的分布式队列）
+enum class QueueType {
+    HEAP,       // 互斥锁保护的优先级堆（默认）
+    LOCK_FREE   // 每个优先级一条有界无锁 MPMC 环形队列
+};
+
+// 队列满时的提交策略
+enum class OverflowPolicy {
+    BLOCK,            // 等待空位，最多 submit_timeout（默认）
+    REJECT,           // 立即拒绝
+    DROP_OLDEST_LOW,  // 丢弃最早入队的一个 LOW 任务腾出空位（被丢弃任务的 future 得到 broken_promise）
+    CALLER_RUNS       // 在提交线程中直接执行，自然降低生产速度
+};
+
+// 提交结果（try_submit/try_post 系列的返回值）
+enum class SubmitStatus {
+    ACCEPTED,       // 已入队
+    RAN_IN_CALLER,  // 队列满，按 CALLER_RUNS 策略已在提交线程中执行完毕
+    QUEUE_FULL,     // 队列满被拒绝（或 DROP_OLDEST_LOW 策略下没有可丢弃的 LOW 任务）
+    TIMEOUT,        // 等待队列空位超时
+    SHUTDOWN        // 线程池已关闭
+};
+
+// try_submit 系列的返回值：提交成功时 future 有效
+template <typename T>
+struct SubmitResult {
+    SubmitStatus status;
+    std::future<T> future;
+
+    explicit operator bool() const {
+        return status == SubmitStatus::ACCEPTED || status == SubmitStatus::RAN_IN_CALLER;
+    }
+};
+
+// 工作线程CPU亲和性策略
+enum class AffinityPolicy {
+    NONE,      // 不绑定，由操作系统调度（默认）
+    COMPACT,   // 逐个填满物理核（含超线程兄弟）与NUMA节点，适合共享缓存的任务
+    SCATTER,   // 在NUMA节点间轮流分配，优先占用不同物理核，适合访存带宽敏感的任务
+    EXPLICIT   // 按 cpu_list 依次绑定
+};
+
+// CACHED模式的扩缩容策略
+enum class ElasticityPolicy {
+    ADAPTIVE,  // 按实测排队时间与利用率计算目标线程数（默认）
+    EAGER      // 每2秒检查一次，按积压任务数一次性扩容（旧策略，便于对比）
+};
+
+// 自适应扩缩容参数（仅 CACHED 模式 + ADAPTIVE 策略）
+struct ElasticityConfig {
+    ElasticityPolicy policy = ElasticityPolicy::ADAPTIVE;
+    std::chrono::milliseconds control_interval{ 50 };     // 控制周期
+    std::chrono::microseconds target_queue_wait{ 2000 };  // 期望的平均排队时间
+    double target_utilization = 0.8;   // 期望的线程利用率（Little 定律目标并发 / 该值）
+    size_t max_spawn_per_tick = 4;     // 每个控制周期最多新建的线程数（突发积压按排空速率一次补足，不受此限）
+    size_t spare_threads = 2;          // 预先创建并保持休眠的备用线程数
+    double shrink_hysteresis = 0.25;   // 目标低于当前值的比例超过该值才考虑缩容
+    size_t shrink_delay_ticks = 20;    // 连续满足缩容条件的周期数
+};
+
+// 扩缩容状态快照
+struct ElasticityStats {
+    size_t target_workers = 0;      // 控制器目标活跃线程数
+    size_t active_workers = 0;      // 活跃线程数（参与取任务）
+    size_t spare_workers = 0;       // 休眠备用线程数
+    size_t total_workers = 0;       // 存活线程总数
+    size_t executing_workers = 0;   // 正在执行任务的线程数
+    uint64_t threads_spawned = 0;   // 累计创建的线程数
+    uint64_t threads_retired = 0;   // 累计退出的线程数
+    double arrival_rate = 0;        // 最近一个周期的任务到达率（个/秒）
+    double mean_service_us = 0;     // 平均执行时间（微秒，平滑值）
+    double mean_queue_wait_us = 0;  // 最近一个周期的平均排队时间（微秒）
+    double utilization = 0;         // 最近一个周期的线程利用率
+};
+
+// 优先级级数（用于按优先级分层的队列）
+inline constexpr size_t kTaskPriorityLevels = 3;
+
+/**
+ * 对数-线性分桶的时延直方图（HDR 风格），单位纳秒
+ * 小于 kSubBuckets 的值逐个计数；其余值按2的幂分段，每段再均分为 kSubBuckets 个桶，
+ * 相对误差不超过 1/kSubBuckets（约6%）；超过 2^kMaxExponent 纳秒（约18分钟）的值计入最后一个桶
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kMaxExponent = 40;
+    static constexpr size_t kBucketCount = kSubBuckets + (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+        if (exponent > kMaxExponent) return kBucketCount - 1;
+        const size_t shift = exponent - kSubBucketBits;
+        const size_t sub = static_cast<size_t>(value >> shift) & (kSubBuckets - 1);
+        return kSubBuckets + (exponent - kSubBucketBits) * kSubBuckets + sub;
+    }
+
+    // 桶内的最大值（百分位按该值报告，与 HdrHistogram 的 highest equivalent value 一致）
+    static uint64_t bucket_upper(size_t bucket) {
+        if (bucket < kSubBuckets) return bucket;
+        const size_t shift = (bucket - kSubBuckets) / kSubBuckets;
+        const uint64_t sub = (bucket - kSubBuckets) % kSubBuckets;
+        return ((kSubBuckets + sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t value) {
+        ++counts[bucket_of(value)];
+        ++count;
+        sum += value;
+        max = std::max(max, value);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBucketCount; ++i) counts[i] += other.counts[i];
+        count += other.count;
+        sum += other.sum;
+        max = std::max(max, other.max);
+    }
+
+    // 百分位值（p 取 0~1），无样本时返回0
+    uint64_t percentile(double p) const {
+        if (count == 0) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(count))));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucket_upper(i), max);
+        }
+        return max;
+    }
+
+    double mean() const { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0; }
+
+    std::array<uint64_t, kBucketCount> counts{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+};
+
+// 单个优先级的统计
+struct PriorityStats {
+    uint64_t completed = 0;          // 执行完毕的任务数（含抛出异常的任务）
+    uint64_t failed = 0;             // 抛出异常的任务数（含经 future 传递的异常）
+    LatencyHistogram queue_wait;     // 入队到开始执行（仅启用 latency_histograms 时有数据）
+    LatencyHistogram execution;      // 执行时间（仅启用 latency_histograms 时有数据）
+};
+
+// 线程池统计快照
+struct ThreadPoolStats {
+    PriorityStats priorities[kTaskPriorityLevels];  // 按 TaskPriority 数值索引
+    uint64_t rejected = 0;           // 因队列满被拒绝的提交次数（含等待超时）
+    uint64_t dropped = 0;            // DROP_OLDEST_LOW 策略丢弃的 LOW 任务数
+    uint64_t ran_in_caller = 0;      // CALLER_RUNS 策略在提交线程中执行的任务数
+    size_t pending_tasks = 0;
+    size_t worker_count = 0;
+
+    const PriorityStats& operator[](TaskPriority priority) const {
+        return priorities[static_cast<size_t>(priority)];
+    }
+
+    uint64_t completed() const {
+        uint64_t total = 0;
+        for (auto& level : priorities) total += level.completed;
+        return total;
+    }
+};
+
+// 任务追踪事件类型
+enum class TaskTraceEvent : uint8_t {
+    EXECUTED,  // 任务正常执行完毕
+    FAILED,    // 任务抛出异常
+};
+
+// 任务追踪记录：定长二进制记录（一个缓存行），时间戳为 steady_clock 纳秒
+struct TaskTraceRecord {
+    uint64_t enqueue_ns;      // 入队时间
+    uint64_t start_ns;        // 开始执行时间
+    uint64_t end_ns;          // 执行结束时间
+    uint32_t thread_index;    // 工作线程追踪序号（线程池内唯一，可被后继线程复用）
+    uint8_t priority;         // 任务优先级（TaskPriority数值）
+    TaskTraceEvent event;     // 事件类型
+    char message[34];         // 异常信息（截断，仅FAILED事件有效）
+};
+static_assert(sizeof(TaskTraceRecord) == 64, "TaskTraceRecord must fit in one cache line");
+
+// 任务追踪输出接口：由后台排空线程批量回调，工作线程不会直接调用
+class TaskTraceSink {
+public:
+    virtual ~TaskTraceSink() = default;
+
+    // 消费一批追踪记录（records 仅在回调期间有效）
+    virtual void consume(const TaskTraceRecord* records, size_t count) = 0;
+
+    // 环形缓冲区写满时丢弃的记录数
+    virtual void on_dropped(uint64_t count) { (void)count; }
+};
+
+// 默认追踪输出：格式化为文本写入输出流
+class OStreamTraceSink : public TaskTraceSink {
+public:
+    explicit OStreamTraceSink(std::ostream& os = std::cout) : os_(os) {}
+
+    void consume(const TaskTraceRecord* records, size_t count) override {
+        for (size_t i = 0; i < count; ++i) {
+            const TaskTraceRecord& r = records[i];
+            os_ << "[worker " << r.thread_index << "] 优先级: " << static_cast<int>(r.priority);
+            if (r.enqueue_ns != 0) {
+                os_ << " 等待: " << (r.start_ns - r.enqueue_ns) / 1000 << "us";
+            }
+            os_ << " 执行: " << (r.end_ns - r.start_ns) / 1000 << "us";
+            if (r.event == TaskTraceEvent::FAILED) {
+                os_ << " error: Task execution failed: " << r.message;
+            }
+            os_ << '\n';
+        }
+        os_.flush();
+    }
+
+    void on_dropped(uint64_t count) override {
+        os_ << "[trace] 缓冲区已满，丢弃 " << count << " 条记录" << std::endl;
+    }
+
+private:
+    std::ostream& os_;
+};
+
 // 线程池配置参数
 struct ThreadPoolConfig {
     size_t min_threads = std::thread::hardware_concurrency();  // 最小线程数
     size_t max_threads = 1024;           // 最大线程数（CACHED模式）
+                                         // WORK_STEALING模式下线程数固定为min_threads
     size_t max_tasks = 1024;             // 任务队列最大容量
-    std::chrono::seconds idle_timeout{ 60 }; // 空闲线程超时时间
+    std::chrono::seconds idle_timeout{ 60 }; // 空闲线程超时时间（ADAPTIVE策略下仅作用于超出 spare_threads 的备用线程）
     PoolMode mode = PoolMode::CACHED;    // 默认工作模式
+    ElasticityConfig elasticity;         // CACHED模式扩缩容策略
+    QueueType queue_type = QueueType::HEAP; // 就绪队列实现
+
+    // 队列满时的处理：submit()/post() 在 BLOCK 策略下最多等待 submit_timeout，其余策略不等待，
+    // 最终被拒绝时抛出异常；try_submit()/try_post() 从不阻塞（BLOCK 视同 REJECT），以状态码返回；
+    // try_submit_for()/try_post_for() 最多等待调用方给定的时长。批量接口始终按 BLOCK 处理
+    OverflowPolicy overflow_policy = OverflowPolicy::BLOCK;
+    std::chrono::milliseconds submit_timeout{ 1000 };
+
+    // LOW 优先级防饿死（仅 LOCK_FREE 队列）：最早的 LOW 任务排队超过该时长后，
+    // 下一次出队优先取它；0 表示关闭，严格按优先级出队
+    std::chrono::milliseconds low_priority_aging{ 0 };
+
+    // 按优先级记录排队/执行时延直方图（每个任务多读两次时钟）；计数器始终开启
+    bool latency_histograms = false;
+
+    // 线程放置：第 k 个启动的工作线程绑定到按策略排列的第 k 个CPU（循环使用）
+    // numa_node >= 0 时只使用该节点内的CPU；策略为 NONE 时整体限定在该节点上
+    AffinityPolicy affinity = AffinityPolicy::NONE;
+    std::vector<int> cpu_list;           // EXPLICIT 策略使用的CPU编号
+    int numa_node = -1;                  // 限定的NUMA节点：内核节点编号，同 numactl（-1 表示不限定；节点不存在或没有可用CPU时构造抛出 std::invalid_argument）
+
+    // 任务追踪（默认关闭）：设置 trace_sink 后，工作线程将追踪记录写入每线程环形缓冲区，
+    // 由后台排空线程按 trace_flush_interval 周期批量交给 trace_sink
+    std::shared_ptr<TaskTraceSink> trace_sink;
+    size_t trace_buffer_size = 4096;     // 每线程环形缓冲区容量（记录数，向上取2的幂）
+    std::chrono::milliseconds trace_flush_interval{ 100 }; // 排空周期
+};
+
+// 仅可移动的任务包装：不超过 kInlineSize 的可调用对象直接存放在内部缓冲区，
+// 避免 std::function 的堆分配；过大或移动可能抛异常的对象才退回堆上存放
+class TaskFunction {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    TaskFunction() noexcept = default;
+
+    template <typename F,
+        typename Fn = std::decay_t<F>,
+        typename = std::enable_if_t<!std::is_same_v<Fn, TaskFunction>>>
+    TaskFunction(F&& f) {
+        if constexpr (fits_inline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            vtable_ = &inline_vtable<Fn>;
+        } else {
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+            vtable_ = &heap_vtable<Fn>;
+        }
+    }
+
+    TaskFunction(TaskFunction&& other) noexcept {
+        move_from(other);
+    }
+
+    TaskFunction& operator=(TaskFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    TaskFunction(const TaskFunction&) = delete;
+    TaskFunction& operator=(const TaskFunction&) = delete;
+
+    ~TaskFunction() { reset(); }
+
+    void operator()() { vtable_->invoke(storage_); }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+private:
+    struct VTable {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src) noexcept;  // 移动构造到 dst 并析构 src
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr bool fits_inline() {
+        return sizeof(Fn) <= kInlineSize &&
+            alignof(Fn) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static constexpr VTable inline_vtable = {
+        [](void* self) { (*static_cast<Fn*>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr VTable heap_vtable = {
+        [](void* self) { (**static_cast<Fn**>(self))(); },
+        [](void* dst, void* src) noexcept { ::new (dst) Fn*(*static_cast<Fn**>(src)); },
+        [](void* self) noexcept { delete *static_cast<Fn**>(self); },
+    };
+
+    void move_from(TaskFunction& other) noexcept {
+        if (other.vtable_) {
+            other.vtable_->move(storage_, other.storage_);
+            vtable_ = other.vtable_;
+            other.vtable_ = nullptr;
+        }
+    }
+
+    void reset() noexcept {
+        if (vtable_) {
+            vtable_->destroy(storage_);
+            vtable_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const VTable* vtable_ = nullptr;
+};
+
+// 任务共享状态（promise/future）的池化内存：按尺寸分级的线程本地空闲链表，
+// 空闲块以批为单位在线程间经全局链表流转，每批只加一次锁，避免逐次 malloc 竞争
+class TaskStatePool {
+public:
+    static void* allocate(size_t bytes) {
+        const int cls = size_class(bytes);
+        if (cls < 0) return ::operator new(bytes);
+
+        LocalCache& cache = local_cache();
+        if (!cache.heads[cls]) {
+            refill(cache, cls);
+            if (!cache.heads[cls]) return ::operator new(kClassSizes[cls]);
+        }
+        FreeNode* node = cache.heads[cls];
+        cache.heads[cls] = node->next;
+        --cache.counts[cls];
+        return node;
+    }
+
+    static void deallocate(void* p, size_t bytes) noexcept {
+        const int cls = size_class(bytes);
+        if (cls < 0) {
+            ::operator delete(p);
+            return;
+        }
+
+        LocalCache& cache = local_cache();
+        auto* node = static_cast<FreeNode*>(p);
+        node->next = cache.heads[cls];
+        cache.heads[cls] = node;
+        if (++cache.counts[cls] >= 2 * kBatchSize) {
+            release_batch(cache, cls);
+        }
+    }
+
+private:
+    static constexpr size_t kClassCount = 3;
+    static constexpr size_t kClassSizes[kClassCount] = { 64, 128, 256 };
+    static constexpr size_t kBatchSize = 64;        // 线程间流转的批大小
+    static constexpr size_t kMaxGlobalBatches = 256; // 每个尺寸级别全局最多缓存的批数
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    // 全局批链表（刻意不析构，避免与线程本地缓存的析构顺序问题）
+    struct GlobalLists {
+        std::mutex mutex;
+        std::vector<FreeNode*> batches[kClassCount];
+    };
+
+    struct LocalCache {
+        FreeNode* heads[kClassCount] = {};
+        size_t counts[kClassCount] = {};
+
+        ~LocalCache() {
+            // 线程退出时把本地空闲块整体归还全局链表
+            for (size_t cls = 0; cls < kClassCount; ++cls) {
+                while (counts[cls] > 0) {
+                    release_batch(*this, static_cast<int>(cls));
+                }
+            }
+        }
+    };
+
+    static int size_class(size_t bytes) {
+        for (size_t i = 0; i < kClassCount; ++i) {
+            if (bytes <= kClassSizes[i]) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    static GlobalLists& global_lists() {
+        static GlobalLists* lists = new GlobalLists();
+        return *lists;
+    }
+
+    static LocalCache& local_cache() {
+        thread_local LocalCache cache;
+        return cache;
+    }
+
+    static void refill(LocalCache& cache, int cls) {
+        GlobalLists& global = global_lists();
+        std::lock_guard lock(global.mutex);
+        auto& batches = global.batches[cls];
+        if (batches.empty()) return;
+        FreeNode* head = batches.back();
+        batches.pop_back();
+        size_t count = 0;
+        for (FreeNode* n = head; n; n = n->next) ++count;
+        cache.heads[cls] = head;
+        cache.counts[cls] = count;
+    }
+
+    // 从本地链表摘下至多一批交给全局链表；全局缓存已满时直接释放
+    static void release_batch(LocalCache& cache, int cls) {
+        FreeNode* head = cache.heads[cls];
+        FreeNode* tail = head;
+        size_t count = 1;
+        while (count < kBatchSize && tail->next) {
+            tail = tail->next;
+            ++count;
+        }
+        cache.heads[cls] = tail->next;
+        cache.counts[cls] -= count;
+        tail->next = nullptr;
+
+        GlobalLists& global = global_lists();
+        {
+            std::lock_guard lock(global.mutex);
+            if (global.batches[cls].size() < kMaxGlobalBatches) {
+                global.batches[cls].push_back(head);
+                return;
+            }
+        }
+        while (head) {
+            FreeNode* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+};
+
+// 基于 TaskStatePool 的标准分配器，用于 std::promise 的共享状态
+template <typename T>
+struct TaskStateAllocator {
+    using value_type = T;
+
+    TaskStateAllocator() noexcept = default;
+    template <typename U>
+    TaskStateAllocator(const TaskStateAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if constexpr (alignof(T) > alignof(std::max_align_t)) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        } else {
+            return static_cast<T*>(TaskStatePool::allocate(n * sizeof(T)));
+        }
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if constexpr (alignof(T) > alignof(std::max_align_t)) {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        } else {
+            TaskStatePool::deallocate(p, n * sizeof(T));
+        }
+    }
+
+    template <typename U>
+    bool operator==(const TaskStateAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const TaskStateAllocator<U>&) const noexcept { return false; }
+};
+
+/**
+ * CPU/NUMA 拓扑（进程启动后首次使用时解析一次）
+ * Linux 下读取 /sys/devices/system/node 与 /sys/devices/system/cpu/cpuN/topology，
+ * 只保留进程亲和性掩码允许的CPU；无法读取或非 Linux 平台时视为单节点
+ */
+class CpuTopology {
+public:
+    static const CpuTopology& instance() {
+        static const CpuTopology topology;
+        return topology;
+    }
+
+    // 节点按紧凑下标 0..node_count()-1 访问；内核节点编号可能不连续，见 node_id()/find_node()
+    size_t node_count() const { return nodes_.size(); }
+
+    const std::vector<int>& node_cpus(size_t node) const { return nodes_.at(node); }
+
+    // 下标对应的内核节点编号（/sys/devices/system/node/nodeN 中的 N）
+    int node_id(size_t node) const { return node_ids_.at(node); }
+
+    // 内核节点编号对应的下标；节点不存在或没有可用CPU时返回 -1
+    int find_node(int node_id) const {
+        auto it = std::find(node_ids_.begin(), node_ids_.end(), node_id);
+        return it == node_ids_.end() ? -1 : static_cast<int>(it - node_ids_.begin());
+    }
+
+    // CPU 所属节点的下标（未知CPU返回0）
+    size_t node_of_cpu(int cpu) const {
+        if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_node_.size()) return 0;
+        return static_cast<size_t>(cpu_node_[cpu]);
+    }
+
+    // 调用线程当前所在的节点
+    size_t current_node() const {
+#ifdef __linux__
+        return node_of_cpu(sched_getcpu());
+#else
+        return 0;
+#endif
+    }
+
+    // 紧凑顺序：节点内按物理核依次排列，同一物理核的超线程兄弟相邻
+    std::vector<int> compact_order(int node = -1) const {
+        std::vector<int> order;
+        for (size_t n = 0; n < nodes_.size(); ++n) {
+            if (node >= 0 && n != static_cast<size_t>(node)) continue;
+            std::vector<int> cpus = nodes_[n];
+            std::sort(cpus.begin(), cpus.end(), [this](int a, int b) {
+                return std::pair(core_leader_[a], a) < std::pair(core_leader_[b], b);
+                });
+            order.insert(order.end(), cpus.begin(), cpus.end());
+        }
+        return order;
+    }
+
+    // 分散顺序：节点间轮流取CPU；节点内先取各物理核的第一个逻辑核，再取超线程兄弟
+    std::vector<int> scatter_order(int node = -1) const {
+        std::vector<std::vector<int>> per_node;
+        for (size_t n = 0; n < nodes_.size(); ++n) {
+            if (node >= 0 && n != static_cast<size_t>(node)) continue;
+            std::vector<int> cpus = nodes_[n];
+            std::sort(cpus.begin(), cpus.end(), [this](int a, int b) {
+                return std::pair(sibling_rank_[a], a) < std::pair(sibling_rank_[b], b);
+                });
+            per_node.push_back(std::move(cpus));
+        }
+
+        std::vector<int> order;
+        for (size_t i = 0; ; ++i) {
+            bool any = false;
+            for (auto& cpus : per_node) {
+                if (i < cpus.size()) {
+                    order.push_back(cpus[i]);
+                    any = true;
+                }
+            }
+            if (!any) break;
+        }
+        return order;
+    }
+
+    // 解析 sysfs 的 CPU 列表格式，例如 "0-3,8,10-11"
+    static std::vector<int> parse_cpu_list(const std::string& text) {
+        std::vector<int> cpus;
+        std::stringstream ss(text);
+        std::string part;
+        while (std::getline(ss, part, ',')) {
+            if (part.empty()) continue;
+            const size_t dash = part.find('-');
+            try {
+                const int first = std::stoi(part.substr(0, dash));
+                const int last = dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+            }
+            catch (const std::exception&) {
+                // 忽略无法解析的片段
+            }
+        }
+        return cpus;
+    }
+
+private:
+    CpuTopology() {
+        std::vector<int> allowed = allowed_cpus();
+        const int max_cpu = allowed.empty() ? 0 : *std::max_element(allowed.begin(), allowed.end());
+        cpu_node_.assign(max_cpu + 1, 0);
+        sibling_rank_.assign(max_cpu + 1, 0);
+        core_leader_.resize(max_cpu + 1);
+        for (int cpu = 0; cpu <= max_cpu; ++cpu) core_leader_[cpu] = cpu;
+
+        // NUMA 节点：按 online 列表读取，节点编号可能不连续（如 "0,2"），不能扫描到第一个缺失编号为止
+        std::vector<std::vector<int>> nodes;
+        std::vector<int> node_ids;
+        std::string online;
+        read_line("/sys/devices/system/node/online", online);
+        for (int n : parse_cpu_list(online)) {
+            std::string list;
+            if (!read_line("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist", list)) continue;
+            std::vector<int> cpus;
+            for (int cpu : parse_cpu_list(list)) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                    cpus.push_back(cpu);
+                    cpu_node_[cpu] = static_cast<int>(nodes.size());
+                }
+            }
+            if (!cpus.empty()) {
+                nodes.push_back(std::move(cpus));
+                node_ids.push_back(n);
+            }
+        }
+        if (nodes.empty()) {
+            nodes.push_back(allowed);
+            node_ids.push_back(0);
+        }
+        nodes_ = std::move(nodes);
+        node_ids_ = std::move(node_ids);
+
+        // 超线程兄弟：同一物理核中编号最小的逻辑核为 leader
+        for (int cpu : allowed) {
+            std::string list;
+            if (!read_line("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list", list)) {
+                continue;
+            }
+            std::vector<int> siblings = parse_cpu_list(list);
+            if (siblings.empty()) continue;
+            std::sort(siblings.begin(), siblings.end());
+            core_leader_[cpu] = siblings.front();
+            sibling_rank_[cpu] = static_cast<int>(
+                std::find(siblings.begin(), siblings.end(), cpu) - siblings.begin());
+        }
+    }
+
+    // 进程允许运行的CPU
+    static std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+#endif
+        if (cpus.empty()) {
+            const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < count; ++cpu) cpus.push_back(static_cast<int>(cpu));
+        }
+        return cpus;
+    }
+
+    static bool read_line(const std::string& path, std::string& line) {
+        std::ifstream in(path);
+        return in && std::getline(in, line) && !line.empty();
+    }
+
+    std::vector<std::vector<int>> nodes_;  // 每个节点的可用CPU（升序）；只含有可用CPU的节点，按内核节点编号升序
+    std::vector<int> node_ids_;            // 下标 -> 内核节点编号
+    std::vector<int> cpu_node_;            // CPU -> 节点下标
+    std::vector<int> sibling_rank_;        // CPU 在所属物理核中的序号
+    std::vector<int> core_leader_;         // CPU -> 所属物理核中编号最小的CPU
 };
 
+// 把调用线程绑定到给定CPU集合（尽力而为：失败或非 Linux 平台时保持不绑定）
+inline bool bind_current_thread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
 class AdvancedThreadPool {
 public:
     explicit AdvancedThreadPool(ThreadPoolConfig config = {})
         : config_(std::move(config)),
         running_(true) {
 
-        // 启动初始线程
-        for (size_t i = 0; i < config_.min_threads; ++i) {
-            add_worker();
+        // 工作窃取模式：为每个工作线程预先创建本地队列
+        if (config_.mode == PoolMode::WORK_STEALING) {
+            if (config_.min_threads == 0) config_.min_threads = 1;
+            local_queues_.reserve(config_.min_threads);
+            for (size_t i = 0; i < config_.min_threads; ++i) {
+                local_queues_.push_back(std::make_unique<StealingQueue>());
+            }
+        }
+
+        build_affinity_plan();
+
+        adaptive_ = config_.mode == PoolMode::CACHED &&
+            config_.elasticity.policy == ElasticityPolicy::ADAPTIVE;
+        desired_workers_ = config_.min_threads;
+        timed_ = adaptive_ || config_.latency_histograms;
+
+        // 无锁就绪队列：每个优先级的环形队列容量都不小于 max_tasks，
+        // 配合 queued_tasks_ 的名额预留，入队永远不会因环满而失败
+        if (config_.mode != PoolMode::WORK_STEALING && config_.queue_type == QueueType::LOCK_FREE) {
+            ready_queue_ = std::make_unique<LockFreeReadyQueue>(
+                std::max<size_t>(config_.max_tasks, 1),
+                static_cast<uint64_t>(std::chrono::nanoseconds(config_.low_priority_aging).count()));
+        }
+
+        // 启动追踪排空线程（仅在设置了追踪输出时）
+        if (config_.trace_sink) {
+            trace_drainer_ = std::jthread([this](std::stop_token st) {
+                drain_traces(st);
+                });
+        }
+
+        // 启动初始线程；自适应模式额外预建备用线程，它们启动后即转入休眠
+        size_t initial = config_.min_threads;
+        if (adaptive_ && config_.max_threads > initial) {
+            initial += std::min(config_.elasticity.spare_threads, config_.max_threads - initial);
+        }
+        for (size_t i = 0; i < initial; ++i) {
+            add_worker();
+        }
+
+        // 启动管理线程（仅CACHED模式需要）
+        if (config_.mode == PoolMode::CACHED) {
+            manager_thread_ = std::jthread([this](std::stop_token st) {
+                manage_workers(st);
+                });
+        }
+    }
+
+    ~AdvancedThreadPool() {
+        shutdown();
+    }
+
+    // 禁用拷贝和赋值
+    AdvancedThreadPool(const AdvancedThreadPool&) = delete;
+    AdvancedThreadPool& operator=(const AdvancedThreadPool&) = delete;
+
+    // 提交任务（带优先级）
+    // 返回的 future 共享状态来自 TaskStatePool，任务本身以内联方式存放在 TaskFunction 中
+    // 队列满时按 overflow_policy 处理，最终被拒绝时抛出 std::runtime_error
+    template <typename F, typename... Args>
+    auto submit(TaskPriority priority, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+
+        auto result = submit_with_status(submit_deadline(), priority,
+            std::forward<F>(f), std::forward<Args>(args)...);
+        throw_if_rejected(result.status);
+        return std::move(result.future);
+    }
+
+    // 提交任务（默认优先级）
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) {
+        return submit(TaskPriority::NORMAL,
+            std::forward<F>(f),
+            std::forward<Args>(args)...);
+    }
+
+    // 投递任务（带优先级，不返回 future）
+    // 可调用对象与参数不超过 TaskFunction::kInlineSize 时整个提交过程不发生堆分配
+    template <typename F, typename... Args>
+    void post(TaskPriority priority, F&& f, Args&&... args) {
+        throw_if_rejected(enqueue(priority,
+            make_callable(std::forward<F>(f), std::forward<Args>(args)...), submit_deadline()));
+    }
+
+    // 投递任务（默认优先级）
+    template <typename F, typename... Args>
+    void post(F&& f, Args&&... args) {
+        post(TaskPriority::NORMAL,
+            std::forward<F>(f),
+            std::forward<Args>(args)...);
+    }
+
+    // 非阻塞提交（带优先级）：队列满时按 overflow_policy 立即处理（BLOCK 视同 REJECT），
+    // 结果以状态码返回，不抛出异常
+    template <typename F, typename... Args>
+    auto try_submit(TaskPriority priority, F&& f, Args&&... args)
+        -> SubmitResult<std::invoke_result_t<F, Args...>> {
+        return submit_with_status(std::nullopt, priority, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 非阻塞提交（默认优先级）
+    template <typename F, typename... Args>
+    auto try_submit(F&& f, Args&&... args) {
+        return try_submit(TaskPriority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 限时提交（带优先级）：队列满时最多等待 timeout，超时返回 SubmitStatus::TIMEOUT
+    template <typename F, typename... Args>
+    auto try_submit_for(std::chrono::steady_clock::duration timeout, TaskPriority priority, F&& f, Args&&... args)
+        -> SubmitResult<std::invoke_result_t<F, Args...>> {
+        return submit_with_status(std::chrono::steady_clock::now() + timeout, priority,
+            std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 限时提交（默认优先级）
+    template <typename F, typename... Args>
+    auto try_submit_for(std::chrono::steady_clock::duration timeout, F&& f, Args&&... args) {
+        return try_submit_for(timeout, TaskPriority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 非阻塞投递（带优先级，不返回 future）
+    template <typename F, typename... Args>
+    SubmitStatus try_post(TaskPriority priority, F&& f, Args&&... args) {
+        return enqueue(priority, make_callable(std::forward<F>(f), std::forward<Args>(args)...), std::nullopt);
+    }
+
+    // 非阻塞投递（默认优先级）
+    template <typename F, typename... Args>
+    SubmitStatus try_post(F&& f, Args&&... args) {
+        return try_post(TaskPriority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 限时投递（带优先级）
+    template <typename F, typename... Args>
+    SubmitStatus try_post_for(std::chrono::steady_clock::duration timeout, TaskPriority priority, F&& f, Args&&... args) {
+        return enqueue(priority, make_callable(std::forward<F>(f), std::forward<Args>(args)...),
+            std::chrono::steady_clock::now() + timeout);
+    }
+
+    // 限时投递（默认优先级）
+    template <typename F, typename... Args>
+    SubmitStatus try_post_for(std::chrono::steady_clock::duration timeout, F&& f, Args&&... args) {
+        return try_post_for(timeout, TaskPriority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 协程调度等待体：挂起当前协程，并把恢复操作投递到线程池
+    struct ScheduleAwaiter {
+        AdvancedThreadPool& pool;
+        TaskPriority priority;
+
+        bool await_ready() const noexcept { return false; }
+
+        // 投递失败（线程池已关闭或队列满超时）时异常从 co_await 处抛出，协程不会丢失；
+        // CALLER_RUNS 策略下协程在当前线程就地恢复。DROP_OLDEST_LOW 策略会丢弃 LOW 任务，
+        // 此时不要以 LOW 优先级调度协程，否则被丢弃的协程永远不会恢复
+        void await_suspend(std::coroutine_handle<> handle) {
+            pool.post(priority, [handle] { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // co_await pool.schedule() 之后协程在工作线程上继续执行
+    // 协程在等待期间不占用线程，配合 threadpool_coro.hpp 中的 Task<T> 使用
+    ScheduleAwaiter schedule(TaskPriority priority = TaskPriority::NORMAL) {
+        return ScheduleAwaiter{ *this, priority };
+    }
+
+    // 批量提交无参任务：所有任务在一次加锁内入队，并只做一次 notify_all
+    // 返回与 tasks 顺序一致的 future 列表
+    template <typename Range>
+    auto submit_batch(Range&& tasks, TaskPriority priority = TaskPriority::NORMAL) {
+        using Fn = std::decay_t<decltype(*std::begin(tasks))>;
+        using ReturnType = std::invoke_result_t<Fn&>;
+
+        std::vector<std::future<ReturnType>> futures;
+        std::vector<TaskItem> items;
+        if constexpr (std::ranges::sized_range<Range>) {
+            futures.reserve(std::ranges::size(tasks));
+            items.reserve(std::ranges::size(tasks));
+        }
+
+        const uint64_t enqueue_ns = enqueue_timestamp();
+        for (auto&& task : tasks) {
+            std::promise<ReturnType> promise(std::allocator_arg, TaskStateAllocator<char>());
+            futures.push_back(promise.get_future());
+            items.push_back({ priority,
+                make_promise_task(std::move(promise), forward_element<Range>(task)), enqueue_ns });
+        }
+
+        enqueue_batch(std::move(items));
+        return futures;
+    }
+
+    // 批量投递无参任务（不返回 future）
+    template <typename Range>
+    void post_batch(Range&& tasks, TaskPriority priority = TaskPriority::NORMAL) {
+        using Fn = std::decay_t<decltype(*std::begin(tasks))>;
+
+        std::vector<TaskItem> items;
+        if constexpr (std::ranges::sized_range<Range>) {
+            items.reserve(std::ranges::size(tasks));
+        }
+
+        const uint64_t enqueue_ns = enqueue_timestamp();
+        for (auto&& task : tasks) {
+            items.push_back({ priority, Fn(forward_element<Range>(task)), enqueue_ns });
+        }
+
+        enqueue_batch(std::move(items));
+    }
+
+    /**
+     * 分块并行循环：把 [begin, end) 按 grain 切分为若干块批量入队，返回单个完成句柄
+     * fn 可以是逐元素形式 fn(i)，也可以是区间形式 fn(chunk_begin, chunk_end)
+     * grain 为 0 时按当前线程数自动切分（约每线程4块）；块数超过 max_tasks 时自动加大 grain
+     * 全部块一次入队：队列容量不足（等待 submit_timeout 后）或线程池已关闭时抛出异常且没有任何块入队
+     * 任一块抛出异常时，其余未开始的块跳过执行，句柄携带第一个异常
+     * 注意：不要在本线程池的工作线程中阻塞等待返回的句柄（FIXED模式下可能耗尽线程）
+     */
+    template <typename Index, typename F>
+    std::future<void> parallel_for(Index begin, std::type_identity_t<Index> end, size_t grain,
+                                   F&& fn, TaskPriority priority = TaskPriority::NORMAL) {
+        static_assert(std::is_integral_v<Index>, "parallel_for requires an integral index type");
+
+        if (!(begin < end)) {
+            std::promise<void> ready;
+            ready.set_value();
+            return ready.get_future();
+        }
+
+        const size_t total = static_cast<size_t>(end - begin);
+        if (grain == 0) {
+            const size_t workers = std::max<size_t>(worker_count(), 1);
+            grain = std::max<size_t>(1, total / (workers * 4));
+        }
+        // 块数不超过 max_tasks：整批一次预留名额，入队失败时不会有块在调用方栈帧展开后继续运行
+        const size_t max_chunks = std::max<size_t>(config_.max_tasks, 1);
+        if ((total + grain - 1) / grain > max_chunks) {
+            grain = (total + max_chunks - 1) / max_chunks;
+        }
+        const size_t chunks = (total + grain - 1) / grain;
+
+        auto state = std::make_shared<LoopState<Index, std::decay_t<F>>>(std::forward<F>(fn), chunks);
+        std::future<void> result = state->done.get_future();
+
+        std::vector<TaskItem> items;
+        items.reserve(chunks);
+        const uint64_t enqueue_ns = enqueue_timestamp();
+        for (size_t c = 0; c < chunks; ++c) {
+            const Index lo = static_cast<Index>(begin + static_cast<Index>(c * grain));
+            const Index hi = (c + 1 == chunks) ? end : static_cast<Index>(lo + static_cast<Index>(grain));
+            items.push_back({ priority, [state, lo, hi] { state->run(lo, hi); }, enqueue_ns });
+        }
+
+        enqueue_batch(std::move(items));
+        return result;
+    }
+
+    // 优雅关闭线程池
+    void shutdown() {
+        if (!running_.exchange(false)) return;
+
+        // 通知所有线程
+        {
+            std::lock_guard lock(queue_mutex_);
+            task_available_.notify_all();
+            queue_not_full_.notify_all();
+            spare_cv_.notify_all();
+        }
+        {
+            std::lock_guard park_lock(park_mutex_);
+            park_cv_.notify_all();
+            space_available_.notify_all();
+        }
+        // 向管理线程发送停止请求（使用 jthread 内置方法）
+        if (manager_thread_.joinable()) {
+            manager_thread_.request_stop();  // 替代 stop_source_.request_stop()
+        }
+    
+        // 等待管理线程结束
+        if (manager_thread_.joinable()) {
+            manager_thread_.join();
+        }
+       
+        // 创建临时容器存放工作线程
+        std::vector<std::thread> workers;
+        {
+            // 短暂锁定以复制工作线程
+            std::unique_lock lock(queue_mutex_);
+            workers = std::move(workers_);  // 转移所有权
+            expired_workers_.clear();        // 清理过期线程集合
+        }
+
+        // 在无锁状态下等待工作线程结束
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+
+        // 最后停止追踪排空线程（退出前会排空剩余记录）
+        if (trace_drainer_.joinable()) {
+            trace_drainer_.request_stop();
+            trace_drainer_.join();
+        }
+    }
+
+    // 获取当前线程数（原子读取，不与工作线程竞争锁）
+    size_t worker_count() const {
+        return worker_count_.load(std::memory_order_relaxed);
+    }
+
+    // 获取等待任务数（原子读取，不与工作线程竞争锁）
+    size_t pending_tasks() const {
+        return queued_tasks_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 统计快照：合并所有工作线程的计数器与直方图
+     * 工作线程只写自己的统计块，读取方不与其竞争锁，可按秒级频率周期性采集
+     */
+    ThreadPoolStats stats() const {
+        ThreadPoolStats snapshot;
+        {
+            std::lock_guard lock(stats_mutex_);
+            for (auto& block : worker_stats_) {
+                for (size_t level = 0; level < kTaskPriorityLevels; ++level) {
+                    block->levels[level].merge_into(snapshot.priorities[level]);
+                }
+            }
+        }
+        snapshot.rejected = rejected_tasks_.load(std::memory_order_relaxed);
+        snapshot.dropped = dropped_tasks_.load(std::memory_order_relaxed);
+        snapshot.ran_in_caller = caller_ran_tasks_.load(std::memory_order_relaxed);
+        snapshot.pending_tasks = pending_tasks();
+        snapshot.worker_count = worker_count();
+        return snapshot;
+    }
+
+    // 扩缩容状态快照（速率与时延字段仅由 ADAPTIVE 控制器每周期更新）
+    ElasticityStats elasticity_stats() const {
+        ElasticityStats stats;
+        {
+            std::lock_guard lock(elastic_stats_mutex_);
+            stats = elastic_stats_;
+        }
+        stats.target_workers = adaptive_ ? desired_workers_.load() : worker_count();
+        stats.active_workers = adaptive_ ? active_workers_.load() : worker_count();
+        stats.spare_workers = spare_workers_.load();
+        stats.total_workers = worker_count();
+        stats.executing_workers = executing_workers_.load();
+        stats.threads_spawned = threads_spawned_.load();
+        stats.threads_retired = threads_retired_.load();
+        return stats;
+    }
+
+private:
+    // 任务包装结构
+    struct TaskItem {
+        TaskPriority priority;
+        TaskFunction task;
+        uint64_t enqueue_ns = 0;  // 入队时间（仅在需要时记录，见 enqueue_timestamp()）
+    };
+
+    // 单个工作线程的追踪环形缓冲区（单生产者：工作线程，单消费者：排空线程）
+    struct TraceRing {
+        explicit TraceRing(size_t capacity) {
+            size_t cap = 1;
+            while (cap < capacity) cap <<= 1;
+            records.reset(new TaskTraceRecord[cap]);
+            mask = cap - 1;
+        }
+
+        // 写入一条记录，缓冲区满时丢弃（绝不阻塞工作线程）
+        void push(const TaskTraceRecord& record) {
+            const uint64_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) > mask) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            records[h & mask] = record;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        // 取出所有已提交记录追加到 out
+        void drain(std::vector<TaskTraceRecord>& out) {
+            const uint64_t t = tail.load(std::memory_order_relaxed);
+            const uint64_t h = head.load(std::memory_order_acquire);
+            for (uint64_t i = t; i != h; ++i) {
+                out.push_back(records[i & mask]);
+            }
+            tail.store(h, std::memory_order_release);
+        }
+
+        std::unique_ptr<TaskTraceRecord[]> records;
+        uint64_t mask = 0;
+        uint32_t index = 0;         // 追踪序号
+        bool in_use = false;        // 是否已被某个工作线程占用（受 trace_mutex_ 保护）
+        alignas(64) std::atomic<uint64_t> head{ 0 };
+        alignas(64) std::atomic<uint64_t> tail{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        uint64_t reported_dropped = 0;  // 已上报的丢弃数（仅排空线程访问）
+    };
+
+    // 工作线程在生命周期内租用一个追踪缓冲区，退出时归还供后继线程复用
+    class TraceLease {
+    public:
+        explicit TraceLease(AdvancedThreadPool& pool) : pool_(pool) {
+            if (!pool_.config_.trace_sink) return;
+            std::lock_guard lock(pool_.trace_mutex_);
+            for (auto& ring : pool_.trace_rings_) {
+                if (!ring->in_use) {
+                    ring_ = ring.get();
+                    break;
+                }
+            }
+            if (!ring_) {
+                pool_.trace_rings_.push_back(std::make_unique<TraceRing>(pool_.config_.trace_buffer_size));
+                ring_ = pool_.trace_rings_.back().get();
+                ring_->index = static_cast<uint32_t>(pool_.trace_rings_.size() - 1);
+            }
+            ring_->in_use = true;
+        }
+
+        ~TraceLease() {
+            if (!ring_) return;
+            std::lock_guard lock(pool_.trace_mutex_);
+            ring_->in_use = false;
+        }
+
+        TraceLease(const TraceLease&) = delete;
+        TraceLease& operator=(const TraceLease&) = delete;
+
+        TraceRing* ring() const { return ring_; }
+
+    private:
+        AdvancedThreadPool& pool_;
+        TraceRing* ring_ = nullptr;
+    };
+
+    // 单线程写、多线程读的计数器：所有者用 load+store 更新，避免原子读改写的开销
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    // 每线程直方图（仅所有者线程写入，快照时按桶读取合并）
+    struct AtomicHistogram {
+        void record(uint64_t value) {
+            bump(counts[LatencyHistogram::bucket_of(value)]);
+            bump(sum, value);
+            if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+        }
+
+        void merge_into(LatencyHistogram& out) const {
+            uint64_t total = 0;
+            for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+                const uint64_t c = counts[i].load(std::memory_order_relaxed);
+                out.counts[i] += c;
+                total += c;
+            }
+            out.count += total;
+            out.sum += sum.load(std::memory_order_relaxed);
+            out.max = std::max(out.max, max.load(std::memory_order_relaxed));
+        }
+
+        std::atomic<uint64_t> counts[LatencyHistogram::kBucketCount] = {};
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+    };
+
+    // 工作线程统计块：线程退出后保留计数，由后继线程继续累加
+    struct alignas(64) WorkerStats {
+        struct Level {
+            std::atomic<uint64_t> completed{ 0 };
+            std::atomic<uint64_t> failed{ 0 };
+            std::atomic<uint64_t> busy_ns{ 0 };   // 累计执行时间（启用计时时）
+            std::atomic<uint64_t> wait_ns{ 0 };   // 累计排队时间（启用计时时）
+            std::unique_ptr<AtomicHistogram> queue_wait;  // 仅 latency_histograms 时分配
+            std::unique_ptr<AtomicHistogram> execution;
+
+            void merge_into(PriorityStats& out) const {
+                out.completed += completed.load(std::memory_order_relaxed);
+                out.failed += failed.load(std::memory_order_relaxed);
+                if (queue_wait) queue_wait->merge_into(out.queue_wait);
+                if (execution) execution->merge_into(out.execution);
+            }
+        };
+
+        explicit WorkerStats(bool histograms) {
+            if (!histograms) return;
+            for (auto& level : levels) {
+                level.queue_wait = std::make_unique<AtomicHistogram>();
+                level.execution = std::make_unique<AtomicHistogram>();
+            }
+        }
+
+        Level levels[kTaskPriorityLevels];
+        bool in_use = false;  // 受 stats_mutex_ 保护
+    };
+
+    // 工作线程在生命周期内租用一个统计块，退出时归还
+    class StatsLease {
+    public:
+        explicit StatsLease(AdvancedThreadPool& pool) : pool_(pool) {
+            std::lock_guard lock(pool_.stats_mutex_);
+            for (auto& block : pool_.worker_stats_) {
+                if (!block->in_use) {
+                    block_ = block.get();
+                    break;
+                }
+            }
+            if (!block_) {
+                pool_.worker_stats_.push_back(std::make_unique<WorkerStats>(pool_.config_.latency_histograms));
+                block_ = pool_.worker_stats_.back().get();
+            }
+            block_->in_use = true;
+        }
+
+        ~StatsLease() {
+            std::lock_guard lock(pool_.stats_mutex_);
+            block_->in_use = false;
+        }
+
+        StatsLease(const StatsLease&) = delete;
+        StatsLease& operator=(const StatsLease&) = delete;
+
+        WorkerStats& block() const { return *block_; }
+
+    private:
+        AdvancedThreadPool& pool_;
+        WorkerStats* block_ = nullptr;
+    };
+
+    // 所有统计块的累计值（自适应控制器每周期读取）
+    struct StatsTotals {
+        uint64_t completed = 0;
+        uint64_t busy_ns = 0;
+        uint64_t wait_ns = 0;
+    };
+
+    StatsTotals collect_totals() const {
+        StatsTotals totals;
+        std::lock_guard lock(stats_mutex_);
+        for (auto& block : worker_stats_) {
+            for (auto& level : block->levels) {
+                totals.completed += level.completed.load(std::memory_order_relaxed);
+                totals.busy_ns += level.busy_ns.load(std::memory_order_relaxed);
+                totals.wait_ns += level.wait_ns.load(std::memory_order_relaxed);
+            }
+        }
+        return totals;
+    }
+
+    // submit() 的任务异常被 promise 捕获，这里记录一次以便统计 failed
+    static inline thread_local bool task_threw_ = false;
+
+    static uint64_t steady_now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // 入队时间戳（仅在启用追踪或需要排队时间时读取时钟）
+    uint64_t enqueue_timestamp() const {
+        // DROP_OLDEST_LOW 策略依赖入队时间在堆中找出最早的 LOW 任务，LOW 老化按队首任务的入队时间判断
+        return (config_.trace_sink || timed_ ||
+            config_.overflow_policy == OverflowPolicy::DROP_OLDEST_LOW ||
+            config_.low_priority_aging.count() > 0) ? steady_now_ns() : 0;
+    }
+
+    // 优先队列比较函数
+    struct TaskCompare {
+        bool operator()(const TaskItem& a, const TaskItem& b) const {
+            // 数值越小优先级越高（HIGH=0, LOW=2）
+            return static_cast<int>(a.priority) > static_cast<int>(b.priority);
+        }
+    };
+
+    // 任务队列类型（基于堆的优先级队列）
+    // std::priority_queue::top() 只返回 const 引用，无法移出仅可移动的 TaskFunction
+    class TaskQueue {
+    public:
+        void push(TaskItem&& item) {
+            heap_.push_back(std::move(item));
+            std::push_heap(heap_.begin(), heap_.end(), TaskCompare{});
+        }
+
+        // 弹出优先级最高的任务（调用前需保证非空）
+        TaskItem pop() {
+            std::pop_heap(heap_.begin(), heap_.end(), TaskCompare{});
+            TaskItem item = std::move(heap_.back());
+            heap_.pop_back();
+            return item;
+        }
+
+        // 移除指定优先级中入队时间最早的任务（线性扫描后重建堆，仅用于 DROP_OLDEST_LOW 策略）
+        bool remove_oldest(TaskPriority priority, TaskItem& out) {
+            auto oldest = heap_.end();
+            for (auto it = heap_.begin(); it != heap_.end(); ++it) {
+                if (it->priority == priority &&
+                    (oldest == heap_.end() || it->enqueue_ns < oldest->enqueue_ns)) {
+                    oldest = it;
+                }
+            }
+            if (oldest == heap_.end()) return false;
+
+            out = std::move(*oldest);
+            if (oldest != heap_.end() - 1) {
+                *oldest = std::move(heap_.back());
+            }
+            heap_.pop_back();
+            std::make_heap(heap_.begin(), heap_.end(), TaskCompare{});
+            return true;
+        }
+
+        bool empty() const { return heap_.empty(); }
+        size_t size() const { return heap_.size(); }
+
+    private:
+        std::vector<TaskItem> heap_;
+    };
+
+    // 绑定可调用对象与参数（参数按值保存，调用时以左值传入，与 std::bind 语义一致）
+    template <typename F, typename... Args>
+    static auto make_callable(F&& f, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0) {
+            return std::decay_t<F>(std::forward<F>(f));
+        } else {
+            return [fn = std::decay_t<F>(std::forward<F>(f)),
+                bound = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(fn, bound);
+            };
+        }
+    }
+
+    // 把 promise 与可调用对象组合为一个任务：执行结果或异常写入 promise
+    template <typename ReturnType, typename Fn>
+    static auto make_promise_task(std::promise<ReturnType>&& promise, Fn&& fn) {
+        return [promise = std::move(promise), fn = std::forward<Fn>(fn)]() mutable {
+            try {
+                if constexpr (std::is_void_v<ReturnType>) {
+                    fn();
+                    promise.set_value();
+                } else {
+                    promise.set_value(fn());
+                }
+            }
+            catch (...) {
+                task_threw_ = true;
+                promise.set_exception(std::current_exception());
+            }
+        };
+    }
+
+    // 右值区间中的元素按移动取出，左值区间中的元素按拷贝取出
+    template <typename Range, typename T>
+    static decltype(auto) forward_element(T& element) {
+        if constexpr (std::is_lvalue_reference_v<Range>) {
+            return static_cast<const T&>(element);
+        } else {
+            return std::move(element);
+        }
+    }
+
+    // parallel_for 的共享状态：剩余块计数、第一个异常与完成通知
+    template <typename Index, typename Fn>
+    struct LoopState {
+        LoopState(Fn&& f, size_t chunks) : fn(std::move(f)), remaining(chunks) {}
+        LoopState(const Fn& f, size_t chunks) : fn(f), remaining(chunks) {}
+
+        void run(Index lo, Index hi) {
+            if (!failed.load(std::memory_order_relaxed)) {
+                try {
+                    if constexpr (std::is_invocable_v<Fn&, Index, Index>) {
+                        fn(lo, hi);
+                    } else {
+                        for (Index i = lo; i < hi; ++i) {
+                            fn(i);
+                        }
+                    }
+                }
+                catch (...) {
+                    if (!failed.exchange(true)) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+
+            // 最后一个完成的块负责发布结果
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (error) {
+                    done.set_exception(error);
+                } else {
+                    done.set_value();
+                }
+            }
+        }
+
+        Fn fn;
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed{ false };
+        std::exception_ptr error;
+        std::promise<void> done;
+    };
+
+    // 等待队列空位的期限：无期限表示队列满时不等待
+    using SubmitDeadline = std::optional<std::chrono::steady_clock::time_point>;
+
+    // submit()/post() 的等待期限：仅 BLOCK 策略等待
+    SubmitDeadline submit_deadline() const {
+        if (config_.overflow_policy != OverflowPolicy::BLOCK) return std::nullopt;
+        return std::chrono::steady_clock::now() + config_.submit_timeout;
+    }
+
+    // 抛异常的接口在边界处把拒绝状态转换为异常，内部路径只传递状态码
+    static void throw_if_rejected(SubmitStatus status) {
+        switch (status) {
+        case SubmitStatus::SHUTDOWN:
+            throw std::runtime_error("ThreadPool is shutdown");
+        case SubmitStatus::TIMEOUT:
+            throw std::runtime_error("Task queue full, submit timeout");
+        case SubmitStatus::QUEUE_FULL:
+            throw std::runtime_error("Task queue full");
+        default:
+            break;
+        }
+    }
+
+    // submit()/try_submit() 的公共实现：被拒绝时返回的 future 无效
+    template <typename F, typename... Args>
+    auto submit_with_status(SubmitDeadline deadline, TaskPriority priority, F&& f, Args&&... args)
+        -> SubmitResult<std::invoke_result_t<F, Args...>> {
+
+        using ReturnType = std::invoke_result_t<F, Args...>;
+
+        std::promise<ReturnType> promise(std::allocator_arg, TaskStateAllocator<char>());
+        SubmitResult<ReturnType> result{ SubmitStatus::ACCEPTED, promise.get_future() };
+
+        result.status = enqueue(priority, make_promise_task(std::move(promise),
+            make_callable(std::forward<F>(f), std::forward<Args>(args)...)), deadline);
+        if (!result) {
+            result.future = {};
+        }
+        return result;
+    }
+
+    // 任务入队（submit/post 的公共路径）
+    // 队列满且无等待期限时按 overflow_policy 处理：DROP_OLDEST_LOW 在各队列实现内部完成，
+    // CALLER_RUNS 在此处就地执行
+    SubmitStatus enqueue(TaskPriority priority, TaskFunction&& fn, const SubmitDeadline& deadline) {
+        TaskItem item{ priority, std::move(fn), enqueue_timestamp() };
+
+        SubmitStatus status;
+        if (config_.mode == PoolMode::WORK_STEALING) {
+            // 工作窃取模式走无全局锁的提交路径
+            status = submit_stealing(item, deadline);
+        } else if (ready_queue_) {
+            status = submit_lock_free(item, deadline);
+        } else {
+            status = submit_heap(item, deadline);
+        }
+
+        if (status == SubmitStatus::QUEUE_FULL && !deadline &&
+            config_.overflow_policy == OverflowPolicy::CALLER_RUNS) {
+            run_in_caller(item);
+            return SubmitStatus::RAN_IN_CALLER;
+        }
+        if (status == SubmitStatus::QUEUE_FULL || status == SubmitStatus::TIMEOUT) {
+            rejected_tasks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return status;
+    }
+
+    // 堆队列提交；被拒绝时 item 保持不变
+    SubmitStatus submit_heap(TaskItem& item, const SubmitDeadline& deadline) {
+        TaskItem dropped;  // 被丢弃的任务在锁外析构（其 promise 会唤醒等待方）
+        bool expand = false;
+        {
+            std::unique_lock lock(queue_mutex_);
+            SubmitStatus status = wait_for_queue_space(lock, deadline);
+            if (status == SubmitStatus::QUEUE_FULL && !deadline &&
+                config_.overflow_policy == OverflowPolicy::DROP_OLDEST_LOW &&
+                task_queue_.remove_oldest(TaskPriority::LOW, dropped)) {
+                queued_tasks_.fetch_sub(1, std::memory_order_relaxed);
+                dropped_tasks_.fetch_add(1, std::memory_order_relaxed);
+                status = SubmitStatus::ACCEPTED;
+            }
+            if (status != SubmitStatus::ACCEPTED) {
+                return status;
+            }
+
+            // 按优先级插入任务
+            task_queue_.push(std::move(item));
+            queued_tasks_.fetch_add(1, std::memory_order_relaxed);
+
+            // 在同一次加锁内完成扩容判断
+            expand = should_expand_locked();
+        }
+
+        // 通知工作线程有新任务
+        task_available_.notify_one();
+
+        // 动态扩容
+        if (expand) {
+            expand_workers();
+        }
+        kick_controller();
+        return SubmitStatus::ACCEPTED;
+    }
+
+    // CALLER_RUNS：在提交线程中执行任务，异常处理与工作线程一致（submit() 的异常经 future 传递）
+    void run_in_caller(TaskItem& item) {
+        caller_ran_tasks_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            item.task();
+        }
+        catch (...) {
+        }
+    }
+
+    // 批量接口的拒绝处理：计数并抛出异常
+    void reject_batch(SubmitStatus status) {
+        if (status == SubmitStatus::QUEUE_FULL || status == SubmitStatus::TIMEOUT) {
+            rejected_tasks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        throw_if_rejected(status);
+    }
+
+    // 批量入队：不超过 max_tasks 的批次整批一次预留名额，要么全部入队、要么全部不入队（抛出异常），
+    // 调用方不会在已有部分任务运行时收到异常；更大的批次只能按剩余容量分段，中途被拒绝时已入队的部分照常执行
+    void enqueue_batch(std::vector<TaskItem>&& items) {
+        if (items.empty()) return;
+
+        if (config_.mode == PoolMode::WORK_STEALING) {
+            submit_stealing_batch(items);
+            return;
+        }
+        if (ready_queue_) {
+            submit_lock_free_batch(items);
+            return;
+        }
+
+        bool expand = false;
+        size_t next = 0;
+        const size_t needed = batch_minimum(items.size());
+        while (next < items.size()) {
+            {
+                std::unique_lock lock(queue_mutex_);
+                const SubmitStatus status = wait_for_queue_space(lock,
+                    std::chrono::steady_clock::now() + config_.submit_timeout, needed);
+                if (status != SubmitStatus::ACCEPTED) {
+                    reject_batch(status);
+                }
+
+                const size_t room = config_.max_tasks - task_queue_.size();
+                const size_t stop = next + std::min(room, items.size() - next);
+                queued_tasks_.fetch_add(stop - next, std::memory_order_relaxed);
+                for (; next < stop; ++next) {
+                    task_queue_.push(std::move(items[next]));
+                }
+                expand = should_expand_locked();
+            }
+            task_available_.notify_all();
+        }
+
+        if (expand) {
+            expand_workers();
+        }
+        kick_controller();
+    }
+
+    // 等待队列空位的提交者计数（作用域内有效）；等待多个名额的批量提交者另行计数
+    struct BlockedSubmitter {
+        BlockedSubmitter(AdvancedThreadPool& pool, size_t needed) : pool_(pool), batch_(needed > 1) {
+            ++pool_.blocked_submitters_;
+            if (batch_) ++pool_.blocked_batches_;
+        }
+        ~BlockedSubmitter() {
+            if (batch_) --pool_.blocked_batches_;
+            --pool_.blocked_submitters_;
+        }
+        AdvancedThreadPool& pool_;
+        const bool batch_;
+    };
+
+    // 释放一个名额后唤醒等待者：有批量提交者等待时全部唤醒，
+    // 否则单次唤醒可能落到名额仍不够、继续等待的批量提交者上，单任务提交者错过空位
+    void notify_space_freed(std::condition_variable& cv) {
+        if (blocked_batches_.load() > 0) {
+            cv.notify_all();
+        } else {
+            cv.notify_one();
+        }
+    }
+
+    // 检查线程池状态并等待队列至少有 needed 个空位（最多到 deadline），调用方需持有 queue_mutex_
+    // 无等待期限时空位不足立即返回 QUEUE_FULL
+    SubmitStatus wait_for_queue_space(std::unique_lock<std::mutex>& lock, const SubmitDeadline& deadline,
+                                      size_t needed = 1) {
+        if (!running_) {
+            return SubmitStatus::SHUTDOWN;
+        }
+        if (task_queue_.size() + needed <= config_.max_tasks) {
+            return SubmitStatus::ACCEPTED;
+        }
+        if (!deadline) {
+            return SubmitStatus::QUEUE_FULL;
+        }
+
+        BlockedSubmitter blocked(*this, needed);
+        const bool has_space = queue_not_full_.wait_until(lock, *deadline, [this, needed] {
+            return task_queue_.size() + needed <= config_.max_tasks || !running_;
+            });
+        if (!has_space) {
+            return SubmitStatus::TIMEOUT;
+        }
+        return running_ ? SubmitStatus::ACCEPTED : SubmitStatus::SHUTDOWN;
+    }
+
+    // 工作窃取模式的本地队列：每个优先级一条双端队列
+    // 所有者从尾部取（LIFO，缓存友好），窃取者与注入队列从头部取（FIFO）
+    struct alignas(64) StealingQueue {
+        std::mutex mutex;
+        std::deque<TaskItem> lanes[kTaskPriorityLevels];
+
+        void push(TaskItem&& item) {
+            std::lock_guard lock(mutex);
+            lanes[static_cast<size_t>(item.priority)].push_back(std::move(item));
+        }
+
+        void push_batch(TaskItem* first, TaskItem* last) {
+            std::lock_guard lock(mutex);
+            for (; first != last; ++first) {
+                lanes[static_cast<size_t>(first->priority)].push_back(std::move(*first));
+            }
+        }
+
+        // 所有者出队：优先级从高到低，同级取最新
+        bool pop_back(TaskItem& out) {
+            std::lock_guard lock(mutex);
+            for (auto& lane : lanes) {
+                if (!lane.empty()) {
+                    out = std::move(lane.back());
+                    lane.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // DROP_OLDEST_LOW 策略：取出指定优先级中最早入队的任务
+        bool pop_oldest(TaskPriority priority, TaskItem& out) {
+            std::lock_guard lock(mutex);
+            auto& lane = lanes[static_cast<size_t>(priority)];
+            if (lane.empty()) return false;
+            out = std::move(lane.front());
+            lane.pop_front();
+            return true;
+        }
+
+        // 窃取/注入队列出队：优先级从高到低，同级取最早
+        bool pop_front(TaskItem& out) {
+            std::unique_lock lock(mutex, std::try_to_lock);
+            if (!lock.owns_lock()) return false;  // 竞争时放弃，换下一个目标
+            for (auto& lane : lanes) {
+                if (!lane.empty()) {
+                    out = std::move(lane.front());
+                    lane.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // 当前线程所属的线程池及其工作线程序号（用于识别池内提交）
+    // thread_local 静态存储期对象默认零初始化，非工作线程的 pool 为 nullptr
+    struct WorkerContext {
+        const AdvancedThreadPool* pool;
+        size_t index;
+    };
+    static inline thread_local WorkerContext current_worker_;
+
+    // 添加工作线程
+    void add_worker() {
+        worker_count_.fetch_add(1, std::memory_order_relaxed);
+        active_workers_.fetch_add(1);
+        threads_spawned_.fetch_add(1, std::memory_order_relaxed);
+        const std::vector<int>* cpus = next_affinity_slot();
+        if (config_.mode == PoolMode::WORK_STEALING) {
+            const size_t index = workers_.size();
+            workers_.emplace_back([this, index, cpus] {
+                if (cpus) bind_current_thread(*cpus);
+                stealing_worker_routine(index);
+                });
+            return;
+        }
+        if (ready_queue_) {
+            workers_.emplace_back([this, cpus] {
+                if (cpus) bind_current_thread(*cpus);
+                lock_free_worker_routine();
+                });
+            return;
+        }
+        workers_.emplace_back([this, cpus] {
+            if (cpus) bind_current_thread(*cpus);
+            worker_routine();
+            });
+    }
+
+    // 根据亲和性策略生成线程放置表：每项为一个工作线程可运行的CPU集合
+    void build_affinity_plan() {
+        const CpuTopology& topology = CpuTopology::instance();
+        const int node = config_.numa_node >= 0 ? topology.find_node(config_.numa_node) : -1;
+        if (config_.numa_node >= 0 && node < 0) {
+            throw std::invalid_argument("numa_node " + std::to_string(config_.numa_node) +
+                " is not an online NUMA node with usable CPUs");
+        }
+
+        std::vector<int> order;
+        switch (config_.affinity) {
+        case AffinityPolicy::NONE:
+            // 仅限定节点时，所有线程共享该节点的CPU集合
+            if (node >= 0) {
+                affinity_plan_.push_back(topology.node_cpus(static_cast<size_t>(node)));
+            }
+            return;
+        case AffinityPolicy::COMPACT:
+            order = topology.compact_order(node);
+            break;
+        case AffinityPolicy::SCATTER:
+            order = topology.scatter_order(node);
+            break;
+        case AffinityPolicy::EXPLICIT:
+            order = config_.cpu_list;
+            break;
+        }
+
+        for (int cpu : order) {
+            affinity_plan_.push_back({ cpu });
         }
+    }
 
-        // 启动管理线程（仅CACHED模式需要）
-        if (config_.mode == PoolMode::CACHED) {
-            manager_thread_ = std::jthread([this](std::stop_token st) {
-                manage_workers(st);
-                });
+    // 为新线程分配放置表中的下一项（调用方需持有 queue_mutex_ 或处于构造阶段）
+    const std::vector<int>* next_affinity_slot() {
+        if (affinity_plan_.empty()) return nullptr;
+        return &affinity_plan_[next_affinity_slot_++ % affinity_plan_.size()];
+    }
+
+    // 空闲超时的线程申请退出（CACHED模式）：线程数不低于 min_threads 时才允许
+    bool try_retire_worker() {
+        std::unique_lock lock(queue_mutex_);
+        if (worker_count_.load(std::memory_order_relaxed) <= config_.min_threads) {
+            return false;
         }
+        worker_count_.fetch_sub(1, std::memory_order_relaxed);
+        active_workers_.fetch_sub(1);
+        threads_retired_.fetch_add(1, std::memory_order_relaxed);
+        expired_workers_.insert(std::this_thread::get_id());
+        return true;
     }
 
-    ~AdvancedThreadPool() {
-        shutdown();
+    // 当前活跃线程是否多于控制器目标（ADAPTIVE）
+    bool surplus_worker() const {
+        return adaptive_ && active_workers_.load() > desired_workers_.load();
     }
 
-    // 禁用拷贝和赋值
-    AdvancedThreadPool(const AdvancedThreadPool&) = delete;
-    AdvancedThreadPool& operator=(const AdvancedThreadPool&) = delete;
+    /**
+     * 多余的空闲线程转为备用线程并休眠（调用方需持有 queue_mutex_）
+     * 控制器提高目标时被唤醒并重新参与取任务；超出 spare_threads 的备用线程
+     * 休眠满 idle_timeout 后退出
+     * @return true 表示恢复为活跃线程，false 表示线程应当退出
+     */
+    bool park_as_spare(std::unique_lock<std::mutex>& lock) {
+        active_workers_.fetch_sub(1);
+        spare_workers_.fetch_add(1);
 
-    // 提交任务（带优先级）
-    template <typename F, typename... Args>
-    auto submit(TaskPriority priority, F&& f, Args&&... args)
-        -> std::future<std::invoke_result_t<F, Args...>> {
+        auto deadline = std::chrono::steady_clock::now() + config_.idle_timeout;
+        while (true) {
+            if (!running_) {
+                spare_workers_.fetch_sub(1);
+                return false;
+            }
+            if (active_workers_.load() < desired_workers_.load()) {
+                spare_workers_.fetch_sub(1);
+                active_workers_.fetch_add(1);
+                return true;
+            }
+            if (spare_cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                if (spare_workers_.load() > config_.elasticity.spare_threads &&
+                    worker_count_.load(std::memory_order_relaxed) > config_.min_threads) {
+                    spare_workers_.fetch_sub(1);
+                    worker_count_.fetch_sub(1, std::memory_order_relaxed);
+                    threads_retired_.fetch_add(1, std::memory_order_relaxed);
+                    expired_workers_.insert(std::this_thread::get_id());
+                    return false;
+                }
+                deadline = std::chrono::steady_clock::now() + config_.idle_timeout;
+            }
+        }
+    }
 
-        using ReturnType = std::invoke_result_t<F, Args...>;
-        using TaskType = std::packaged_task<ReturnType()>;
+    // 工作窃取模式提交：池内线程压入自己的本地队列，外部线程压入全局注入队列
+    SubmitStatus submit_stealing(TaskItem& item, const SubmitDeadline& deadline) {
+        // 先预留名额再入队：保证计数不小于实际任务数，休眠线程不会漏掉任务
+        TaskItem dropped;
+        const SubmitStatus status = reserve_or_drop(deadline, dropped);
+        if (status != SubmitStatus::ACCEPTED) {
+            return status;
+        }
+        if (current_worker_.pool == this) {
+            local_queues_[current_worker_.index]->push(std::move(item));
+        } else {
+            injection_queue_.push(std::move(item));
+        }
 
-        // 绑定任务和参数（使用完美转发）
-        auto task = std::make_shared<TaskType>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
+        // 仅在有线程休眠时才触碰休眠锁
+        if (sleeping_workers_.load() > 0) {
+            std::lock_guard park_lock(park_mutex_);
+            park_cv_.notify_one();
+        }
+        return SubmitStatus::ACCEPTED;
+    }
 
-        std::future<ReturnType> result = task->get_future();
+    // 工作窃取模式批量提交：按剩余容量分段，每段一次加锁压入目标队列
+    void submit_stealing_batch(std::vector<TaskItem>& items) {
+        StealingQueue& target = current_worker_.pool == this
+            ? *local_queues_[current_worker_.index]
+            : injection_queue_;
 
-        {
-            std::unique_lock lock(queue_mutex_);
+        size_t next = 0;
+        const size_t minimum = batch_minimum(items.size());
+        while (next < items.size()) {
+            const size_t count = reserve_batch_slots(items.size() - next, minimum);
+            target.push_batch(items.data() + next, items.data() + next + count);
+            next += count;
+            wake_parked_workers(count);
+        }
+    }
 
-            // 检查线程池状态
-            if (!running_) {
-                throw std::runtime_error("ThreadPool is shutdown");
+    // 无锁队列模式提交：预留名额后直接写入对应优先级的环形队列
+    SubmitStatus submit_lock_free(TaskItem& item, const SubmitDeadline& deadline) {
+        TaskItem dropped;
+        const SubmitStatus status = reserve_or_drop(deadline, dropped);
+        if (status != SubmitStatus::ACCEPTED) {
+            return status;
+        }
+        ready_queue_->push(std::move(item));
+        wake_parked_workers(1);
+        expand_if_saturated();
+        kick_controller();
+        return SubmitStatus::ACCEPTED;
+    }
+
+    // 无锁队列模式批量提交
+    void submit_lock_free_batch(std::vector<TaskItem>& items) {
+        size_t next = 0;
+        const size_t minimum = batch_minimum(items.size());
+        while (next < items.size()) {
+            const size_t count = reserve_batch_slots(items.size() - next, minimum);
+            for (size_t end = next + count; next < end; ++next) {
+                ready_queue_->push(std::move(items[next]));
             }
+            wake_parked_workers(count);
+        }
+        expand_if_saturated();
+        kick_controller();
+    }
 
-            // 等待队列有空位（带超时）
-            if (task_queue_.size() >= config_.max_tasks) {
-                if (!task_available_.wait_for(lock, std::chrono::seconds(1), [this] {
-                    return task_queue_.size() < config_.max_tasks || !running_;
-                    })) {
-                    throw std::runtime_error("Task queue full, submit timeout");
-                }
+    // 唤醒休眠的工作线程：仅在有线程休眠时才触碰休眠锁
+    void wake_parked_workers(size_t count) {
+        if (sleeping_workers_.load() > 0) {
+            std::lock_guard park_lock(park_mutex_);
+            if (count == 1) {
+                park_cv_.notify_one();
+            } else {
+                park_cv_.notify_all();
             }
+        }
+    }
 
-            // 按优先级插入任务
-            task_queue_.push({ priority, [task] { (*task)(); } });
+    // CACHED模式无锁队列（EAGER策略）：所有线程都在忙且仍有积压时扩容
+    void expand_if_saturated() {
+        if (config_.mode == PoolMode::CACHED && !adaptive_ &&
+            sleeping_workers_.load() == 0 &&
+            worker_count_.load(std::memory_order_relaxed) < config_.max_threads) {
+            expand_workers();
         }
+    }
 
-        // 通知工作线程有新任务
-        task_available_.notify_one();
+    /**
+     * 在 queued_tasks_ 中预留入队名额（WORK_STEALING 与 LOCK_FREE 队列共用）
+     * 名额通过 CAS 精确预留，队列中的任务总数不会超过 max_tasks
+     * 剩余名额少于 minimum 时最多等待到 deadline；无等待期限时立即返回 QUEUE_FULL
+     * 返回 ACCEPTED 时预留发生在 shutdown 之前，工作线程会等这些名额对应的任务执行完才退出
+     * @param granted 成功时为实际预留的名额数（minimum ~ wanted）
+     */
+    SubmitStatus reserve_queue_slots(size_t wanted, const SubmitDeadline& deadline, size_t& granted,
+                                     size_t minimum = 1) {
+        size_t queued = queued_tasks_.load();
+        while (true) {
+            if (!running_) {
+                return SubmitStatus::SHUTDOWN;
+            }
+            if (queued + minimum <= config_.max_tasks) {
+                granted = std::min(wanted, config_.max_tasks - queued);
+                if (queued_tasks_.compare_exchange_weak(queued, queued + granted)) {
+                    // 预留后再检查一次：shutdown 可能在上面的检查之后开始，工作线程按 queued_tasks_ == 0 退出，
+                    // 此后入队的任务无人执行；关闭已开始时退还名额（running_ 与名额均为顺序一致的原子操作）
+                    if (!running_) {
+                        queued_tasks_.fetch_sub(granted);
+                        return SubmitStatus::SHUTDOWN;
+                    }
+                    return SubmitStatus::ACCEPTED;
+                }
+                continue;
+            }
+            if (!deadline) {
+                return SubmitStatus::QUEUE_FULL;
+            }
 
-        // 动态扩容检查
-        if (should_expand()) {
-            expand_workers();
+            std::unique_lock park_lock(park_mutex_);
+            BlockedSubmitter blocked(*this, minimum);
+            const bool has_space = space_available_.wait_until(park_lock, *deadline, [this, minimum] {
+                return queued_tasks_.load() + minimum <= config_.max_tasks || !running_;
+                });
+            if (!has_space) {
+                return SubmitStatus::TIMEOUT;
+            }
+            queued = queued_tasks_.load();
         }
+    }
 
-        return result;
+    // 单个任务预留名额；DROP_OLDEST_LOW 策略下队列满时取出一个最早的 LOW 任务，
+    // 新任务直接沿用它的名额（dropped 由调用方在入队后析构）
+    SubmitStatus reserve_or_drop(const SubmitDeadline& deadline, TaskItem& dropped) {
+        size_t granted = 0;
+        const SubmitStatus status = reserve_queue_slots(1, deadline, granted);
+        if (status != SubmitStatus::QUEUE_FULL || deadline ||
+            config_.overflow_policy != OverflowPolicy::DROP_OLDEST_LOW || !take_oldest_low(dropped)) {
+            return status;
+        }
+        dropped_tasks_.fetch_add(1, std::memory_order_relaxed);
+        return SubmitStatus::ACCEPTED;
     }
 
-    // 提交任务（默认优先级）
-    template <typename F, typename... Args>
-    auto submit(F&& f, Args&&... args) {
-        return submit(TaskPriority::NORMAL,
-            std::forward<F>(f),
-            std::forward<Args>(args)...);
+    // 取出最早入队的 LOW 任务：无锁队列取 LOW 环的队头；
+    // 工作窃取模式先查注入队列，再依次查各线程本地队列
+    bool take_oldest_low(TaskItem& out) {
+        if (ready_queue_) {
+            return ready_queue_->pop_level(TaskPriority::LOW, out);
+        }
+        if (injection_queue_.pop_oldest(TaskPriority::LOW, out)) return true;
+        for (auto& queue : local_queues_) {
+            if (queue->pop_oldest(TaskPriority::LOW, out)) return true;
+        }
+        return false;
     }
 
-    // 优雅关闭线程池
-    void shutdown() {
-        if (!running_.exchange(false)) return;
+    // 批次一次预留的最少名额：能整批放入队列时为整批，否则为 1（按剩余容量分段）
+    size_t batch_minimum(size_t count) const {
+        return count <= config_.max_tasks ? count : 1;
+    }
 
-        // 通知所有线程
-        task_available_.notify_all();
-        // 向管理线程发送停止请求（使用 jthread 内置方法）
-        if (manager_thread_.joinable()) {
-            manager_thread_.request_stop();  // 替代 stop_source_.request_stop()
+    // 批量接口预留名额：按 BLOCK 语义最多等待 submit_timeout，被拒绝时抛出异常
+    size_t reserve_batch_slots(size_t wanted, size_t minimum) {
+        size_t granted = 0;
+        const SubmitStatus status = reserve_queue_slots(wanted,
+            std::chrono::steady_clock::now() + config_.submit_timeout, granted, minimum);
+        if (status != SubmitStatus::ACCEPTED) {
+            reject_batch(status);
         }
-    
-        // 等待管理线程结束
-        if (manager_thread_.joinable()) {
-            manager_thread_.join();
+        return granted;
+    }
+
+    /**
+     * 有界无锁多生产者多消费者环形队列（Dmitry Vyukov 算法）
+     * 每个槽位带一个序号：生产者/消费者各自 CAS 推进位置，再通过序号发布槽位，
+     * 出入队不加锁，也不在队列内部移动其他任务
+     */
+    class MpmcRing {
+    public:
+        explicit MpmcRing(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+            mask_ = size - 1;
+            cells_ = std::make_unique<Cell[]>(size);
+            for (size_t i = 0; i < size; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
         }
-       
-        // 创建临时容器存放工作线程
-        std::vector<std::thread> workers;
-        {
-            // 短暂锁定以复制工作线程
-            std::unique_lock lock(queue_mutex_);
-            workers = std::move(workers_);  // 转移所有权
-            expired_workers_.clear();        // 清理过期线程集合
+
+        ~MpmcRing() {
+            TaskItem item;
+            while (pop(item)) {}
         }
 
-        // 在无锁状态下等待工作线程结束
-        for (auto& worker : workers) {
-            if (worker.joinable()) {
-                worker.join();
+        MpmcRing(const MpmcRing&) = delete;
+        MpmcRing& operator=(const MpmcRing&) = delete;
+
+        bool push(TaskItem&& item) {
+            Cell* cell;
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                cell = &cells_[pos & mask_];
+                const size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false;  // 环已满
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
             }
+            cell->enqueue_ns.store(item.enqueue_ns, std::memory_order_relaxed);
+            ::new (static_cast<void*>(cell->storage)) TaskItem(std::move(item));
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
         }
-    }
 
-    // 获取当前线程数
-    size_t worker_count() const {
-        std::unique_lock lock(queue_mutex_);
-        return workers_.size();
-    }
+        // 队首任务的入队时间，环为空时返回 0。不出队；与并发出队竞争时可能读到刚被取走的任务，只用于老化判断
+        uint64_t head_enqueue_ns() const {
+            const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            const Cell& cell = cells_[pos & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+                return 0;
+            }
+            return cell.enqueue_ns.load(std::memory_order_relaxed);
+        }
 
-    // 获取等待任务数
-    size_t pending_tasks() const {
-        std::unique_lock lock(queue_mutex_);
-        return task_queue_.size();
-    }
+        bool pop(TaskItem& out) {
+            Cell* cell;
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                cell = &cells_[pos & mask_];
+                const size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false;  // 环为空
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+            TaskItem* item = std::launder(reinterpret_cast<TaskItem*>(cell->storage));
+            out = std::move(*item);
+            item->~TaskItem();
+            cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
 
-private:
-    // 任务包装结构
-    struct TaskItem {
-        TaskPriority priority;
-        std::function<void()> task;
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            std::atomic<uint64_t> enqueue_ns{ 0 };  // 槽中任务的入队时间（供 head_enqueue_ns() 无竞争地读取）
+            alignas(TaskItem) unsigned char storage[sizeof(TaskItem)];
+        };
+
+        alignas(64) std::atomic<size_t> enqueue_pos_{ 0 };  // 生产者与消费者位置分处不同缓存行
+        alignas(64) std::atomic<size_t> dequeue_pos_{ 0 };
+        size_t mask_ = 0;
+        std::unique_ptr<Cell[]> cells_;
     };
 
-    // 优先队列比较函数
-    struct TaskCompare {
-        bool operator()(const TaskItem& a, const TaskItem& b) const {
-            // 数值越小优先级越高（HIGH=0, LOW=2）
-            return static_cast<int>(a.priority) > static_cast<int>(b.priority);
+    // 无锁就绪队列：每个优先级一条 MpmcRing，出队按 HIGH -> NORMAL -> LOW 顺序
+    class LockFreeReadyQueue {
+    public:
+        LockFreeReadyQueue(size_t capacity, uint64_t low_aging_ns)
+            : low_aging_ns_(low_aging_ns) {
+            for (auto& ring : rings_) {
+                ring = std::make_unique<MpmcRing>(capacity);
+            }
+        }
+
+        void push(TaskItem&& item) {
+            MpmcRing& ring = *rings_[static_cast<size_t>(item.priority)];
+            // 名额已预留，环满只可能是消费者尚未发布槽位的瞬间
+            while (!ring.push(std::move(item))) {
+                std::this_thread::yield();
+            }
+        }
+
+        bool pop(TaskItem& out) {
+            constexpr size_t kLow = static_cast<size_t>(TaskPriority::LOW);
+
+            // 防饿死：LOW 队首任务已排队超过 low_aging_ns_ 时，本次优先取它（LOW 为空时不读时钟）
+            if (low_aging_ns_ > 0) {
+                const uint64_t enqueued = rings_[kLow]->head_enqueue_ns();
+                if (enqueued != 0 && steady_now_ns() >= enqueued + low_aging_ns_ && rings_[kLow]->pop(out)) {
+                    return true;
+                }
+            }
+
+            for (size_t level = 0; level < kTaskPriorityLevels; ++level) {
+                if (rings_[level]->pop(out)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // DROP_OLDEST_LOW 策略：取出指定优先级中最早入队的任务
+        bool pop_level(TaskPriority priority, TaskItem& out) {
+            return rings_[static_cast<size_t>(priority)]->pop(out);
         }
+
+    private:
+        std::unique_ptr<MpmcRing> rings_[kTaskPriorityLevels];
+        const uint64_t low_aging_ns_;
     };
 
-    // 任务队列类型（优先级队列）
-    using TaskQueue = std::priority_queue<
-        TaskItem,
-        std::vector<TaskItem>,
-        TaskCompare
-    >;
+    // 工作窃取模式取任务：本地队列 -> 全局注入队列 -> 随机起点轮询窃取
+    bool acquire_stealing_task(size_t index, TaskItem& out, std::minstd_rand& rng) {
+        if (local_queues_[index]->pop_back(out)) return true;
+        if (injection_queue_.pop_front(out)) return true;
 
-    // 添加工作线程
-    void add_worker() {
-        workers_.emplace_back([this] {
-            worker_routine();
-            });
+        const size_t n = local_queues_.size();
+        const size_t start = rng() % n;
+        for (size_t i = 0; i < n; ++i) {
+            const size_t victim = (start + i) % n;
+            if (victim != index && local_queues_[victim]->pop_front(out)) return true;
+        }
+        // try_lock 可能因竞争失败，最后对注入队列做一次阻塞式检查
+        std::lock_guard lock(injection_queue_.mutex);
+        for (auto& lane : injection_queue_.lanes) {
+            if (!lane.empty()) {
+                out = std::move(lane.front());
+                lane.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 工作窃取模式的工作线程主循环
+    void stealing_worker_routine(size_t index) {
+        current_worker_ = { this, index };
+        std::minstd_rand rng(static_cast<unsigned>(index + 1));
+        TraceLease trace(*this);
+        StatsLease stats(*this);
+
+        while (true) {
+            TaskItem task;
+            if (acquire_stealing_task(index, task, rng)) {
+                queued_tasks_.fetch_sub(1);
+                if (blocked_submitters_.load() > 0) {
+                    std::lock_guard park_lock(park_mutex_);
+                    notify_space_freed(space_available_);
+                }
+                execute_task(task, trace.ring(), stats.block());
+                continue;
+            }
+
+            // 没有可执行任务：休眠直到有新任务或线程池关闭
+            std::unique_lock park_lock(park_mutex_);
+            ++sleeping_workers_;
+            park_cv_.wait(park_lock, [this] {
+                return queued_tasks_.load() > 0 || !running_;
+                });
+            --sleeping_workers_;
+
+            if (!running_ && queued_tasks_.load() == 0) {
+                return;  // 关闭线程池（剩余任务已全部执行完毕）
+            }
+        }
     }
 
     // 工作线程主循环
     void worker_routine() {
         auto last_active = std::chrono::steady_clock::now();
+        TraceLease trace(*this);
+        StatsLease stats(*this);
 
         while (running_) {
             std::optional<TaskItem> task;
@@ -208,18 +2256,30 @@ private:
             {
                 std::unique_lock lock(queue_mutex_);
 
+                // 自适应模式：空闲线程不按超时退出，由控制器决定是否转为备用线程
+                if (adaptive_) {
+                    task_available_.wait(lock, [this] {
+                        return !task_queue_.empty() || !running_ || surplus_worker();
+                        });
+                    if (running_ && task_queue_.empty() && surplus_worker()) {
+                        if (!park_as_spare(lock)) return;
+                        continue;
+                    }
+                }
                 // 等待任务或超时（CACHED模式）
-                if (config_.mode == PoolMode::CACHED) {
+                else if (config_.mode == PoolMode::CACHED) {
                     // 使用wait_until避免虚假唤醒
                     auto timeout_point = last_active + config_.idle_timeout;
 
                     while (task_queue_.empty() && running_) {
                         if (task_available_.wait_until(lock, timeout_point) == std::cv_status::timeout) {
                             // 检查是否应该退出（空闲超时且超过最小线程数）
-                            if (workers_.size() > config_.min_threads) {
+                            if (worker_count_.load(std::memory_order_relaxed) > config_.min_threads) {
                                 // 标记当前线程为可移除
-                                auto self = std::this_thread::get_id();
-                                expired_workers_.insert(self);
+                                worker_count_.fetch_sub(1, std::memory_order_relaxed);
+                                active_workers_.fetch_sub(1);
+                                threads_retired_.fetch_add(1, std::memory_order_relaxed);
+                                expired_workers_.insert(std::this_thread::get_id());
                                 return;
                             }
                             // 重置超时时间
@@ -240,57 +2300,196 @@ private:
                 }
 
                 if (!task_queue_.empty()) {
-                    task = std::move(task_queue_.top());
-                    task_queue_.pop();
+                    task = task_queue_.pop();
+                    queued_tasks_.fetch_sub(1, std::memory_order_relaxed);
                     last_active = std::chrono::steady_clock::now();
+                    if (blocked_submitters_.load() > 0) {
+                        notify_space_freed(queue_not_full_);
+                    }
                 }
             }
 
             // 执行任务
             if (task) {
-                try {
-                    // 添加任务开始执行日志
-                    {
-                        static std::mutex log_mutex;
-                        std::scoped_lock lock(log_mutex);
-                        auto now = std::chrono::system_clock::now();
-                        std::time_t time = std::chrono::system_clock::to_time_t(now);
-                        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            now.time_since_epoch()) % 1000;
-                
-                        std::cout << "[" << std::put_time(std::localtime(&time), "%H:%M:%S")
-                                << '.' << std::setfill('0') << std::setw(3) << ms.count()
-                                << "] Thread " << std::this_thread::get_id()
-                                 << " 开始执行优先级: " 
-                                << static_cast<int>(task->priority) << std::endl;
-                    }
-                    task->task();
+                execute_task(*task, trace.ring(), stats.block());
+            }
+        }
+    }
+
+    // 无锁队列模式的工作线程主循环：取任务不加锁，队列为空时才进入休眠
+    void lock_free_worker_routine() {
+        auto last_active = std::chrono::steady_clock::now();
+        TraceLease trace(*this);
+        StatsLease stats(*this);
+
+        while (true) {
+            TaskItem task;
+            if (ready_queue_->pop(task)) {
+                queued_tasks_.fetch_sub(1);
+                if (blocked_submitters_.load() > 0) {
+                    std::lock_guard park_lock(park_mutex_);
+                    notify_space_freed(space_available_);
+                }
+                execute_task(task, trace.ring(), stats.block());
+                if (config_.mode == PoolMode::CACHED) {
+                    last_active = std::chrono::steady_clock::now();
+                }
+                continue;
+            }
+
+            // 自适应模式：多余的空闲线程转为备用线程
+            if (surplus_worker()) {
+                std::unique_lock lock(queue_mutex_);
+                if (surplus_worker() && queued_tasks_.load() == 0) {
+                    if (!park_as_spare(lock)) return;
+                    continue;
+                }
+            }
+
+            // 没有可执行任务：休眠直到有新任务、线程池关闭或空闲超时（CACHED模式，EAGER策略）
+            bool has_task = true;
+            {
+                std::unique_lock park_lock(park_mutex_);
+                ++sleeping_workers_;
+                auto ready = [this] { return queued_tasks_.load() > 0 || !running_ || surplus_worker(); };
+                if (config_.mode == PoolMode::CACHED && !adaptive_) {
+                    has_task = park_cv_.wait_until(park_lock, last_active + config_.idle_timeout, ready);
+                } else {
+                    park_cv_.wait(park_lock, ready);
                 }
-                catch (const std::exception& e) {
-                    // 捕获标准异常（如std::runtime_error等）
-                    std::string error_msg = "Task execution failed: " + std::string(e.what());
+                --sleeping_workers_;
+            }
+
+            if (!running_ && queued_tasks_.load() == 0) {
+                return;  // 关闭线程池（剩余任务已全部执行完毕）
+            }
+            if (!has_task) {
+                if (try_retire_worker()) return;
+                last_active = std::chrono::steady_clock::now();
+            }
+        }
+    }
 
-                    // 记录错误日志（包含线程ID、时间、错误信息）
-                    {
-                        static std::mutex log_mutex;  // 确保日志线程安全
-                        std::scoped_lock lock(log_mutex);
+    // 执行单个任务并写入本线程统计块
+    // 启用时延直方图或自适应扩缩容时额外记录执行时间与排队时间
+    void execute_task(TaskItem& task, TraceRing* trace, WorkerStats& stats) {
+        auto& level = stats.levels[static_cast<size_t>(task.priority)];
+        if (!timed_) {
+            const bool failed = run_task(task, trace);
+            bump(level.completed);
+            if (failed) bump(level.failed);
+            return;
+        }
 
-                        auto now = std::chrono::system_clock::now();
-                        std::time_t time = std::chrono::system_clock::to_time_t(now);
+        if (adaptive_) executing_workers_.fetch_add(1, std::memory_order_relaxed);
+        const uint64_t start_ns = steady_now_ns();
+        const bool failed = run_task(task, trace);
+        const uint64_t end_ns = steady_now_ns();
+        if (adaptive_) executing_workers_.fetch_sub(1, std::memory_order_relaxed);
 
-                        std::cerr << "[" << std::ctime(&time)
-                            << "] Thread " << std::this_thread::get_id()
-                            << " error: " << error_msg << std::endl;
-                    }
+        const uint64_t exec_ns = end_ns - start_ns;
+        const uint64_t wait_ns = start_ns - std::min(start_ns, task.enqueue_ns);
+        bump(level.busy_ns, exec_ns);
+        bump(level.wait_ns, wait_ns);
+        if (level.execution) {
+            level.queue_wait->record(wait_ns);
+            level.execution->record(exec_ns);
+        }
+        bump(level.completed);
+        if (failed) bump(level.failed);
+    }
+
+    // 运行任务本体（捕获任务异常，避免工作线程退出），返回任务是否抛出异常
+    // 热路径上不做任何同步I/O：仅在启用追踪时向本线程缓冲区写入一条定长记录
+    bool run_task(TaskItem& task, TraceRing* trace) {
+        task_threw_ = false;
+        if (!trace) {
+            try {
+                task.task();
+            }
+            catch (...) {
+                // 未启用追踪时异常被吞掉；submit() 的异常已由 future 传递给调用方
+                return true;
+            }
+            return task_threw_;
+        }
+
+        TaskTraceRecord record;
+        record.enqueue_ns = task.enqueue_ns;
+        record.thread_index = trace->index;
+        record.priority = static_cast<uint8_t>(task.priority);
+        record.event = TaskTraceEvent::EXECUTED;
+        record.message[0] = '\0';
+        record.start_ns = steady_now_ns();
+        try {
+            task.task();
+        }
+        catch (const std::exception& e) {
+            // 捕获标准异常（如std::runtime_error等），截断后写入追踪记录
+            record.event = TaskTraceEvent::FAILED;
+            std::strncpy(record.message, e.what(), sizeof(record.message) - 1);
+            record.message[sizeof(record.message) - 1] = '\0';
+        }
+        catch (...) {
+            record.event = TaskTraceEvent::FAILED;
+            std::strncpy(record.message, "unknown exception", sizeof(record.message) - 1);
+            record.message[sizeof(record.message) - 1] = '\0';
+        }
+        record.end_ns = steady_now_ns();
+        trace->push(record);
+        return record.event == TaskTraceEvent::FAILED || task_threw_;
+    }
+
+    // 追踪排空线程：周期性收集所有缓冲区记录并批量交给 trace_sink
+    void drain_traces(std::stop_token st) {
+        std::vector<TaskTraceRecord> batch;
+        std::mutex wait_mutex;
+        std::condition_variable_any wait_cv;
+
+        auto flush = [&] {
+            uint64_t dropped = 0;
+            {
+                std::lock_guard lock(trace_mutex_);
+                for (auto& ring : trace_rings_) {
+                    ring->drain(batch);
+                    const uint64_t total = ring->dropped.load(std::memory_order_relaxed);
+                    dropped += total - ring->reported_dropped;
+                    ring->reported_dropped = total;
                 }
             }
+            if (!batch.empty()) {
+                config_.trace_sink->consume(batch.data(), batch.size());
+                batch.clear();
+            }
+            if (dropped > 0) {
+                config_.trace_sink->on_dropped(dropped);
+            }
+        };
+
+        while (!st.stop_requested()) {
+            {
+                std::unique_lock lock(wait_mutex);
+                wait_cv.wait_for(lock, st, config_.trace_flush_interval, [] { return false; });
+            }
+            flush();
         }
+        flush();
     }
 
     // 管理线程（动态调整线程池大小）
     void manage_workers(std::stop_token st) {
+        if (adaptive_) {
+            control_workers(st);
+            return;
+        }
+
+        std::mutex wait_mutex;
+        std::condition_variable_any wait_cv;
         while (!st.stop_requested()) {
-            std::this_thread::sleep_for(std::chrono::seconds(2));
+            {
+                std::unique_lock lock(wait_mutex);
+                wait_cv.wait_for(lock, st, std::chrono::seconds(2), [] { return false; });
+            }
 
             // 清理过期线程
             cleanup_expired_workers();
@@ -302,13 +2501,156 @@ private:
         }
     }
 
+    // 提交方发现积压任务多于活跃线程时提前唤醒控制器（每个周期最多一次）
+    void kick_controller() {
+        if (!adaptive_) return;
+        if (queued_tasks_.load(std::memory_order_relaxed) > active_workers_.load(std::memory_order_relaxed) &&
+            !controller_kick_.load(std::memory_order_relaxed) &&
+            !controller_kick_.exchange(true)) {
+            std::lock_guard lock(controller_mutex_);
+            controller_cv_.notify_one();
+        }
+    }
+
+    /**
+     * 自适应控制器主循环（ADAPTIVE策略）
+     * 每个周期根据 Little 定律估计所需并发：L = λ × S / 目标利用率，
+     * 平均排队时间超过目标、或积压任务多于空闲线程（突发）时额外加上在目标时间内消化积压所需的线程数；
+     * 扩容先唤醒备用线程，突发积压一次补足，其余情况新建线程受 max_spawn_per_tick 限制；
+     * 积压未消化时间隔 target_queue_wait 即复查，不等完整周期；
+     * 缩容需连续 shrink_delay_ticks 个周期低于阈值，每次只回收差值的一半
+     */
+    void control_workers(std::stop_token st) {
+        const auto interval = config_.elasticity.control_interval;
+        auto last_tick = std::chrono::steady_clock::now();
+        StatsTotals last = collect_totals();
+        size_t last_queued = queued_tasks_.load();
+        double service_ns = 0;
+        size_t shrink_streak = 0;
+        bool growing = false;  // 上个周期是否因积压扩容
+        // 积压未消化时的复查间隔：新线程投入后尽快按实测执行时间补足，而不是再等一个完整周期
+        const std::chrono::steady_clock::duration fast_interval = std::clamp<std::chrono::steady_clock::duration>(
+            config_.elasticity.target_queue_wait, std::chrono::milliseconds(1), interval);
+
+        auto earliest = last_tick;  // 被提前唤醒时最早的调整时刻（首个周期不受限制）
+
+        while (!st.stop_requested()) {
+            {
+                const auto period = growing ? fast_interval : std::chrono::steady_clock::duration(interval);
+                std::unique_lock lock(controller_mutex_);
+                controller_cv_.wait_until(lock, st, last_tick + period, [this] {
+                    return controller_kick_.load();
+                    });
+                controller_cv_.wait_until(lock, st, earliest, [] { return false; });
+            }
+            if (st.stop_requested()) break;
+            controller_kick_.store(false);
+
+            cleanup_expired_workers();
+
+            const auto now = std::chrono::steady_clock::now();
+            const double dt = std::chrono::duration<double>(now - last_tick).count();
+            last_tick = now;
+
+            const StatsTotals totals = collect_totals();
+            const size_t queued = queued_tasks_.load();
+            const uint64_t d_completed = totals.completed - last.completed;
+            const double d_busy = static_cast<double>(totals.busy_ns - last.busy_ns);
+            const double d_wait = static_cast<double>(totals.wait_ns - last.wait_ns);
+            const double arrivals = std::max(0.0,
+                static_cast<double>(d_completed) + static_cast<double>(queued) - static_cast<double>(last_queued));
+            last = totals;
+            last_queued = queued;
+
+            if (d_completed > 0) {
+                const double sample = d_busy / static_cast<double>(d_completed);
+                service_ns = service_ns == 0 ? sample : 0.5 * service_ns + 0.5 * sample;
+            }
+            const double mean_wait_ns = d_completed > 0 ? d_wait / static_cast<double>(d_completed) : 0;
+            const double arrival_rate = dt > 0 ? arrivals / dt : 0;
+
+            const size_t active = active_workers_.load();
+            const size_t spare = spare_workers_.load();
+            const size_t desired = desired_workers_.load();
+            const double utilization = active > 0 && dt > 0 ? d_busy / (dt * 1e9 * static_cast<double>(active)) : 0;
+
+            // Little 定律：所需并发 = 到达率 × 平均执行时间
+            const double service_s = service_ns / 1e9;
+            double demand = arrival_rate * service_s / std::max(config_.elasticity.target_utilization, 0.05);
+            const double target_wait_s = std::chrono::duration<double>(config_.elasticity.target_queue_wait).count();
+            // 突发积压：积压任务多于空闲线程时不等排队时间的统计滞后，直接按排空速率估计，
+            // 即在 target_queue_wait 内排空积压所需的线程数（执行时间沿用之前周期的平滑值）
+            const size_t executing = executing_workers_.load();
+            const size_t idle = active > executing ? active - executing : 0;
+            const bool burst = queued > idle && service_ns > 0 && target_wait_s > 0;
+            if (target_wait_s > 0 && (burst || (queued > 0 && mean_wait_ns / 1e9 > target_wait_s))) {
+                demand += static_cast<double>(queued) * service_s / target_wait_s;
+            }
+
+            size_t target = static_cast<size_t>(std::ceil(demand));
+            // 所有活跃线程都卡在任务上且没有完成任何任务时执行时间可能已变长：至少按步长爬坡
+            if (queued > 0 && d_completed == 0 && executing >= active) {
+                target = std::max(target, desired + config_.elasticity.max_spawn_per_tick);
+            }
+            target = std::clamp(target, config_.min_threads, std::max(config_.min_threads, config_.max_threads));
+
+            size_t new_desired = desired;
+            size_t spawn = 0;
+            growing = queued > 0 && target > desired;
+            // 被提前唤醒时仍保证两次调整之间至少间隔 1/4 周期（积压未消化时为复查间隔）
+            earliest = now + std::min(growing ? fast_interval : std::chrono::steady_clock::duration(interval),
+                                      std::chrono::steady_clock::duration(interval / 4));
+            if (target > desired) {
+                shrink_streak = 0;
+                const size_t available = active + spare;
+                if (target > available) {
+                    // 突发积压一次补足排空所需的线程；其余情况每周期最多新建 max_spawn_per_tick 个
+                    spawn = burst ? target - available
+                                  : std::min(target - available, config_.elasticity.max_spawn_per_tick);
+                }
+                new_desired = std::min(target, available + spawn);
+            } else if (static_cast<double>(target) < static_cast<double>(desired) * (1.0 - config_.elasticity.shrink_hysteresis)) {
+                if (++shrink_streak >= config_.elasticity.shrink_delay_ticks) {
+                    shrink_streak = 0;
+                    new_desired = desired - std::max<size_t>(1, (desired - target) / 2);
+                }
+            } else {
+                shrink_streak = 0;
+            }
+
+            if (new_desired != desired || spawn > 0) {
+                std::unique_lock lock(queue_mutex_);
+                if (!running_) break;
+                desired_workers_.store(new_desired);
+                for (size_t i = 0; i < spawn; ++i) {
+                    add_worker();
+                }
+                if (new_desired > desired) {
+                    spare_cv_.notify_all();
+                } else {
+                    // 让空闲线程重新检查目标并转为备用线程
+                    task_available_.notify_all();
+                    std::lock_guard park_lock(park_mutex_);
+                    park_cv_.notify_all();
+                }
+            }
+
+            std::lock_guard stats_lock(elastic_stats_mutex_);
+            elastic_stats_.arrival_rate = arrival_rate;
+            elastic_stats_.mean_service_us = service_ns / 1e3;
+            elastic_stats_.mean_queue_wait_us = mean_wait_ns / 1e3;
+            elastic_stats_.utilization = utilization;
+        }
+    }
+
     // 清理过期线程
     void cleanup_expired_workers() {
         std::unique_lock lock(queue_mutex_);
         if (expired_workers_.empty()) return;
     
+        // 线程数下限已在线程退出前检查，这里只回收已标记的线程
         auto it = workers_.begin();
-        while (it != workers_.end() && workers_.size() > config_.min_threads) {
+        while (it != workers_.end()) {
             if (expired_workers_.find(it->get_id()) != expired_workers_.end()) {
                 if (it->joinable()) it->join();
                 it = workers_.erase(it);
@@ -321,12 +2663,17 @@ private:
 
     // 判断是否需要扩容
     bool should_expand() const {
-        if (config_.mode != PoolMode::CACHED) return false;
+        std::unique_lock lock(queue_mutex_);
+        return should_expand_locked();
+    }
+
+    // 判断是否需要扩容（调用方需持有 queue_mutex_）
+    bool should_expand_locked() const {
+        if (config_.mode != PoolMode::CACHED || adaptive_) return false;
         if (!running_) return false;
 
-        std::unique_lock lock(queue_mutex_);
-        return !task_queue_.empty() &&
-            workers_.size() < config_.max_threads;
+        return queued_tasks_.load() > 0 &&
+            worker_count_.load(std::memory_order_relaxed) < config_.max_threads;
     }
 
     // 扩容线程池
@@ -334,8 +2681,11 @@ private:
         std::unique_lock lock(queue_mutex_);
         if (!running_) return;
 
-        const size_t max_to_add = config_.max_threads - workers_.size();
-        const size_t tasks = task_queue_.size();
+        const size_t workers = worker_count_.load(std::memory_order_relaxed);
+        if (workers >= config_.max_threads) return;
+
+        const size_t max_to_add = config_.max_threads - workers;
+        const size_t tasks = queued_tasks_.load();
         const size_t needed = std::min(tasks, max_to_add);
 
         for (size_t i = 0; i < needed; ++i) {
@@ -352,10 +2702,60 @@ private:
     TaskQueue task_queue_;                // 优先级任务队列
     mutable std::mutex queue_mutex_;      // 队列互斥锁
     std::condition_variable task_available_; // 任务可用通知
+    std::condition_variable queue_not_full_;  // 队列空位通知（仅在有提交者等待时触发）
+    std::atomic<size_t> worker_count_{ 0 };   // 存活的工作线程数（不含已申请退出的线程）
+    std::atomic<size_t> queued_tasks_{ 0 };   // 所有队列中的待执行任务数（各模式通用）
+
+    // 无锁就绪队列（queue_type 为 LOCK_FREE 时使用）
+    std::unique_ptr<LockFreeReadyQueue> ready_queue_;
 
     // 过期线程管理
     std::unordered_set<std::thread::id> expired_workers_;
 
+    // 线程放置（构造后只读；next_affinity_slot_ 由 queue_mutex_ 保护）
+    std::vector<std::vector<int>> affinity_plan_;
+    size_t next_affinity_slot_ = 0;
+
+    // 工作窃取模式（WORK_STEALING专用）
+    std::vector<std::unique_ptr<StealingQueue>> local_queues_; // 每个工作线程的本地队列
+    StealingQueue injection_queue_;            // 外部线程提交的全局注入队列
+
+    // 休眠与唤醒（WORK_STEALING 与 LOCK_FREE 队列共用）
+    std::atomic<size_t> sleeping_workers_{ 0 }; // 正在休眠的工作线程数
+    std::atomic<size_t> blocked_submitters_{ 0 }; // 因队列满而等待的提交者数
+    std::atomic<size_t> blocked_batches_{ 0 };    // 其中等待整批名额的批量提交者数
+    std::mutex park_mutex_;                    // 休眠/唤醒互斥锁（不参与任务出入队）
+    std::condition_variable park_cv_;          // 工作线程休眠条件变量
+    std::condition_variable space_available_;  // 队列空位通知
+
+    // 任务追踪（仅设置 trace_sink 时使用）
+    std::vector<std::unique_ptr<TraceRing>> trace_rings_; // 所有追踪缓冲区（只增不减）
+    std::mutex trace_mutex_;                   // 保护缓冲区注册/租用（不在任务执行路径上）
+    std::jthread trace_drainer_;               // 追踪排空线程
+
+    // 统计（工作线程各写各的统计块，只增不减）
+    std::vector<std::unique_ptr<WorkerStats>> worker_stats_;
+    mutable std::mutex stats_mutex_;              // 保护统计块注册/租用与快照遍历
+    std::atomic<uint64_t> rejected_tasks_{ 0 };   // 队列满被拒绝的提交次数
+    std::atomic<uint64_t> dropped_tasks_{ 0 };    // DROP_OLDEST_LOW 丢弃的任务数
+    std::atomic<uint64_t> caller_ran_tasks_{ 0 }; // CALLER_RUNS 在提交线程中执行的任务数
+    bool timed_ = false;                          // 是否记录执行/排队时间（构造后只读）
+
+    // 自适应扩缩容（CACHED模式 + ADAPTIVE策略）
+    bool adaptive_ = false;                       // 是否启用自适应控制器（构造后只读）
+    std::atomic<size_t> desired_workers_{ 0 };    // 控制器目标活跃线程数
+    std::atomic<size_t> active_workers_{ 0 };     // 活跃线程数（不含备用线程）
+    std::atomic<size_t> spare_workers_{ 0 };      // 休眠备用线程数
+    std::atomic<size_t> executing_workers_{ 0 };  // 正在执行任务的线程数
+    std::atomic<uint64_t> threads_spawned_{ 0 };  // 累计创建线程数
+    std::atomic<uint64_t> threads_retired_{ 0 };  // 累计退出线程数
+    std::atomic<bool> controller_kick_{ false };  // 提交方请求控制器提前运行
+    std::condition_variable spare_cv_;            // 备用线程唤醒（配合 queue_mutex_）
+    std::mutex controller_mutex_;
+    std::condition_variable_any controller_cv_;
+    mutable std::mutex elastic_stats_mutex_;
+    ElasticityStats elastic_stats_;               // 控制器最近一次计算的速率与时延
+
     // 管理线程（CACHED模式专用）
     std::jthread manager_thread_;         // C++20的jthread（自动管理）
 };
@@ -2,6 +2,9 @@
 /*--------以下测试代码为两种模式下的简易测试，你也可以自行编辑测试代码进行测试--------*/
 
 #include "advancedthreadpool.hpp"
+#include "threadpool_coro.hpp"
+#include <cstdlib>
+#include <latch>
 #include <random>
 #include <sstream>
 
@@ -244,4 +247,467 @@ int main() {
     
     return 0;
 }
-#endif
\ No newline at end of file
+#endif
+
+/*
+该测试代码是三种模式（FIXED / CACHED / WORK_STEALING）的吞吐量基准测试，
+以及 submit()/post() 与改造前提交路径的开销对比
+*/
+
+
+#if 0
+
+// 统计全局堆分配次数（用于对比各提交路径的每任务分配数）
+static std::atomic<size_t> g_heap_allocs{ 0 };
+
+// 数组形式与带大小的 delete 一并替换，new/delete 成对落在 malloc/free 上；
+// noinline 防止 GCC 把内联后的 free 与未内联的 operator new 配对误报 -Wmismatched-new-delete
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void* operator new[](std::size_t size) { return ::operator new(size); }
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// 极小任务：模拟一次仿真tick的少量计算
+inline void tiny_work(std::atomic<uint64_t>& sink) {
+    uint64_t x = sink.load(std::memory_order_relaxed);
+    for (int i = 0; i < 64; ++i) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    sink.fetch_add(x & 1, std::memory_order_relaxed);
+}
+
+// 被测线程池配置：工作模式 + 就绪队列实现
+struct PoolVariant {
+    const char* name;
+    PoolMode mode;
+    QueueType queue;
+};
+
+// 场景1：外部线程逐个提交全部任务
+double bench_external(PoolVariant variant, size_t threads, size_t tasks) {
+    ThreadPoolConfig config;
+    config.min_threads = threads;
+    config.max_threads = threads;
+    config.max_tasks = tasks;
+    config.mode = variant.mode;
+    config.queue_type = variant.queue;
+    AdvancedThreadPool pool(config);
+
+    std::atomic<uint64_t> sink{ 0 };
+    std::latch done(static_cast<std::ptrdiff_t>(tasks));
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        pool.submit([&] { tiny_work(sink); done.count_down(); });
+    }
+    done.wait();
+    auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return tasks / elapsed;
+}
+
+// 场景2：任务在池内派生子任务（分治/仿真步进展开），体现本地队列的优势
+double bench_fan_out(PoolVariant variant, size_t threads, size_t roots, size_t children) {
+    ThreadPoolConfig config;
+    config.min_threads = threads;
+    config.max_threads = threads;
+    config.max_tasks = roots * (children + 1);
+    config.mode = variant.mode;
+    config.queue_type = variant.queue;
+    AdvancedThreadPool pool(config);
+
+    std::atomic<uint64_t> sink{ 0 };
+    const size_t total = roots * (children + 1);
+    std::latch done(static_cast<std::ptrdiff_t>(total));
+
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < roots; ++r) {
+        pool.submit([&] {
+            for (size_t c = 0; c < children; ++c) {
+                pool.submit([&] { tiny_work(sink); done.count_down(); });
+            }
+            done.count_down();
+        });
+    }
+    done.wait();
+    auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return total / elapsed;
+}
+
+// 改造前的提交路径：make_shared<packaged_task> + std::bind + std::function
+template <typename F>
+auto legacy_submit(AdvancedThreadPool& pool, F&& f) {
+    using ReturnType = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::bind(std::forward<F>(f)));
+    auto result = task->get_future();
+    std::function<void()> wrapper = [task] { (*task)(); };
+    pool.post(std::move(wrapper));
+    return result;
+}
+
+// 场景3：单个外部线程提交，对比各提交路径的吞吐量与每任务堆分配次数
+void bench_submit_paths(size_t threads, size_t tasks) {
+    ThreadPoolConfig config;
+    config.min_threads = threads;
+    config.max_threads = threads;
+    config.max_tasks = tasks;
+    config.mode = PoolMode::FIXED;
+    AdvancedThreadPool pool(config);
+
+    std::atomic<uint64_t> sink{ 0 };
+
+    // 调用方按窗口消费 future（同一时刻最多 kWindow 个任务在途）
+    const size_t kWindow = 1024;
+    vector<future<void>> futures;
+    futures.reserve(kWindow);
+    auto drain = [&] {
+        for (auto& f : futures) f.get();
+        futures.clear();
+    };
+
+    auto measure = [&](const char* name, auto&& body) {
+        const size_t allocs_before = g_heap_allocs.load();
+        auto start = chrono::steady_clock::now();
+        body();
+        auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        const double allocs = static_cast<double>(g_heap_allocs.load() - allocs_before) / tasks;
+        cout << left << setw(36) << name
+             << setw(14) << fixed << setprecision(0) << tasks / elapsed
+             << setprecision(2) << allocs << endl;
+    };
+
+    cout << "\n=== 提交路径开销 (" << threads << " 线程) ===" << endl;
+    cout << left << setw(36) << "path" << setw(14) << "任务/秒" << "堆分配/任务" << endl;
+
+    measure("legacy (packaged_task+bind)", [&] {
+        for (size_t i = 0; i < tasks; ++i) {
+            futures.push_back(legacy_submit(pool, [&] { tiny_work(sink); }));
+            if (futures.size() == kWindow) drain();
+        }
+        drain();
+    });
+    measure("submit() (pooled promise)", [&] {
+        for (size_t i = 0; i < tasks; ++i) {
+            futures.push_back(pool.submit([&] { tiny_work(sink); }));
+            if (futures.size() == kWindow) drain();
+        }
+        drain();
+    });
+    measure("post() (fire-and-forget)", [&] {
+        std::latch done(static_cast<std::ptrdiff_t>(tasks));
+        for (size_t i = 0; i < tasks; ++i) {
+            pool.post([&] { tiny_work(sink); done.count_down(); });
+        }
+        done.wait();
+    });
+    measure("post_batch() (1024/batch)", [&] {
+        std::latch done(static_cast<std::ptrdiff_t>(tasks));
+        vector<function<void()>> batch;
+        batch.reserve(kWindow);
+        for (size_t i = 0; i < tasks; ++i) {
+            batch.push_back([&] { tiny_work(sink); done.count_down(); });
+            if (batch.size() == kWindow || i + 1 == tasks) {
+                pool.post_batch(std::move(batch));
+                batch.clear();
+                batch.reserve(kWindow);
+            }
+        }
+        done.wait();
+    });
+    measure("parallel_for() (auto grain)", [&] {
+        pool.parallel_for(size_t(0), tasks, 0, [&](size_t) { tiny_work(sink); }).get();
+    });
+}
+
+// 场景4：突发负载下 CACHED 模式两种扩缩容策略的对比
+// 每轮瞬间提交一批带阻塞等待的任务（模拟I/O），记录提交到完成的时延与线程数变化
+void bench_bursty(ElasticityPolicy policy, const char* name) {
+    const size_t kBursts = 20;
+    const size_t kBurstSize = 300;
+    const auto kGap = chrono::milliseconds(100);
+
+    ThreadPoolConfig config;
+    config.min_threads = 4;
+    config.max_threads = 512;
+    config.max_tasks = kBurstSize * 2;
+    config.mode = PoolMode::CACHED;
+    config.elasticity.policy = policy;
+    AdvancedThreadPool pool(config);
+
+    vector<double> latency_us(kBursts * kBurstSize);
+    std::atomic<size_t> peak_workers{ 0 };
+    std::atomic<bool> sampling{ true };
+    std::thread sampler([&] {
+        while (sampling.load()) {
+            size_t workers = pool.worker_count();
+            size_t peak = peak_workers.load();
+            while (workers > peak && !peak_workers.compare_exchange_weak(peak, workers)) {}
+            std::this_thread::sleep_for(chrono::milliseconds(2));
+        }
+    });
+
+    for (size_t b = 0; b < kBursts; ++b) {
+        std::latch done(static_cast<std::ptrdiff_t>(kBurstSize));
+        for (size_t i = 0; i < kBurstSize; ++i) {
+            const auto submitted = chrono::steady_clock::now();
+            double* slot = &latency_us[b * kBurstSize + i];
+            pool.post([&done, slot, submitted] {
+                std::this_thread::sleep_for(chrono::microseconds(500));
+                *slot = chrono::duration<double, std::micro>(chrono::steady_clock::now() - submitted).count();
+                done.count_down();
+            });
+        }
+        done.wait();
+        std::this_thread::sleep_for(kGap);
+    }
+    sampling = false;
+    sampler.join();
+
+    std::sort(latency_us.begin(), latency_us.end());
+    auto pct = [&](double p) { return latency_us[static_cast<size_t>(p * (latency_us.size() - 1))]; };
+    const ElasticityStats stats = pool.elasticity_stats();
+    cout << left << setw(12) << name
+         << setw(12) << fixed << setprecision(0) << pct(0.50)
+         << setw(12) << pct(0.99)
+         << setw(10) << peak_workers.load()
+         << setw(10) << stats.threads_spawned
+         << setw(10) << stats.total_workers << endl;
+}
+
+// 过载场景：生产者提交速度远超消费能力，对比各溢出策略下生产者单次提交的耗时与任务去向
+void bench_overflow(OverflowPolicy policy, const char* name) {
+    const size_t kProducers = 2;
+    const size_t kAttempts = 20000;
+
+    ThreadPoolConfig config;
+    config.min_threads = 2;
+    config.max_threads = 2;
+    config.max_tasks = 256;
+    config.mode = PoolMode::FIXED;
+    config.overflow_policy = policy;
+    config.submit_timeout = chrono::milliseconds(1);
+    AdvancedThreadPool pool(config);
+
+    auto spin = [] {
+        const auto until = chrono::steady_clock::now() + chrono::microseconds(20);
+        while (chrono::steady_clock::now() < until) {}
+    };
+
+    vector<double> cost_us(kProducers * kAttempts);
+    vector<std::thread> producers;
+    for (size_t p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (size_t i = 0; i < kAttempts; ++i) {
+                const auto priority = static_cast<TaskPriority>(i % kTaskPriorityLevels);
+                const auto start = chrono::steady_clock::now();
+                if (policy == OverflowPolicy::BLOCK) {
+                    (void)pool.try_post_for(config.submit_timeout, priority, spin);
+                } else {
+                    (void)pool.try_post(priority, spin);
+                }
+                cost_us[p * kAttempts + i] =
+                    chrono::duration<double, std::micro>(chrono::steady_clock::now() - start).count();
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    pool.shutdown();
+
+    std::sort(cost_us.begin(), cost_us.end());
+    auto pct = [&](double q) { return cost_us[static_cast<size_t>(q * (cost_us.size() - 1))]; };
+    const ThreadPoolStats stats = pool.stats();
+    cout << left << setw(16) << name
+         << setw(12) << fixed << setprecision(2) << pct(0.50)
+         << setw(12) << pct(0.99)
+         << setw(12) << stats.completed()
+         << setw(10) << stats.rejected
+         << setw(10) << stats.dropped
+         << setw(10) << stats.ran_in_caller << endl;
+}
+
+// 打印统计快照：每个优先级的完成/异常数与排队、执行时延分位数（微秒）
+void print_pool_stats(const ThreadPoolStats& stats) {
+    const char* names[] = { "HIGH", "NORMAL", "LOW" };
+    cout << left << setw(8) << "prio" << setw(10) << "done" << setw(8) << "failed"
+         << setw(10) << "wait p50" << setw(10) << "wait p99" << setw(11) << "wait max"
+         << setw(10) << "exec p50" << setw(10) << "exec p99" << "exec max" << endl;
+    for (size_t i = 0; i < kTaskPriorityLevels; ++i) {
+        const PriorityStats& level = stats.priorities[i];
+        auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+        cout << left << setw(8) << names[i] << setw(10) << level.completed << setw(8) << level.failed
+             << fixed << setprecision(1)
+             << setw(10) << us(level.queue_wait.percentile(0.50))
+             << setw(10) << us(level.queue_wait.percentile(0.99))
+             << setw(11) << us(level.queue_wait.max)
+             << setw(10) << us(level.execution.percentile(0.50))
+             << setw(10) << us(level.execution.percentile(0.99))
+             << us(level.execution.max) << endl;
+    }
+    cout << "rejected=" << stats.rejected << " pending=" << stats.pending_tasks
+         << " workers=" << stats.worker_count << endl;
+}
+
+// 场景5：混合优先级负载下的时延统计，并对比开启直方图前后的投递吞吐量
+void bench_stats(size_t threads, size_t tasks) {
+    for (bool histograms : { false, true }) {
+        ThreadPoolConfig config;
+        config.min_threads = threads;
+        config.max_threads = threads;
+        config.max_tasks = tasks;
+        config.mode = PoolMode::FIXED;
+        config.latency_histograms = histograms;
+        AdvancedThreadPool pool(config);
+
+        std::atomic<uint64_t> sink{ 0 };
+        std::latch done(static_cast<std::ptrdiff_t>(tasks));
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < tasks; ++i) {
+            pool.post(static_cast<TaskPriority>(i % kTaskPriorityLevels), [&] {
+                tiny_work(sink);
+                done.count_down();
+            });
+        }
+        done.wait();
+        auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "\n=== 统计快照 (" << threads << " 线程, latency_histograms="
+             << (histograms ? "on" : "off") << ", " << fixed << setprecision(0)
+             << tasks / elapsed << " 任务/秒) ===" << endl;
+        print_pool_stats(pool.stats());
+    }
+}
+
+int main() {
+    const size_t kTasks = 200000;
+    const PoolVariant variants[] = {
+        { "FIXED", PoolMode::FIXED, QueueType::HEAP },
+        { "FIXED+LOCK_FREE", PoolMode::FIXED, QueueType::LOCK_FREE },
+        { "CACHED", PoolMode::CACHED, QueueType::HEAP },
+        { "CACHED+LOCK_FREE", PoolMode::CACHED, QueueType::LOCK_FREE },
+        { "WORK_STEALING", PoolMode::WORK_STEALING, QueueType::HEAP },
+    };
+
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 2) * 2;
+    vector<size_t> thread_counts;
+    for (size_t t = 1; t <= max_threads; t *= 2) thread_counts.push_back(t);
+
+    auto run = [&](const char* title, auto&& bench) {
+        cout << "\n=== " << title << " (任务/秒) ===" << endl;
+        cout << left << "线程数    ";
+        for (auto& variant : variants) cout << setw(18) << variant.name;
+        cout << endl;
+
+        for (size_t threads : thread_counts) {
+            cout << left << setw(10) << threads;
+            for (auto& variant : variants) {
+                double rate = bench(variant, threads);
+                cout << setw(18) << fixed << setprecision(0) << rate;
+            }
+            cout << endl;
+        }
+    };
+
+    run("外部提交", [&](const PoolVariant& variant, size_t threads) {
+        return bench_external(variant, threads, kTasks);
+    });
+    run("池内派生", [&](const PoolVariant& variant, size_t threads) {
+        return bench_fan_out(variant, threads, 1000, kTasks / 1000 - 1);
+    });
+
+    for (size_t threads : { size_t(1), max_threads }) {
+        bench_submit_paths(threads, kTasks);
+    }
+
+    cout << "\n=== 突发负载 (CACHED, 20轮 x 300个0.5ms阻塞任务) ===" << endl;
+    cout << left << setw(12) << "policy" << setw(12) << "p50(us)" << setw(12) << "p99(us)"
+         << setw(10) << "peak" << setw(10) << "spawned" << setw(10) << "final" << endl;
+    bench_bursty(ElasticityPolicy::EAGER, "EAGER");
+    bench_bursty(ElasticityPolicy::ADAPTIVE, "ADAPTIVE");
+
+    cout << "\n=== 过载 (FIXED 2线程, 2个生产者 x 20000次提交, 20us任务, 队列256) ===" << endl;
+    cout << left << setw(16) << "policy" << setw(12) << "p50(us)" << setw(12) << "p99(us)"
+         << setw(12) << "executed" << setw(10) << "rejected" << setw(10) << "dropped" << setw(10) << "caller" << endl;
+    bench_overflow(OverflowPolicy::BLOCK, "BLOCK(1ms)");
+    bench_overflow(OverflowPolicy::REJECT, "REJECT");
+    bench_overflow(OverflowPolicy::DROP_OLDEST_LOW, "DROP_OLDEST_LOW");
+    bench_overflow(OverflowPolicy::CALLER_RUNS, "CALLER_RUNS");
+
+    bench_stats(max_threads, kTasks);
+
+    return 0;
+}
+#endif
+
+/*
+该测试代码是协程层（threadpool_coro.hpp）的示例：
+大量模拟智能体以 Task<T> 形式挂起在线程池上，不各自占用线程
+*/
+
+
+#if 0
+
+// 模拟智能体：每一步都重新调度到线程池，在步与步之间挂起
+Task<long> agent_step(AdvancedThreadPool& pool, int agent_id, int steps) {
+    long state = agent_id;
+    for (int step = 0; step < steps; ++step) {
+        co_await pool.schedule(step % 2 == 0 ? TaskPriority::NORMAL : TaskPriority::LOW);
+        state = state * 31 + step;
+    }
+    co_return state % 1000;
+}
+
+Task<long> simulation(AdvancedThreadPool& pool, int agents, int steps) {
+    vector<Task<long>> tasks;
+    tasks.reserve(agents);
+    for (int i = 0; i < agents; ++i) {
+        tasks.push_back(agent_step(pool, i, steps));
+    }
+
+    // 所有智能体并发推进，全部结束后汇总
+    long total = 0;
+    for (long value : co_await when_all(std::move(tasks))) {
+        total += value;
+    }
+    co_return total;
+}
+
+Task<int> may_fail(AdvancedThreadPool& pool, bool fail) {
+    co_await pool.schedule(TaskPriority::HIGH);
+    if (fail) throw runtime_error("agent failed");
+    co_return 1;
+}
+
+int main() {
+    ThreadPoolConfig config;
+    config.mode = PoolMode::FIXED;
+    config.min_threads = 4;
+    config.max_threads = 4;
+    config.max_tasks = 100000;
+
+    AdvancedThreadPool pool(config);
+
+    const int kAgents = 20000;
+    const int kSteps = 10;
+
+    auto start = chrono::steady_clock::now();
+    long total = sync_wait(simulation(pool, kAgents, kSteps));
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+    cout << kAgents << " 个智能体 x " << kSteps << " 步, 线程数: " << pool.worker_count()
+         << ", 结果: " << total << ", 耗时: " << elapsed.count() << "ms" << endl;
+
+    // 异常从 co_await/sync_wait 处抛出
+    try {
+        sync_wait(when_all(may_fail(pool, false), may_fail(pool, true)));
+    }
+    catch (const exception& e) {
+        cout << "捕获异常: " << e.what() << endl;
+    }
+
+    pool.shutdown();
+    return 0;
+}
+#endif
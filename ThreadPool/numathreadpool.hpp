@@ -0,0 +1,129 @@
+
+/*-------此为按NUMA节点划分的线程池，基于 advancedthreadpool.hpp，切记需使用支持C++20及以上的编译器--------*/
+
+#ifndef NUMA_THREADPOOL_H
+#define NUMA_THREADPOOL_H
+
+#include "advancedthreadpool.hpp"
+
+/**
+ * NUMA 感知线程池：每个NUMA节点一个 AdvancedThreadPool 子池，子池线程只在本节点CPU上运行
+ * 数据驻留在某个节点（例如某个缓存分片）时，用 submit_near/post_near 把任务投递到该节点，
+ * 避免跨节点访存；不指定节点时投递到调用线程当前所在的节点
+ */
+class NumaThreadPool {
+public:
+    /**
+     * @param config 每个子池的配置模板：
+     *   min_threads 为 0 时取该节点的CPU数；
+     *   affinity 为 NONE 时线程在节点内自由调度，COMPACT/SCATTER 在节点内逐核绑定，
+     *   EXPLICIT 只使用 cpu_list 中属于该节点的CPU（若无则退化为节点内自由调度）；
+     *   numa_node 由本类按节点填写，传入值被忽略
+     */
+    explicit NumaThreadPool(ThreadPoolConfig config = {}) {
+        const CpuTopology& topology = CpuTopology::instance();
+        pools_.reserve(topology.node_count());
+
+        for (size_t node = 0; node < topology.node_count(); ++node) {
+            ThreadPoolConfig node_config = config;
+            node_config.numa_node = topology.node_id(node);
+
+            const std::vector<int>& cpus = topology.node_cpus(node);
+            if (node_config.min_threads == 0) {
+                node_config.min_threads = cpus.size();
+            }
+            node_config.max_threads = std::max(node_config.max_threads, node_config.min_threads);
+
+            if (config.affinity == AffinityPolicy::EXPLICIT) {
+                node_config.cpu_list.clear();
+                for (int cpu : config.cpu_list) {
+                    if (topology.node_of_cpu(cpu) == node) node_config.cpu_list.push_back(cpu);
+                }
+                if (node_config.cpu_list.empty()) {
+                    node_config.affinity = AffinityPolicy::NONE;
+                }
+            }
+
+            pools_.push_back(std::make_unique<AdvancedThreadPool>(std::move(node_config)));
+        }
+    }
+
+    // 禁用拷贝和赋值
+    NumaThreadPool(const NumaThreadPool&) = delete;
+    NumaThreadPool& operator=(const NumaThreadPool&) = delete;
+
+    // 节点数（单节点机器上为1）
+    size_t node_count() const { return pools_.size(); }
+
+    // 访问某个节点的子池（节点编号按节点数取模）
+    AdvancedThreadPool& node_pool(size_t node) {
+        return *pools_[node % pools_.size()];
+    }
+
+    // 调用线程当前所在的节点
+    size_t current_node() const {
+        return CpuTopology::instance().current_node() % pools_.size();
+    }
+
+    // 在指定节点上执行任务（带优先级）
+    template <typename F, typename... Args>
+    auto submit_near(size_t node, TaskPriority priority, F&& f, Args&&... args) {
+        return node_pool(node).submit(priority, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 在指定节点上执行任务（默认优先级）
+    template <typename F, typename... Args>
+    auto submit_near(size_t node, F&& f, Args&&... args) {
+        return node_pool(node).submit(std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 在指定节点上投递任务（带优先级，不返回 future）
+    template <typename F, typename... Args>
+    void post_near(size_t node, TaskPriority priority, F&& f, Args&&... args) {
+        node_pool(node).post(priority, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 在指定节点上投递任务（默认优先级）
+    template <typename F, typename... Args>
+    void post_near(size_t node, F&& f, Args&&... args) {
+        node_pool(node).post(std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 提交到调用线程所在节点
+    template <typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) {
+        return submit_near(current_node(), std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 投递到调用线程所在节点
+    template <typename F, typename... Args>
+    void post(F&& f, Args&&... args) {
+        post_near(current_node(), std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 关闭所有子池
+    void shutdown() {
+        for (auto& pool : pools_) {
+            pool->shutdown();
+        }
+    }
+
+    // 所有子池的线程数之和
+    size_t worker_count() const {
+        size_t total = 0;
+        for (auto& pool : pools_) total += pool->worker_count();
+        return total;
+    }
+
+    // 所有子池的等待任务数之和
+    size_t pending_tasks() const {
+        size_t total = 0;
+        for (auto& pool : pools_) total += pool->pending_tasks();
+        return total;
+    }
+
+private:
+    std::vector<std::unique_ptr<AdvancedThreadPool>> pools_;  // 按节点编号排列的子池
+};
+
+#endif // NUMA_THREADPOOL_H
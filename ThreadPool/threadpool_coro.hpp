@@ -0,0 +1,446 @@
+
+/*-------此为线程池的C++20协程层，基于 advancedthreadpool.hpp，切记需使用支持C++20及以上的编译器--------*/
+
+#ifndef THREADPOOL_CORO_H
+#define THREADPOOL_CORO_H
+
+#include "advancedthreadpool.hpp"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <variant>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * 用法：
+ *   Task<int> step(AdvancedThreadPool& pool) {
+ *       co_await pool.schedule();        // 切换到工作线程
+ *       co_return compute();
+ *   }
+ *   int v = sync_wait(step(pool));       // 在非工作线程中阻塞等待结果
+ *
+ * Task<T> 为惰性协程：创建后不执行，直到被 co_await/sync_wait/spawn_detached 启动；
+ * 完成时通过对称转移直接恢复等待方，不经过线程池队列
+ */
+
+template <typename T = void>
+class Task;
+
+namespace coro_detail {
+
+// Task 的 promise 公共部分：惰性启动，结束时恢复等待方
+struct TaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    std::coroutine_handle<> continuation;  // 等待该任务的协程
+};
+
+// when_all 的结果类型：void 子任务以 std::monostate 占位
+template <typename T>
+using WhenAllResult = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+// 立即执行、结束时自行销毁的协程（spawn_detached 的驱动）
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+// sync_wait 的完成事件：通知在持锁状态下发出，等待方返回后销毁事件是安全的
+struct SyncWaitEvent {
+    void set() {
+        std::lock_guard lock(mutex);
+        done = true;
+        cv.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [this] { return done; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+// when_all 计数器：子任务数 + 1（父协程启动全部子任务后也到达一次），最后到达者恢复父协程
+struct WhenAllCounter {
+    explicit WhenAllCounter(size_t children) : remaining(children + 1) {}
+
+    bool arrive() noexcept {
+        return remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    std::atomic<size_t> remaining;
+    std::coroutine_handle<> parent;
+};
+
+// when_all 子任务驱动：等待子任务，结束时向计数器报到
+class WhenAllDriver {
+public:
+    struct promise_type {
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                WhenAllCounter* counter = handle.promise().counter;
+                return counter->arrive() ? counter->parent : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        WhenAllDriver get_return_object() noexcept {
+            return WhenAllDriver(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }  // 子任务异常已在驱动体内捕获
+
+        WhenAllCounter* counter = nullptr;
+    };
+
+    WhenAllDriver(WhenAllDriver&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    WhenAllDriver& operator=(WhenAllDriver&&) = delete;
+    ~WhenAllDriver() {
+        if (handle_) handle_.destroy();
+    }
+
+    void start(WhenAllCounter& counter) {
+        handle_.promise().counter = &counter;
+        handle_.resume();
+    }
+
+private:
+    explicit WhenAllDriver(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// sync_wait 的驱动：结束时挂起并发出完成事件，协程帧由等待线程销毁
+class SyncWaitDriver {
+public:
+    struct promise_type {
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                handle.promise().event->set();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        SyncWaitDriver get_return_object() noexcept {
+            return SyncWaitDriver(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }  // 异常已在驱动体内捕获
+
+        SyncWaitEvent* event = nullptr;
+    };
+
+    SyncWaitDriver(SyncWaitDriver&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    SyncWaitDriver& operator=(SyncWaitDriver&&) = delete;
+    ~SyncWaitDriver() {
+        if (handle_) handle_.destroy();
+    }
+
+    // 启动并阻塞到协程结束
+    void run() {
+        SyncWaitEvent event;
+        handle_.promise().event = &event;
+        handle_.resume();
+        event.wait();
+    }
+
+private:
+    explicit SyncWaitDriver(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// 父协程的等待体：启动全部子任务，若子任务已同步完成则不挂起
+struct WhenAllAwaiter {
+    std::vector<WhenAllDriver>& drivers;
+    WhenAllCounter& counter;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> parent) {
+        counter.parent = parent;
+        for (auto& driver : drivers) {
+            driver.start(counter);
+        }
+        return !counter.arrive();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+template <typename T>
+WhenAllDriver make_when_all_driver(Task<T>& task, std::optional<WhenAllResult<T>>& slot, std::exception_ptr& error) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await std::move(task);
+            slot.emplace();
+        } else {
+            slot.emplace(co_await std::move(task));
+        }
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+}
+
+inline void rethrow_first(const std::vector<std::exception_ptr>& errors) {
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+} // namespace coro_detail
+
+// 协程任务：co_return 的值或抛出的异常在 co_await 处取得
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    static_assert(!std::is_reference_v<T>, "Task<T&> is not supported");
+
+    struct promise_type : coro_detail::TaskPromiseBase {
+        Task get_return_object() noexcept {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        template <typename U>
+        void return_value(U&& value) {
+            result.template emplace<1>(std::forward<U>(value));
+        }
+
+        void unhandled_exception() noexcept {
+            result.template emplace<2>(std::current_exception());
+        }
+
+        T take() {
+            if (result.index() == 2) std::rethrow_exception(std::get<2>(result));
+            return std::move(std::get<1>(result));
+        }
+
+        std::variant<std::monostate, T, std::exception_ptr> result;
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    // 等待任务完成：启动任务，并在其结束时恢复当前协程
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().take(); }
+        };
+        return Awaiter{ handle_ };
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class [[nodiscard]] Task<void> {
+public:
+    struct promise_type : coro_detail::TaskPromiseBase {
+        Task get_return_object() noexcept {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() noexcept {
+            error = std::current_exception();
+        }
+
+        void take() {
+            if (error) std::rethrow_exception(error);
+        }
+
+        std::exception_ptr error;
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            void await_resume() { handle.promise().take(); }
+        };
+        return Awaiter{ handle_ };
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * 并发等待多个任务，结果按参数顺序组成 tuple（void 任务对应 std::monostate）
+ * 所有子任务都结束后才返回；若有子任务抛出异常，重新抛出排在最前的那个
+ */
+template <typename... Ts>
+Task<std::tuple<coro_detail::WhenAllResult<Ts>...>> when_all(Task<Ts>... tasks) {
+    coro_detail::WhenAllCounter counter(sizeof...(Ts));
+    std::tuple<std::optional<coro_detail::WhenAllResult<Ts>>...> slots;
+    std::vector<std::exception_ptr> errors(sizeof...(Ts));
+    std::vector<coro_detail::WhenAllDriver> drivers;
+    drivers.reserve(sizeof...(Ts));
+
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        (drivers.push_back(coro_detail::make_when_all_driver(tasks, std::get<I>(slots), errors[I])), ...);
+    }(std::index_sequence_for<Ts...>{});
+
+    co_await coro_detail::WhenAllAwaiter{ drivers, counter };
+    coro_detail::rethrow_first(errors);
+
+    co_return std::apply([](auto&... slot) {
+        return std::tuple<coro_detail::WhenAllResult<Ts>...>(std::move(*slot)...);
+        }, slots);
+}
+
+// 并发等待一组同类型任务，结果顺序与输入一致
+template <typename T>
+Task<std::vector<coro_detail::WhenAllResult<T>>> when_all(std::vector<Task<T>> tasks) {
+    coro_detail::WhenAllCounter counter(tasks.size());
+    std::vector<std::optional<coro_detail::WhenAllResult<T>>> slots(tasks.size());
+    std::vector<std::exception_ptr> errors(tasks.size());
+    std::vector<coro_detail::WhenAllDriver> drivers;
+    drivers.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        drivers.push_back(coro_detail::make_when_all_driver(tasks[i], slots[i], errors[i]));
+    }
+
+    co_await coro_detail::WhenAllAwaiter{ drivers, counter };
+    coro_detail::rethrow_first(errors);
+
+    std::vector<coro_detail::WhenAllResult<T>> results;
+    results.reserve(slots.size());
+    for (auto& slot : slots) {
+        results.push_back(std::move(*slot));
+    }
+    co_return results;
+}
+
+/**
+ * 在当前线程启动任务并阻塞等待结果（异常原样抛出）
+ * 注意：不要在同一线程池的工作线程中调用，FIXED模式下可能耗尽线程而死锁
+ */
+template <typename T>
+T sync_wait(Task<T> task) {
+    std::optional<coro_detail::WhenAllResult<T>> value;
+    std::exception_ptr error;
+
+    auto driver = [](Task<T> t, std::optional<coro_detail::WhenAllResult<T>>& out,
+        std::exception_ptr& err) -> coro_detail::SyncWaitDriver {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(t);
+                out.emplace();
+            } else {
+                out.emplace(co_await std::move(t));
+            }
+        }
+        catch (...) {
+            err = std::current_exception();
+        }
+    }(std::move(task), value, error);
+
+    driver.run();
+    if (error) std::rethrow_exception(error);
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(*value);
+    }
+}
+
+/**
+ * 启动任务但不等待（"发射后不管"），任务结束后自动释放协程帧
+ * 任务在调用线程上执行到第一个挂起点，通常应以 co_await pool.schedule() 开头；
+ * 与 post() 一致，任务抛出的异常被丢弃
+ */
+inline void spawn_detached(Task<void> task) {
+    [](Task<void> t) -> coro_detail::DetachedTask {
+        try {
+            co_await std::move(t);
+        }
+        catch (...) {
+        }
+    }(std::move(task));
+}
+
+#endif // THREADPOOL_CORO_H